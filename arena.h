@@ -0,0 +1,92 @@
+#ifndef TRABALHO1_ARENA_H
+#define TRABALHO1_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define ARENA_BLOCK_SIZE 4096
+
+/**
+ * Bump allocator, memory is handed out from big blocks and is only given back when the whole arena is destroyed.
+ *
+ * Allocating is not thread safe, but the memory usage can be read from any thread.
+ */
+class Arena {
+
+private:
+    char *currentPosition;
+
+    size_t remainingBytes;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+
+    std::atomic_size_t memoryUsage;
+
+    char *allocateBlock(size_t blockSize) {
+
+        blocks.emplace_back(new char[blockSize]);
+
+        memoryUsage.fetch_add(blockSize + sizeof(char *), std::memory_order_relaxed);
+
+        return blocks.back().get();
+    }
+
+    char *allocateFallback(size_t bytes) {
+
+        if (bytes > ARENA_BLOCK_SIZE / 4) {
+            //Big objects get their own block, so we don't waste what's left of the current one
+            return allocateBlock(bytes);
+        }
+
+        currentPosition = allocateBlock(ARENA_BLOCK_SIZE);
+        remainingBytes = ARENA_BLOCK_SIZE;
+
+        char *result = currentPosition;
+
+        currentPosition += bytes;
+        remainingBytes -= bytes;
+
+        return result;
+    }
+
+public:
+    Arena() : currentPosition(nullptr), remainingBytes(0), memoryUsage(0) {}
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @param alignment Must be a power of 2, no larger than the alignment of new
+     */
+    char *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+
+        size_t misalignment = reinterpret_cast<uintptr_t>(currentPosition) & (alignment - 1);
+
+        size_t padding = misalignment == 0 ? 0 : alignment - misalignment;
+
+        if (bytes + padding <= remainingBytes) {
+            char *result = currentPosition + padding;
+
+            currentPosition += bytes + padding;
+            remainingBytes -= bytes + padding;
+
+            return result;
+        }
+
+        //New blocks are always aligned
+        return allocateFallback(bytes);
+    }
+
+    /**
+     * The total size of the blocks allocated so far
+     */
+    size_t getMemoryUsage() const {
+        return memoryUsage.load(std::memory_order_relaxed);
+    }
+};
+
+#endif //TRABALHO1_ARENA_H
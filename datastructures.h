@@ -2,8 +2,11 @@
 #define TRABALHO1_DATASTRUCTURES_H
 
 #include <vector>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <string>
+#include <utility>
 
 template<typename T>
 class Set {
@@ -23,6 +26,9 @@ public:
 template<typename T, typename V>
 using node_info = std::tuple<std::shared_ptr<T>, std::shared_ptr<V>>;
 
+template<typename T, typename V>
+using entry_visitor = std::function<void(const std::shared_ptr<T> &, const std::shared_ptr<V> &)>;
+
 template<typename T, typename V, class A = std::allocator<node_info<T, V>>>
 class Map {
 
@@ -61,6 +67,51 @@ public:
 
     virtual std::optional<node_info<T, V>> popLargest() = 0;
 
+    /**
+     * Go through the entries in key order without collecting them all first. Maps that can walk their own structure
+     * override this, the rest go through entries()
+     */
+    virtual void forEachEntry(const entry_visitor<T, V> &visitor) {
+
+        auto all = this->entries();
+
+        for (auto &entry : *all) {
+            visitor(std::get<0>(entry), std::get<1>(entry));
+        }
+    }
+
+    /**
+     * Add entries that are already sorted by key, like the ones read back from a snapshot. Maps with a faster path
+     * for sorted input override this, the rest add them one by one
+     */
+    virtual void addSorted(std::vector<node_info<T, V>> sorted) {
+
+        for (auto &entry : sorted) {
+            this->add(std::move(std::get<0>(entry)), std::move(std::get<1>(entry)));
+        }
+    }
+
+};
+
+template<typename T, typename V>
+using heap_entry = std::pair<T, std::shared_ptr<V>>;
+
+/**
+ * Min priority queue. Keys are stored by value, since heaps compare them far more often than maps do
+ */
+template<typename T, typename V>
+class PriorityQueue {
+public:
+    virtual ~PriorityQueue() {};
+
+    virtual void push(const T &key, std::shared_ptr<V> value) = 0;
+
+    virtual std::optional<heap_entry<T, V>> peekSmallest() = 0;
+
+    virtual std::optional<heap_entry<T, V>> popSmallest() = 0;
+
+    virtual unsigned int size() = 0;
+
 };
 
 template<typename T>
@@ -85,4 +136,26 @@ public:
 
 };
 
+/**
+ * The bytes of a key that get hashed. By default the object itself, which is right for keys without pointers or
+ * padding
+ */
+template<typename T>
+struct KeyHash {
+
+    template<typename H>
+    static unsigned int hash(H &hashFunction, const T &key, int seed = 0) {
+        return hashFunction.hashObject(&key, sizeof(T), seed);
+    }
+};
+
+template<>
+struct KeyHash<std::string> {
+
+    template<typename H>
+    static unsigned int hash(H &hashFunction, const std::string &key, int seed = 0) {
+        return hashFunction.hashObject(key.data(), key.size(), seed);
+    }
+};
+
 #endif //TRABALHO1_DATASTRUCTURES_H
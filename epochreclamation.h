@@ -0,0 +1,164 @@
+#ifndef TRABALHO1_EPOCHRECLAMATION_H
+#define TRABALHO1_EPOCHRECLAMATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Amount of activity counters, each one in its own cache line, threads get spread among them
+#define EPOCH_SLOTS 64
+#define EPOCH_CACHE_LINE 64
+
+//How many retired objects we accumulate before trying to free them
+#define EPOCH_RECLAIM_THRESHOLD 128
+
+struct alignas(EPOCH_CACHE_LINE) EpochSlot {
+    //How many operations of this slot are running in an even and in an odd epoch
+    std::atomic_int active[2];
+
+    EpochSlot() : active{0, 0} {}
+};
+
+/**
+ * Epoch based memory reclamation, for structures whose readers take no locks and so can still be looking at a node
+ * after a writer removed it.
+ *
+ * Every operation on the structure runs inside a Guard, which counts it in the epoch it started in. Removed objects
+ * are retired with the current epoch instead of deleted, and the epoch can only move forward once no operation is
+ * still running in the epoch before it. So by the time the global epoch is two past the one an object was retired
+ * in, every operation that could have seen it has finished and it can be freed.
+ */
+class EpochReclaimer {
+
+private:
+    struct RetiredObject {
+        void *object;
+
+        void (*deleter)(void *);
+
+        uint64_t epoch;
+    };
+
+    std::atomic_uint64_t epoch;
+
+    EpochSlot slots[EPOCH_SLOTS];
+
+    std::mutex retiredLock;
+
+    std::vector<RetiredObject> retired;
+
+    static unsigned int getSlot() {
+        static thread_local unsigned int slot =
+                std::hash<std::thread::id>()(std::this_thread::get_id()) % EPOCH_SLOTS;
+
+        return slot;
+    }
+
+    /**
+     * Move the epoch forward if no operation is still running in the previous one, and free everything that no
+     * operation can see anymore. Must be called with the retired lock held
+     */
+    void reclaim() {
+
+        uint64_t current = epoch.load();
+
+        bool canAdvance = true;
+
+        //The operations in the epoch before the current one have the same parity as the next one
+        for (auto &slot : slots) {
+            if (slot.active[(current + 1) & 1].load() != 0) {
+                canAdvance = false;
+
+                break;
+            }
+        }
+
+        if (canAdvance) {
+            epoch.compare_exchange_strong(current, current + 1);
+
+            current = epoch.load();
+        }
+
+        size_t kept = 0;
+
+        for (auto &object : retired) {
+            if (object.epoch + 2 <= current) {
+                object.deleter(object.object);
+            } else {
+                retired[kept++] = object;
+            }
+        }
+
+        retired.resize(kept);
+    }
+
+public:
+    class Guard {
+
+    private:
+        std::atomic_int *active;
+
+    public:
+        explicit Guard(std::atomic_int *active) : active(active) {}
+
+        Guard(const Guard &) = delete;
+
+        Guard &operator=(const Guard &) = delete;
+
+        ~Guard() {
+            active->fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    EpochReclaimer() : epoch(0) {}
+
+    ~EpochReclaimer() {
+        for (auto &object : retired) {
+            object.deleter(object.object);
+        }
+    }
+
+    /**
+     * Enter an operation, the objects that are reachable now will stay alive until the guard is destroyed
+     */
+    Guard enter() {
+
+        EpochSlot &slot = slots[getSlot()];
+
+        while (true) {
+            uint64_t current = epoch.load();
+
+            slot.active[current & 1].fetch_add(1);
+
+            //If the epoch moved while we were announcing ourselves, the reclaimer might not have seen us
+            if (epoch.load() == current) {
+                return Guard(&slot.active[current & 1]);
+            }
+
+            slot.active[current & 1].fetch_sub(1);
+        }
+    }
+
+    /**
+     * Free the object once no operation can still be looking at it. The object must already be unreachable
+     *
+     * @tparam Deleter How to free objects that weren't allocated with new
+     */
+    template<typename O, typename Deleter = std::default_delete<O>>
+    void retire(O *object) {
+
+        std::lock_guard<std::mutex> lock(retiredLock);
+
+        retired.push_back({object, [](void *toDelete) { Deleter()((O *) toDelete); }, epoch.load()});
+
+        if (retired.size() >= EPOCH_RECLAIM_THRESHOLD) {
+            reclaim();
+        }
+    }
+};
+
+#endif //TRABALHO1_EPOCHRECLAMATION_H
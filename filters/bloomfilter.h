@@ -9,7 +9,7 @@
 #define DEFAULT_HASH_FUNCTIONS 3
 #define DEFAULT_BLOOM_FILTER_SIZE 512000 //512KB default size
 
-unsigned int getRecommendedSizeFor(int hashFunctions, int itemCount, float failRate) {
+inline unsigned int getRecommendedSizeFor(int hashFunctions, int itemCount, float failRate) {
     return (unsigned int) ((hashFunctions * itemCount) / log10(2));
 }
 
@@ -35,16 +35,16 @@ private:
     std::unique_ptr<std::vector<uint8_t>> data;
 
 private:
-    unsigned int getHashFunction(int hashFunc, const void *key, uint32_t size) {
+    unsigned int getHashFunction(int hashFunc, const T &key) {
 
         static MurmurHash murmurHash;
 
         static SpookyHashImpl spookyHash;
 
         if (hashFunc % 2 == 0) {
-            return murmurHash.hashObject(key, size, hashFunc);
+            return KeyHash<T>::hash(murmurHash, key, hashFunc);
         } else {
-            return spookyHash.hashObject(key, size, hashFunc);
+            return KeyHash<T>::hash(spookyHash, key, hashFunc);
         }
     }
 
@@ -81,10 +81,20 @@ private:
 
 public:
     BloomFilter(unsigned int byteSize = DEFAULT_BLOOM_FILTER_SIZE, unsigned int hashFunctions = DEFAULT_HASH_FUNCTIONS)
-            : byteSize(byteSize), hashFunctionCount(hashFunctions) {
+            : byteSize(byteSize), items(0), hashFunctionCount(hashFunctions) {
         data = std::make_unique<std::vector<uint8_t>>(this->byteSize);
     };
 
+    /**
+     * A filter with the contents of another one, like one that was written to disk
+     *
+     * @param data The bytes of the filter, as returned by getData
+     */
+    BloomFilter(std::vector<uint8_t> data, unsigned int hashFunctions, unsigned int items)
+            : byteSize(data.size()), items(items), hashFunctionCount(hashFunctions) {
+        this->data = std::make_unique<std::vector<uint8_t>>(std::move(data));
+    }
+
     ~BloomFilter() {
         data.reset();
     }
@@ -93,7 +103,7 @@ public:
 
         for (int i = 0; i < hashFunctionCount; i++) {
 
-            unsigned int hash = getHashFunction(i, &key, sizeof(T));
+            unsigned int hash = getHashFunction(i, key);
 
             hash = calculatePositionFromHash(hash);
 
@@ -114,7 +124,7 @@ public:
 
         for (int i = 0; i < hashFunctionCount; i++) {
 
-            unsigned int hash = getHashFunction(i, &key, sizeof(T));
+            unsigned int hash = getHashFunction(i, key);
 
             hash = calculatePositionFromHash(hash);
 
@@ -134,6 +144,14 @@ public:
         return byteSize * UINT8_WIDTH;
     };
 
+    unsigned int getHashFunctionCount() const {
+        return this->hashFunctionCount;
+    }
+
+    const std::vector<uint8_t> &getData() const {
+        return *this->data;
+    }
+
 };
 
 
@@ -0,0 +1,137 @@
+#ifndef TRABALHO1_COUNTINGBLOOMFILTER_H
+#define TRABALHO1_COUNTINGBLOOMFILTER_H
+
+#include "../datastructures.h"
+#include "hashes/MurmurHash3.h"
+#include "hashes/SpookyV2.h"
+#include <cmath>
+#include <vector>
+
+//Bits of each counter, two counters fit in a byte
+#define COUNTER_BITS 4
+//A counter that got this high is stuck, decrementing it could make the filter forget a key that is still there
+#define COUNTER_MAX 15
+
+/**
+ * Bloom filter with a small counter instead of a bit in each position, so keys can be removed.
+ *
+ * Instead of running every hash function, the positions are derived from two hashes (Murmur and Spooky) as
+ * h1 + i * h2 (Kirsch and Mitzenmacher "Less Hashing, Same Performance"), which gives the same false positive rate.
+ */
+template<typename T>
+class CountingBloomFilter : public Filter<T> {
+
+private:
+    //Two 4 bit counters per byte
+    std::vector<uint8_t> counters;
+
+    unsigned int counterCount;
+
+    unsigned int hashFunctionCount;
+
+    unsigned int items;
+
+    MurmurHash murmurHash;
+
+    SpookyHashImpl spookyHash;
+
+    unsigned int getCounter(unsigned int position) const {
+        return (this->counters[position / 2] >> ((position % 2) * COUNTER_BITS)) & COUNTER_MAX;
+    }
+
+    void setCounter(unsigned int position, unsigned int value) {
+
+        unsigned int shift = (position % 2) * COUNTER_BITS;
+
+        uint8_t &byte = this->counters[position / 2];
+
+        byte = (uint8_t) ((byte & ~(COUNTER_MAX << shift)) | (value << shift));
+    }
+
+    /**
+     * Call the function with each position of the key
+     */
+    template<typename F>
+    void forEachPosition(const T &key, F function) {
+
+        unsigned int first = KeyHash<T>::hash(this->murmurHash, key),
+                second = KeyHash<T>::hash(this->spookyHash, key) | 1;
+
+        for (unsigned int i = 0; i < this->hashFunctionCount; i++) {
+            function((first + i * second) % this->counterCount);
+        }
+    }
+
+public:
+    CountingBloomFilter(unsigned int counterCount, unsigned int hashFunctions) : counters((counterCount + 1) / 2),
+                                                                              counterCount(counterCount),
+                                                                              hashFunctionCount(hashFunctions),
+                                                                              items(0) {}
+
+    /**
+     * A filter sized for the expected amount of keys with the given false positive rate
+     */
+    static std::unique_ptr<CountingBloomFilter<T>> forExpectedSize(unsigned int expectedKeys, double falsePositiveRate) {
+
+        double keys = std::max(expectedKeys, 1u);
+
+        //The usual optimal sizes, m = -n ln p / (ln 2)^2 and k = m / n ln 2
+        auto counters = (unsigned int) std::ceil(-keys * std::log(falsePositiveRate) / (std::log(2) * std::log(2)));
+
+        auto hashFunctions = (unsigned int) std::max(1.0, std::round(counters / keys * std::log(2)));
+
+        return std::make_unique<CountingBloomFilter<T>>(counters, hashFunctions);
+    }
+
+    bool test(const T &key) override {
+
+        unsigned int first = KeyHash<T>::hash(this->murmurHash, key),
+                second = KeyHash<T>::hash(this->spookyHash, key) | 1;
+
+        for (unsigned int i = 0; i < this->hashFunctionCount; i++) {
+            //A single empty counter is enough to know the key was never added
+            if (getCounter((first + i * second) % this->counterCount) == 0) return false;
+        }
+
+        return true;
+    }
+
+    void add(const T &key) override {
+
+        forEachPosition(key, [this](unsigned int position) {
+            unsigned int counter = getCounter(position);
+
+            if (counter < COUNTER_MAX) setCounter(position, counter + 1);
+        });
+
+        this->items++;
+    }
+
+    /**
+     * Remove a key that was added before. Removing a key that was never added can make the filter forget others
+     */
+    void remove(const T &key) {
+
+        forEachPosition(key, [this](unsigned int position) {
+            unsigned int counter = getCounter(position);
+
+            if (counter > 0 && counter < COUNTER_MAX) setCounter(position, counter - 1);
+        });
+
+        this->items--;
+    }
+
+    unsigned int size() override {
+        return this->items;
+    }
+
+    unsigned int getCounterCount() const {
+        return this->counterCount;
+    }
+
+    unsigned int getHashFunctionCount() const {
+        return this->hashFunctionCount;
+    }
+};
+
+#endif //TRABALHO1_COUNTINGBLOOMFILTER_H
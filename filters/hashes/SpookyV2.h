@@ -26,6 +26,9 @@
 // slower than MD5.
 //
 
+#ifndef _SPOOKYV2_H_
+#define _SPOOKYV2_H_
+
 #include <stddef.h>
 
 #ifdef _MSC_VER
@@ -426,4 +429,6 @@ public:
 
     };
 
-};
\ No newline at end of file
+};
+
+#endif // _SPOOKYV2_H_
@@ -0,0 +1,612 @@
+#ifndef TRABALHO1_CONCURRENTHASHMAP_H
+#define TRABALHO1_CONCURRENTHASHMAP_H
+
+#include "../datastructures.h"
+#include "../epochreclamation.h"
+#include "swisstable.h"
+#include <atomic>
+#include <thread>
+
+//Default amount of shards, each one has its own lock and its own table
+#define CONCURRENT_HASH_SHARDS 64
+//Slots in the table of a new shard
+#define CONCURRENT_HASH_INITIAL_CAPACITY 16
+//A shard is resized once 3/4 of its slots are used (Counting the removed ones)
+#define CONCURRENT_HASH_MAX_LOAD_NUMERATOR 3
+#define CONCURRENT_HASH_MAX_LOAD_DENOMINATOR 4
+//Slots of the old table that every write moves to the new one while a shard is being resized
+#define CONCURRENT_HASH_MIGRATE_STEP 32
+#define CONCURRENT_HASH_CACHE_LINE 64
+
+/**
+ * An entry is never changed once it's in a table, replacing a value puts a new entry in its slot. So a reader that
+ * loaded the entry pointer can always read the whole entry, as long as it's inside an epoch guard
+ */
+template<typename T, typename V>
+class ConcurrentHashEntry {
+
+private:
+    unsigned int hash;
+
+    std::shared_ptr<T> key;
+
+    std::shared_ptr<V> value;
+
+public:
+    ConcurrentHashEntry(unsigned int hash, std::shared_ptr<T> key, std::shared_ptr<V> value) : hash(hash),
+                                                                                               key(std::move(key)),
+                                                                                               value(std::move(
+                                                                                                       value)) {}
+
+    unsigned int getHash() const {
+        return hash;
+    }
+
+    const std::shared_ptr<T> &getKey() const {
+        return key;
+    }
+
+    const std::shared_ptr<V> &getValue() const {
+        return value;
+    }
+};
+
+/**
+ * Linear probing table of entry pointers. Only the writers of the shard change it, readers load the slots while they
+ * might be changing and check the shard's version afterwards
+ */
+template<typename T, typename V>
+struct ConcurrentHashBuckets {
+
+    size_t capacity;
+
+    //Slots that aren't empty, removed entries included. Only read and written with the shard locked
+    size_t used;
+
+    std::unique_ptr<std::atomic<ConcurrentHashEntry<T, V> *>[]> slots;
+
+    explicit ConcurrentHashBuckets(size_t capacity) : capacity(capacity), used(0),
+                                                      slots(new std::atomic<ConcurrentHashEntry<T, V> *>[capacity]) {
+
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+};
+
+template<typename T, typename V>
+struct alignas(CONCURRENT_HASH_CACHE_LINE) ConcurrentHashShard {
+
+    //Odd while a writer holds the shard
+    std::atomic_uint64_t version;
+
+    std::atomic<ConcurrentHashBuckets<T, V> *> current;
+
+    //The table that is being moved into current, null when the shard isn't being resized
+    std::atomic<ConcurrentHashBuckets<T, V> *> previous;
+
+    //How many slots of the previous table were already moved. Only used with the shard locked
+    size_t migrated;
+
+    std::atomic_uint count;
+
+    ConcurrentHashShard() : version(0), current(new ConcurrentHashBuckets<T, V>(CONCURRENT_HASH_INITIAL_CAPACITY)),
+                            previous(nullptr), migrated(0), count(0) {}
+
+    /**
+     * Wait until no writer holds the shard and get its version
+     */
+    uint64_t stableVersion() const {
+
+        uint64_t current = version.load(std::memory_order_acquire);
+
+        while ((current & 1) != 0) {
+            std::this_thread::yield();
+
+            current = version.load(std::memory_order_acquire);
+        }
+
+        return current;
+    }
+
+    /**
+     * Every slot is read with an acquire load, so none of them can be moved after this check
+     */
+    bool validate(uint64_t readVersion) const {
+        return version.load(std::memory_order_acquire) == readVersion;
+    }
+
+    void lock() {
+
+        uint64_t expected = stableVersion();
+
+        while (!version.compare_exchange_weak(expected, expected + 1, std::memory_order_acquire)) {
+            expected = stableVersion();
+        }
+    }
+
+    void unlock() {
+        version.fetch_add(1, std::memory_order_release);
+    }
+};
+
+/**
+ * Concurrent hash map split into a power of two of shards, each with its own open addressing table.
+ *
+ * Every shard is guarded by an optimistic version lock: readers take no locks and don't write to the shard, they read
+ * the shard's version, probe its table and check the version didn't change, retrying if a writer got in between.
+ * Writers lock the shard they hash to, so writers of different shards never wait for each other. Entries and tables
+ * that are replaced are freed through epoch based reclamation, since a reader might still be probing them. That is
+ * the one shared write a reader makes: entering and leaving the epoch changes a counter in the reclaimer slot its
+ * thread id hashes to, and threads whose ids land on the same slot share it.
+ *
+ * A full shard is resized incrementally: the new table replaces the old one right away, and every write to the shard
+ * moves the next CONCURRENT_HASH_MIGRATE_STEP slots of the old table into it, so no write has to rehash the whole
+ * shard. Until the move is done lookups probe the new table and then the old one.
+ */
+template<typename T, typename V>
+class ConcurrentHashMap : public Map<T, V> {
+
+private:
+    typedef ConcurrentHashEntry<T, V> Entry;
+
+    typedef ConcurrentHashBuckets<T, V> Buckets;
+
+    typedef ConcurrentHashShard<T, V> Shard;
+
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    std::unique_ptr<Shard[]> shards;
+
+    unsigned int shardMask;
+
+    unsigned int shardBits;
+
+    SpookyHashImpl hashFunction;
+
+    EpochReclaimer reclaimer;
+
+    /**
+     * Marks the slots of removed entries, so probes keep going past them
+     */
+    static Entry *tombstone() {
+
+        static Entry removed(0, nullptr, nullptr);
+
+        return &removed;
+    }
+
+    static bool isEntry(const Entry *entry) {
+        return entry != nullptr && entry != tombstone();
+    }
+
+    static size_t maxLoad(size_t capacity) {
+        return capacity * CONCURRENT_HASH_MAX_LOAD_NUMERATOR / CONCURRENT_HASH_MAX_LOAD_DENOMINATOR;
+    }
+
+    unsigned int hashKey(const T &key) {
+        return KeyHash<T>::hash(this->hashFunction, key);
+    }
+
+    Shard &shardFor(unsigned int hash) const {
+        return this->shards[hash & this->shardMask];
+    }
+
+    /**
+     * The low bits of the hash pick the shard, the others the slot
+     */
+    size_t startSlot(const Buckets *buckets, unsigned int hash) const {
+        return (hash >> this->shardBits) & (buckets->capacity - 1);
+    }
+
+    /**
+     * @return The slot with the key, NOT_FOUND if it isn't in the table
+     */
+    size_t findSlot(const Buckets *buckets, unsigned int hash, const T &key) const {
+
+        size_t mask = buckets->capacity - 1;
+
+        size_t slot = startSlot(buckets, hash);
+
+        for (size_t probes = 0; probes < buckets->capacity; probes++, slot = (slot + 1) & mask) {
+            Entry *entry = buckets->slots[slot].load(std::memory_order_acquire);
+
+            if (entry == nullptr) return NOT_FOUND;
+
+            if (entry != tombstone() && entry->getHash() == hash && *entry->getKey() == key) {
+                return slot;
+            }
+        }
+
+        return NOT_FOUND;
+    }
+
+    /**
+     * Put an entry whose key isn't in the table in the first free slot. The table must have room for it
+     */
+    void placeEntry(Buckets *buckets, Entry *entry) {
+
+        size_t mask = buckets->capacity - 1;
+
+        size_t slot = startSlot(buckets, entry->getHash());
+
+        while (isEntry(buckets->slots[slot].load(std::memory_order_relaxed))) {
+            slot = (slot + 1) & mask;
+        }
+
+        if (buckets->slots[slot].load(std::memory_order_relaxed) == nullptr) {
+            buckets->used++;
+        }
+
+        buckets->slots[slot].store(entry, std::memory_order_release);
+    }
+
+    /**
+     * Move up to steps slots of the old table of a shard that is being resized, and drop the old table once they
+     * were all moved. The moved slots become tombstones, the entries in the old table are always the latest ones
+     */
+    void migrate(Shard &shard, size_t steps) {
+
+        Buckets *previous = shard.previous.load(std::memory_order_relaxed);
+
+        if (previous == nullptr) return;
+
+        Buckets *current = shard.current.load(std::memory_order_relaxed);
+
+        for (; steps > 0 && shard.migrated < previous->capacity; steps--, shard.migrated++) {
+            Entry *entry = previous->slots[shard.migrated].load(std::memory_order_relaxed);
+
+            if (!isEntry(entry)) continue;
+
+            placeEntry(current, entry);
+
+            previous->slots[shard.migrated].store(tombstone(), std::memory_order_release);
+        }
+
+        if (shard.migrated == previous->capacity) {
+            shard.previous.store(nullptr, std::memory_order_release);
+
+            this->reclaimer.retire(previous);
+        }
+    }
+
+    /**
+     * Replace the table of the shard with an empty one, twice the size unless most of the used slots were removed
+     * entries. The entries get moved by the writes that come after
+     */
+    void startResize(Shard &shard) {
+
+        //Only one old table at a time
+        while (shard.previous.load(std::memory_order_relaxed) != nullptr) {
+            migrate(shard, SIZE_MAX);
+        }
+
+        Buckets *current = shard.current.load(std::memory_order_relaxed);
+
+        size_t capacity = current->capacity;
+
+        if (shard.count.load(std::memory_order_relaxed) * 2 >= maxLoad(capacity)) {
+            capacity *= 2;
+        }
+
+        shard.migrated = 0;
+
+        shard.previous.store(current, std::memory_order_release);
+        shard.current.store(new Buckets(capacity), std::memory_order_release);
+    }
+
+    /**
+     * Add an entry whose key isn't in the shard, which has to be locked
+     */
+    void insertNew(Shard &shard, Entry *entry) {
+
+        Buckets *current = shard.current.load(std::memory_order_relaxed);
+
+        if (current->used + 1 > maxLoad(current->capacity)) {
+            startResize(shard);
+
+            current = shard.current.load(std::memory_order_relaxed);
+        }
+
+        placeEntry(current, entry);
+
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Find the entry of the key without taking any lock. Must be called inside an epoch guard
+     */
+    Entry *lookup(const T &key) {
+
+        unsigned int hash = hashKey(key);
+
+        Shard &shard = shardFor(hash);
+
+        while (true) {
+            uint64_t version = shard.stableVersion();
+
+            Buckets *current = shard.current.load(std::memory_order_acquire),
+                    *previous = shard.previous.load(std::memory_order_acquire);
+
+            Entry *entry = nullptr;
+
+            size_t slot = findSlot(current, hash, key);
+
+            if (slot != NOT_FOUND) {
+                entry = current->slots[slot].load(std::memory_order_acquire);
+            } else if (previous != nullptr && (slot = findSlot(previous, hash, key)) != NOT_FOUND) {
+                entry = previous->slots[slot].load(std::memory_order_acquire);
+            }
+
+            if (shard.validate(version)) {
+                return entry;
+            }
+        }
+    }
+
+    /**
+     * Find the slot of the key in either table of a locked shard
+     * @param buckets Gets the table the slot is in
+     */
+    size_t lockedFind(Shard &shard, unsigned int hash, const T &key, Buckets **buckets) {
+
+        *buckets = shard.current.load(std::memory_order_relaxed);
+
+        size_t slot = findSlot(*buckets, hash, key);
+
+        if (slot == NOT_FOUND && shard.previous.load(std::memory_order_relaxed) != nullptr) {
+            *buckets = shard.previous.load(std::memory_order_relaxed);
+
+            slot = findSlot(*buckets, hash, key);
+        }
+
+        return slot;
+    }
+
+    /**
+     * @param replace Whether an existing value gets replaced
+     * @return Whether the key was added
+     */
+    bool put(std::shared_ptr<T> key, std::shared_ptr<V> value, bool replace) {
+
+        auto guard = this->reclaimer.enter();
+
+        unsigned int hash = hashKey(*key);
+
+        Shard &shard = shardFor(hash);
+
+        shard.lock();
+
+        migrate(shard, CONCURRENT_HASH_MIGRATE_STEP);
+
+        Buckets *buckets;
+
+        size_t slot = lockedFind(shard, hash, *key, &buckets);
+
+        bool added = slot == NOT_FOUND;
+
+        if (added) {
+            insertNew(shard, new Entry(hash, std::move(key), std::move(value)));
+        } else if (replace) {
+            Entry *old = buckets->slots[slot].load(std::memory_order_relaxed);
+
+            buckets->slots[slot].store(new Entry(hash, std::move(key), std::move(value)), std::memory_order_release);
+
+            this->reclaimer.retire(old);
+        }
+
+        shard.unlock();
+
+        return added;
+    }
+
+    /**
+     * Every entry of every shard, each shard is locked while it's read
+     */
+    template<typename F>
+    void forEach(F function) {
+
+        auto guard = this->reclaimer.enter();
+
+        for (unsigned int i = 0; i <= this->shardMask; i++) {
+            Shard &shard = this->shards[i];
+
+            shard.lock();
+
+            for (Buckets *buckets : {shard.current.load(std::memory_order_relaxed),
+                                     shard.previous.load(std::memory_order_relaxed)}) {
+                if (buckets == nullptr) continue;
+
+                for (size_t slot = 0; slot < buckets->capacity; slot++) {
+                    Entry *entry = buckets->slots[slot].load(std::memory_order_relaxed);
+
+                    if (isEntry(entry)) function(entry);
+                }
+            }
+
+            shard.unlock();
+        }
+    }
+
+public:
+    /**
+     * @param shardCount Rounded up to a power of two
+     */
+    explicit ConcurrentHashMap(unsigned int shardCount = CONCURRENT_HASH_SHARDS) : shardBits(0) {
+
+        while ((1u << this->shardBits) < shardCount) {
+            this->shardBits++;
+        }
+
+        this->shardMask = (1u << this->shardBits) - 1;
+
+        this->shards = std::make_unique<Shard[]>(this->shardMask + 1);
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+
+    ~ConcurrentHashMap() {
+
+        for (unsigned int i = 0; i <= this->shardMask; i++) {
+            for (Buckets *buckets : {this->shards[i].current.load(), this->shards[i].previous.load()}) {
+                if (buckets == nullptr) continue;
+
+                for (size_t slot = 0; slot < buckets->capacity; slot++) {
+                    Entry *entry = buckets->slots[slot].load();
+
+                    if (isEntry(entry)) delete entry;
+                }
+
+                delete buckets;
+            }
+        }
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+        put(std::move(key), std::move(value), true);
+    }
+
+    /**
+     * @return Whether the key was added, a key that is already in the map keeps its value
+     */
+    bool addIfAbsent(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+        return put(std::move(key), std::move(value), false);
+    }
+
+    bool hasKey(const T &key) override {
+
+        auto guard = this->reclaimer.enter();
+
+        return lookup(key) != nullptr;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        auto guard = this->reclaimer.enter();
+
+        Entry *entry = lookup(key);
+
+        if (entry == nullptr) return std::nullopt;
+
+        return entry->getValue();
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        auto guard = this->reclaimer.enter();
+
+        unsigned int hash = hashKey(key);
+
+        Shard &shard = shardFor(hash);
+
+        shard.lock();
+
+        migrate(shard, CONCURRENT_HASH_MIGRATE_STEP);
+
+        Buckets *buckets;
+
+        size_t slot = lockedFind(shard, hash, key, &buckets);
+
+        std::optional<std::shared_ptr<V>> result = std::nullopt;
+
+        if (slot != NOT_FOUND) {
+            Entry *entry = buckets->slots[slot].load(std::memory_order_relaxed);
+
+            buckets->slots[slot].store(tombstone(), std::memory_order_release);
+
+            shard.count.fetch_sub(1, std::memory_order_relaxed);
+
+            result = entry->getValue();
+
+            this->reclaimer.retire(entry);
+        }
+
+        shard.unlock();
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        forEach([&results](Entry *entry) {
+            results->push_back(entry->getKey());
+        });
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        forEach([&results](Entry *entry) {
+            results->push_back(entry->getValue());
+        });
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        forEach([&results](Entry *entry) {
+            results->push_back(std::make_tuple(entry->getKey(), entry->getValue()));
+        });
+
+        return results;
+    }
+
+    unsigned int size() override {
+
+        unsigned int total = 0;
+
+        for (unsigned int i = 0; i <= this->shardMask; i++) {
+            total += this->shards[i].count.load(std::memory_order_relaxed);
+        }
+
+        return total;
+    }
+};
+
+/**
+ * Concurrent hash set on a ConcurrentHashMap, every key is stored as its own value
+ */
+template<typename T>
+class ConcurrentHashSet : public Set<T> {
+
+private:
+    ConcurrentHashMap<T, T> map;
+
+public:
+    explicit ConcurrentHashSet(unsigned int shardCount = CONCURRENT_HASH_SHARDS) : map(shardCount) {}
+
+    void add(const T &key) override {
+
+        auto stored = std::make_shared<T>(key);
+
+        this->map.addIfAbsent(stored, stored);
+    }
+
+    bool contains(const T &key) override {
+        return this->map.hasKey(key);
+    }
+
+    std::shared_ptr<T> find(const T &key) override {
+        return this->map.get(key).value_or(nullptr);
+    }
+
+    std::shared_ptr<T> remove(const T &key) override {
+        return this->map.remove(key).value_or(nullptr);
+    }
+
+    unsigned int size() override {
+        return this->map.size();
+    }
+};
+
+#endif //TRABALHO1_CONCURRENTHASHMAP_H
@@ -0,0 +1,521 @@
+#ifndef TRABALHO1_SWISSTABLE_H
+#define TRABALHO1_SWISSTABLE_H
+
+#include "../datastructures.h"
+#include "../filters/hashes/MurmurHash3.h"
+#include "../filters/hashes/SpookyV2.h"
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//Slots per group, a group of control bytes is compared with a single SSE2 instruction
+#define SWISS_GROUP_SIZE 16
+//The table grows once it is 7/8 full (Counting the tombstones)
+#define SWISS_MAX_LOAD_NUMERATOR 7
+#define SWISS_MAX_LOAD_DENOMINATOR 8
+
+//Control byte of a slot that was never used. Full slots have the 7 low bits of their hash, so the top bit is clear
+#define SWISS_EMPTY ((int8_t) -128)
+//Control byte of a slot whose key was removed. Lookups have to keep probing past it
+#define SWISS_DELETED ((int8_t) -2)
+
+/**
+ * A group of control bytes, and the bit masks of its slots that match something
+ */
+class SwissGroup {
+
+private:
+#if defined(__SSE2__)
+    __m128i controls;
+#else
+    const int8_t *controls;
+#endif
+
+public:
+    explicit SwissGroup(const int8_t *controls) {
+#if defined(__SSE2__)
+        this->controls = _mm_loadu_si128((const __m128i *) controls);
+#else
+        this->controls = controls;
+#endif
+    }
+
+    uint32_t match(int8_t control) const {
+#if defined(__SSE2__)
+        return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(control), this->controls));
+#else
+        uint32_t mask = 0;
+
+        for (int i = 0; i < SWISS_GROUP_SIZE; i++) {
+            mask |= (uint32_t) (this->controls[i] == control) << i;
+        }
+
+        return mask;
+#endif
+    }
+
+    uint32_t matchEmpty() const {
+        return match(SWISS_EMPTY);
+    }
+
+    /**
+     * Empty and deleted are the only control bytes with the top bit set
+     */
+    uint32_t matchEmptyOrDeleted() const {
+#if defined(__SSE2__)
+        return (uint32_t) _mm_movemask_epi8(this->controls);
+#else
+        uint32_t mask = 0;
+
+        for (int i = 0; i < SWISS_GROUP_SIZE; i++) {
+            mask |= (uint32_t) (this->controls[i] < 0) << i;
+        }
+
+        return mask;
+#endif
+    }
+};
+
+/**
+ * Open addressing hash table in the style of Abseil's Swiss tables, shared by SwissSet and SwissMap.
+ *
+ * Every slot has a control byte with 7 bits of the hash of its key (H2), the rest of the hash (H1) picks the group the
+ * probing starts in. A lookup compares the H2 of the key with the 16 control bytes of a group at once, and only looks
+ * at the slots that match, so it almost never compares a key that isn't the one it's after. The probing goes over
+ * whole groups (Quadratically, which visits every group since there is a power of two of them) and stops at the
+ * first group with an empty slot.
+ *
+ * Removed slots become tombstones, unless their group still has an empty slot (Then no probe ever went past it and it
+ * can be empty again). Tombstones count towards the load, once the table is full it's rehashed, to twice the size or
+ * to the same size when it's mostly tombstones.
+ *
+ * @tparam Entry What each slot holds
+ * @tparam KeyOf Gets the key of an entry, with a static key(const Entry &)
+ * @tparam H The HashFunction, SpookyHashImpl (A little faster for short keys) or MurmurHash
+ */
+template<typename T, typename Entry, typename KeyOf, typename H = SpookyHashImpl>
+class SwissTable {
+
+private:
+    int8_t *controls;
+
+    Entry *slots;
+
+    size_t capacity;
+
+    size_t tableSize;
+
+    //How many more empty slots can be filled before the table has to be rehashed
+    size_t growthLeft;
+
+    H hashFunction;
+
+    static size_t maxLoad(size_t capacity) {
+        return capacity * SWISS_MAX_LOAD_NUMERATOR / SWISS_MAX_LOAD_DENOMINATOR;
+    }
+
+    static int8_t h2(unsigned int hash) {
+        return (int8_t) (hash & 0x7F);
+    }
+
+    static size_t h1(unsigned int hash) {
+        return hash >> 7;
+    }
+
+    unsigned int hashKey(const T &key) {
+        return KeyHash<T>::hash(this->hashFunction, key);
+    }
+
+    size_t groupMask() const {
+        return this->capacity / SWISS_GROUP_SIZE - 1;
+    }
+
+    void allocate(size_t capacity) {
+
+        this->capacity = capacity;
+        this->growthLeft = maxLoad(capacity);
+
+        this->controls = new int8_t[capacity];
+
+        memset(this->controls, SWISS_EMPTY, capacity);
+
+        this->slots = static_cast<Entry *>(::operator new(capacity * sizeof(Entry)));
+    }
+
+    void deallocate() {
+
+        for (size_t i = 0; i < this->capacity; i++) {
+            if (this->controls[i] >= 0) this->slots[i].~Entry();
+        }
+
+        delete[] this->controls;
+
+        ::operator delete(this->slots);
+    }
+
+    /**
+     * The first slot that is empty or deleted in the probe sequence of the hash
+     */
+    size_t findFreeSlot(unsigned int hash) const {
+
+        size_t group = h1(hash) & groupMask();
+
+        for (size_t step = 1;; step++) {
+            uint32_t free = SwissGroup(this->controls + group * SWISS_GROUP_SIZE).matchEmptyOrDeleted();
+
+            if (free != 0) {
+                return group * SWISS_GROUP_SIZE + __builtin_ctz(free);
+            }
+
+            group = (group + step) & groupMask();
+        }
+    }
+
+    /**
+     * Move every entry to new arrays of the given capacity, which drops the tombstones
+     */
+    void rehash(size_t newCapacity) {
+
+        int8_t *oldControls = this->controls;
+
+        Entry *oldSlots = this->slots;
+
+        size_t oldCapacity = this->capacity;
+
+        allocate(newCapacity);
+
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldControls[i] < 0) continue;
+
+            const T &key = KeyOf::key(oldSlots[i]);
+
+            unsigned int hash = hashKey(key);
+
+            size_t slot = findFreeSlot(hash);
+
+            this->controls[slot] = h2(hash);
+
+            new(&this->slots[slot]) Entry(std::move(oldSlots[i]));
+
+            oldSlots[i].~Entry();
+        }
+
+        this->growthLeft -= this->tableSize;
+
+        delete[] oldControls;
+
+        ::operator delete(oldSlots);
+    }
+
+public:
+    SwissTable() : tableSize(0) {
+        allocate(SWISS_GROUP_SIZE);
+    }
+
+    SwissTable(const SwissTable &) = delete;
+
+    SwissTable &operator=(const SwissTable &) = delete;
+
+    ~SwissTable() {
+        deallocate();
+    }
+
+    size_t size() const {
+        return this->tableSize;
+    }
+
+    size_t getCapacity() const {
+        return this->capacity;
+    }
+
+    /**
+     * @return The entry with the key, null if there is none
+     */
+    Entry *find(const T &key) {
+
+        unsigned int hash = hashKey(key);
+
+        int8_t control = h2(hash);
+
+        size_t group = h1(hash) & groupMask();
+
+        for (size_t step = 1;; step++) {
+            SwissGroup controlGroup(this->controls + group * SWISS_GROUP_SIZE);
+
+            for (uint32_t matches = controlGroup.match(control); matches != 0; matches &= matches - 1) {
+                size_t slot = group * SWISS_GROUP_SIZE + __builtin_ctz(matches);
+
+                if (KeyOf::key(this->slots[slot]) == key) {
+                    return &this->slots[slot];
+                }
+            }
+
+            //The key would have been put in this empty slot, or in one before it
+            if (controlGroup.matchEmpty() != 0) {
+                return nullptr;
+            }
+
+            group = (group + step) & groupMask();
+        }
+    }
+
+    /**
+     * Insert an entry whose key isn't in the table
+     * @return The entry in the table
+     */
+    Entry *insertNew(const T &key, Entry entry) {
+
+        unsigned int hash = hashKey(key);
+
+        size_t slot = findFreeSlot(hash);
+
+        //Tombstones can be reused without using up an empty slot
+        if (this->controls[slot] == SWISS_EMPTY && this->growthLeft == 0) {
+            //Mostly tombstones, rehashing to the same size is enough to make room
+            rehash(this->tableSize * 2 < maxLoad(this->capacity) ? this->capacity : this->capacity * 2);
+
+            slot = findFreeSlot(hash);
+        }
+
+        if (this->controls[slot] == SWISS_EMPTY) {
+            this->growthLeft--;
+        }
+
+        this->controls[slot] = h2(hash);
+
+        this->tableSize++;
+
+        return new(&this->slots[slot]) Entry(std::move(entry));
+    }
+
+    /**
+     * Remove an entry returned by find
+     */
+    Entry erase(Entry *entry) {
+
+        size_t slot = entry - this->slots;
+
+        Entry removed = std::move(*entry);
+
+        entry->~Entry();
+
+        size_t groupStart = slot - slot % SWISS_GROUP_SIZE;
+
+        //With an empty slot in the group every probe stops here anyway, so nothing needs a tombstone
+        if (SwissGroup(this->controls + groupStart).matchEmpty() != 0) {
+            this->controls[slot] = SWISS_EMPTY;
+
+            this->growthLeft++;
+        } else {
+            this->controls[slot] = SWISS_DELETED;
+        }
+
+        this->tableSize--;
+
+        return removed;
+    }
+
+    /**
+     * Make room for the given amount of entries without any rehash
+     */
+    void reserve(size_t entries) {
+
+        size_t newCapacity = this->capacity;
+
+        while (maxLoad(newCapacity) < entries) {
+            newCapacity *= 2;
+        }
+
+        if (newCapacity != this->capacity) {
+            rehash(newCapacity);
+        }
+    }
+
+    template<typename F>
+    void forEach(F function) {
+
+        for (size_t i = 0; i < this->capacity; i++) {
+            if (this->controls[i] >= 0) function(this->slots[i]);
+        }
+    }
+};
+
+template<typename T>
+struct SwissSetKey {
+
+    static const T &key(const T &entry) {
+        return entry;
+    }
+};
+
+/**
+ * Hash set on a SwissTable. The keys are stored in the slots themselves, so find and remove give back a copy of the
+ * key
+ */
+template<typename T, typename H = SpookyHashImpl>
+class SwissSet : public Set<T> {
+
+private:
+    SwissTable<T, T, SwissSetKey<T>, H> table;
+
+public:
+    SwissSet() = default;
+
+    explicit SwissSet(size_t expectedSize) {
+        this->table.reserve(expectedSize);
+    }
+
+    void add(const T &key) override {
+
+        if (this->table.find(key) == nullptr) {
+            this->table.insertNew(key, key);
+        }
+    }
+
+    bool contains(const T &key) override {
+        return this->table.find(key) != nullptr;
+    }
+
+    std::shared_ptr<T> find(const T &key) override {
+
+        T *entry = this->table.find(key);
+
+        if (entry == nullptr) return nullptr;
+
+        return std::make_shared<T>(*entry);
+    }
+
+    std::shared_ptr<T> remove(const T &key) override {
+
+        T *entry = this->table.find(key);
+
+        if (entry == nullptr) return nullptr;
+
+        return std::make_shared<T>(this->table.erase(entry));
+    }
+
+    unsigned int size() override {
+        return this->table.size();
+    }
+
+    size_t capacity() const {
+        return this->table.getCapacity();
+    }
+};
+
+template<typename T, typename V>
+struct SwissMapKey {
+
+    static const T &key(const node_info<T, V> &entry) {
+        return *std::get<0>(entry);
+    }
+};
+
+/**
+ * Unordered map on a SwissTable, the companion of SwissSet. The slots hold the key and value pointers, so finding a
+ * key only follows the key pointer of the slots whose control byte matched
+ */
+template<typename T, typename V, typename H = SpookyHashImpl>
+class SwissMap : public Map<T, V> {
+
+private:
+    SwissTable<T, node_info<T, V>, SwissMapKey<T, V>, H> table;
+
+public:
+    SwissMap() = default;
+
+    explicit SwissMap(size_t expectedSize) {
+        this->table.reserve(expectedSize);
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        node_info<T, V> *entry = this->table.find(*key);
+
+        if (entry != nullptr) {
+            std::get<1>(*entry) = std::move(value);
+
+            return;
+        }
+
+        const T &keyValue = *key;
+
+        this->table.insertNew(keyValue, std::make_tuple(std::move(key), std::move(value)));
+    }
+
+    bool hasKey(const T &key) override {
+        return this->table.find(key) != nullptr;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        node_info<T, V> *entry = this->table.find(key);
+
+        if (entry == nullptr) return std::nullopt;
+
+        return std::get<1>(*entry);
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        node_info<T, V> *entry = this->table.find(key);
+
+        if (entry == nullptr) return std::nullopt;
+
+        return std::get<1>(this->table.erase(entry));
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        results->reserve(this->table.size());
+
+        this->table.forEach([&results](node_info<T, V> &entry) {
+            results->push_back(std::get<0>(entry));
+        });
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        results->reserve(this->table.size());
+
+        this->table.forEach([&results](node_info<T, V> &entry) {
+            results->push_back(std::get<1>(entry));
+        });
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        results->reserve(this->table.size());
+
+        this->table.forEach([&results](node_info<T, V> &entry) {
+            results->push_back(entry);
+        });
+
+        return results;
+    }
+
+    unsigned int size() override {
+        return this->table.size();
+    }
+
+    size_t capacity() const {
+        return this->table.getCapacity();
+    }
+};
+
+#endif //TRABALHO1_SWISSTABLE_H
@@ -0,0 +1,140 @@
+#ifndef TRABALHO1_DARYHEAP_H
+#define TRABALHO1_DARYHEAP_H
+
+#include "../datastructures.h"
+#include <algorithm>
+
+//The 4 int keys of the children of a node take 16 contiguous bytes, so they span at most 2 cache lines
+#define DEFAULT_HEAP_ARITY 4
+
+/**
+ * Implicit heap where every node has D children instead of 2.
+ *
+ * The tree is half as tall as a binary heap (For D = 4), and the D children that are compared when going down are
+ * next to each other in memory. The keys and the values are kept in separate arrays, so the comparisons only touch
+ * the keys and never the reference counts of the values.
+ *
+ * Moves use a hole instead of swaps: the element that is going up or down is only written once, at the end.
+ */
+template<typename T, typename V, unsigned int D = DEFAULT_HEAP_ARITY>
+class DaryHeap : public PriorityQueue<T, V> {
+
+    static_assert(D >= 2, "A heap needs at least 2 children per node");
+
+private:
+    std::vector<T> heapKeys;
+
+    std::vector<std::shared_ptr<V>> heapValues;
+
+    void siftUp(size_t position) {
+
+        T key = std::move(this->heapKeys[position]);
+        std::shared_ptr<V> value = std::move(this->heapValues[position]);
+
+        while (position > 0) {
+            size_t parent = (position - 1) / D;
+
+            if (!(key < this->heapKeys[parent])) break;
+
+            this->heapKeys[position] = std::move(this->heapKeys[parent]);
+            this->heapValues[position] = std::move(this->heapValues[parent]);
+
+            position = parent;
+        }
+
+        this->heapKeys[position] = std::move(key);
+        this->heapValues[position] = std::move(value);
+    }
+
+    void siftDown(size_t position) {
+
+        size_t heapSize = this->heapKeys.size();
+
+        T key = std::move(this->heapKeys[position]);
+        std::shared_ptr<V> value = std::move(this->heapValues[position]);
+
+        while (true) {
+            size_t firstChild = position * D + 1;
+
+            if (firstChild >= heapSize) break;
+
+            size_t lastChild = std::min(firstChild + D, heapSize), smallest = firstChild;
+
+            for (size_t child = firstChild + 1; child < lastChild; child++) {
+                if (this->heapKeys[child] < this->heapKeys[smallest]) {
+                    smallest = child;
+                }
+            }
+
+            if (!(this->heapKeys[smallest] < key)) break;
+
+            this->heapKeys[position] = std::move(this->heapKeys[smallest]);
+            this->heapValues[position] = std::move(this->heapValues[smallest]);
+
+            position = smallest;
+        }
+
+        this->heapKeys[position] = std::move(key);
+        this->heapValues[position] = std::move(value);
+    }
+
+public:
+    DaryHeap() = default;
+
+    explicit DaryHeap(unsigned int expectedSize) {
+        this->heapKeys.reserve(expectedSize);
+        this->heapValues.reserve(expectedSize);
+    }
+
+    void push(const T &key, std::shared_ptr<V> value) override {
+
+        this->heapKeys.push_back(key);
+        this->heapValues.push_back(std::move(value));
+
+        siftUp(this->heapKeys.size() - 1);
+    }
+
+    std::optional<heap_entry<T, V>> peekSmallest() override {
+
+        if (this->heapKeys.empty()) return std::nullopt;
+
+        return std::make_pair(this->heapKeys[0], this->heapValues[0]);
+    }
+
+    std::optional<heap_entry<T, V>> popSmallest() override {
+
+        if (this->heapKeys.empty()) return std::nullopt;
+
+        heap_entry<T, V> result = std::make_pair(std::move(this->heapKeys[0]), std::move(this->heapValues[0]));
+
+        //The last element fills the hole at the root and then sinks to its place
+        this->heapKeys[0] = std::move(this->heapKeys.back());
+        this->heapValues[0] = std::move(this->heapValues.back());
+
+        this->heapKeys.pop_back();
+        this->heapValues.pop_back();
+
+        if (!this->heapKeys.empty()) {
+            siftDown(0);
+        }
+
+        return result;
+    }
+
+    /**
+     * The smallest key without copying it, the heap must not be empty
+     */
+    const T &smallestKey() const {
+        return this->heapKeys[0];
+    }
+
+    bool empty() const {
+        return this->heapKeys.empty();
+    }
+
+    unsigned int size() override {
+        return this->heapKeys.size();
+    }
+};
+
+#endif //TRABALHO1_DARYHEAP_H
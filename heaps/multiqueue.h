@@ -0,0 +1,160 @@
+#ifndef TRABALHO1_MULTIQUEUE_H
+#define TRABALHO1_MULTIQUEUE_H
+
+#include "daryheap.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+//How many heaps there are for each thread
+#define MULTI_QUEUE_FACTOR 2
+//How many times a pop picks two random heaps before going through all of them
+#define MULTI_QUEUE_ATTEMPTS 32
+#define MULTI_QUEUE_CACHE_LINE 64
+
+template<typename T, typename V>
+struct alignas(MULTI_QUEUE_CACHE_LINE) MultiQueueShard {
+    std::mutex lock;
+
+    DaryHeap<T, V> heap;
+};
+
+/**
+ * Relaxed concurrent priority queue (Rihani, Sanders and Dementiev "MultiQueues").
+ *
+ * There are c * p sequential heaps, each with its own lock. A push goes to a random heap, and a pop looks at two
+ * random heaps and takes the smallest key of the better one. No lock is ever waited on: if a heap is busy, the
+ * thread just picks others, so threads almost never contend.
+ *
+ * The popped key is not always the smallest one in the queue, but its expected rank is O(p).
+ */
+template<typename T, typename V>
+class MultiQueue : public PriorityQueue<T, V> {
+
+private:
+    std::unique_ptr<MultiQueueShard<T, V>[]> shards;
+
+    unsigned int shardCount;
+
+    std::atomic_uint32_t queueSize;
+
+    static uint64_t nextRandom() {
+
+        //xorshift64, every thread has its own state
+        static thread_local uint64_t state =
+                (uint64_t) std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        return state;
+    }
+
+    /**
+     * Go through every heap, waiting for the locks. For when the random picks keep finding empty or busy heaps
+     */
+    std::optional<heap_entry<T, V>> popFromAny() {
+
+        for (unsigned int i = 0; i < this->shardCount; i++) {
+            std::lock_guard<std::mutex> lock(this->shards[i].lock);
+
+            if (!this->shards[i].heap.empty()) {
+                this->queueSize.fetch_sub(1, std::memory_order_relaxed);
+
+                return this->shards[i].heap.popSmallest();
+            }
+        }
+
+        return std::nullopt;
+    }
+
+public:
+    /**
+     * @param threadCount How many threads are going to use the queue at the same time
+     */
+    explicit MultiQueue(unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency())) :
+            shardCount(std::max(2u, threadCount * MULTI_QUEUE_FACTOR)), queueSize(0) {
+
+        this->shards = std::make_unique<MultiQueueShard<T, V>[]>(this->shardCount);
+    }
+
+    void push(const T &key, std::shared_ptr<V> value) override {
+
+        while (true) {
+            MultiQueueShard<T, V> &shard = this->shards[nextRandom() % this->shardCount];
+
+            std::unique_lock<std::mutex> lock(shard.lock, std::try_to_lock);
+
+            if (!lock.owns_lock()) continue;
+
+            shard.heap.push(key, std::move(value));
+
+            this->queueSize.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+        }
+    }
+
+    /**
+     * Only approximate while other threads are changing the queue
+     */
+    std::optional<heap_entry<T, V>> peekSmallest() override {
+
+        std::optional<heap_entry<T, V>> smallest;
+
+        for (unsigned int i = 0; i < this->shardCount; i++) {
+            std::lock_guard<std::mutex> lock(this->shards[i].lock);
+
+            if (!this->shards[i].heap.empty() &&
+                (!smallest || this->shards[i].heap.smallestKey() < smallest->first)) {
+                smallest = this->shards[i].heap.peekSmallest();
+            }
+        }
+
+        return smallest;
+    }
+
+    std::optional<heap_entry<T, V>> popSmallest() override {
+
+        for (int attempt = 0; attempt < MULTI_QUEUE_ATTEMPTS; attempt++) {
+
+            if (this->queueSize.load(std::memory_order_relaxed) == 0) return std::nullopt;
+
+            uint64_t random = nextRandom();
+
+            unsigned int first = random % this->shardCount,
+                    second = (first + 1 + (random >> 32) % (this->shardCount - 1)) % this->shardCount;
+
+            std::unique_lock<std::mutex> firstLock(this->shards[first].lock, std::try_to_lock);
+
+            if (!firstLock.owns_lock()) continue;
+
+            std::unique_lock<std::mutex> secondLock(this->shards[second].lock, std::try_to_lock);
+
+            if (!secondLock.owns_lock()) continue;
+
+            DaryHeap<T, V> *firstHeap = &this->shards[first].heap, *secondHeap = &this->shards[second].heap;
+
+            if (firstHeap->empty() && secondHeap->empty()) continue;
+
+            DaryHeap<T, V> *better = firstHeap;
+
+            if (firstHeap->empty() || (!secondHeap->empty() && secondHeap->smallestKey() < firstHeap->smallestKey())) {
+                better = secondHeap;
+            }
+
+            this->queueSize.fetch_sub(1, std::memory_order_relaxed);
+
+            return better->popSmallest();
+        }
+
+        return popFromAny();
+    }
+
+    unsigned int size() override {
+        return this->queueSize.load(std::memory_order_relaxed);
+    }
+};
+
+#endif //TRABALHO1_MULTIQUEUE_H
@@ -0,0 +1,271 @@
+#ifndef TRABALHO1_PAIRINGHEAP_H
+#define TRABALHO1_PAIRINGHEAP_H
+
+#include "../datastructures.h"
+
+template<typename T, typename V>
+class PairingNode {
+
+private:
+    T key;
+
+    std::shared_ptr<V> value;
+
+    //The first child, the rest of the children hang from its sibling list
+    PairingNode<T, V> *child;
+
+    PairingNode<T, V> *sibling;
+
+    //The parent for the first child, the left sibling for the others. Lets a node be cut out in O(1)
+    PairingNode<T, V> *previous;
+
+public:
+    PairingNode(const T &key, std::shared_ptr<V> value) : key(key), value(std::move(value)), child(nullptr),
+                                                          sibling(nullptr), previous(nullptr) {}
+
+    const T &getKey() const {
+        return key;
+    }
+
+    void setKey(const T &key) {
+        this->key = key;
+    }
+
+    const std::shared_ptr<V> &getValue() const {
+        return value;
+    }
+
+    std::shared_ptr<V> &getValueRef() {
+        return value;
+    }
+
+    PairingNode<T, V> *getChild() const {
+        return child;
+    }
+
+    void setChild(PairingNode<T, V> *child) {
+        this->child = child;
+    }
+
+    PairingNode<T, V> *getSibling() const {
+        return sibling;
+    }
+
+    void setSibling(PairingNode<T, V> *sibling) {
+        this->sibling = sibling;
+    }
+
+    PairingNode<T, V> *getPrevious() const {
+        return previous;
+    }
+
+    void setPrevious(PairingNode<T, V> *previous) {
+        this->previous = previous;
+    }
+};
+
+/**
+ * Pairing heap, a heap ordered multiway tree.
+ *
+ * Pushing and decreasing a key are O(1): the node just gets melded with the root. All the work is delayed to the
+ * pop, which pairs up the children of the root from left to right and then melds the pairs from right to left
+ * (Amortized O(log n)).
+ *
+ * Unlike the array heaps, every entry has a node that doesn't move, so push returns a handle that can be used to
+ * decrease the key of the entry later (As needed by Dijkstra or Prim). A handle stays valid until its entry is popped.
+ */
+template<typename T, typename V>
+class PairingHeap : public PriorityQueue<T, V> {
+
+private:
+    PairingNode<T, V> *root;
+
+    unsigned int heapSize;
+
+    /**
+     * Join two trees without siblings, the one with the larger root becomes the first child of the other
+     */
+    static PairingNode<T, V> *meld(PairingNode<T, V> *first, PairingNode<T, V> *second) {
+
+        if (first == nullptr) return second;
+        if (second == nullptr) return first;
+
+        if (second->getKey() < first->getKey()) {
+            std::swap(first, second);
+        }
+
+        second->setPrevious(first);
+        second->setSibling(first->getChild());
+
+        if (first->getChild() != nullptr) {
+            first->getChild()->setPrevious(second);
+        }
+
+        first->setChild(second);
+        first->setSibling(nullptr);
+        first->setPrevious(nullptr);
+
+        return first;
+    }
+
+    /**
+     * The two pass pairing of a sibling list, done without recursion so long lists can't overflow the stack
+     */
+    static PairingNode<T, V> *mergePairs(PairingNode<T, V> *first) {
+
+        if (first == nullptr) return nullptr;
+
+        //First pass, meld the siblings in pairs from left to right, linking the results backwards through previous
+        PairingNode<T, V> *lastPair = nullptr;
+
+        while (first != nullptr) {
+            PairingNode<T, V> *second = first->getSibling();
+
+            PairingNode<T, V> *next = second == nullptr ? nullptr : second->getSibling();
+
+            first->setSibling(nullptr);
+
+            if (second != nullptr) second->setSibling(nullptr);
+
+            PairingNode<T, V> *pair = meld(first, second);
+
+            pair->setPrevious(lastPair);
+
+            lastPair = pair;
+
+            first = next;
+        }
+
+        //Second pass, meld the pairs from right to left
+        PairingNode<T, V> *result = lastPair;
+
+        lastPair = lastPair->getPrevious();
+
+        while (lastPair != nullptr) {
+            PairingNode<T, V> *previousPair = lastPair->getPrevious();
+
+            result = meld(lastPair, result);
+
+            lastPair = previousPair;
+        }
+
+        result->setPrevious(nullptr);
+
+        return result;
+    }
+
+    /**
+     * Take a node (And its sub tree) out of its parent's children
+     */
+    static void cut(PairingNode<T, V> *node) {
+
+        PairingNode<T, V> *previous = node->getPrevious();
+
+        if (previous->getChild() == node) {
+            previous->setChild(node->getSibling());
+        } else {
+            previous->setSibling(node->getSibling());
+        }
+
+        if (node->getSibling() != nullptr) {
+            node->getSibling()->setPrevious(previous);
+        }
+
+        node->setSibling(nullptr);
+        node->setPrevious(nullptr);
+    }
+
+public:
+    PairingHeap() : root(nullptr), heapSize(0) {}
+
+    PairingHeap(const PairingHeap &) = delete;
+
+    PairingHeap &operator=(const PairingHeap &) = delete;
+
+    ~PairingHeap() override {
+
+        std::vector<PairingNode<T, V> *> toDelete;
+
+        if (root != nullptr) toDelete.push_back(root);
+
+        while (!toDelete.empty()) {
+            PairingNode<T, V> *node = toDelete.back();
+
+            toDelete.pop_back();
+
+            if (node->getChild() != nullptr) toDelete.push_back(node->getChild());
+            if (node->getSibling() != nullptr) toDelete.push_back(node->getSibling());
+
+            delete node;
+        }
+    }
+
+    /**
+     * @return A handle to the entry, to be used with decreaseKey
+     */
+    PairingNode<T, V> *insert(const T &key, std::shared_ptr<V> value) {
+
+        auto *node = new PairingNode<T, V>(key, std::move(value));
+
+        this->root = meld(this->root, node);
+
+        this->heapSize++;
+
+        return node;
+    }
+
+    void push(const T &key, std::shared_ptr<V> value) override {
+        insert(key, std::move(value));
+    }
+
+    /**
+     * Lower the key of an entry that is still in the heap
+     *
+     * @return False if the new key isn't smaller than the current one, in which case nothing changes
+     */
+    bool decreaseKey(PairingNode<T, V> *node, const T &key) {
+
+        if (!(key < node->getKey())) return false;
+
+        node->setKey(key);
+
+        if (node != this->root) {
+            //The sub tree of the node is still heap ordered, only its link to the parent might not be
+            cut(node);
+
+            this->root = meld(this->root, node);
+        }
+
+        return true;
+    }
+
+    std::optional<heap_entry<T, V>> peekSmallest() override {
+
+        if (this->root == nullptr) return std::nullopt;
+
+        return std::make_pair(this->root->getKey(), this->root->getValue());
+    }
+
+    std::optional<heap_entry<T, V>> popSmallest() override {
+
+        if (this->root == nullptr) return std::nullopt;
+
+        PairingNode<T, V> *oldRoot = this->root;
+
+        heap_entry<T, V> result = std::make_pair(oldRoot->getKey(), std::move(oldRoot->getValueRef()));
+
+        this->root = mergePairs(oldRoot->getChild());
+
+        this->heapSize--;
+
+        delete oldRoot;
+
+        return result;
+    }
+
+    unsigned int size() override {
+        return this->heapSize;
+    }
+};
+
+#endif //TRABALHO1_PAIRINGHEAP_H
@@ -0,0 +1,402 @@
+#ifndef TRABALHO1_ARENASKIPLIST_H
+#define TRABALHO1_ARENASKIPLIST_H
+
+#include "../arena.h"
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+//Memtables are flushed long before they get big enough to need taller towers
+#define ARENA_SKIP_LIST_MAX_HEIGHT 12
+//Each level has 1/4 of the nodes of the level below it
+#define ARENA_SKIP_LIST_BRANCHING 4
+
+enum class MemtableLookup {
+    //The key was never written to the list
+    NOT_FOUND,
+    FOUND,
+    //The latest write to the key was a remove
+    DELETED
+};
+
+/**
+ * One write to a key, the value is copied into the arena unless the write was a remove
+ */
+template<typename V>
+class ArenaValue {
+
+private:
+    alignas(V) unsigned char storage[sizeof(V)];
+
+    bool tombstone;
+
+    //The write this one replaced, only kept so its value can be destroyed along with the arena
+    ArenaValue<V> *replaced;
+
+public:
+    ArenaValue(const V *value, ArenaValue<V> *replaced) : tombstone(value == nullptr), replaced(replaced) {
+        if (value != nullptr) {
+            new(storage) V(*value);
+        }
+    }
+
+    ~ArenaValue() {
+        if (!tombstone) {
+            reinterpret_cast<V *>(storage)->~V();
+        }
+    }
+
+    /**
+     * @return The value, or null if the key was removed
+     */
+    const V *getValue() const {
+        return tombstone ? nullptr : reinterpret_cast<const V *>(storage);
+    }
+
+    ArenaValue<V> *getReplaced() const {
+        return replaced;
+    }
+};
+
+template<typename T, typename V>
+class ArenaSkipNode {
+
+private:
+    const T key;
+
+    //The latest write to the key, never null. Removed keys keep a tombstone so they shadow older copies of the key
+    std::atomic<ArenaValue<V> *> value;
+
+    //The actual size depends on the height of the node, the rest of the tower is allocated right after the node
+    std::atomic<ArenaSkipNode<T, V> *> next[1];
+
+public:
+    /**
+     * Must be built in a block of nodeSize(height) bytes, the links past the first one are constructed here
+     */
+    ArenaSkipNode(const T &key, ArenaValue<V> *value, int height) : key(key), value(value), next{} {
+        for (int level = 1; level < height; level++) {
+            new(next + level) std::atomic<ArenaSkipNode<T, V> *>(nullptr);
+        }
+    }
+
+    const T &getKey() const {
+        return key;
+    }
+
+    ArenaValue<V> *getValue() const {
+        return value.load(std::memory_order_acquire);
+    }
+
+    void setValue(ArenaValue<V> *value) {
+        this->value.store(value, std::memory_order_release);
+    }
+
+    ArenaSkipNode<T, V> *getNext(int level) const {
+        return next[level].load(std::memory_order_acquire);
+    }
+
+    /**
+     * Publish the node to the readers of this level, everything written to the node before is visible to them
+     */
+    void setNext(int level, ArenaSkipNode<T, V> *node) {
+        next[level].store(node, std::memory_order_release);
+    }
+
+    /**
+     * For the nodes that aren't in the list yet, so no reader can see them
+     */
+    void setNextUnpublished(int level, ArenaSkipNode<T, V> *node) {
+        next[level].store(node, std::memory_order_relaxed);
+    }
+
+    static size_t nodeSize(int height) {
+        return sizeof(ArenaSkipNode<T, V>) + (height - 1) * sizeof(std::atomic<ArenaSkipNode<T, V> *>);
+    }
+};
+
+/**
+ * Skip list meant to be used as a write buffer (Memtable) in the style of LevelDB.
+ *
+ * Nodes, keys and values are all copied into an arena owned by the list, so the nodes don't need an allocation of
+ * their own and the whole list is freed in one go. Keys and values that allocate on their own (Like strings) still
+ * do when they are copied, and the list keeps track of the nodes that need their destructors run. Keys are never
+ * unlinked, a remove only leaves a tombstone.
+ *
+ * Only one thread may write at a time, but any number of threads can read while it does: a node is completely
+ * built before it is published with a release store, and readers follow the pointers with acquire loads.
+ */
+template<typename T, typename V>
+class ArenaSkipList {
+
+private:
+    Arena arena;
+
+    //The head has no key, so it's only a tower. A null node in the search means the head
+    std::atomic<ArenaSkipNode<T, V> *> head[ARENA_SKIP_LIST_MAX_HEIGHT];
+
+    std::atomic_int maxHeight;
+
+    std::atomic_uint32_t listSize;
+
+    uint64_t randomState;
+
+    //Only used to destroy the keys and values that need it
+    std::vector<ArenaSkipNode<T, V> *> nodesToDestroy;
+
+    int randomHeight() {
+
+        //xorshift64, only the writer calls this
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+
+        uint64_t random = randomState;
+
+        int height = 1;
+
+        while (height < ARENA_SKIP_LIST_MAX_HEIGHT && (random % ARENA_SKIP_LIST_BRANCHING) == 0) {
+            height++;
+
+            random /= ARENA_SKIP_LIST_BRANCHING;
+        }
+
+        return height;
+    }
+
+    ArenaSkipNode<T, V> *getNext(ArenaSkipNode<T, V> *node, int level) const {
+
+        if (node == nullptr) {
+            return head[level].load(std::memory_order_acquire);
+        }
+
+        return node->getNext(level);
+    }
+
+    ArenaSkipNode<T, V> *createNode(const T &key, ArenaValue<V> *value, int height) {
+
+        char *memory = arena.allocate(ArenaSkipNode<T, V>::nodeSize(height), alignof(ArenaSkipNode<T, V>));
+
+        return new(memory) ArenaSkipNode<T, V>(key, value, height);
+    }
+
+    ArenaValue<V> *createValue(const V *value, ArenaValue<V> *replaced) {
+
+        char *memory = arena.allocate(sizeof(ArenaValue<V>), alignof(ArenaValue<V>));
+
+        return new(memory) ArenaValue<V>(value, replaced);
+    }
+
+    /**
+     * @param previous If not null, filled with the last node before the key in every level (Null for the head)
+     * @return The first node with a key >= than the given key
+     */
+    ArenaSkipNode<T, V> *findGreaterOrEqual(const T &key, ArenaSkipNode<T, V> **previous) const {
+
+        ArenaSkipNode<T, V> *current = nullptr;
+
+        int level = maxHeight.load(std::memory_order_relaxed) - 1;
+
+        while (true) {
+            ArenaSkipNode<T, V> *next = getNext(current, level);
+
+            if (next != nullptr && next->getKey() < key) {
+                current = next;
+            } else {
+                if (previous != nullptr) previous[level] = current;
+
+                if (level == 0) return next;
+
+                level--;
+            }
+        }
+    }
+
+    /**
+     * @param value The new value, or null to leave a tombstone
+     */
+    void write(const T &key, const V *value) {
+
+        ArenaSkipNode<T, V> *previous[ARENA_SKIP_LIST_MAX_HEIGHT];
+
+        ArenaSkipNode<T, V> *node = findGreaterOrEqual(key, previous);
+
+        if (node != nullptr && node->getKey() == key) {
+
+            ArenaValue<V> *current = node->getValue();
+
+            //Readers either see the old write or the new one, both are complete
+            node->setValue(createValue(value, current));
+
+            if (current->getValue() != nullptr && value == nullptr) {
+                listSize.fetch_sub(1, std::memory_order_relaxed);
+            } else if (current->getValue() == nullptr && value != nullptr) {
+                listSize.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return;
+        }
+
+        int height = randomHeight();
+
+        int currentHeight = maxHeight.load(std::memory_order_relaxed);
+
+        if (height > currentHeight) {
+            for (int level = currentHeight; level < height; level++) {
+                previous[level] = nullptr;
+            }
+
+            //Readers that see the new height before the node is linked just find null pointers from the head,
+            //and move to the next level down
+            maxHeight.store(height, std::memory_order_relaxed);
+        }
+
+        ArenaSkipNode<T, V> *created = createNode(key, createValue(value, nullptr), height);
+
+        for (int level = 0; level < height; level++) {
+            created->setNextUnpublished(level, getNext(previous[level], level));
+
+            if (previous[level] == nullptr) {
+                head[level].store(created, std::memory_order_release);
+            } else {
+                previous[level]->setNext(level, created);
+            }
+        }
+
+        if (!std::is_trivially_destructible<T>::value || !std::is_trivially_destructible<V>::value) {
+            nodesToDestroy.push_back(created);
+        }
+
+        if (value != nullptr) {
+            listSize.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    ArenaSkipList() : maxHeight(1), listSize(0), randomState(0x9E3779B97F4A7C15ULL) {
+        for (auto &level : head) {
+            level.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ArenaSkipList() {
+        //The arena frees the memory, we only have to run the destructors that do something
+        for (auto *node : nodesToDestroy) {
+            ArenaValue<V> *value = node->getValue();
+
+            while (value != nullptr) {
+                ArenaValue<V> *replaced = value->getReplaced();
+
+                value->~ArenaValue<V>();
+
+                value = replaced;
+            }
+
+            node->~ArenaSkipNode<T, V>();
+        }
+    }
+
+    /**
+     * Must only be called by the writer thread
+     */
+    void add(const T &key, const V &value) {
+        write(key, &value);
+    }
+
+    /**
+     * Leave a tombstone for the key, must only be called by the writer thread
+     */
+    void remove(const T &key) {
+        write(key, nullptr);
+    }
+
+    /**
+     * @param value Set to the value of the key when it's found. It stays valid for as long as the list exists
+     */
+    MemtableLookup lookup(const T &key, const V *&value) const {
+
+        ArenaSkipNode<T, V> *node = findGreaterOrEqual(key, nullptr);
+
+        if (node == nullptr || !(node->getKey() == key)) return MemtableLookup::NOT_FOUND;
+
+        const V *current = node->getValue()->getValue();
+
+        if (current == nullptr) return MemtableLookup::DELETED;
+
+        value = current;
+
+        return MemtableLookup::FOUND;
+    }
+
+    bool hasKey(const T &key) const {
+        const V *value;
+
+        return lookup(key, value) == MemtableLookup::FOUND;
+    }
+
+    /**
+     * The amount of keys in the list that are not removed
+     */
+    unsigned int size() const {
+        return listSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * How much memory the list is holding, so the caller can decide when to flush it
+     */
+    size_t approximateMemoryUsage() const {
+        return arena.getMemoryUsage();
+    }
+
+    /**
+     * Goes through the keys in order, including the removed ones. Can be used while the writer is adding keys
+     */
+    class Iterator {
+
+    private:
+        const ArenaSkipList<T, V> *list;
+
+        ArenaSkipNode<T, V> *node;
+
+    public:
+        explicit Iterator(const ArenaSkipList<T, V> *list) : list(list), node(nullptr) {}
+
+        bool valid() const {
+            return node != nullptr;
+        }
+
+        const T &key() const {
+            return node->getKey();
+        }
+
+        /**
+         * @return The value of the current key, or null if it was removed
+         */
+        const V *value() const {
+            return node->getValue()->getValue();
+        }
+
+        void next() {
+            node = node->getNext(0);
+        }
+
+        void seek(const T &key) {
+            node = list->findGreaterOrEqual(key, nullptr);
+        }
+
+        void seekToFirst() {
+            node = list->getNext(nullptr, 0);
+        }
+    };
+
+    Iterator iterator() const {
+        Iterator result(this);
+
+        result.seekToFirst();
+
+        return result;
+    }
+};
+
+#endif //TRABALHO1_ARENASKIPLIST_H
@@ -0,0 +1,565 @@
+#ifndef TRABALHO1_CACHESENSITIVESKIPLIST_H
+#define TRABALHO1_CACHESENSITIVESKIPLIST_H
+
+#include "../datastructures.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//One in this many level 0 nodes is in the lowest express lane
+#define CSSL_BASE_SKIP 4
+//Each express lane has one key for every cache line of keys in the lane below it
+#define CSSL_CACHE_LINE 64
+//Searches can walk this many level 0 nodes more than the lanes promise before the lanes are rebuilt
+#define CSSL_MIN_REBUILD 64
+
+/**
+ * Allocates the lanes aligned to a cache line, so every block of a lane starts on one
+ */
+template<typename T>
+struct CacheLineAllocator {
+
+    typedef T value_type;
+
+    CacheLineAllocator() = default;
+
+    template<typename U>
+    CacheLineAllocator(const CacheLineAllocator<U> &) {}
+
+    T *allocate(size_t count) {
+        return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(CSSL_CACHE_LINE)));
+    }
+
+    void deallocate(T *pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(CSSL_CACHE_LINE));
+    }
+
+    template<typename U>
+    bool operator==(const CacheLineAllocator<U> &) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const CacheLineAllocator<U> &) const {
+        return false;
+    }
+};
+
+template<typename T>
+using ExpressLane = std::vector<T, CacheLineAllocator<T>>;
+
+/**
+ * How many of the first count keys are smaller than the key. The keys are sorted, so this is also the position of the
+ * first one that isn't.
+ *
+ * Branchless, so the compiler can vectorize it for any key type that allows it
+ */
+template<typename T>
+inline size_t laneCountLess(const T *keys, size_t count, const T &key) {
+
+    size_t smaller = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        smaller += keys[i] < key;
+    }
+
+    return smaller;
+}
+
+#if defined(__SSE2__)
+
+/**
+ * The same count for 32 bit keys, comparing 4 keys per instruction. A whole block of a lane is a single cache line
+ */
+inline size_t laneCountLess(const int32_t *keys, size_t count, const int32_t &key) {
+
+    __m128i target = _mm_set1_epi32(key), smaller = _mm_setzero_si128();
+
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        //Every key that is smaller than the target gives -1
+        smaller = _mm_sub_epi32(smaller, _mm_cmpgt_epi32(target, _mm_loadu_si128((const __m128i *) (keys + i))));
+    }
+
+    int32_t partial[4];
+
+    _mm_storeu_si128((__m128i *) partial, smaller);
+
+    size_t result = (size_t) (partial[0] + partial[1] + partial[2] + partial[3]);
+
+    for (; i < count; i++) {
+        result += keys[i] < key;
+    }
+
+    return result;
+}
+
+#endif
+
+template<typename T, typename V>
+class CSSLNode {
+
+private:
+    //A copy of the key, so walking level 0 doesn't need to follow the key pointer
+    T keyValue;
+
+    std::shared_ptr<T> key;
+
+    std::shared_ptr<V> value;
+
+    CSSLNode<T, V> *next;
+
+    //Whether the lowest express lane points to this node
+    bool inLane;
+
+public:
+    CSSLNode(std::shared_ptr<T> key, std::shared_ptr<V> value, CSSLNode<T, V> *next) : keyValue(*key),
+                                                                                        key(std::move(key)),
+                                                                                        value(std::move(value)),
+                                                                                        next(next),
+                                                                                        inLane(false) {}
+
+    const T &getKeyVal() const {
+        return keyValue;
+    }
+
+    const std::shared_ptr<T> &getKey() const {
+        return key;
+    }
+
+    const std::shared_ptr<V> &getValue() const {
+        return value;
+    }
+
+    void setValue(std::shared_ptr<V> value) {
+        this->value = std::move(value);
+    }
+
+    CSSLNode<T, V> *getNext() const {
+        return next;
+    }
+
+    void setNext(CSSLNode<T, V> *next) {
+        this->next = next;
+    }
+
+    bool isInLane() const {
+        return inLane;
+    }
+
+    void setInLane(bool inLane) {
+        this->inLane = inLane;
+    }
+};
+
+/**
+ * Cache sensitive skip list (Sprenger et al. "Cache-Sensitive Skip List: Efficient Range Queries on Modern CPUs").
+ *
+ * Level 0 is a sorted linked list, so inserts stay cheap, but the levels above it are not towers of pointers in the
+ * nodes. They are express lanes: dense arrays of keys, where each lane has one key for every block of keys (A cache
+ * line) of the lane below it, and the lowest lane has every CSSL_BASE_SKIP-th node. A search scans the small top
+ * lane, then a single cache line (With SIMD for integer keys) in each lane below it, and only walks a few level 0
+ * nodes at the end, instead of chasing one pointer to a different node per step.
+ *
+ * Inserts don't touch the lanes, they just make the level 0 walks a little longer. Removing a node that a lane points
+ * to replaces it in the lanes with a neighbour. Once the searches have walked about as many extra nodes as there are
+ * in the list, the lanes are rebuilt from level 0 in one pass.
+ */
+template<typename T, typename V>
+class CacheSensitiveSkipList : public OrderedMap<T, V> {
+
+private:
+    static constexpr size_t laneSkip() {
+        return std::max((size_t) 2, (size_t) CSSL_CACHE_LINE / sizeof(T));
+    }
+
+    CSSLNode<T, V> *firstNode;
+
+    CSSLNode<T, V> *lastNode;
+
+    //The lowest lane first. Each lane has every laneSkip()-th key of the one before it
+    std::vector<ExpressLane<T>> lanes;
+
+    //The level 0 node of each key of the lowest lane
+    std::vector<CSSLNode<T, V> *> laneNodes;
+
+    unsigned int listSize;
+
+    //Level 0 nodes walked past the CSSL_BASE_SKIP the lanes promise, since the last rebuild
+    size_t extraSteps;
+
+    void rebuildLanes() {
+
+        this->lanes.clear();
+        this->laneNodes.clear();
+
+        this->extraSteps = 0;
+
+        if (this->firstNode == nullptr) return;
+
+        ExpressLane<T> lowest;
+
+        lowest.reserve(this->listSize / CSSL_BASE_SKIP + 1);
+        this->laneNodes.reserve(this->listSize / CSSL_BASE_SKIP + 1);
+
+        size_t position = 0;
+
+        for (CSSLNode<T, V> *node = this->firstNode; node != nullptr; node = node->getNext(), position++) {
+
+            node->setInLane(position % CSSL_BASE_SKIP == 0);
+
+            if (node->isInLane()) {
+                lowest.push_back(node->getKeyVal());
+                this->laneNodes.push_back(node);
+            }
+        }
+
+        this->lanes.push_back(std::move(lowest));
+
+        while (this->lanes.back().size() > laneSkip()) {
+            const ExpressLane<T> &below = this->lanes.back();
+
+            ExpressLane<T> lane;
+
+            lane.reserve(below.size() / laneSkip() + 1);
+
+            for (size_t i = 0; i < below.size(); i += laneSkip()) {
+                lane.push_back(below[i]);
+            }
+
+            this->lanes.push_back(std::move(lane));
+        }
+    }
+
+    void maintainLanes() {
+        if (this->extraSteps >= this->listSize + CSSL_MIN_REBUILD) {
+            rebuildLanes();
+        }
+    }
+
+    /**
+     * How many keys of the lowest lane are smaller than the key, going down through every lane
+     */
+    size_t lanePosition(const T &key) const {
+
+        if (this->lanes.empty()) return 0;
+
+        const ExpressLane<T> &top = this->lanes.back();
+
+        size_t smaller = laneCountLess(top.data(), top.size(), key);
+
+        for (size_t lane = this->lanes.size() - 1; lane > 0 && smaller > 0; lane--) {
+            const ExpressLane<T> &below = this->lanes[lane - 1];
+
+            //The block below the last smaller key, every key after the block is >= to the key
+            size_t start = (smaller - 1) * laneSkip(), end = std::min(start + laneSkip(), below.size());
+
+            smaller = start + laneCountLess(below.data() + start, end - start, key);
+        }
+
+        return smaller;
+    }
+
+    /**
+     * The first node with a key >= to the given one (Null if there is none), and the node before it
+     */
+    CSSLNode<T, V> *lowerBound(const T &key, CSSLNode<T, V> **predecessor) {
+
+        size_t position = lanePosition(key);
+
+        CSSLNode<T, V> *previous = position == 0 ? nullptr : this->laneNodes[position - 1],
+                *current = previous == nullptr ? this->firstNode : previous->getNext();
+
+        size_t steps = 0;
+
+        while (current != nullptr && current->getKeyVal() < key) {
+            previous = current;
+            current = current->getNext();
+
+            steps++;
+        }
+
+        if (steps > CSSL_BASE_SKIP) {
+            this->extraSteps += steps - CSSL_BASE_SKIP;
+        }
+
+        if (predecessor != nullptr) {
+            *predecessor = previous;
+        }
+
+        return current;
+    }
+
+    CSSLNode<T, V> *findNode(const T &key) {
+
+        maintainLanes();
+
+        CSSLNode<T, V> *node = lowerBound(key, nullptr);
+
+        return node != nullptr && node->getKeyVal() == key ? node : nullptr;
+    }
+
+    /**
+     * Point every lane entry of the node to another one. The successor takes its place when there is one, it's never
+     * past the next node in the lane, so the lanes stay sorted (A key might show up twice until the next rebuild)
+     */
+    void replaceInLanes(CSSLNode<T, V> *node, CSSLNode<T, V> *successor) {
+
+        size_t position = lanePosition(node->getKeyVal());
+
+        for (; position < this->laneNodes.size() && this->laneNodes[position] == node; position++) {
+
+            CSSLNode<T, V> *replacement = successor;
+
+            if (replacement == nullptr) {
+                if (position == 0) {
+                    //Nothing is left around it, searches start at the first node until the next rebuild
+                    this->lanes.clear();
+                    this->laneNodes.clear();
+
+                    return;
+                }
+
+                replacement = this->laneNodes[position - 1];
+            }
+
+            replacement->setInLane(true);
+
+            this->laneNodes[position] = replacement;
+
+            //The key is also in every lane above whose stride divides its position
+            size_t lanePosition = position;
+
+            for (size_t lane = 0; lane < this->lanes.size(); lane++) {
+                this->lanes[lane][lanePosition] = replacement->getKeyVal();
+
+                if (lanePosition % laneSkip() != 0) break;
+
+                lanePosition /= laneSkip();
+            }
+        }
+    }
+
+    void removeNode(CSSLNode<T, V> *node, CSSLNode<T, V> *predecessor) {
+
+        if (predecessor == nullptr) {
+            this->firstNode = node->getNext();
+        } else {
+            predecessor->setNext(node->getNext());
+        }
+
+        if (this->lastNode == node) {
+            this->lastNode = predecessor;
+        }
+
+        if (node->isInLane()) {
+            replaceInLanes(node, node->getNext());
+        }
+
+        this->listSize--;
+
+        delete node;
+    }
+
+    void rangeHelper(CSSLNode<T, V> *node, const T *max, std::vector<node_info<T, V>> *results) {
+
+        for (; node != nullptr && (max == nullptr || !(*max < node->getKeyVal())); node = node->getNext()) {
+            results->push_back(std::make_tuple(node->getKey(), node->getValue()));
+        }
+    }
+
+public:
+    CacheSensitiveSkipList() : firstNode(nullptr), lastNode(nullptr), listSize(0), extraSteps(0) {}
+
+    CacheSensitiveSkipList(const CacheSensitiveSkipList &) = delete;
+
+    CacheSensitiveSkipList &operator=(const CacheSensitiveSkipList &) = delete;
+
+    ~CacheSensitiveSkipList() override {
+
+        CSSLNode<T, V> *current = this->firstNode;
+
+        while (current != nullptr) {
+            CSSLNode<T, V> *next = current->getNext();
+
+            delete current;
+
+            current = next;
+        }
+    }
+
+    unsigned int size() override {
+        return this->listSize;
+    }
+
+    /**
+     * How many express lanes there are right now, they are only built once searches need them
+     */
+    unsigned int laneCount() const {
+        return this->lanes.size();
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        //Keys that go after every other one (Like an ascending load) don't need a search
+        if (this->lastNode != nullptr && this->lastNode->getKeyVal() < *key) {
+            auto *node = new CSSLNode<T, V>(std::move(key), std::move(value), nullptr);
+
+            this->lastNode->setNext(node);
+            this->lastNode = node;
+
+            this->listSize++;
+
+            return;
+        }
+
+        maintainLanes();
+
+        CSSLNode<T, V> *predecessor, *current = lowerBound(*key, &predecessor);
+
+        if (current != nullptr && current->getKeyVal() == *key) {
+            current->setValue(std::move(value));
+
+            return;
+        }
+
+        auto *node = new CSSLNode<T, V>(std::move(key), std::move(value), current);
+
+        if (predecessor == nullptr) {
+            this->firstNode = node;
+        } else {
+            predecessor->setNext(node);
+        }
+
+        if (current == nullptr) {
+            this->lastNode = node;
+        }
+
+        this->listSize++;
+    }
+
+    bool hasKey(const T &key) override {
+        return findNode(key) != nullptr;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        CSSLNode<T, V> *node = findNode(key);
+
+        if (node == nullptr) return std::nullopt;
+
+        return node->getValue();
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        maintainLanes();
+
+        CSSLNode<T, V> *predecessor, *node = lowerBound(key, &predecessor);
+
+        if (node == nullptr || !(node->getKeyVal() == key)) return std::nullopt;
+
+        std::shared_ptr<V> value = node->getValue();
+
+        removeNode(node, predecessor);
+
+        return value;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        results->reserve(this->listSize);
+
+        for (CSSLNode<T, V> *node = this->firstNode; node != nullptr; node = node->getNext()) {
+            results->push_back(node->getKey());
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        results->reserve(this->listSize);
+
+        for (CSSLNode<T, V> *node = this->firstNode; node != nullptr; node = node->getNext()) {
+            results->push_back(node->getValue());
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        results->reserve(this->listSize);
+
+        rangeHelper(this->firstNode, nullptr, results.get());
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        maintainLanes();
+
+        rangeHelper(lowerBound(base, nullptr), &max, results.get());
+
+        return results;
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+
+        if (this->firstNode == nullptr) return std::nullopt;
+
+        return std::make_tuple(this->firstNode->getKey(), this->firstNode->getValue());
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+
+        if (this->lastNode == nullptr) return std::nullopt;
+
+        return std::make_tuple(this->lastNode->getKey(), this->lastNode->getValue());
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        if (this->firstNode == nullptr) return std::nullopt;
+
+        auto result = std::make_tuple(this->firstNode->getKey(), this->firstNode->getValue());
+
+        removeNode(this->firstNode, nullptr);
+
+        return result;
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        if (this->lastNode == nullptr) return std::nullopt;
+
+        maintainLanes();
+
+        CSSLNode<T, V> *predecessor, *node = lowerBound(this->lastNode->getKeyVal(), &predecessor);
+
+        auto result = std::make_tuple(node->getKey(), node->getValue());
+
+        removeNode(node, predecessor);
+
+        return result;
+    }
+};
+
+#endif //TRABALHO1_CACHESENSITIVESKIPLIST_H
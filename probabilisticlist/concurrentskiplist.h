@@ -3,6 +3,7 @@
 
 #include <mutex>
 #include "skiplist.h"
+#include "../epochreclamation.h"
 #include <atomic>
 
 template<typename T, typename V>
@@ -10,12 +11,17 @@ class ConcurrentSkipNode : public SkipNode<T, V> {
 
 private:
     //This is used to make the remove operations appear atomic (When the node is marked, it is in the process of being removed
-    bool marked;
+    //Other threads spin on these flags without taking the lock, so they have to be atomic
+    std::atomic_bool marked;
     //This is the linearization point for the add operation
     //It is true when all of the pointers from the node level have been filled
-    bool fullyLinked;
+    std::atomic_bool fullyLinked;
     std::mutex lock;
 
+    //The value set by the last add of a key that was already in the list, null while the node has its first value.
+    //Readers copy the value without locks, so a new value gets its own cell instead of overwriting the old one
+    std::atomic<std::shared_ptr<V> *> replacedValue;
+
 public:
 
     //We start with fully linked = false,
@@ -27,15 +33,19 @@ public:
                     std::move(value),
                     level),
             marked(false),
-            fullyLinked(fullyLinked), lock() {
+            fullyLinked(fullyLinked), lock(), replacedValue(nullptr) {
+    }
+
+    ~ConcurrentSkipNode() override {
+        delete this->replacedValue.load();
     }
 
     bool isMarked() const {
-        return this->marked;
+        return this->marked.load(std::memory_order_acquire);
     }
 
     bool isFullyLinked() const {
-        return this->fullyLinked;
+        return this->fullyLinked.load(std::memory_order_acquire);
     }
 
     std::mutex &getLock() {
@@ -43,11 +53,25 @@ public:
     }
 
     void setFullyLinked(bool fullyLinked) {
-        this->fullyLinked = fullyLinked;
+        this->fullyLinked.store(fullyLinked, std::memory_order_release);
     }
 
     void setMarked(bool marked) {
-        this->marked = marked;
+        this->marked.store(marked, std::memory_order_release);
+    }
+
+    std::shared_ptr<V> loadValue() const {
+
+        std::shared_ptr<V> *replaced = this->replacedValue.load(std::memory_order_acquire);
+
+        return replaced == nullptr ? this->value : *replaced;
+    }
+
+    /**
+     * @return The cell of the previous value, which readers might still be copying. Null if it was the first value
+     */
+    std::shared_ptr<V> *exchangeValue(std::shared_ptr<V> *value) {
+        return this->replacedValue.exchange(value, std::memory_order_acq_rel);
     }
 
 };
@@ -55,13 +79,14 @@ public:
 template<typename T, typename V>
 class ConcurrentSkipList : public OrderedMap<T, V> {
 
-private:
+protected:
+    //Readers take no locks, so removed nodes are only freed once no operation can still be on them.
+    //Declared first so it's destroyed after the list
+    EpochReclaimer reclaimer;
 
-    std::random_device randomEngine;
-    std::mt19937 generator;
-    std::uniform_int_distribution<unsigned int> distribution;
+private:
 
-    std::unique_ptr<SkipNode<T, V>> rootNode;
+    SkipNodePtr<T, V> rootNode;
 
     std::atomic<SkipNode<T, V> *> lastNode;
 
@@ -69,17 +94,15 @@ private:
     std::atomic_uint32_t treeLevel;
 
 public:
-    ConcurrentSkipList() : randomEngine(),
-                           rootNode(initializeNodeRoot(SKIP_LIST_HEIGHT_LIMIT)),
+    ConcurrentSkipList() : rootNode(initializeNodeRoot(SKIP_LIST_HEIGHT_LIMIT)),
                            treeSize(0),
                            treeLevel(0),
                            lastNode(nullptr) {
-        this->generator = std::mt19937(randomEngine());
     }
 
     ~ConcurrentSkipList() {
 
-        std::unique_ptr<SkipNode<T,V>> current = std::move(this->rootNode);
+        SkipNodePtr<T, V> current = std::move(this->rootNode);
 
         while (current.get()->getNextNode(0) != nullptr) {
             //By reassigning the unique_ptr, the previous one gets deleted
@@ -89,34 +112,23 @@ public:
 
 protected:
     int generateLevel() {
-        int random = distribution(generator);
-
-        //Maybe get the amount of consecutive bits that have been set to 1 to get the correct level,
-        //Instead of generating a new number every single time?
-
-        int level = 0;
-
-        while ((random & FIRST_BIT_MASK) != 0 && level < SKIP_LIST_HEIGHT_LIMIT) {
-            level++;
-
-            random = random << 1;
-        }
-
-        return level;
+        //Each thread has its own generator, so concurrent inserts don't share any state here
+        return generateSkipListLevel();
     }
 
-    std::unique_ptr<SkipNode<T, V>> initializeNode(std::shared_ptr<T> key, std::shared_ptr<V> value) {
-        return std::make_unique<ConcurrentSkipNode<T, V>>(std::move(key), std::move(value), this->generateLevel(),
-                                                          false);
+    SkipNodePtr<T, V> initializeNode(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+        return initializeNodeWithLevel(std::move(key), std::move(value), this->generateLevel());
     }
 
-    std::unique_ptr<ConcurrentSkipNode<T, V>>
+    std::unique_ptr<ConcurrentSkipNode<T, V>, SkipNodeDeleter<T, V>>
     initializeNodeWithLevel(std::shared_ptr<T> key, std::shared_ptr<V> value, int level) {
-        return std::make_unique<ConcurrentSkipNode<T, V>>(std::move(key), std::move(value), level, false);
+        return SkipNode<T, V>::template createNode<ConcurrentSkipNode<T, V>>(level, std::move(key), std::move(value),
+                                                                            level, false);
     }
 
-    std::unique_ptr<SkipNode<T, V>> initializeNodeRoot(int level) {
-        return std::make_unique<ConcurrentSkipNode<T, V>>(std::shared_ptr<T>(), std::shared_ptr<V>(), level, true);
+    SkipNodePtr<T, V> initializeNodeRoot(int level) {
+        return SkipNode<T, V>::template createNode<ConcurrentSkipNode<T, V>>(level, std::shared_ptr<T>(),
+                                                                            std::shared_ptr<V>(), level, true);
     }
 
     /**
@@ -137,7 +149,17 @@ protected:
 
         auto *predecessor = (ConcurrentSkipNode<T, V> *) this->getRoot();
 
-        for (int level = this->getListLevel(); level >= 0; level--) {
+        int listLevel = this->getListLevel();
+
+        if (predecessors != nullptr && successors != nullptr) {
+            //The new node might be taller than the list, so the levels above the list level start at the root
+            for (int level = SKIP_LIST_HEIGHT_LIMIT - 1; level > listLevel; level--) {
+                predecessors[level] = predecessor;
+                successors[level] = (ConcurrentSkipNode<T, V> *) predecessor->getNextNode(level);
+            }
+        }
+
+        for (int level = listLevel; level >= 0; level--) {
 
             auto *current = (ConcurrentSkipNode<T, V> *) predecessor->getNextNode(level);
 
@@ -166,77 +188,51 @@ private:
         return node->isFullyLinked() && !node->isMarked() && levelFound == node->getLevel();
     }
 
-    void listTraversalHelper(std::vector<node_info<T, V>> *results) {
-
-        ConcurrentSkipNode<T, V> *root = this->getRoot();
-
-        ConcurrentSkipNode<T, V> *next = root, *previous = root;
-
-        do {
-            next = (ConcurrentSkipNode<T, V> *) next->getNextNode(0);
-
-            if (next->isMarked() || !next->isFullyLinked()) {
-                //Node is being removed or node is still being added,
-                //Wait until this operation is finished so we don't get any wrong values
-
-                if (previous->isMarked()) {
-                    //If the previous is being removed and the next is also being removed then they might reference
-                    //The same node or even if they don't, that memory is going to be freed shortly, so we have to restart
-                    //The collection of the nodes.
-                    results->clear();
+    /**
+     * A node that is being added or removed is skipped, the traversal takes effect before it is fully linked or
+     * after it is marked. Removed nodes keep their links, so the traversal can go on from one
+     */
+    static bool isPresent(ConcurrentSkipNode<T, V> *node) {
+        return node->isFullyLinked() && !node->isMarked();
+    }
 
-                    listTraversalHelper(results);
+    void listTraversalHelper(std::vector<node_info<T, V>> *results) {
 
-                    return;
-                }
+        auto *current = (ConcurrentSkipNode<T, V> *) this->getRoot()->getNextNode(0);
 
-                next = previous;
+        while (current != nullptr) {
 
-                continue;
-            } else {
-                results->push_back(std::make_tuple(next->getKey(), next->getValue()));
+            if (isPresent(current)) {
+                results->push_back(std::make_tuple(current->getKey(), current->loadValue()));
             }
 
-            previous = next;
-        } while (next != nullptr);
+            current = (ConcurrentSkipNode<T, V> *) current->getNextNode(0);
+        }
     }
 
     void rangeSearchHelper(const T &base, const T &max, std::vector<node_info<T, V>> *results) {
-        ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
-
-        int levelFound = concurrentFindNode(base, predecessors, successors);
-
-        ConcurrentSkipNode<T, V> *current = predecessors[0], *previous = current;
 
-        while (current != nullptr && *current->getKeyVal() <= max) {
-
-            if (current->isMarked() || !current->isFullyLinked()) {
+        ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
 
-                if (previous->isMarked()) {
-                    //When we have the current and previous nodes marked
-                    //Then we have no valid starting point for our search
-                    //So we clear the current results
-                    //And start over.
-                    results->clear();
+        concurrentFindNode(base, predecessors, successors);
 
-                    rangeSearchHelper(base, max, results);
-                    return;
-                }
+        //The first node with a key >= to the base
+        ConcurrentSkipNode<T, V> *current = successors[0];
 
-                current = previous;
+        while (current != nullptr && !(max < *current->getKeyVal())) {
 
-                continue;
+            if (isPresent(current)) {
+                results->push_back(std::make_tuple(current->getKey(), current->loadValue()));
             }
 
-            previous = current;
-            current = (ConcurrentSkipNode<T, V>*) current->getNextNode(0);
+            current = (ConcurrentSkipNode<T, V> *) current->getNextNode(0);
         }
-
     }
 
 protected:
     int getListLevel() const {
-        return this->treeLevel.load();
+        //Only where searches start: a stale level just starts them one level too low or too high, which is still correct
+        return this->treeLevel.load(std::memory_order_relaxed);
     }
 
     void setListLevel(int listLevel) {
@@ -247,40 +243,23 @@ protected:
         return (ConcurrentSkipNode<T, V> *) this->rootNode.get();
     }
 
-public:
-
-    unsigned int size() override {
-        return this->treeSize.load();
-    }
-
-    bool hasKey(const T &key) override {
-
-        ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
-
-        int levelFound = concurrentFindNode(key, predecessors, successors);
-
-        ConcurrentSkipNode<T, V> *node = successors[levelFound];
-
-        //The node has to be fully linked (Fully inserted) and not in the process of being removed
-        return levelFound != -1 && node->isFullyLinked() && !node->isMarked() && (*node->getKeyVal() == key);
-    }
-
-    std::optional<std::shared_ptr<V>> get(const T &key) override {
-
-        ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
-
-        int levelFound = concurrentFindNode(key, predecessors, successors);
+    void replaceValue(ConcurrentSkipNode<T, V> *node, std::shared_ptr<V> value) {
 
-        ConcurrentSkipNode<T, V> *node = successors[levelFound];
+        std::shared_ptr<V> *previous = node->exchangeValue(new std::shared_ptr<V>(std::move(value)));
 
-        if (levelFound != -1 && node->isFullyLinked() && !node->isMarked()) {
-            return node->getValue();
+        if (previous != nullptr) {
+            this->reclaimer.retire(previous);
         }
-
-        return std::nullopt;
     }
 
-    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+    /**
+     * Insert the key, or find the node that already has it. Must be called inside a guard of the reclaimer
+     *
+     * @param replace Whether the value of a key that is already in the list is replaced with the given one
+     * @return The node with the key
+     */
+    ConcurrentSkipNode<T, V> *insertNode(std::shared_ptr<T> key, std::shared_ptr<V> value, bool replace) {
+
         int nodeLevel = this->generateLevel();
 
         ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
@@ -300,9 +279,11 @@ public:
                     //Wait for the node to finish being added, if necessary
                     while (!node->isFullyLinked()) {}
 
-                    node->setValue(std::move(value));
+                    if (replace) {
+                        replaceValue(node, std::move(value));
+                    }
 
-                    return;
+                    return node;
                 }
 
                 //If the node was being removed, then we try again
@@ -319,7 +300,9 @@ public:
             //Locks will all be unlocked. (Sort of like a finally would do)
             //Since the scope of these locks is inside the while, they will get unlocked
             //Everytime we cycle the while, as is intended
-            std::vector<std::unique_lock<std::mutex>> locks(SKIP_LIST_HEIGHT_LIMIT);
+            std::vector<std::unique_lock<std::mutex>> locks;
+
+            locks.reserve(SKIP_LIST_HEIGHT_LIMIT);
 
             //Lets acquire the locks of the nodes in every level until our new node level
             for (int level = 0; isValid && (level <= nodeLevel); level++) {
@@ -348,8 +331,7 @@ public:
                 continue;
             }
 
-            std::unique_ptr<ConcurrentSkipNode<T, V>> node = initializeNodeWithLevel(std::move(key), std::move(value),
-                                                                                     nodeLevel);
+            auto node = initializeNodeWithLevel(std::move(key), std::move(value), nodeLevel);
 
             ConcurrentSkipNode<T, V> *nodeP = node.get();
 
@@ -380,7 +362,7 @@ public:
                     break;
                 }
 
-            } while (!this->lastNode.compare_exchange_weak(last, node.get()));
+            } while (!this->lastNode.compare_exchange_weak(last, nodeP));
 
             this->treeSize++;
 
@@ -397,12 +379,54 @@ public:
                 }
             }
 
-            break;
+            return nodeP;
         }
     }
 
+public:
+
+    unsigned int size() override {
+        return this->treeSize.load(std::memory_order_relaxed);
+    }
+
+    bool hasKey(const T &key) override {
+
+        auto guard = this->reclaimer.enter();
+
+        ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
+
+        int levelFound = concurrentFindNode(key, predecessors, successors);
+
+        //The node has to be fully linked (Fully inserted) and not in the process of being removed
+        return levelFound != -1 && isPresent(successors[levelFound]);
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        auto guard = this->reclaimer.enter();
+
+        ConcurrentSkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
+
+        int levelFound = concurrentFindNode(key, predecessors, successors);
+
+        if (levelFound != -1 && isPresent(successors[levelFound])) {
+            return successors[levelFound]->loadValue();
+        }
+
+        return std::nullopt;
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        auto guard = this->reclaimer.enter();
+
+        insertNode(std::move(key), std::move(value), true);
+    }
+
     std::optional<std::shared_ptr<V>> remove(const T &key) override {
 
+        auto guard = this->reclaimer.enter();
+
         ConcurrentSkipNode<T, V> *toDelete = nullptr;
 
         bool isMarked = false;
@@ -436,7 +460,10 @@ public:
 
                 ConcurrentSkipNode<T, V> *predecessor = nullptr, *successor = nullptr, *previousPredecessor = nullptr;
 
-                std::vector<std::unique_lock<std::mutex>> locks(SKIP_LIST_HEIGHT_LIMIT);
+                std::vector<std::unique_lock<std::mutex>> locks;
+
+                locks.reserve(SKIP_LIST_HEIGHT_LIMIT);
+
                 bool valid = true;
 
                 //Acquire the locks to all the predecessors of the node we want to remove.
@@ -457,12 +484,12 @@ public:
 
                 if (!valid) continue;
 
-                std::unique_ptr<SkipNode<T, V>> toDeleteOwnership;
+                SkipNodePtr<T, V> toDeleteOwnership;
                 //Now that we have all of the locks in our control, remove the node from the list
                 for (int level = topLevel; level >= 0; level--) {
 
                     if (level == 0) {
-                        std::unique_ptr<SkipNode<T, V>> nextNode = toDelete->getNextOwnership();
+                        SkipNodePtr<T, V> nextNode = toDelete->getNextOwnership();
 
                         toDeleteOwnership = predecessors[level]->getNextOwnership();
 
@@ -476,7 +503,7 @@ public:
                 //We know that no other operation can take place, so this does not need
                 //A big amount of synchronization
                 if (this->lastNode.load() == toDeleteOwnership.get()) {
-                    this->lastNode.store(predecessors[0]);
+                    this->lastNode.store(predecessors[0] == this->getRoot() ? nullptr : predecessors[0]);
                 }
 
                 this->treeSize--;
@@ -488,13 +515,20 @@ public:
 
                     newLevel = tLevel;
 
-                    while (newLevel > 0 && this->getRoot()->getNextNode(tLevel) == nullptr) {
+                    while (newLevel > 0 && this->getRoot()->getNextNode(newLevel) == nullptr) {
                         newLevel--;
                     }
 
                 } while (!this->treeLevel.compare_exchange_weak(tLevel, newLevel));
 
-                return toDeleteOwnership.get()->getValue();
+                std::shared_ptr<V> value = toDelete->loadValue();
+
+                toDeleteLock.reset();
+
+                //Other threads might still be traversing the removed node
+                this->reclaimer.template retire<SkipNode<T, V>, SkipNodeDeleter<T, V>>(toDeleteOwnership.release());
+
+                return value;
             } else {
                 return std::nullopt;
             }
@@ -502,6 +536,9 @@ public:
     }
 
     std::optional<node_info<T, V>> peekLargest() override {
+
+        auto guard = this->reclaimer.enter();
+
         while (true) {
 
             ConcurrentSkipNode<T, V> *load = (ConcurrentSkipNode<T, V> *) this->lastNode.load();
@@ -512,13 +549,15 @@ public:
                 //If the node is being removed or added, retry
                 if (!load->isFullyLinked() || load->isMarked()) continue;
 
-                return std::make_tuple(load->getKey(), load->getValue());
+                return std::make_tuple(load->getKey(), load->loadValue());
             }
         }
     }
 
     std::optional<node_info<T, V>> peekSmallest() override {
 
+        auto guard = this->reclaimer.enter();
+
         ConcurrentSkipNode<T, V> *root = this->getRoot();
 
         ConcurrentSkipNode<T, V> *next;
@@ -530,18 +569,24 @@ public:
 
         } while (next->isMarked() || !next->isFullyLinked());
 
-        return std::make_tuple(next->getKey(), next->getValue());
+        return std::make_tuple(next->getKey(), next->loadValue());
     }
 
     std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
 
-        std::unique_ptr<std::vector<std::shared_ptr<T>>> results =
-                std::make_unique<std::vector<std::shared_ptr<T>>>(this->size());
+        auto guard = this->reclaimer.enter();
+
+        std::unique_ptr<std::vector<std::shared_ptr<T>>> results = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        std::vector<node_info<T, V>> cache;
 
-        std::vector<node_info<T, V>> cache(this->size());
+        //The size is only a hint, other threads can change it while we go through the list
+        cache.reserve(this->size());
 
         listTraversalHelper(&cache);
 
+        results->reserve(cache.size());
+
         for (node_info<T, V> &start : cache) {
             results->push_back(std::move(std::get<0>(start)));
         }
@@ -551,13 +596,18 @@ public:
 
     std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
 
-        std::unique_ptr<std::vector<std::shared_ptr<V>>> results =
-                std::make_unique<std::vector<std::shared_ptr<V>>>(this->size());
+        auto guard = this->reclaimer.enter();
+
+        std::unique_ptr<std::vector<std::shared_ptr<V>>> results = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        std::vector<node_info<T, V>> cache;
 
-        std::vector<node_info<T, V>> cache(this->size());
+        cache.reserve(this->size());
 
         listTraversalHelper(&cache);
 
+        results->reserve(cache.size());
+
         for (node_info<T, V> &start : cache) {
             results->push_back(std::move(std::get<1>(start)));
         }
@@ -566,8 +616,12 @@ public:
     }
 
     std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
-        std::unique_ptr<std::vector<node_info<T, V>>> results = std::make_unique<std::vector<node_info<T, V>>>(
-                this->size());
+
+        auto guard = this->reclaimer.enter();
+
+        std::unique_ptr<std::vector<node_info<T, V>>> results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        results->reserve(this->size());
 
         listTraversalHelper(results.get());
 
@@ -576,8 +630,9 @@ public:
 
     std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
 
-        std::unique_ptr<std::vector<node_info<T, V>>> results = std::make_unique<std::vector<node_info<T, V>>>(
-                this->size());
+        auto guard = this->reclaimer.enter();
+
+        std::unique_ptr<std::vector<node_info<T, V>>> results = std::make_unique<std::vector<node_info<T, V>>>();
 
         rangeSearchHelper(base, max, results.get());
 
@@ -586,29 +641,34 @@ public:
 
     std::optional<node_info<T, V>> popSmallest() override {
 
+        auto guard = this->reclaimer.enter();
+
         ConcurrentSkipNode<T, V> *root = this->getRoot();
 
-        ConcurrentSkipNode<T, V> *next;
+        while (true) {
 
-        do {
-            next = (ConcurrentSkipNode<T, V>*) root->getNextNode(0);
+            auto *next = (ConcurrentSkipNode<T, V> *) root->getNextNode(0);
 
             if (next == nullptr) return std::nullopt;
 
-        } while (next->isMarked() || !next->isFullyLinked());
+            //If the node is being removed or added, retry
+            if (next->isMarked() || !next->isFullyLinked()) continue;
 
-        auto peekResult = std::make_tuple(next->getKey(), next->getValue());
+            std::shared_ptr<T> key = next->getKey();
 
-        auto result = remove(*next->getKeyVal());
+            //Another thread may have removed the node in the meantime, then we try the next one
+            auto result = remove(*key);
 
-        if (result) {
-            return peekResult;
+            if (result) {
+                return std::make_tuple(key, *result);
+            }
         }
-
-        return popSmallest();
     }
 
     std::optional<node_info<T, V>> popLargest() override {
+
+        auto guard = this->reclaimer.enter();
+
         while (true) {
 
             ConcurrentSkipNode<T, V> *load = (ConcurrentSkipNode<T, V> *) this->lastNode.load();
@@ -619,12 +679,12 @@ public:
                 //If the node is being removed or added, retry
                 if (!load->isFullyLinked() || load->isMarked()) continue;
 
-                auto peekResult = std::make_tuple(load->getKey(), load->getValue());
+                std::shared_ptr<T> key = load->getKey();
 
-                auto result = remove(*load->getKeyVal());
+                auto result = remove(*key);
 
                 if (result) {
-                    return peekResult;
+                    return std::make_tuple(key, *result);
                 }
             }
         }
@@ -0,0 +1,719 @@
+#ifndef TRABALHO1_MVCCSKIPLIST_H
+#define TRABALHO1_MVCCSKIPLIST_H
+
+#include "concurrentskiplist.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+
+//Every how many commits the writer that made the commit collects old versions
+#define MVCC_COLLECT_INTERVAL 1024
+//How many keys each of those collections goes through
+#define MVCC_COLLECT_STEP (MVCC_COLLECT_INTERVAL * 2)
+
+/**
+ * One value of a key, stamped with the commit that wrote it. A null value means the key was removed in that commit
+ */
+template<typename V>
+class MVCCVersion {
+
+private:
+    uint64_t version;
+
+    std::shared_ptr<V> value;
+
+    //The version this one replaced, cut off by the garbage collection once no reader can need it
+    std::atomic<MVCCVersion<V> *> older;
+
+public:
+    MVCCVersion(uint64_t version, std::shared_ptr<V> value, MVCCVersion<V> *older) : version(version),
+                                                                                     value(std::move(value)),
+                                                                                     older(older) {}
+
+    uint64_t getVersion() const {
+        return version;
+    }
+
+    const std::shared_ptr<V> &getValue() const {
+        return value;
+    }
+
+    bool isTombstone() const {
+        return value == nullptr;
+    }
+
+    MVCCVersion<V> *getOlder() const {
+        return older.load(std::memory_order_acquire);
+    }
+
+    void setOlder(MVCCVersion<V> *older) {
+        this->older.store(older, std::memory_order_release);
+    }
+};
+
+/**
+ * Every version of a key, from the newest to the oldest. Writers of the key take the lock, readers just walk it
+ */
+template<typename V>
+class MVCCVersionChain {
+
+private:
+    std::mutex lock;
+
+    std::atomic<MVCCVersion<V> *> newest;
+
+    //Set when the chain is about to be taken out of the list, writers have to find or create another one
+    bool removed;
+
+public:
+    MVCCVersionChain() : newest(nullptr), removed(false) {}
+
+    MVCCVersionChain(const MVCCVersionChain &) = delete;
+
+    MVCCVersionChain &operator=(const MVCCVersionChain &) = delete;
+
+    ~MVCCVersionChain() {
+
+        MVCCVersion<V> *current = this->newest.load();
+
+        while (current != nullptr) {
+            MVCCVersion<V> *older = current->getOlder();
+
+            delete current;
+
+            current = older;
+        }
+    }
+
+    std::mutex &getLock() {
+        return lock;
+    }
+
+    MVCCVersion<V> *getNewest() const {
+        return newest.load(std::memory_order_acquire);
+    }
+
+    void setNewest(MVCCVersion<V> *newest) {
+        this->newest.store(newest, std::memory_order_release);
+    }
+
+    bool isRemoved() const {
+        return removed;
+    }
+
+    void setRemoved(bool removed) {
+        this->removed = removed;
+    }
+
+    /**
+     * The newest version that was committed at or before the given version, null if there is none
+     */
+    const MVCCVersion<V> *versionAt(uint64_t version) const {
+
+        const MVCCVersion<V> *current = getNewest();
+
+        while (current != nullptr && current->getVersion() > version) {
+            current = current->getOlder();
+        }
+
+        return current;
+    }
+};
+
+/**
+ * The ConcurrentSkipList that maps every key to its version chain, with the lookups the MVCCSkipList needs
+ */
+template<typename T, typename V>
+class MVCCIndex : public ConcurrentSkipList<T, MVCCVersionChain<V>> {
+
+public:
+    typedef ConcurrentSkipNode<T, MVCCVersionChain<V>> Node;
+
+    EpochReclaimer &getReclaimer() {
+        return this->reclaimer;
+    }
+
+    /**
+     * The node of the key, even if it's being removed. Null if the key is not in the list
+     */
+    Node *findChain(const T &key) {
+
+        Node *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
+
+        int levelFound = this->concurrentFindNode(key, predecessors, successors);
+
+        return levelFound == -1 ? nullptr : successors[levelFound];
+    }
+
+    /**
+     * The node of the key, inserting it with an empty chain if it's not in the list yet
+     */
+    Node *findOrAddChain(const std::shared_ptr<T> &key) {
+
+        Node *node = findChain(*key);
+
+        if (node != nullptr && node->isFullyLinked() && !node->isMarked()) {
+            return node;
+        }
+
+        return this->insertNode(key, std::make_shared<MVCCVersionChain<V>>(), false);
+    }
+
+    Node *first() {
+        return (Node *) this->getRoot()->getNextNode(0);
+    }
+
+    /**
+     * The first node with a key >= to the given one
+     */
+    Node *seek(const T &key) {
+
+        Node *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
+
+        this->concurrentFindNode(key, predecessors, successors);
+
+        return successors[0];
+    }
+
+    /**
+     * The last node with a key < than the given one, null if there is none
+     */
+    Node *before(const T &key) {
+
+        Node *predecessors[SKIP_LIST_HEIGHT_LIMIT], *successors[SKIP_LIST_HEIGHT_LIMIT];
+
+        this->concurrentFindNode(key, predecessors, successors);
+
+        return predecessors[0] == this->getRoot() ? nullptr : predecessors[0];
+    }
+
+    Node *last() {
+
+        SkipNode<T, MVCCVersionChain<V>> *current = this->getRoot();
+
+        for (int level = this->getListLevel(); level >= 0; level--) {
+            while (current->getNextNode(level) != nullptr) {
+                current = current->getNextNode(level);
+            }
+        }
+
+        return current == this->getRoot() ? nullptr : (Node *) current;
+    }
+};
+
+/**
+ * Multi version concurrent skip list (MVCC).
+ *
+ * Every key keeps a chain of versions, each stamped by a global commit counter. Commits become visible in the order
+ * of their stamps, so reading every chain at one stamp gives the exact state of the map right after that commit, no
+ * matter what the writers are doing in the meantime.
+ *
+ * snapshot() pins the current stamp: the reads and range scans of the snapshot never change and never block writers,
+ * and since a snapshot holds no reclamation guard between its operations, it doesn't hold up the freeing of removed
+ * nodes either. The plain reads of the map work on the latest visible stamp, and its scans take a snapshot of their
+ * own, so they never see half of a concurrent change.
+ *
+ * Versions that no snapshot can see anymore are cut from the chains by the writers of the key and by a collection
+ * that goes through part of the list every MVCC_COLLECT_INTERVAL commits. Keys whose last version is a removal that
+ * every snapshot already sees are taken out of the list.
+ */
+template<typename T, typename V>
+class MVCCSkipList : public OrderedMap<T, V> {
+
+public:
+    typedef typename MVCCIndex<T, V>::Node Node;
+
+    /**
+     * A consistent view of the map at one commit. Must be destroyed before the map
+     */
+    class Snapshot {
+
+    private:
+        MVCCSkipList<T, V> *list;
+
+        uint64_t version;
+
+        Snapshot(MVCCSkipList<T, V> *list, uint64_t version) : list(list), version(version) {}
+
+        friend class MVCCSkipList<T, V>;
+
+    public:
+        Snapshot(const Snapshot &) = delete;
+
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        ~Snapshot() {
+            list->releaseSnapshot(version);
+        }
+
+        uint64_t getVersion() const {
+            return version;
+        }
+
+        bool hasKey(const T &key) {
+            return get(key).has_value();
+        }
+
+        std::optional<std::shared_ptr<V>> get(const T &key) {
+
+            auto guard = list->index.getReclaimer().enter();
+
+            Node *node = list->index.findChain(key);
+
+            if (node == nullptr) return std::nullopt;
+
+            const MVCCVersion<V> *found = node->getValueVal()->versionAt(version);
+
+            if (found == nullptr || found->isTombstone()) return std::nullopt;
+
+            return found->getValue();
+        }
+
+        std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) {
+
+            auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+            list->scan(version, &base, &max, results.get());
+
+            return results;
+        }
+
+        std::unique_ptr<std::vector<node_info<T, V>>> entries() {
+
+            auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+            list->scan(version, nullptr, nullptr, results.get());
+
+            return results;
+        }
+    };
+
+private:
+    MVCCIndex<T, V> index;
+
+    //The stamp of the last commit that was handed out
+    std::atomic_uint64_t commitCounter;
+
+    //Every commit up to this one is in the chains, snapshots are taken here
+    std::atomic_uint64_t visibleVersion;
+
+    //No reader needs versions older than the newest one <= to this in each chain. Only changes with the snapshot lock
+    std::atomic_uint64_t collectVersion;
+
+    std::mutex snapshotLock;
+
+    std::multiset<uint64_t> activeSnapshots;
+
+    //Only one thread collects at a time, it continues from where the last collection stopped
+    std::mutex collectLock;
+
+    std::shared_ptr<T> collectCursor;
+
+    std::atomic_uint32_t mapSize;
+
+    void releaseSnapshot(uint64_t version) {
+
+        std::lock_guard<std::mutex> lock(this->snapshotLock);
+
+        this->activeSnapshots.erase(this->activeSnapshots.find(version));
+    }
+
+    /**
+     * Move the collection version up to the oldest snapshot, or to the visible version if there are none
+     */
+    void advanceCollectVersion() {
+
+        std::lock_guard<std::mutex> lock(this->snapshotLock);
+
+        uint64_t oldest = this->activeSnapshots.empty() ? this->visibleVersion.load(std::memory_order_acquire)
+                                                         : *this->activeSnapshots.begin();
+
+        this->collectVersion.store(oldest, std::memory_order_release);
+    }
+
+    /**
+     * Wait for every earlier commit to become visible and then make this one visible
+     */
+    void publish(uint64_t version) {
+
+        while (this->visibleVersion.load(std::memory_order_acquire) != version - 1) {
+            std::this_thread::yield();
+        }
+
+        this->visibleVersion.store(version, std::memory_order_release);
+    }
+
+    /**
+     * Cut the versions no reader can need from the chain. Must be called with the lock of the chain
+     *
+     * @return Whether the chain only has a removal that every reader sees, so the key can leave the list
+     */
+    bool collectChain(MVCCVersionChain<V> *chain) {
+
+        uint64_t horizon = this->collectVersion.load(std::memory_order_acquire);
+
+        MVCCVersion<V> *newest = chain->getNewest(), *keeper = newest;
+
+        //Every reader reads at or after the horizon, so none of them goes past this version
+        while (keeper != nullptr && keeper->getVersion() > horizon) {
+            keeper = keeper->getOlder();
+        }
+
+        if (keeper == nullptr) return false;
+
+        MVCCVersion<V> *older = keeper->getOlder();
+
+        keeper->setOlder(nullptr);
+
+        while (older != nullptr) {
+            MVCCVersion<V> *next = older->getOlder();
+
+            //Readers that started before the horizon moved might still be on it
+            this->index.getReclaimer().retire(older);
+
+            older = next;
+        }
+
+        return keeper == newest && keeper->isTombstone();
+    }
+
+    /**
+     * Collect the chain of the node, and take the key out of the list when nobody can see it anymore
+     */
+    void collectNode(Node *node) {
+
+        MVCCVersionChain<V> *chain = node->getValueVal();
+
+        std::unique_lock<std::mutex> lock(chain->getLock());
+
+        if (chain->isRemoved() || !collectChain(chain)) return;
+
+        chain->setRemoved(true);
+
+        lock.unlock();
+
+        this->index.remove(*node->getKeyVal());
+    }
+
+    /**
+     * Go through the next MVCC_COLLECT_STEP keys of the list, or through all of them
+     *
+     * @param everything Whether to go through the whole list, waiting for any collection that is running. Otherwise
+     *                   the step is skipped when another thread is already collecting
+     */
+    void collectStep(bool everything) {
+
+        std::unique_lock<std::mutex> lock(this->collectLock, std::defer_lock);
+
+        if (everything) {
+            lock.lock();
+        } else if (!lock.try_lock()) {
+            return;
+        }
+
+        advanceCollectVersion();
+
+        auto guard = this->index.getReclaimer().enter();
+
+        Node *node = everything || this->collectCursor == nullptr ? this->index.first()
+                                                                  : this->index.seek(*this->collectCursor);
+
+        for (unsigned int step = 0; node != nullptr && (everything || step < MVCC_COLLECT_STEP); step++) {
+
+            Node *next = (Node *) node->getNextNode(0);
+
+            collectNode(node);
+
+            node = next;
+        }
+
+        //The next collection starts over from the beginning when this one reached the end
+        this->collectCursor = node == nullptr ? nullptr : node->getKey();
+    }
+
+    /**
+     * The newest visible version of the chain, null if there is none
+     */
+    const MVCCVersion<V> *latestVersion(const MVCCVersionChain<V> *chain) {
+
+        uint64_t version = this->visibleVersion.load(std::memory_order_acquire);
+
+        while (true) {
+            const MVCCVersion<V> *found = chain->versionAt(version);
+
+            if (found != nullptr) return found;
+
+            //Without a snapshot the version we read at can be collected under us, but only after the visible version
+            //Has moved past it, so reading again at the new visible version finds it
+            uint64_t current = this->visibleVersion.load(std::memory_order_acquire);
+
+            if (current == version) return nullptr;
+
+            version = current;
+        }
+    }
+
+    /**
+     * The value of the key before the commit, or a null pointer if there was none
+     *
+     * @param newKey The key to insert if it's not in the list, only needed when adding
+     * @param value The new value, or a null pointer to remove the key
+     */
+    std::shared_ptr<V> commit(const T &key, const std::shared_ptr<T> &newKey, std::shared_ptr<V> value) {
+
+        auto guard = this->index.getReclaimer().enter();
+
+        bool removal = value == nullptr;
+
+        while (true) {
+            Node *node = removal ? this->index.findChain(key) : this->index.findOrAddChain(newKey);
+
+            if (node == nullptr) return nullptr;
+
+            MVCCVersionChain<V> *chain = node->getValueVal();
+
+            std::unique_lock<std::mutex> lock(chain->getLock());
+
+            if (chain->isRemoved()) {
+                //The chain is leaving the list, wait for it to be gone and use a new one
+                lock.unlock();
+
+                std::this_thread::yield();
+
+                continue;
+            }
+
+            MVCCVersion<V> *newest = chain->getNewest();
+
+            std::shared_ptr<V> previous = newest == nullptr ? nullptr : newest->getValue();
+
+            //Removing a key that isn't there doesn't need a commit
+            if (removal && previous == nullptr) return nullptr;
+
+            uint64_t version = this->commitCounter.fetch_add(1) + 1;
+
+            chain->setNewest(new MVCCVersion<V>(version, std::move(value), newest));
+
+            if (previous == nullptr) {
+                this->mapSize++;
+            } else if (removal) {
+                this->mapSize--;
+            }
+
+            collectChain(chain);
+
+            lock.unlock();
+
+            publish(version);
+
+            if (version % MVCC_COLLECT_INTERVAL == 0) {
+                collectStep(false);
+            }
+
+            return previous;
+        }
+    }
+
+    /**
+     * Add the visible entries at the version with keys between base and max (Both inclusive and optional) to results
+     */
+    void scan(uint64_t version, const T *base, const T *max, std::vector<node_info<T, V>> *results) {
+
+        auto guard = this->index.getReclaimer().enter();
+
+        Node *node = base == nullptr ? this->index.first() : this->index.seek(*base);
+
+        //Nodes inserted or removed while we go through the list only have versions the snapshot doesn't see
+        while (node != nullptr && (max == nullptr || !(*max < *node->getKeyVal()))) {
+
+            const MVCCVersion<V> *found = node->getValueVal()->versionAt(version);
+
+            if (found != nullptr && !found->isTombstone()) {
+                results->push_back(std::make_tuple(node->getKey(), found->getValue()));
+            }
+
+            node = (Node *) node->getNextNode(0);
+        }
+    }
+
+    std::optional<node_info<T, V>> peekFrom(Node *node, bool forward) {
+
+        while (node != nullptr) {
+            const MVCCVersion<V> *found = latestVersion(node->getValueVal());
+
+            if (found != nullptr && !found->isTombstone()) {
+                return std::make_tuple(node->getKey(), found->getValue());
+            }
+
+            node = forward ? (Node *) node->getNextNode(0) : this->index.before(*node->getKeyVal());
+        }
+
+        return std::nullopt;
+    }
+
+public:
+    MVCCSkipList() : commitCounter(0), visibleVersion(0), collectVersion(0), mapSize(0) {}
+
+    /**
+     * Pin the current version of the map, its reads will keep seeing it until the snapshot is destroyed
+     */
+    std::unique_ptr<Snapshot> snapshot() {
+
+        std::lock_guard<std::mutex> lock(this->snapshotLock);
+
+        //Taken with the lock, so the collection version can't move past it before it's registered
+        uint64_t version = this->visibleVersion.load(std::memory_order_acquire);
+
+        this->activeSnapshots.insert(version);
+
+        return std::unique_ptr<Snapshot>(new Snapshot(this, version));
+    }
+
+    /**
+     * Collect every version that no snapshot needs anymore, instead of waiting for the writers to do it
+     */
+    void collectGarbage() {
+        collectStep(true);
+    }
+
+    /**
+     * How many versions the chains hold, counting removals. Goes through the whole list
+     */
+    unsigned int versionCount() {
+
+        auto guard = this->index.getReclaimer().enter();
+
+        unsigned int count = 0;
+
+        for (Node *node = this->index.first(); node != nullptr; node = (Node *) node->getNextNode(0)) {
+            for (auto *version = node->getValueVal()->getNewest(); version != nullptr; version = version->getOlder()) {
+                count++;
+            }
+        }
+
+        return count;
+    }
+
+    uint64_t getVisibleVersion() const {
+        return this->visibleVersion.load(std::memory_order_acquire);
+    }
+
+    unsigned int size() override {
+        return this->mapSize.load();
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+        commit(*key, key, std::move(value));
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        std::shared_ptr<V> previous = commit(key, nullptr, nullptr);
+
+        if (previous == nullptr) return std::nullopt;
+
+        return previous;
+    }
+
+    bool hasKey(const T &key) override {
+        return get(key).has_value();
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        auto guard = this->index.getReclaimer().enter();
+
+        Node *node = this->index.findChain(key);
+
+        if (node == nullptr) return std::nullopt;
+
+        const MVCCVersion<V> *found = latestVersion(node->getValueVal());
+
+        if (found == nullptr || found->isTombstone()) return std::nullopt;
+
+        return found->getValue();
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        auto cache = entries();
+
+        for (node_info<T, V> &entry : *cache) {
+            results->push_back(std::move(std::get<0>(entry)));
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        auto cache = entries();
+
+        for (node_info<T, V> &entry : *cache) {
+            results->push_back(std::move(std::get<1>(entry)));
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+        return snapshot()->entries();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+        return snapshot()->rangeSearch(base, max);
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+
+        auto guard = this->index.getReclaimer().enter();
+
+        return peekFrom(this->index.first(), true);
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+
+        auto guard = this->index.getReclaimer().enter();
+
+        return peekFrom(this->index.last(), false);
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        while (true) {
+            auto smallest = peekSmallest();
+
+            if (!smallest) return std::nullopt;
+
+            //Another thread might have taken it first
+            auto value = remove(*std::get<0>(*smallest));
+
+            if (value) {
+                return std::make_tuple(std::move(std::get<0>(*smallest)), std::move(*value));
+            }
+        }
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        while (true) {
+            auto largest = peekLargest();
+
+            if (!largest) return std::nullopt;
+
+            auto value = remove(*std::get<0>(*largest));
+
+            if (value) {
+                return std::make_tuple(std::move(std::get<0>(*largest)), std::move(*value));
+            }
+        }
+    }
+};
+
+#endif //TRABALHO1_MVCCSKIPLIST_H
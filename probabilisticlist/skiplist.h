@@ -4,14 +4,64 @@
 #include <chrono>
 #include <memory>
 #include <random>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <vector>
 #include "../datastructures.h"
 
-//Since most cache lines are around 64 bytes long, we can keep an array of 8 64 bit pointers
-//To improve cache performance
+//Maximum level of a node, the towers have room for levels 0 to level (inclusive)
 #define SKIP_LIST_HEIGHT_LIMIT 28
-#define FIRST_BIT_MASK 0x1
 
+/**
+ * Random level for a new node, where each level is half as likely as the one below it.
+ *
+ * Every thread has its own wyrand generator, so inserting threads share no state, and the level is the amount of
+ * trailing ones of a single random word, so there's no loop. The bit set on the complement caps the level.
+ */
+inline int generateSkipListLevel() {
+
+    static thread_local uint64_t state = std::random_device()() ^
+                                         (uint64_t) std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    state += 0xA0761D6478BD642FULL;
+
+    __uint128_t product = (__uint128_t) state * (state ^ 0xE7037ED1A0B428DBULL);
+
+    uint64_t random = (uint64_t) (product >> 64) ^ (uint64_t) product;
+
+    return __builtin_ctzll(~random | (1ULL << (SKIP_LIST_HEIGHT_LIMIT - 1)));
+}
+
+template<typename T, typename V>
+class SkipNode;
+
+/**
+ * Nodes are not allocated with new, so they need their own deleter
+ */
+template<typename T, typename V>
+struct SkipNodeDeleter {
+    void operator()(SkipNode<T, V> *node) const;
+};
+
+template<typename T, typename V>
+using SkipNodePtr = std::unique_ptr<SkipNode<T, V>, SkipNodeDeleter<T, V>>;
+
+/**
+ * A node and its tower of forward pointers live in a single allocation.
+ *
+ * The tower is placed right before the node (Level 0 is the pointer just before it, level 1 the one before that and
+ * so on), so subclasses can still add their own fields, and the search touches the forward pointer and the key in
+ * the same cache line instead of chasing a pointer to a separately allocated array.
+ *
+ * Before the pointers there is a second tower with the span of each link, the amount of level 0 steps it skips,
+ * laid out the same way. Only the SkipList keeps the spans up to date.
+ *
+ * The level 0 link is the only place the next node is kept, and whoever holds the node before it owns it. Nodes
+ * don't free the node after them, the lists walk level 0 to free the chain.
+ */
 template<typename T, typename V>
 class SkipNode {
 
@@ -19,21 +69,76 @@ protected:
     std::shared_ptr<T> key;
     std::shared_ptr<V> value;
 
-    std::vector<SkipNode<T, V> *> height_levels;
+    int level;
 
-    std::unique_ptr<SkipNode<T, V>> nextNode;
+    //Concurrent lists read the links without locks, the acquire loads and release stores are plain moves on x86
+    typedef std::atomic<SkipNode<T, V> *> Link;
 
-    int level;
+    static_assert(sizeof(Link) == sizeof(SkipNode<T, V> *), "A link has to take the space of a pointer");
+
+    Link *getTower() {
+        return reinterpret_cast<Link *>(this);
+    }
+
+    unsigned int *getSpanTower() {
+        return reinterpret_cast<unsigned int *>(reinterpret_cast<char *>(this) - (level + 1) * sizeof(Link));
+    }
+
+    /**
+     * Bytes taken by the tower of a node with the given level, rounded so the node after it stays aligned
+     */
+    static size_t towerSize(int level) {
+        size_t size = (level + 1) * (sizeof(Link) + sizeof(unsigned int));
+
+        return (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    }
 
 public:
     SkipNode(std::shared_ptr<T> key, std::shared_ptr<V> value, int level) : key(std::move(key)),
                                                                             value(std::move(value)),
-                                                                            height_levels(SKIP_LIST_HEIGHT_LIMIT),
                                                                             level(level) {
     }
 
-    ~SkipNode() {
-        this->nextNode.reset();
+    virtual ~SkipNode() {}
+
+    /**
+     * Allocate the tower and the node in a single block, the tower starts out empty
+     *
+     * @tparam Node The type of node to create, SkipNode or one of its subclasses
+     * @param args The arguments to pass to the node constructor
+     */
+    template<typename Node, typename... Args>
+    static std::unique_ptr<Node, SkipNodeDeleter<T, V>> createNode(int level, Args &&... args) {
+
+        static_assert(alignof(Node) <= alignof(std::max_align_t), "Skip nodes can't be over aligned");
+
+        size_t tower = towerSize(level);
+
+        char *block = static_cast<char *>(::operator new(tower + sizeof(Node)));
+
+        //Every pointer starts as null and every span as 0
+        std::memset(block, 0, tower);
+
+        for (int link = 1; link <= level + 1; link++) {
+            new(reinterpret_cast<Link *>(block + tower) - link) Link(nullptr);
+        }
+
+        try {
+            return std::unique_ptr<Node, SkipNodeDeleter<T, V>>(new(block + tower) Node(std::forward<Args>(args)...));
+        } catch (...) {
+            ::operator delete(block);
+
+            throw;
+        }
+    }
+
+    static void destroyNode(SkipNode<T, V> *node) {
+
+        char *block = reinterpret_cast<char *>(node) - towerSize(node->level);
+
+        node->~SkipNode();
+
+        ::operator delete(block);
     }
 
     std::shared_ptr<T> getKey() const {
@@ -52,17 +157,27 @@ public:
         return key.get();
     }
 
-    void setBaseNext(std::unique_ptr<SkipNode<T, V>> next) {
-        this->nextNode = std::move(next);
-        this->height_levels[0] = this->nextNode.get();
+    V *getValueVal() {
+        return value.get();
+    }
+
+    /**
+     * Link the given node after this one, this node now owns it
+     */
+    void setBaseNext(SkipNodePtr<T, V> next) {
+        this->getTower()[-1].store(next.release(), std::memory_order_release);
     }
 
     void setNext(int nodeHeight, SkipNode<T, V> *next) {
-        this->height_levels[nodeHeight] = next;
+        this->getTower()[-1 - nodeHeight].store(next, std::memory_order_release);
     }
 
-    std::unique_ptr<SkipNode<T, V>> getNextOwnership() {
-        return std::move(this->nextNode);
+    /**
+     * Take over the node after this one. The link keeps pointing to it, so readers going through this node can still
+     * follow it, until it's replaced with setBaseNext
+     */
+    SkipNodePtr<T, V> getNextOwnership() {
+        return SkipNodePtr<T, V>(this->getTower()[-1].load(std::memory_order_relaxed));
     }
 
     int getLevel() {
@@ -70,20 +185,49 @@ public:
     }
 
     SkipNode<T, V> *getNextNode(int level) {
-        return height_levels[level];
+        return this->getTower()[-1 - level].load(std::memory_order_acquire);
+    }
+
+    unsigned int getSpan(int level) {
+        return this->getSpanTower()[-1 - level];
+    }
+
+    void setSpan(int level, unsigned int span) {
+        this->getSpanTower()[-1 - level] = span;
     }
 
 };
 
+template<typename T, typename V>
+void SkipNodeDeleter<T, V>::operator()(SkipNode<T, V> *node) const {
+    SkipNode<T, V>::destroyNode(node);
+}
+
+/**
+ * Where a search ended: the last node before the key in every level, and the position of each of those nodes.
+ *
+ * Searching for a key a little after the finger only climbs until a level jumps past the key and comes back down,
+ * so it costs O(log d), d being the distance from the finger, instead of starting from the top of the list.
+ */
+template<typename T, typename V>
+struct SkipListFinger {
+    SkipNode<T, V> *predecessors[SKIP_LIST_HEIGHT_LIMIT];
+
+    unsigned int ranks[SKIP_LIST_HEIGHT_LIMIT];
+
+    //The version of the list when the finger was taken, it can only be used if the list didn't change since
+    unsigned long version;
+
+    SkipListFinger() : version(0) {
+        predecessors[0] = nullptr;
+    }
+};
+
 template<typename T, typename V>
 class SkipList : public OrderedMap<T, V> {
 
 private:
-    std::random_device randomEngine;
-    std::mt19937 generator;
-    std::uniform_int_distribution<unsigned int> distribution;
-
-    std::unique_ptr<SkipNode<T, V>> rootNode;
+    SkipNodePtr<T, V> rootNode;
 
     SkipNode<T, V> *lastNode;
 
@@ -91,30 +235,36 @@ private:
 
     unsigned int listSize;
 
+    //Changes every time a node is added or removed
+    unsigned long listVersion;
+
+    //Where the last add or remove ended, nearly sorted writes start their search from here
+    SkipListFinger<T, V> finger;
+
     unsigned long timeTakenFound, timeTakenInsert;
 
 public:
-    SkipList() : randomEngine(),
-                 rootNode(initializeNodeRoot(SKIP_LIST_HEIGHT_LIMIT)),
-                 listSize(0),
-                 listLevel(0),
+    SkipList() : rootNode(initializeNodeRoot(SKIP_LIST_HEIGHT_LIMIT)),
                  lastNode(nullptr),
+                 listLevel(0),
+                 listSize(0),
+                 listVersion(1),
                  timeTakenFound(0),
                  timeTakenInsert(0) {
-        this->generator = std::mt19937(randomEngine());
     }
 
-    SkipList(std::unique_ptr<SkipNode<T, V>> root) : randomEngine(),
-                                                     rootNode(std::move(root)),
-                                                     listSize(0),
-                                                     listLevel(0),
-                                                     lastNode(nullptr) {
-        this->generator = std::mt19937(randomEngine());
+    SkipList(SkipNodePtr<T, V> root) : rootNode(std::move(root)),
+                                       lastNode(nullptr),
+                                       listLevel(0),
+                                       listSize(0),
+                                       listVersion(1),
+                                       timeTakenFound(0),
+                                       timeTakenInsert(0) {
     }
 
     ~SkipList() override {
 
-        std::unique_ptr<SkipNode<T,V>> current = std::move(this->rootNode);
+        SkipNodePtr<T, V> current = std::move(this->rootNode);
 
         while (current.get()->getNextNode(0) != nullptr) {
             //By reassigning the unique_ptr, the previous one gets deleted
@@ -132,43 +282,37 @@ protected:
     }
 
     int generateLevel() {
-        unsigned int random = distribution(generator);
-
-        //Maybe get the amount of consecutive bits that have been set to 1 to get the correct level,
-        //Instead of generating a new number every single time?
-
-        int level = 0;
-
-        while ((random & FIRST_BIT_MASK) != 0 && level < SKIP_LIST_HEIGHT_LIMIT) {
-            level++;
-
-            random = random >> 1;
-        }
-
-        // std::cout << "Generated level: " << level << std::endl;
-
-        return level;
+        return generateSkipListLevel();
     }
 
-    virtual std::unique_ptr<SkipNode<T, V>> initializeNode(std::shared_ptr<T> key, std::shared_ptr<V> value) {
-        return std::make_unique<SkipNode<T, V>>(std::move(key), std::move(value), generateLevel());
+    virtual SkipNodePtr<T, V> initializeNode(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+        int level = generateLevel();
+
+        return SkipNode<T, V>::template createNode<SkipNode<T, V>>(level, std::move(key), std::move(value), level);
     }
 
-    virtual std::unique_ptr<SkipNode<T, V>> initializeNodeRoot(int level) {
-        return std::make_unique<SkipNode<T, V>>(std::shared_ptr<T>(), std::shared_ptr<V>(), level);
+    virtual SkipNodePtr<T, V> initializeNodeRoot(int level) {
+        return SkipNode<T, V>::template createNode<SkipNode<T, V>>(level, std::shared_ptr<T>(), std::shared_ptr<V>(),
+                                                                  level);
     }
 
     SkipNode<T, V> *getRoot() {
         return this->rootNode.get();
     }
 
-    void setRootNode(std::unique_ptr<SkipNode<T, V>> root) {
-        this->rootNode = root;
+    void setRootNode(SkipNodePtr<T, V> root) {
+        this->rootNode = std::move(root);
     }
 
-    SkipNode<T, V> *findNode(const T &key, SkipNode<T, V> **toUpdate) {
+    /**
+     * @param ranks If not null, filled with the rank of the node left in toUpdate for each level
+     * (The amount of level 0 steps from the root to it)
+     */
+    SkipNode<T, V> *findNode(const T &key, SkipNode<T, V> **toUpdate, unsigned int *ranks = nullptr) {
         SkipNode<T, V> *current = this->getRoot();
 
+        unsigned int rank = 0;
+
         //Start in the highest level
         for (int currentLevel = this->getListLevel(); currentLevel >= 0; currentLevel--) {
 
@@ -177,6 +321,8 @@ protected:
             while (next != nullptr &&
                    *next->getKeyVal() < key) {
                 //Find the largest key in the current level that is smaller than the key we're looking for
+                rank += current->getSpan(currentLevel);
+
                 current = next;
                 next = next->getNextNode(currentLevel);
             }
@@ -186,6 +332,10 @@ protected:
                 //So that we can update it if the new node we inserted has a level >= to the currentLevel
                 toUpdate[currentLevel] = current;
             }
+
+            if (ranks != nullptr) {
+                ranks[currentLevel] = rank;
+            }
         }
 
         //Since we find the largest node that's smaller than key, if the node that follows it is not the node we are looking
@@ -193,6 +343,103 @@ protected:
         return current->getNextNode(0);
     }
 
+    /**
+     * Same as findNode, but starts from the finger when the key comes after it. Falls back to a search from the
+     * root if the finger is stale or the key is behind it
+     *
+     * @param toUpdate Must not be null, along with ranks, both are filled for every level
+     */
+    SkipNode<T, V> *findNodeFrom(const SkipListFinger<T, V> &start, const T &key, SkipNode<T, V> **toUpdate,
+                                 unsigned int *ranks) {
+
+        SkipNode<T, V> *current = start.predecessors[0];
+
+        if (start.version != this->listVersion || current == nullptr ||
+            (current != this->getRoot() && !(*current->getKeyVal() < key))) {
+            return findNode(key, toUpdate, ranks);
+        }
+
+        int listLevel = this->getListLevel(), topLevel = 0;
+
+        //Climb until the next node in the level is past the key, that level and the ones above it don't change
+        while (topLevel <= listLevel) {
+            SkipNode<T, V> *next = start.predecessors[topLevel]->getNextNode(topLevel);
+
+            if (next == nullptr || !(*next->getKeyVal() < key)) break;
+
+            topLevel++;
+        }
+
+        for (int level = listLevel; level >= topLevel; level--) {
+            toUpdate[level] = start.predecessors[level];
+            ranks[level] = start.ranks[level];
+        }
+
+        if (topLevel == 0) return start.predecessors[0]->getNextNode(0);
+
+        //Continue from the highest level that is still behind the key
+        current = start.predecessors[topLevel - 1];
+
+        unsigned int rank = start.ranks[topLevel - 1];
+
+        for (int currentLevel = topLevel - 1; currentLevel >= 0; currentLevel--) {
+
+            SkipNode<T, V> *next = current->getNextNode(currentLevel);
+
+            while (next != nullptr && *next->getKeyVal() < key) {
+                rank += current->getSpan(currentLevel);
+
+                current = next;
+                next = next->getNextNode(currentLevel);
+            }
+
+            toUpdate[currentLevel] = current;
+            ranks[currentLevel] = rank;
+        }
+
+        return current->getNextNode(0);
+    }
+
+    /**
+     * Leave the finger where the search for an add or a remove ended
+     */
+    void moveFinger(SkipListFinger<T, V> &toMove, SkipNode<T, V> **predecessors, const unsigned int *ranks) {
+
+        int levels = this->getListLevel() + 1;
+
+        std::copy(predecessors, predecessors + levels, toMove.predecessors);
+        std::copy(ranks, ranks + levels, toMove.ranks);
+
+        toMove.version = this->listVersion;
+    }
+
+    /**
+     * Find the node in the given position by following the spans, with 1 being the first node
+     */
+    SkipNode<T, V> *findNodeByRank(unsigned int rank) {
+
+        SkipNode<T, V> *current = this->getRoot();
+
+        unsigned int traversed = 0;
+
+        for (int currentLevel = this->getListLevel(); currentLevel >= 0; currentLevel--) {
+
+            while (current->getNextNode(currentLevel) != nullptr &&
+                   traversed + current->getSpan(currentLevel) <= rank) {
+
+                traversed += current->getSpan(currentLevel);
+
+                current = current->getNextNode(currentLevel);
+            }
+
+            if (traversed == rank) {
+                return current;
+            }
+        }
+
+        return nullptr;
+    }
+
     void traverseList(std::vector<node_info<T, V>> *destination) {
 
         SkipNode<T, V> *current = getRoot()->getNextNode(0);
@@ -206,17 +453,23 @@ protected:
 
     }
 
-public:
-    virtual void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+    /**
+     * Add the key, searching from the given finger, which is then moved to the new key
+     *
+     * @return The node of the key
+     */
+    SkipNode<T, V> *insertFrom(SkipListFinger<T, V> &start, std::shared_ptr<T> key, std::shared_ptr<V> value) {
 
         SkipNode<T, V> *update[SKIP_LIST_HEIGHT_LIMIT] = {nullptr};
 
+        unsigned int ranks[SKIP_LIST_HEIGHT_LIMIT] = {0};
+
         const T &keyRef = *key;
 
-        SkipNode<T, V> *current = findNode(keyRef, update);
+        SkipNode<T, V> *current = findNodeFrom(start, keyRef, update, ranks);
 
         if (current == nullptr || !(*current->getKeyVal() == keyRef)) {
-            std::unique_ptr<SkipNode<T, V>> newNodeOwnership = initializeNode(std::move(key), std::move(value));
+            SkipNodePtr<T, V> newNodeOwnership = initializeNode(std::move(key), std::move(value));
 
             SkipNode<T, V> *createdNode = newNodeOwnership.get();
 
@@ -224,6 +477,11 @@ public:
 
                 for (int i = getListLevel() + 1; i <= createdNode->getLevel(); i++) {
                     update[i] = this->getRoot();
+
+                    ranks[i] = 0;
+
+                    //The root link in an unused level skips the whole list
+                    update[i]->setSpan(i, this->listSize);
                 }
 
                 setListLevel(createdNode->getLevel());
@@ -232,6 +490,13 @@ public:
             for (int nodeLevel = 0; nodeLevel <= createdNode->getLevel(); nodeLevel++) {
                 SkipNode<T, V> *lastChecked = update[nodeLevel];
 
+                //The steps between the predecessor in this level and the new node
+                unsigned int stepsBefore = ranks[0] - ranks[nodeLevel];
+
+                createdNode->setSpan(nodeLevel, lastChecked->getSpan(nodeLevel) - stepsBefore);
+
+                lastChecked->setSpan(nodeLevel, stepsBefore + 1);
+
                 if (nodeLevel == 0) {
                     auto nextNodeOwnership = lastChecked->getNextOwnership();
 
@@ -245,15 +510,38 @@ public:
                 }
             }
 
+            //The links above the new node now skip over it too
+            for (int nodeLevel = createdNode->getLevel() + 1; nodeLevel <= getListLevel(); nodeLevel++) {
+                update[nodeLevel]->setSpan(nodeLevel, update[nodeLevel]->getSpan(nodeLevel) + 1);
+            }
+
             if (createdNode->getNextNode(0) == nullptr) {
                 this->lastNode = createdNode;
             }
 
             this->listSize++;
 
-        } else {
-            current->setValue(std::move(value));
+            this->listVersion++;
+
+            //The predecessors of the new node come before it, so their positions didn't change
+            moveFinger(start, update, ranks);
+
+            return createdNode;
         }
+
+        current->setValue(std::move(value));
+
+        moveFinger(start, update, ranks);
+
+        return current;
+    }
+
+public:
+    /**
+     * Nearly sorted inserts are cheap, as the search starts where the previous add or remove ended
+     */
+    virtual void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+        insertFrom(this->finger, std::move(key), std::move(value));
     }
 
     virtual bool hasKey(const T &key) override {
@@ -280,15 +568,31 @@ public:
     virtual std::optional<std::shared_ptr<V>> remove(const T &key) override {
         SkipNode<T, V> *update[SKIP_LIST_HEIGHT_LIMIT] = {nullptr};
 
-        SkipNode<T, V> *current = findNode(key, update);
+        unsigned int ranks[SKIP_LIST_HEIGHT_LIMIT] = {0};
+
+        SkipNode<T, V> *current = findNodeFrom(this->finger, key, update, ranks);
 
         if (current == nullptr || !(*current->getKeyVal() == key)) {
+            moveFinger(this->finger, update, ranks);
+
             return std::nullopt;
         } else {
 
             //We want to keep the reference alive because we still need to access the next nodes
             //When we are done moving the references is when we know this node can be disposed of
-            std::unique_ptr<SkipNode<T, V>> nodeOwnership;
+            SkipNodePtr<T, V> nodeOwnership;
+
+            for (int nodeLevel = 0; nodeLevel <= getListLevel(); nodeLevel++) {
+
+                SkipNode<T, V> *lastChecked = update[nodeLevel];
+
+                if (lastChecked->getNextNode(nodeLevel) == current) {
+                    //The predecessor now skips whatever the removed node used to skip
+                    lastChecked->setSpan(nodeLevel, lastChecked->getSpan(nodeLevel) + current->getSpan(nodeLevel) - 1);
+                } else {
+                    lastChecked->setSpan(nodeLevel, lastChecked->getSpan(nodeLevel) - 1);
+                }
+            }
 
             for (int nodeLevel = 0; nodeLevel <= current->getLevel(); nodeLevel++) {
 
@@ -313,6 +617,11 @@ public:
                 setListLevel(getListLevel() - 1);
             }
 
+            this->listVersion++;
+
+            //The predecessors of the removed node came before it, so their positions didn't change
+            moveFinger(this->finger, update, ranks);
+
             return nodeOwnership.get()->getValue();
         }
     }
@@ -347,9 +656,13 @@ public:
 
     std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
 
-        auto keyVector = std::make_unique<std::vector<std::shared_ptr<T>>>(this->size());
+        auto keyVector = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        keyVector->reserve(this->size());
 
-        std::vector<node_info<T, V>> nodeCache(this->size());
+        std::vector<node_info<T, V>> nodeCache;
+
+        nodeCache.reserve(this->size());
 
         traverseList(&nodeCache);
 
@@ -361,9 +674,13 @@ public:
     }
 
     std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
-        auto valueVector = std::make_unique<std::vector<std::shared_ptr<V>>>(this->size());
+        auto valueVector = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        valueVector->reserve(this->size());
 
-        std::vector<node_info<T, V>> nodeCache(this->size());
+        std::vector<node_info<T, V>> nodeCache;
+
+        nodeCache.reserve(this->size());
 
         traverseList(&nodeCache);
 
@@ -375,13 +692,23 @@ public:
     }
 
     std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
-        auto valueVector = std::make_unique<std::vector<node_info<T, V>>>(this->size());
+        auto valueVector = std::make_unique<std::vector<node_info<T, V>>>();
+
+        valueVector->reserve(this->size());
 
         traverseList(valueVector.get());
 
         return valueVector;
     }
 
+    void forEachEntry(const entry_visitor<T, V> &visitor) override {
+
+        for (SkipNode<T, V> *current = getRoot()->getNextNode(0); current != nullptr;
+             current = current->getNextNode(0)) {
+            visitor(current->getKey(), current->getValue());
+        }
+    }
+
     std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
 
         SkipNode<T, V> *node = findNode(base, nullptr);
@@ -400,6 +727,178 @@ public:
         return std::move(result);
     }
 
+    /**
+     * A position in the list that remembers the search that led to it, so it can be used as a hint for another add.
+     * It must not be used after the node it points to is removed
+     */
+    class Iterator {
+
+    private:
+        SkipNode<T, V> *node;
+
+        SkipListFinger<T, V> path;
+
+        friend class SkipList<T, V>;
+
+    public:
+        Iterator() : node(nullptr) {}
+
+        bool valid() const {
+            return node != nullptr;
+        }
+
+        std::shared_ptr<T> key() const {
+            return node->getKey();
+        }
+
+        std::shared_ptr<V> value() const {
+            return node->getValue();
+        }
+
+        void next() {
+            node = node->getNextNode(0);
+        }
+    };
+
+    /**
+     * @return The first entry with a key >= than the given key
+     */
+    Iterator lowerBound(const T &key) {
+
+        SkipNode<T, V> *update[SKIP_LIST_HEIGHT_LIMIT];
+
+        unsigned int ranks[SKIP_LIST_HEIGHT_LIMIT];
+
+        Iterator result;
+
+        result.node = findNode(key, update, ranks);
+
+        moveFinger(result.path, update, ranks);
+
+        return result;
+    }
+
+    Iterator begin() {
+
+        Iterator result;
+
+        result.node = this->getRoot()->getNextNode(0);
+
+        for (int level = 0; level <= this->getListLevel(); level++) {
+            result.path.predecessors[level] = this->getRoot();
+            result.path.ranks[level] = 0;
+        }
+
+        result.path.version = this->listVersion;
+
+        return result;
+    }
+
+    /**
+     * Add the key, starting the search from the hint instead of the top of the list. For keys that come a little after
+     * the hint this is O(log d), d being the distance between them. A hint that is past the key or that was taken
+     * before the list changed is still correct, it just doesn't help.
+     *
+     * @return The position of the added key, to be used as the hint for the next one
+     */
+    Iterator addWithHint(const Iterator &hint, std::shared_ptr<T> key, std::shared_ptr<V> value) {
+
+        Iterator result;
+
+        result.path = hint.path;
+
+        result.node = insertFrom(result.path, std::move(key), std::move(value));
+
+        return result;
+    }
+
+    /**
+     * Add a batch of entries, sorting it first if needed. The batch is merged into the list in a single forward sweep:
+     * the predecessors of each key are found starting from the ones of the key before it, so no search goes back to
+     * the top of the list. When a key shows up more than once in the batch, the last value wins
+     */
+    void addBatch(std::vector<node_info<T, V>> batch) {
+
+        auto keyOrder = [](const node_info<T, V> &first, const node_info<T, V> &second) {
+            return *std::get<0>(first) < *std::get<0>(second);
+        };
+
+        if (!std::is_sorted(batch.begin(), batch.end(), keyOrder)) {
+            std::stable_sort(batch.begin(), batch.end(), keyOrder);
+        }
+
+        Iterator position = begin();
+
+        for (auto &entry : batch) {
+            position.node = insertFrom(position.path, std::move(std::get<0>(entry)), std::move(std::get<1>(entry)));
+        }
+
+        //Later writes near the end of the batch can keep going from there
+        this->finger = position.path;
+    }
+
+    void addSorted(std::vector<node_info<T, V>> sorted) override {
+        addBatch(std::move(sorted));
+    }
+
+    /**
+     * The position of the key in the list, in O(log n)
+     *
+     * @return The amount of keys smaller than the key, or nothing if the key is not in the list
+     */
+    std::optional<unsigned int> rank(const T &key) {
+
+        unsigned int ranks[SKIP_LIST_HEIGHT_LIMIT];
+
+        SkipNode<T, V> *node = findNode(key, nullptr, ranks);
+
+        if (node == nullptr || !(*node->getKeyVal() == key)) {
+            return std::nullopt;
+        }
+
+        return ranks[0];
+    }
+
+    /**
+     * The entry in the given position (Starting at 0), in O(log n)
+     */
+    std::optional<node_info<T, V>> at(unsigned int position) {
+
+        if (position >= this->listSize) {
+            return std::nullopt;
+        }
+
+        SkipNode<T, V> *node = findNodeByRank(position + 1);
+
+        return std::make_tuple(node->getKey(), node->getValue());
+    }
+
+    /**
+     * The entries with positions from lowest to highest (Inclusive), in O(log n + (highest - lowest))
+     */
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeByRank(unsigned int lowest, unsigned int highest) {
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        if (lowest > highest || lowest >= this->listSize) {
+            return result;
+        }
+
+        highest = std::min(highest, this->listSize - 1);
+
+        result->reserve(highest - lowest + 1);
+
+        SkipNode<T, V> *node = findNodeByRank(lowest + 1);
+
+        for (unsigned int position = lowest; position <= highest; position++) {
+            result->push_back(std::make_tuple(node->getKey(), node->getValue()));
+
+            node = node->getNextNode(0);
+        }
+
+        return result;
+    }
+
     std::optional<node_info<T, V>> popSmallest() override {
         auto *root = this->getRoot();
 
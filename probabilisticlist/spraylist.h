@@ -0,0 +1,138 @@
+#ifndef TRABALHO1_SPRAYLIST_H
+#define TRABALHO1_SPRAYLIST_H
+
+#include "concurrentskiplist.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+//How many sprays a pop tries before giving up and taking the exact smallest node
+#define SPRAY_MAX_ATTEMPTS 16
+//How many level 0 nodes after the landing node we look at for one that isn't already taken
+#define SPRAY_CLAIM_WINDOW 4
+
+/**
+ * Relaxed priority queue built on the ConcurrentSkipList (Alistarh et al. "The SprayList").
+ *
+ * With an exact popSmallest every thread fights over the first node of the list. Here popSmallest instead does a
+ * random walk (A spray) that starts a few levels up from the root, jumps a random amount of nodes forward on each
+ * level and then goes down, so it lands on one of roughly the first O(p log³ p) nodes, where p is the amount of
+ * threads. Different threads land on different nodes, so they rarely contend, and the node that is returned is
+ * still close to the smallest one.
+ *
+ * The node is claimed through the normal remove, so the marked flag makes sure every node is only popped once.
+ * When the list gets too small to spray over, it falls back to the exact popSmallest.
+ *
+ * Everything else behaves exactly like the ConcurrentSkipList.
+ */
+template<typename T, typename V>
+class SprayList : public ConcurrentSkipList<T, V> {
+
+private:
+    //The level the spray starts at
+    int sprayHeight;
+    //The largest amount of nodes the spray skips in each level
+    int jumpLength;
+    //How many levels the spray goes down after each jump
+    int descent;
+
+    //Below this size the spray would mostly land past the end of the list
+    unsigned int minimumSize;
+
+    static uint64_t nextRandom() {
+
+        //xorshift64, every thread has its own state so sprays don't share a cache line
+        static thread_local uint64_t state =
+                (uint64_t) std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        return state;
+    }
+
+    /**
+     * @return The node the spray landed on, never the root. Null if it walked off the end of the list
+     */
+    ConcurrentSkipNode<T, V> *spray() {
+
+        SkipNode<T, V> *current = this->getRoot();
+
+        int level = std::min(this->sprayHeight, this->getListLevel());
+
+        while (true) {
+            int jumps = (int) (nextRandom() % (this->jumpLength + 1));
+
+            for (int jump = 0; jump < jumps; jump++) {
+                SkipNode<T, V> *next = current->getNextNode(level);
+
+                if (next == nullptr) break;
+
+                current = next;
+            }
+
+            if (level == 0) break;
+
+            level = std::max(0, level - this->descent);
+        }
+
+        if (current == this->getRoot()) {
+            current = current->getNextNode(0);
+        }
+
+        return (ConcurrentSkipNode<T, V> *) current;
+    }
+
+public:
+    /**
+     * @param threadCount How many threads are going to pop at the same time, the spray gets wider with it
+     */
+    explicit SprayList(unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+
+        double logThreads = std::log2((double) std::max(1u, threadCount));
+
+        this->sprayHeight = (int) logThreads + 1;
+        this->jumpLength = std::max(1, (int) (logThreads * logThreads * logThreads));
+        this->descent = std::max(1, (int) std::log2(std::max(1.0, logThreads)));
+
+        //With a single thread there's nobody to contend with, so the spray would only lose precision
+        this->minimumSize = threadCount <= 1 ? UINT32_MAX : threadCount * this->jumpLength;
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        if (this->size() < this->minimumSize) {
+            return ConcurrentSkipList<T, V>::popSmallest();
+        }
+
+        auto guard = this->reclaimer.enter();
+
+        for (int attempt = 0; attempt < SPRAY_MAX_ATTEMPTS; attempt++) {
+
+            ConcurrentSkipNode<T, V> *node = spray();
+
+            for (int step = 0; node != nullptr && step < SPRAY_CLAIM_WINDOW; step++) {
+
+                if (node->isFullyLinked() && !node->isMarked()) {
+                    std::shared_ptr<T> key = node->getKey();
+
+                    //Only one of the threads that landed on the node gets to mark it
+                    auto value = this->remove(*key);
+
+                    if (value) {
+                        return std::make_tuple(std::move(key), std::move(*value));
+                    }
+                }
+
+                node = (ConcurrentSkipNode<T, V> *) node->getNextNode(0);
+            }
+        }
+
+        //Too many collisions, the list is probably almost empty
+        return ConcurrentSkipList<T, V>::popSmallest();
+    }
+};
+
+#endif //TRABALHO1_SPRAYLIST_H
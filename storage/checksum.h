@@ -0,0 +1,69 @@
+#ifndef TRABALHO1_CHECKSUM_H
+#define TRABALHO1_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+//Reversed polynomial of CRC-32C (Castagnoli), which is what the SSE 4.2 crc32 instruction computes
+#define CRC32C_POLYNOMIAL 0x82F63B78u
+
+struct Crc32cTable {
+
+    uint32_t entries[256];
+
+    constexpr Crc32cTable() : entries() {
+
+        for (uint32_t i = 0; i < 256; i++) {
+
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+            }
+
+            this->entries[i] = crc;
+        }
+    }
+};
+
+/**
+ * CRC-32C of the bytes, to catch files that were corrupted or cut short. Uses the crc32 instruction when it's
+ * available and a table a byte at a time otherwise, both give the same result
+ *
+ * @param crc The checksum of the bytes before these ones, to checksum data that comes in pieces
+ */
+inline uint32_t crc32c(const void *data, size_t length, uint32_t crc = 0) {
+
+    const auto *bytes = (const uint8_t *) data;
+
+    crc = ~crc;
+
+#if defined(__SSE4_2__)
+    for (; length >= 8; length -= 8, bytes += 8) {
+        uint64_t word;
+
+        std::memcpy(&word, bytes, 8);
+
+        crc = (uint32_t) _mm_crc32_u64(crc, word);
+    }
+
+    for (; length > 0; length--) {
+        crc = _mm_crc32_u8(crc, *bytes++);
+    }
+#else
+    static constexpr Crc32cTable table;
+
+    for (; length > 0; length--) {
+        crc = table.entries[(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+    }
+#endif
+
+    return ~crc;
+}
+
+#endif //TRABALHO1_CHECKSUM_H
@@ -0,0 +1,848 @@
+#ifndef TRABALHO1_DURABLEMAP_H
+#define TRABALHO1_DURABLEMAP_H
+
+#include "../datastructures.h"
+#include "checksum.h"
+#include "fileio.h"
+#include "serialization.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Most writes that share a single log write and fsync
+#define DURABLE_MAP_MAX_BATCH 128
+//Writes logged between two snapshots. The log has to be replayed on recovery, the snapshot is bulk loaded
+#define DURABLE_MAP_SNAPSHOT_INTERVAL (1u << 20)
+//Bytes a snapshot is written out in
+#define DURABLE_MAP_WRITE_BUFFER (1024 * 1024)
+//Starts and ends every snapshot, so a file that was cut short isn't taken for one
+#define DURABLE_MAP_SNAPSHOT_MAGIC 0x534E4150
+#define DURABLE_MAP_SNAPSHOT_HEADER (sizeof(uint32_t) + 2 * sizeof(uint64_t))
+#define DURABLE_MAP_SNAPSHOT_FOOTER (2 * sizeof(uint32_t))
+//Length and checksum in front of every log record
+#define DURABLE_MAP_RECORD_HEADER (2 * sizeof(uint32_t))
+
+/**
+ * A write waiting for the writer that commits its batch
+ */
+template<typename T, typename V>
+class DurableWrite {
+
+public:
+    enum WriteType {
+        ADD,
+        REMOVE,
+        POP_SMALLEST,
+        POP_LARGEST,
+        SNAPSHOT,
+        //Entries sorted by key, added with addSorted
+        LOAD
+    };
+
+    WriteType type;
+
+    std::shared_ptr<T> key;
+    std::shared_ptr<V> value;
+
+    std::vector<node_info<T, V>> *sorted;
+
+    //The value a removal took out, or the entry a pop took out
+    std::optional<node_info<T, V>> removed;
+
+    std::exception_ptr error;
+
+    bool done;
+
+    explicit DurableWrite(WriteType type) : type(type), sorted(nullptr), done(false) {}
+
+    /**
+     * Pops and snapshots depend on everything before them being applied and loads are a batch already, so they go
+     * in a batch of their own
+     */
+    bool isExclusive() const {
+        return this->type != ADD && this->type != REMOVE;
+    }
+};
+
+struct DurabilityStats {
+    //Writes logged since the map was opened
+    uint64_t records;
+
+    //Log writes, each followed by one fsync. records / commits is the average batch
+    uint64_t commits;
+
+    uint64_t snapshots;
+
+    //Snapshots taken because of the interval that failed, they are tried again after another interval
+    uint64_t failedSnapshots;
+
+    //Entries loaded from the snapshot and writes replayed from the log when the map was opened
+    uint64_t snapshotEntries, replayedRecords;
+};
+
+/**
+ * Makes any OrderedMap survive a restart. Every write is appended to a log and synced before it's applied to the map,
+ * and every so often the whole map is written out to a snapshot so the log can start over.
+ *
+ * Group commit: writers queue their writes and the writer at the front of the queue takes up to maxBatch of them,
+ * logs them with a single write and a single fsync, applies them to the map in log order and wakes the others up.
+ * While it does, the next writers pile up behind it and go out in the next batch, so the more writers wait on the
+ * disk the fewer syncs each of them pays for.
+ *
+ * Files in the directory:
+ * - wal-N.log: the log segments. Each record is its length and CRC-32C followed by the type of write and its key
+ * (and value). A crash can only leave the end of the newest segment half written, which is cut off on recovery
+ * - snapshot: the entries of the map in key order, streamed out with forEachEntry, and the first segment that has
+ * writes the snapshot doesn't. Written to snapshot.tmp, synced and renamed, so there is always a whole one
+ *
+ * Recovery bulk loads the snapshot with addSorted and replays the segments that came after it. Reads and the snapshot
+ * traversal hold the map lock, so writers wait for a snapshot to be written before applying their batch.
+ */
+template<typename T, typename V>
+class DurableMapAdaptor : public OrderedMap<T, V> {
+
+private:
+    std::unique_ptr<OrderedMap<T, V>> map;
+
+    std::string directory;
+
+    unsigned int maxBatch;
+
+    uint64_t snapshotInterval;
+
+    //Held by reads and by the committing writer while it applies its batch
+    std::mutex mapLock;
+
+    std::mutex queueLock;
+
+    std::condition_variable queueChanged;
+
+    std::deque<DurableWrite<T, V> *> queue;
+
+    //Only used by the writer at the front of the queue
+    int logFile;
+
+    uint64_t logGeneration, sinceSnapshot;
+
+    std::string logBuffer;
+
+    //A log write that failed leaves the end of the log in an unknown state, so nothing is logged after it
+    std::exception_ptr failure;
+
+    std::atomic_uint64_t records, commits, snapshots, failedSnapshots;
+
+    uint64_t snapshotEntries, replayedRecords;
+
+    std::string segmentPath(uint64_t generation) const {
+        return this->directory + "/wal-" + std::to_string(generation) + ".log";
+    }
+
+    std::string snapshotPath() const {
+        return this->directory + "/snapshot";
+    }
+
+    void openSegment(uint64_t generation, int flags) {
+
+        std::string path = segmentPath(generation);
+
+        this->logFile = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | flags, 0644);
+
+        if (this->logFile < 0) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + path);
+        }
+
+        this->logGeneration = generation;
+    }
+
+    /**
+     * Bulk load the snapshot into the map
+     *
+     * @return The first log segment that has writes the snapshot doesn't
+     */
+    uint64_t loadSnapshot() {
+
+        std::string path = snapshotPath();
+
+        int file = ::open(path.c_str(), O_RDONLY);
+
+        if (file < 0) {
+            if (errno == ENOENT) return 0;
+
+            throw std::system_error(errno, std::generic_category(), "Opening " + path);
+        }
+
+        struct stat status{};
+
+        if (::fstat(file, &status) != 0) {
+            int error = errno;
+
+            ::close(file);
+
+            throw std::system_error(error, std::generic_category(), "Reading " + path);
+        }
+
+        size_t size = status.st_size;
+
+        if (size < DURABLE_MAP_SNAPSHOT_HEADER + DURABLE_MAP_SNAPSHOT_FOOTER) {
+            ::close(file);
+
+            throw std::runtime_error("Corrupted snapshot " + path);
+        }
+
+        void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        ::close(file);
+
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Mapping " + path);
+        }
+
+        const char *start = (const char *) mapping, *footer = start + size - DURABLE_MAP_SNAPSHOT_FOOTER;
+
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+        uint64_t generation = 0;
+
+        try {
+            const char *cursor = footer;
+
+            uint32_t checksum = Serializer<uint32_t>::read(cursor), endMagic = Serializer<uint32_t>::read(cursor);
+
+            cursor = start;
+
+            if (Serializer<uint32_t>::read(cursor) != DURABLE_MAP_SNAPSHOT_MAGIC ||
+                endMagic != DURABLE_MAP_SNAPSHOT_MAGIC ||
+                crc32c(start, size - DURABLE_MAP_SNAPSHOT_FOOTER) != checksum) {
+                throw std::runtime_error("Corrupted snapshot " + path);
+            }
+
+            generation = Serializer<uint64_t>::read(cursor);
+
+            uint64_t count = Serializer<uint64_t>::read(cursor);
+
+            std::vector<node_info<T, V>> sorted;
+
+            sorted.reserve(count);
+
+            for (uint64_t i = 0; i < count; i++) {
+                auto key = std::make_shared<T>(Serializer<T>::read(cursor));
+
+                sorted.emplace_back(std::move(key), std::make_shared<V>(Serializer<V>::read(cursor)));
+            }
+
+            this->map->addSorted(std::move(sorted));
+
+            this->snapshotEntries = count;
+        } catch (...) {
+            ::munmap(mapping, size);
+
+            throw;
+        }
+
+        ::munmap(mapping, size);
+
+        return generation;
+    }
+
+    /**
+     * Apply the records of a segment to the map
+     *
+     * @param newest Whether this is the newest segment, the only one a crash can leave half written. Its broken tail
+     * is cut off, anywhere else it means the log is corrupted
+     */
+    void replaySegment(uint64_t generation, bool newest) {
+
+        std::string path = segmentPath(generation);
+
+        int file = ::open(path.c_str(), O_RDWR);
+
+        if (file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + path);
+        }
+
+        try {
+            struct stat status{};
+
+            if (::fstat(file, &status) != 0) {
+                throw std::system_error(errno, std::generic_category(), "Reading " + path);
+            }
+
+            std::string contents(status.st_size, '\0');
+
+            fileio::readFully(file, &contents[0], contents.size(), 0, path);
+
+            size_t offset = 0;
+
+            while (offset + DURABLE_MAP_RECORD_HEADER <= contents.size()) {
+
+                const char *cursor = contents.data() + offset;
+
+                uint32_t length = Serializer<uint32_t>::read(cursor), checksum = Serializer<uint32_t>::read(cursor);
+
+                if (length == 0 || length > contents.size() - offset - DURABLE_MAP_RECORD_HEADER ||
+                    crc32c(cursor, length) != checksum) {
+                    break;
+                }
+
+                applyRecord(cursor);
+
+                offset += DURABLE_MAP_RECORD_HEADER + length;
+
+                this->replayedRecords++;
+            }
+
+            if (offset < contents.size()) {
+                if (!newest) throw std::runtime_error("Corrupted log " + path);
+
+                if (::ftruncate(file, (off_t) offset) != 0 || ::fsync(file) != 0) {
+                    throw std::system_error(errno, std::generic_category(), "Truncating " + path);
+                }
+            }
+        } catch (...) {
+            ::close(file);
+
+            throw;
+        }
+
+        ::close(file);
+    }
+
+    void applyRecord(const char *cursor) {
+
+        auto type = (typename DurableWrite<T, V>::WriteType) *cursor++;
+
+        auto key = std::make_shared<T>(Serializer<T>::read(cursor));
+
+        if (type == DurableWrite<T, V>::ADD) {
+            this->map->add(std::move(key), std::make_shared<V>(Serializer<V>::read(cursor)));
+        } else {
+            this->map->remove(*key);
+        }
+    }
+
+    /**
+     * Find the snapshot and the log segments left by a previous instance and rebuild the map from them
+     */
+    void recover() {
+
+        if (::mkdir(this->directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::system_error(errno, std::generic_category(), "Creating " + this->directory);
+        }
+
+        //A snapshot that was being written when the previous instance stopped
+        ::unlink((snapshotPath() + ".tmp").c_str());
+
+        DIR *dir = ::opendir(this->directory.c_str());
+
+        if (dir == nullptr) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + this->directory);
+        }
+
+        std::vector<uint64_t> segments;
+
+        while (struct dirent *entry = ::readdir(dir)) {
+            unsigned long long generation;
+            char extension[4];
+
+            if (std::sscanf(entry->d_name, "wal-%llu.%3s", &generation, extension) == 2 &&
+                std::string(extension) == "log") {
+                segments.push_back(generation);
+            }
+        }
+
+        ::closedir(dir);
+
+        std::sort(segments.begin(), segments.end());
+
+        uint64_t first = loadSnapshot();
+
+        for (size_t i = 0; i < segments.size(); i++) {
+
+            //Segments from before the snapshot that the previous instance didn't get to remove
+            if (segments[i] < first) {
+                ::unlink(segmentPath(segments[i]).c_str());
+
+                continue;
+            }
+
+            replaySegment(segments[i], i + 1 == segments.size());
+        }
+
+        //Keep appending to the newest segment
+        if (!segments.empty() && segments.back() >= first) {
+            openSegment(segments.back(), 0);
+        } else {
+            openSegment(first, O_TRUNC);
+
+            fileio::syncDirectory(this->directory);
+        }
+    }
+
+    /**
+     * Write out the whole map, start a new log segment and drop the old ones. The map can't change while this runs,
+     * only the writer at the front of the queue calls it
+     */
+    void writeSnapshot() {
+
+        uint64_t generation = this->logGeneration + 1;
+
+        std::string path = snapshotPath(), temporaryPath = path + ".tmp";
+
+        int file = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Creating " + temporaryPath);
+        }
+
+        int previousLog = this->logFile;
+
+        uint64_t previousGeneration = this->logGeneration;
+
+        try {
+            std::string buffer;
+
+            buffer.reserve(DURABLE_MAP_WRITE_BUFFER);
+
+            uint32_t checksum = 0;
+
+            auto flushBuffer = [&]() {
+                checksum = crc32c(buffer.data(), buffer.size(), checksum);
+
+                fileio::writeFully(file, buffer.data(), buffer.size(), temporaryPath);
+
+                buffer.clear();
+            };
+
+            {
+                std::lock_guard<std::mutex> lock(this->mapLock);
+
+                Serializer<uint32_t>::write(buffer, DURABLE_MAP_SNAPSHOT_MAGIC);
+                Serializer<uint64_t>::write(buffer, generation);
+                Serializer<uint64_t>::write(buffer, this->map->size());
+
+                this->map->forEachEntry([&](const std::shared_ptr<T> &key, const std::shared_ptr<V> &value) {
+
+                    Serializer<T>::write(buffer, *key);
+                    Serializer<V>::write(buffer, *value);
+
+                    if (buffer.size() >= DURABLE_MAP_WRITE_BUFFER) flushBuffer();
+                });
+            }
+
+            flushBuffer();
+
+            Serializer<uint32_t>::write(buffer, checksum);
+            Serializer<uint32_t>::write(buffer, DURABLE_MAP_SNAPSHOT_MAGIC);
+
+            fileio::writeFully(file, buffer.data(), buffer.size(), temporaryPath);
+
+            if (::fsync(file) != 0) {
+                throw std::system_error(errno, std::generic_category(), "Syncing " + temporaryPath);
+            }
+
+            ::close(file);
+
+            file = -1;
+
+            openSegment(generation, O_TRUNC);
+
+            if (::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+                throw std::system_error(errno, std::generic_category(), "Renaming " + temporaryPath);
+            }
+        } catch (...) {
+            if (file >= 0) ::close(file);
+
+            ::unlink(temporaryPath.c_str());
+
+            //Keep logging to the old segment, the snapshot before this one still goes with it
+            if (this->logFile != previousLog) {
+                ::close(this->logFile);
+
+                ::unlink(segmentPath(generation).c_str());
+
+                this->logFile = previousLog;
+                this->logGeneration = previousGeneration;
+            }
+
+            throw;
+        }
+
+        ::close(previousLog);
+
+        //Until the rename is known to survive a crash, the old segments are needed to recover from the old snapshot,
+        //so they're only removed once this doesn't throw
+        fileio::syncDirectory(this->directory);
+
+        //Every segment before the new one only has writes the snapshot already has
+        for (uint64_t old = previousGeneration + 1; old-- > 0;) {
+            if (::unlink(segmentPath(old).c_str()) != 0) break;
+        }
+
+        this->sinceSnapshot = 0;
+
+        this->snapshots++;
+    }
+
+    void appendRecord(typename DurableWrite<T, V>::WriteType type, const T &key, const V *value) {
+
+        size_t start = this->logBuffer.size();
+
+        //Filled in once the record is written
+        Serializer<uint32_t>::write(this->logBuffer, 0);
+        Serializer<uint32_t>::write(this->logBuffer, 0);
+
+        this->logBuffer.push_back((char) type);
+
+        Serializer<T>::write(this->logBuffer, key);
+
+        if (value != nullptr) Serializer<V>::write(this->logBuffer, *value);
+
+        size_t payload = start + DURABLE_MAP_RECORD_HEADER;
+
+        auto length = (uint32_t) (this->logBuffer.size() - payload);
+
+        uint32_t checksum = crc32c(this->logBuffer.data() + payload, length);
+
+        std::memcpy(&this->logBuffer[start], &length, sizeof(uint32_t));
+        std::memcpy(&this->logBuffer[start + sizeof(uint32_t)], &checksum, sizeof(uint32_t));
+    }
+
+    /**
+     * Log the batch with one write and one fsync, then apply it to the map in the same order
+     */
+    void commit(const std::vector<DurableWrite<T, V> *> &batch) {
+
+        if (this->failure) std::rethrow_exception(this->failure);
+
+        if (batch.front()->type == DurableWrite<T, V>::SNAPSHOT) {
+            writeSnapshot();
+
+            return;
+        }
+
+        this->logBuffer.clear();
+
+        uint64_t logged = batch.size();
+
+        for (DurableWrite<T, V> *write : batch) {
+
+            switch (write->type) {
+                case DurableWrite<T, V>::ADD:
+                    appendRecord(write->type, *write->key, write->value.get());
+                    break;
+                case DurableWrite<T, V>::REMOVE:
+                    appendRecord(write->type, *write->key, nullptr);
+                    break;
+                case DurableWrite<T, V>::LOAD:
+                    for (auto &entry : *write->sorted) {
+                        appendRecord(DurableWrite<T, V>::ADD, *std::get<0>(entry), std::get<1>(entry).get());
+                    }
+
+                    logged = write->sorted->size();
+
+                    break;
+                default: {
+                    //Only this writer changes the map, so the entry it sees is the one the pop will take out
+                    std::optional<node_info<T, V>> entry;
+
+                    {
+                        std::lock_guard<std::mutex> lock(this->mapLock);
+
+                        entry = write->type == DurableWrite<T, V>::POP_SMALLEST ? this->map->peekSmallest()
+                                                                                 : this->map->peekLargest();
+                    }
+
+                    if (!entry) return;
+
+                    appendRecord(DurableWrite<T, V>::REMOVE, *std::get<0>(*entry), nullptr);
+                }
+            }
+        }
+
+        try {
+            fileio::writeFully(this->logFile, this->logBuffer.data(), this->logBuffer.size(),
+                               segmentPath(this->logGeneration));
+
+            if (::fdatasync(this->logFile) != 0) {
+                throw std::system_error(errno, std::generic_category(), "Syncing " + segmentPath(this->logGeneration));
+            }
+        } catch (...) {
+            this->failure = std::current_exception();
+
+            throw;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->mapLock);
+
+            for (DurableWrite<T, V> *write : batch) {
+
+                switch (write->type) {
+                    case DurableWrite<T, V>::ADD:
+                        this->map->add(std::move(write->key), std::move(write->value));
+                        break;
+                    case DurableWrite<T, V>::REMOVE: {
+                        auto value = this->map->remove(*write->key);
+
+                        if (value) write->removed = std::make_tuple(write->key, *value);
+
+                        break;
+                    }
+                    case DurableWrite<T, V>::LOAD:
+                        this->map->addSorted(std::move(*write->sorted));
+                        break;
+                    case DurableWrite<T, V>::POP_SMALLEST:
+                        write->removed = this->map->popSmallest();
+                        break;
+                    default:
+                        write->removed = this->map->popLargest();
+                }
+            }
+        }
+
+        this->records += logged;
+        this->commits++;
+
+        this->sinceSnapshot += logged;
+
+        if (this->sinceSnapshot >= this->snapshotInterval) {
+            //The batch is already in the log, a snapshot that fails doesn't fail it
+            try {
+                writeSnapshot();
+            } catch (...) {
+                this->failedSnapshots++;
+
+                this->sinceSnapshot = 0;
+            }
+        }
+    }
+
+    /**
+     * Queue the write and wait until it's committed, committing a batch if it gets to the front of the queue first
+     */
+    void submit(DurableWrite<T, V> &write) {
+
+        std::unique_lock<std::mutex> lock(this->queueLock);
+
+        this->queue.push_back(&write);
+
+        this->queueChanged.wait(lock, [this, &write]() { return write.done || this->queue.front() == &write; });
+
+        if (!write.done) {
+            std::vector<DurableWrite<T, V> *> batch;
+
+            for (DurableWrite<T, V> *pending : this->queue) {
+                if (batch.size() == this->maxBatch || (!batch.empty() && pending->isExclusive())) break;
+
+                batch.push_back(pending);
+
+                if (pending->isExclusive()) break;
+            }
+
+            lock.unlock();
+
+            std::exception_ptr error;
+
+            try {
+                commit(batch);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+
+            for (DurableWrite<T, V> *committed : batch) {
+                this->queue.pop_front();
+
+                committed->error = error;
+                committed->done = true;
+            }
+
+            this->queueChanged.notify_all();
+        }
+
+        if (write.error) std::rethrow_exception(write.error);
+    }
+
+public:
+    /**
+     * Open the map in the directory, recovering what a previous instance left there
+     *
+     * @param map An empty map, it's filled with the recovered entries
+     * @param maxBatch Most writes that share one fsync
+     * @param snapshotInterval Writes logged before the map is written out to a new snapshot
+     */
+    DurableMapAdaptor(std::unique_ptr<OrderedMap<T, V>> map, std::string directory,
+                      unsigned int maxBatch = DURABLE_MAP_MAX_BATCH,
+                      uint64_t snapshotInterval = DURABLE_MAP_SNAPSHOT_INTERVAL) : map(std::move(map)),
+                                                                                   directory(std::move(directory)),
+                                                                                   maxBatch(std::max(maxBatch, 1u)),
+                                                                                   snapshotInterval(snapshotInterval),
+                                                                                   logFile(-1), logGeneration(0),
+                                                                                   sinceSnapshot(0), records(0),
+                                                                                   commits(0), snapshots(0),
+                                                                                   failedSnapshots(0),
+                                                                                   snapshotEntries(0),
+                                                                                   replayedRecords(0) {
+        if (this->map->size() != 0) {
+            throw std::invalid_argument("The map has to start out empty");
+        }
+
+        recover();
+    }
+
+    ~DurableMapAdaptor() override {
+        if (this->logFile >= 0) ::close(this->logFile);
+    }
+
+    /**
+     * Write the map out to a new snapshot now, instead of waiting for the interval
+     */
+    void snapshot() {
+
+        DurableWrite<T, V> write(DurableWrite<T, V>::SNAPSHOT);
+
+        submit(write);
+    }
+
+    DurabilityStats getStats() const {
+        return {this->records.load(), this->commits.load(), this->snapshots.load(), this->failedSnapshots.load(),
+                this->snapshotEntries, this->replayedRecords};
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        DurableWrite<T, V> write(DurableWrite<T, V>::ADD);
+
+        write.key = std::move(key);
+        write.value = std::move(value);
+
+        submit(write);
+    }
+
+    /**
+     * The entries are logged with a single write and fsync and handed to the addSorted of the map
+     */
+    void addSorted(std::vector<node_info<T, V>> sorted) override {
+
+        if (sorted.empty()) return;
+
+        DurableWrite<T, V> write(DurableWrite<T, V>::LOAD);
+
+        write.sorted = &sorted;
+
+        submit(write);
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        DurableWrite<T, V> write(DurableWrite<T, V>::REMOVE);
+
+        write.key = std::make_shared<T>(key);
+
+        submit(write);
+
+        if (!write.removed) return std::nullopt;
+
+        return std::get<1>(*write.removed);
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        DurableWrite<T, V> write(DurableWrite<T, V>::POP_SMALLEST);
+
+        submit(write);
+
+        return write.removed;
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        DurableWrite<T, V> write(DurableWrite<T, V>::POP_LARGEST);
+
+        submit(write);
+
+        return write.removed;
+    }
+
+    bool hasKey(const T &key) override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->hasKey(key);
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->get(key);
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->keys();
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->values();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->entries();
+    }
+
+    unsigned int size() override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->size();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->rangeSearch(base, max);
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->peekSmallest();
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        return this->map->peekLargest();
+    }
+
+    void forEachEntry(const entry_visitor<T, V> &visitor) override {
+
+        std::lock_guard<std::mutex> lock(this->mapLock);
+
+        this->map->forEachEntry(visitor);
+    }
+};
+
+#endif //TRABALHO1_DURABLEMAP_H
@@ -0,0 +1,72 @@
+#ifndef TRABALHO1_FILEIO_H
+#define TRABALHO1_FILEIO_H
+
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+
+/**
+ * File access with system calls that throw when they fail
+ */
+namespace fileio {
+
+    inline void writeFully(int file, const char *data, size_t length, const std::string &path) {
+
+        while (length > 0) {
+            ssize_t written = ::write(file, data, length);
+
+            if (written < 0) {
+                if (errno == EINTR) continue;
+
+                throw std::system_error(errno, std::generic_category(), "Writing " + path);
+            }
+
+            data += written;
+            length -= written;
+        }
+    }
+
+    inline void readFully(int file, char *data, size_t length, uint64_t offset, const std::string &path) {
+
+        while (length > 0) {
+            ssize_t read = ::pread(file, data, length, (off_t) offset);
+
+            if (read < 0 && errno == EINTR) continue;
+
+            if (read <= 0) {
+                throw std::system_error(read < 0 ? errno : EIO, std::generic_category(), "Reading " + path);
+            }
+
+            data += read;
+            length -= read;
+            offset += read;
+        }
+    }
+
+    /**
+     * Make the files that were created or renamed in the directory survive a crash
+     */
+    inline void syncDirectory(const std::string &directory) {
+
+        int file = ::open(directory.c_str(), O_RDONLY);
+
+        if (file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + directory);
+        }
+
+        if (::fsync(file) != 0) {
+            int error = errno;
+
+            ::close(file);
+
+            throw std::system_error(error, std::generic_category(), "Syncing " + directory);
+        }
+
+        ::close(file);
+    }
+}
+
+#endif //TRABALHO1_FILEIO_H
@@ -0,0 +1,1246 @@
+#ifndef TRABALHO1_LSMTREE_H
+#define TRABALHO1_LSMTREE_H
+
+#include "../datastructures.h"
+#include "../filters/bloomfilter.h"
+#include "../probabilisticlist/concurrentskiplist.h"
+#include "fileio.h"
+#include "serialization.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <mutex>
+#include <shared_mutex>
+#include <sys/stat.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+//Keys in the memtable before it's written out as a run
+#define LSM_MEMTABLE_ENTRIES 65536
+//Memtables waiting to be written out before writers have to wait for them
+#define LSM_MAX_IMMUTABLE_MEMTABLES 2
+//Runs in level 0 before they are merged into level 1
+#define LSM_LEVEL0_RUNS 4
+//Each level holds this many times the keys of the one before it
+#define LSM_LEVEL_RATIO 10
+//Keys between each entry of the sparse index. The keys between two entries are read from disk in one go
+#define LSM_INDEX_INTERVAL 16
+//About 1% false positives
+#define LSM_BLOOM_BITS_PER_KEY 10
+#define LSM_BLOOM_HASH_FUNCTIONS 7
+//Bytes a run is written out in
+#define LSM_WRITE_BUFFER (1024 * 1024)
+//Ends every run, so a file that was cut short isn't taken for one
+#define LSM_RUN_MAGIC 0x4C534D31
+#define LSM_FOOTER_SIZE (4 * sizeof(uint64_t) + sizeof(uint32_t))
+//Flag of the entries that record a removed key
+#define LSM_TOMBSTONE 1
+
+/**
+ * Something that goes through entries in key order. A null value means the key was removed
+ */
+template<typename T, typename V>
+class LsmSource {
+
+public:
+    virtual ~LsmSource() = default;
+
+    virtual bool valid() const = 0;
+
+    virtual const std::shared_ptr<T> &key() const = 0;
+
+    virtual const std::shared_ptr<V> &value() const = 0;
+
+    virtual void next() = 0;
+};
+
+/**
+ * The entries of a memtable, as they were when it was read
+ */
+template<typename T, typename V>
+class LsmMemtableSource : public LsmSource<T, V> {
+
+private:
+    std::unique_ptr<std::vector<node_info<T, V>>> entries;
+
+    size_t position;
+
+public:
+    explicit LsmMemtableSource(std::unique_ptr<std::vector<node_info<T, V>>> entries) : entries(std::move(entries)),
+                                                                                          position(0) {}
+
+    bool valid() const override {
+        return this->position < this->entries->size();
+    }
+
+    const std::shared_ptr<T> &key() const override {
+        return std::get<0>((*this->entries)[this->position]);
+    }
+
+    const std::shared_ptr<V> &value() const override {
+        return std::get<1>((*this->entries)[this->position]);
+    }
+
+    void next() override {
+        this->position++;
+    }
+};
+
+/**
+ * An immutable file with entries sorted by key, written out from a memtable or merged from other runs.
+ *
+ * Layout:
+ * - The entries, each a flag byte followed by the key and, if the key wasn't removed, the value
+ * - The sparse index: the amount of index entries, then the key and file offset of every LSM_INDEX_INTERVAL'th entry,
+ * then the largest key
+ * - The Bloom filter: the amount of hash functions, the amount of keys, the amount of bytes and the bytes
+ * - The footer: where the index starts, where the filter starts, the amount of entries, the level 0 runs it covers and
+ * the magic number
+ *
+ * The index and the filter are kept in memory, the entries are read from disk when they're needed.
+ */
+template<typename T, typename V>
+class LsmRun {
+
+private:
+    std::string path;
+
+    int file;
+
+    unsigned int level;
+
+    uint64_t sequence;
+
+    uint64_t entryCount;
+
+    //The level 0 runs with a lower sequence were merged into this one (Or into the runs it was merged from)
+    uint64_t level0Covered;
+
+    //Where the entries end and the index starts
+    uint64_t dataEnd;
+
+    std::vector<T> indexKeys;
+
+    std::vector<uint64_t> indexOffsets;
+
+    std::unique_ptr<T> largestKey;
+
+    std::unique_ptr<BloomFilter<T>> filter;
+
+    //Replaced by a compaction, the file is removed once nobody is reading it anymore
+    std::atomic_bool obsolete;
+
+    void load() {
+
+        struct stat status{};
+
+        if (::fstat(this->file, &status) != 0 || (uint64_t) status.st_size < LSM_FOOTER_SIZE) {
+            throw std::runtime_error("Not a sorted run: " + this->path);
+        }
+
+        uint64_t fileSize = status.st_size;
+
+        std::string footer(LSM_FOOTER_SIZE, '\0');
+
+        fileio::readFully(this->file, &footer[0], LSM_FOOTER_SIZE, fileSize - LSM_FOOTER_SIZE, this->path);
+
+        const char *cursor = footer.data();
+
+        this->dataEnd = Serializer<uint64_t>::read(cursor);
+
+        uint64_t filterStart = Serializer<uint64_t>::read(cursor);
+
+        this->entryCount = Serializer<uint64_t>::read(cursor);
+
+        this->level0Covered = Serializer<uint64_t>::read(cursor);
+
+        if (Serializer<uint32_t>::read(cursor) != LSM_RUN_MAGIC || this->dataEnd > filterStart ||
+            filterStart > fileSize - LSM_FOOTER_SIZE) {
+            throw std::runtime_error("Not a sorted run: " + this->path);
+        }
+
+        std::string metadata(fileSize - LSM_FOOTER_SIZE - this->dataEnd, '\0');
+
+        fileio::readFully(this->file, &metadata[0], metadata.size(), this->dataEnd, this->path);
+
+        cursor = metadata.data();
+
+        uint64_t indexEntries = Serializer<uint64_t>::read(cursor);
+
+        this->indexKeys.reserve(indexEntries);
+        this->indexOffsets.reserve(indexEntries);
+
+        for (uint64_t i = 0; i < indexEntries; i++) {
+            this->indexKeys.push_back(Serializer<T>::read(cursor));
+
+            this->indexOffsets.push_back(Serializer<uint64_t>::read(cursor));
+        }
+
+        this->largestKey = std::make_unique<T>(Serializer<T>::read(cursor));
+
+        unsigned int hashFunctions = Serializer<uint32_t>::read(cursor);
+
+        uint64_t items = Serializer<uint64_t>::read(cursor);
+
+        std::vector<uint8_t> filterData(Serializer<uint64_t>::read(cursor));
+
+        std::memcpy(filterData.data(), cursor, filterData.size());
+
+        this->filter = std::make_unique<BloomFilter<T>>(std::move(filterData), hashFunctions, items);
+    }
+
+public:
+    LsmRun(std::string path, unsigned int level, uint64_t sequence) : path(std::move(path)), level(level),
+                                                                      sequence(sequence), entryCount(0),
+                                                                      level0Covered(0), dataEnd(0), obsolete(false) {
+
+        this->file = ::open(this->path.c_str(), O_RDONLY);
+
+        if (this->file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + this->path);
+        }
+
+        try {
+            load();
+        } catch (...) {
+            ::close(this->file);
+
+            throw;
+        }
+    }
+
+    ~LsmRun() {
+
+        ::close(this->file);
+
+        if (this->obsolete.load()) {
+            ::unlink(this->path.c_str());
+        }
+    }
+
+    /**
+     * Write the entries of the source to a new run. The file is written under a temporary name and only renamed to the
+     * final one once it's complete and synced, so a crash never leaves half a run behind
+     *
+     * @param expectedEntries At most how many entries the source has, for sizing the filter
+     * @param dropTombstones Leave out the removed keys, only when there's no older run they could be hiding keys of
+     * @param level0Covered The level 0 runs with a lower sequence are merged into this one
+     * @return The new run, or null if there was nothing to write
+     */
+    static std::shared_ptr<LsmRun<T, V>> write(const std::string &path, unsigned int level, uint64_t sequence,
+                                               LsmSource<T, V> &source, uint64_t expectedEntries,
+                                               bool dropTombstones, uint64_t level0Covered) {
+
+        std::string temporaryPath = path + ".tmp";
+
+        int file = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Creating " + temporaryPath);
+        }
+
+        BloomFilter<T> filter(std::max((uint64_t) 1, expectedEntries * LSM_BLOOM_BITS_PER_KEY / UINT8_WIDTH),
+                              LSM_BLOOM_HASH_FUNCTIONS);
+
+        std::string buffer, index;
+
+        uint64_t written = 0, entries = 0;
+
+        std::shared_ptr<T> lastKey;
+
+        try {
+            for (; source.valid(); source.next()) {
+
+                const std::shared_ptr<V> &value = source.value();
+
+                if (value == nullptr && dropTombstones) continue;
+
+                if (entries % LSM_INDEX_INTERVAL == 0) {
+                    Serializer<T>::write(index, *source.key());
+
+                    Serializer<uint64_t>::write(index, written + buffer.size());
+                }
+
+                buffer.push_back(value == nullptr ? LSM_TOMBSTONE : 0);
+
+                Serializer<T>::write(buffer, *source.key());
+
+                if (value != nullptr) {
+                    Serializer<V>::write(buffer, *value);
+                }
+
+                filter.add(*source.key());
+
+                lastKey = source.key();
+
+                entries++;
+
+                if (buffer.size() >= LSM_WRITE_BUFFER) {
+                    fileio::writeFully(file, buffer.data(), buffer.size(), temporaryPath);
+
+                    written += buffer.size();
+
+                    buffer.clear();
+                }
+            }
+
+            if (entries == 0) {
+                ::close(file);
+
+                ::unlink(temporaryPath.c_str());
+
+                return nullptr;
+            }
+
+            uint64_t dataEnd = written + buffer.size();
+
+            Serializer<uint64_t>::write(buffer, (entries + LSM_INDEX_INTERVAL - 1) / LSM_INDEX_INTERVAL);
+
+            buffer.append(index);
+
+            Serializer<T>::write(buffer, *lastKey);
+
+            uint64_t filterStart = written + buffer.size();
+
+            Serializer<uint32_t>::write(buffer, filter.getHashFunctionCount());
+            Serializer<uint64_t>::write(buffer, filter.size());
+            Serializer<uint64_t>::write(buffer, filter.getData().size());
+
+            buffer.append((const char *) filter.getData().data(), filter.getData().size());
+
+            Serializer<uint64_t>::write(buffer, dataEnd);
+            Serializer<uint64_t>::write(buffer, filterStart);
+            Serializer<uint64_t>::write(buffer, entries);
+            Serializer<uint64_t>::write(buffer, level0Covered);
+            Serializer<uint32_t>::write(buffer, LSM_RUN_MAGIC);
+
+            fileio::writeFully(file, buffer.data(), buffer.size(), temporaryPath);
+
+            if (::fsync(file) != 0) {
+                throw std::system_error(errno, std::generic_category(), "Syncing " + temporaryPath);
+            }
+        } catch (...) {
+            ::close(file);
+
+            ::unlink(temporaryPath.c_str());
+
+            throw;
+        }
+
+        ::close(file);
+
+        if (::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Renaming " + temporaryPath);
+        }
+
+        return std::make_shared<LsmRun<T, V>>(path, level, sequence);
+    }
+
+    unsigned int getLevel() const {
+        return this->level;
+    }
+
+    uint64_t getSequence() const {
+        return this->sequence;
+    }
+
+    uint64_t getEntryCount() const {
+        return this->entryCount;
+    }
+
+    uint64_t getLevel0Covered() const {
+        return this->level0Covered;
+    }
+
+    size_t getBlockCount() const {
+        return this->indexOffsets.size();
+    }
+
+    void setObsolete() {
+        this->obsolete.store(true);
+    }
+
+    /**
+     * Whether the key could be in this run, without reading it
+     */
+    bool mightContain(const T &key) {
+        return !(key < this->indexKeys.front()) && !(*this->largestKey < key) && this->filter->test(key);
+    }
+
+    /**
+     * The block that would have the key, the last one that starts at or before it
+     */
+    size_t findBlock(const T &key) const {
+
+        auto after = std::upper_bound(this->indexKeys.begin(), this->indexKeys.end(), key);
+
+        return after == this->indexKeys.begin() ? 0 : (after - this->indexKeys.begin()) - 1;
+    }
+
+    /**
+     * Read the entries of a block into the buffer
+     */
+    void readBlock(size_t block, std::string &buffer) const {
+
+        uint64_t start = this->indexOffsets[block],
+                end = block + 1 < this->indexOffsets.size() ? this->indexOffsets[block + 1] : this->dataEnd;
+
+        buffer.resize(end - start);
+
+        fileio::readFully(this->file, &buffer[0], buffer.size(), start, this->path);
+    }
+
+    /**
+     * Read one entry of a block and move the cursor past it
+     */
+    static std::shared_ptr<V> readEntry(const char *&cursor, std::shared_ptr<T> &key) {
+
+        bool removed = *cursor++ == LSM_TOMBSTONE;
+
+        key = std::make_shared<T>(Serializer<T>::read(cursor));
+
+        return removed ? nullptr : std::make_shared<V>(Serializer<V>::read(cursor));
+    }
+
+    /**
+     * Look the key up in the block that would have it. Should only be called when mightContain is true
+     *
+     * @return Empty if the run doesn't have the key, null if the run has it as removed
+     */
+    std::optional<std::shared_ptr<V>> find(const T &key) const {
+
+        std::string buffer;
+
+        readBlock(findBlock(key), buffer);
+
+        const char *cursor = buffer.data(), *end = buffer.data() + buffer.size();
+
+        std::shared_ptr<T> current;
+
+        while (cursor < end) {
+            std::shared_ptr<V> value = readEntry(cursor, current);
+
+            if (!(*current < key)) {
+                if (key < *current) break;
+
+                return value;
+            }
+        }
+
+        return std::nullopt;
+    }
+};
+
+/**
+ * Goes through a run in order a block at a time
+ */
+template<typename T, typename V>
+class LsmRunSource : public LsmSource<T, V> {
+
+private:
+    std::shared_ptr<LsmRun<T, V>> run;
+
+    size_t block;
+
+    std::string buffer;
+
+    const char *cursor;
+
+    std::shared_ptr<T> currentKey;
+
+    std::shared_ptr<V> currentValue;
+
+    bool hasEntry;
+
+    void loadBlock(size_t toLoad) {
+
+        this->block = toLoad;
+
+        this->run->readBlock(toLoad, this->buffer);
+
+        this->cursor = this->buffer.data();
+    }
+
+public:
+    /**
+     * Start at the first key that is >= to the base, or at the start of the run if there's no base
+     */
+    LsmRunSource(std::shared_ptr<LsmRun<T, V>> run, const T *base) : run(std::move(run)), block(0), cursor(nullptr),
+                                                                      hasEntry(true) {
+
+        loadBlock(base == nullptr ? 0 : this->run->findBlock(*base));
+
+        next();
+
+        while (base != nullptr && this->hasEntry && *this->currentKey < *base) {
+            next();
+        }
+    }
+
+    bool valid() const override {
+        return this->hasEntry;
+    }
+
+    const std::shared_ptr<T> &key() const override {
+        return this->currentKey;
+    }
+
+    const std::shared_ptr<V> &value() const override {
+        return this->currentValue;
+    }
+
+    void next() override {
+
+        if (this->cursor == this->buffer.data() + this->buffer.size()) {
+            if (this->block + 1 >= this->run->getBlockCount()) {
+                this->hasEntry = false;
+
+                return;
+            }
+
+            loadBlock(this->block + 1);
+        }
+
+        this->currentValue = LsmRun<T, V>::readEntry(this->cursor, this->currentKey);
+    }
+};
+
+/**
+ * Merges sources into one sequence in key order. When more than one source has a key, the entry of the first source
+ * wins, so the sources go from newest to oldest
+ */
+template<typename T, typename V>
+class LsmMergeIterator {
+
+private:
+    std::vector<std::unique_ptr<LsmSource<T, V>>> sources;
+
+    LsmSource<T, V> *current;
+
+    void findSmallest() {
+
+        this->current = nullptr;
+
+        for (auto &source : this->sources) {
+            //Only a strictly smaller key replaces the current one, so the newest source wins ties
+            if (source->valid() && (this->current == nullptr || *source->key() < *this->current->key())) {
+                this->current = source.get();
+            }
+        }
+    }
+
+public:
+    explicit LsmMergeIterator(std::vector<std::unique_ptr<LsmSource<T, V>>> sources) : sources(std::move(sources)) {
+        findSmallest();
+    }
+
+    bool valid() const {
+        return this->current != nullptr;
+    }
+
+    const std::shared_ptr<T> &key() const {
+        return this->current->key();
+    }
+
+    const std::shared_ptr<V> &value() const {
+        return this->current->value();
+    }
+
+    void next() {
+
+        std::shared_ptr<T> key = this->current->key();
+
+        //Older versions of the key are skipped along with it
+        for (auto &source : this->sources) {
+            if (source->valid() && !(*key < *source->key())) {
+                source->next();
+            }
+        }
+
+        findSmallest();
+    }
+};
+
+/**
+ * The merge of sources seen as a source itself, so it can be written out as a run
+ */
+template<typename T, typename V>
+class LsmMergeSource : public LsmSource<T, V> {
+
+private:
+    LsmMergeIterator<T, V> iterator;
+
+public:
+    explicit LsmMergeSource(std::vector<std::unique_ptr<LsmSource<T, V>>> sources) : iterator(std::move(sources)) {}
+
+    bool valid() const override {
+        return this->iterator.valid();
+    }
+
+    const std::shared_ptr<T> &key() const override {
+        return this->iterator.key();
+    }
+
+    const std::shared_ptr<V> &value() const override {
+        return this->iterator.value();
+    }
+
+    void next() override {
+        this->iterator.next();
+    }
+};
+
+/**
+ * Everything a read has to look at. A new version is published whenever a memtable or a run is added or replaced, and
+ * readers keep the one they started with, so runs that get compacted away stay readable until they're done
+ */
+template<typename T, typename V>
+struct LsmVersion {
+    std::shared_ptr<ConcurrentSkipList<T, V>> memtable;
+
+    //Memtables that are full and waiting to be written out, newest first
+    std::vector<std::shared_ptr<ConcurrentSkipList<T, V>>> immutables;
+
+    //Newest first, their keys overlap
+    std::vector<std::shared_ptr<LsmRun<T, V>>> level0;
+
+    //One run for each level from 1 on, null when the level is empty
+    std::vector<std::shared_ptr<LsmRun<T, V>>> levels;
+};
+
+struct LsmStats {
+    //Run lookups that the Bloom filter answered without reading the run
+    uint64_t filterSkips;
+
+    //Run lookups that had to read a block of the run
+    uint64_t blockReads;
+};
+
+/**
+ * A log structured merge tree: a key value store that keeps its data in sorted runs on disk.
+ *
+ * Writes go to a ConcurrentSkipList memtable. Once it has enough keys it's swapped for an empty one and a background
+ * thread writes it out as a run in level 0. Once level 0 has LSM_LEVEL0_RUNS runs they're merged with level 1, and
+ * every level that holds more than LSM_LEVEL_RATIO times the keys of the one before it is merged into the next one, so
+ * each level from 1 on is a single run (Leveled compaction). Removing a key writes a tombstone, which is dropped once
+ * it's merged into the last level.
+ *
+ * Lookups go from the newest data to the oldest and skip the runs whose range or Bloom filter rule the key out, range
+ * scans merge all of them.
+ *
+ * Reopening a directory picks up the runs that are in it. The memtable is only written out when it's full, on flush and
+ * on destruction, so writes still in memory are lost if the process dies.
+ *
+ * If the background thread fails to write a run, the memtable stays in memory where reads still find it, and the
+ * error is thrown to every writer and flush from then on.
+ */
+template<typename T, typename V>
+class LsmTree {
+
+private:
+    using Memtable = ConcurrentSkipList<T, V>;
+
+    std::string directory;
+
+    unsigned int memtableEntries;
+
+    //Writers hold it shared while they write to the memtable, swapping the memtable holds it exclusively
+    std::shared_mutex memtableLock;
+
+    std::shared_ptr<Memtable> memtable;
+
+    std::mutex versionLock;
+
+    std::shared_ptr<const LsmVersion<T, V>> version;
+
+    std::atomic_uint64_t nextSequence;
+
+    std::atomic_uint64_t filterSkips, blockReads;
+
+    std::mutex workLock;
+
+    std::condition_variable workReady, workDone;
+
+    unsigned int pendingMemtables;
+
+    bool compacting, stopping;
+
+    //Set once by the background thread when it fails, it stops working after that
+    std::exception_ptr backgroundError;
+
+    std::atomic_bool failed;
+
+    std::thread worker;
+
+    std::string runPath(unsigned int level, uint64_t sequence) const {
+        return this->directory + "/L" + std::to_string(level) + "-" + std::to_string(sequence) + ".run";
+    }
+
+    std::shared_ptr<const LsmVersion<T, V>> currentVersion() {
+
+        std::lock_guard<std::mutex> lock(this->versionLock);
+
+        return this->version;
+    }
+
+    /**
+     * Publish a change to the current version
+     */
+    template<typename F>
+    void updateVersion(F change) {
+
+        std::lock_guard<std::mutex> lock(this->versionLock);
+
+        auto updated = std::make_shared<LsmVersion<T, V>>(*this->version);
+
+        change(*updated);
+
+        this->version = std::move(updated);
+    }
+
+    /**
+     * Pick up the runs left in the directory by a previous instance
+     */
+    void openDirectory() {
+
+        if (::mkdir(this->directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::system_error(errno, std::generic_category(), "Creating " + this->directory);
+        }
+
+        DIR *dir = ::opendir(this->directory.c_str());
+
+        if (dir == nullptr) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + this->directory);
+        }
+
+        std::vector<std::tuple<unsigned int, uint64_t>> found;
+
+        std::vector<std::string> leftovers;
+
+        while (struct dirent *entry = ::readdir(dir)) {
+            std::string name = entry->d_name;
+
+            unsigned int level;
+            unsigned long long sequence;
+            char extension[8];
+
+            if (std::sscanf(name.c_str(), "L%u-%llu.%7s", &level, &sequence, extension) != 3) continue;
+
+            if (std::string(extension) == "run") {
+                found.emplace_back(level, sequence);
+            } else {
+                //Runs that were being written when the previous instance stopped
+                leftovers.push_back(name);
+            }
+        }
+
+        ::closedir(dir);
+
+        for (auto &name : leftovers) {
+            ::unlink((this->directory + "/" + name).c_str());
+        }
+
+        //Newest first
+        std::sort(found.begin(), found.end(), [](auto &first, auto &second) {
+            return std::get<1>(first) > std::get<1>(second);
+        });
+
+        auto initial = std::make_shared<LsmVersion<T, V>>();
+
+        uint64_t sequence = 0, level0Covered = 0;
+
+        for (auto &[level, runSequence] : found) {
+
+            sequence = std::max(sequence, runSequence + 1);
+
+            auto run = std::make_shared<LsmRun<T, V>>(runPath(level, runSequence), level, runSequence);
+
+            level0Covered = std::max(level0Covered, run->getLevel0Covered());
+
+            if (level == 0) {
+                initial->level0.push_back(run);
+
+                continue;
+            }
+
+            if (initial->levels.size() < level) initial->levels.resize(level);
+
+            //A crash between writing a compacted run and removing its inputs leaves the older run of the level
+            //behind, which the newer one already has everything of
+            if (initial->levels[level - 1] == nullptr) {
+                initial->levels[level - 1] = run;
+            } else {
+                run->setObsolete();
+            }
+        }
+
+        //The same goes for level 0 runs that were merged into a level below, which would hide the newer entries
+        //of the runs they were merged with
+        auto covered = [level0Covered](const std::shared_ptr<LsmRun<T, V>> &run) {
+            return run->getSequence() < level0Covered;
+        };
+
+        for (auto &run : initial->level0) {
+            if (covered(run)) run->setObsolete();
+        }
+
+        initial->level0.erase(std::remove_if(initial->level0.begin(), initial->level0.end(), covered),
+                              initial->level0.end());
+
+        this->nextSequence.store(sequence);
+
+        initial->memtable = this->memtable;
+
+        this->version = std::move(initial);
+    }
+
+    static uint64_t levelCapacity(unsigned int level, unsigned int memtableEntries) {
+
+        uint64_t capacity = memtableEntries;
+
+        for (unsigned int i = 0; i < level; i++) {
+            capacity *= LSM_LEVEL_RATIO;
+        }
+
+        return capacity;
+    }
+
+    /**
+     * Swap the memtable for an empty one and hand it to the background thread
+     *
+     * @param force Swap it even if it's not full, as long as it has something
+     */
+    void switchMemtable(bool force) {
+
+        std::unique_lock<std::mutex> work(this->workLock);
+
+        //Writers wait here while the background thread is too far behind
+        this->workDone.wait(work, [this]() {
+            return this->pendingMemtables < LSM_MAX_IMMUTABLE_MEMTABLES || this->backgroundError != nullptr;
+        });
+
+        if (this->backgroundError != nullptr) std::rethrow_exception(this->backgroundError);
+
+        std::unique_lock<std::shared_mutex> lock(this->memtableLock);
+
+        //Another writer might have swapped it already
+        if (this->memtable->size() == 0 || (!force && this->memtable->size() < this->memtableEntries)) return;
+
+        std::shared_ptr<Memtable> full = std::move(this->memtable);
+
+        this->memtable = std::make_shared<Memtable>();
+
+        updateVersion([this, &full](LsmVersion<T, V> &updated) {
+            updated.memtable = this->memtable;
+
+            updated.immutables.insert(updated.immutables.begin(), full);
+        });
+
+        this->pendingMemtables++;
+
+        this->workReady.notify_one();
+    }
+
+    void writeOldestMemtable() {
+
+        std::shared_ptr<Memtable> oldest = currentVersion()->immutables.back();
+
+        LsmMemtableSource<T, V> source(oldest->entries());
+
+        uint64_t sequence = this->nextSequence.fetch_add(1);
+
+        auto run = LsmRun<T, V>::write(runPath(0, sequence), 0, sequence, source, oldest->size(), false, 0);
+
+        fileio::syncDirectory(this->directory);
+
+        updateVersion([&run](LsmVersion<T, V> &updated) {
+            updated.immutables.pop_back();
+
+            if (run != nullptr) {
+                updated.level0.insert(updated.level0.begin(), run);
+            }
+        });
+    }
+
+    /**
+     * Merge runs, newest first, into a single run of the target level that replaces them
+     */
+    void mergeRuns(const std::vector<std::shared_ptr<LsmRun<T, V>>> &inputs, unsigned int targetLevel) {
+
+        auto current = currentVersion();
+
+        //Nothing below the target level, so removed keys have nothing left to hide
+        bool lastLevel = true;
+
+        for (size_t level = targetLevel; level < current->levels.size(); level++) {
+            if (current->levels[level] != nullptr) lastLevel = false;
+        }
+
+        std::vector<std::unique_ptr<LsmSource<T, V>>> sources;
+
+        uint64_t expectedEntries = 0, level0Covered = 0;
+
+        for (auto &input : inputs) {
+            sources.push_back(std::make_unique<LsmRunSource<T, V>>(input, nullptr));
+
+            expectedEntries += input->getEntryCount();
+
+            level0Covered = std::max(level0Covered, input->getLevel() == 0 ? input->getSequence() + 1
+                                                                          : input->getLevel0Covered());
+        }
+
+        LsmMergeSource<T, V> merged(std::move(sources));
+
+        uint64_t sequence = this->nextSequence.fetch_add(1);
+
+        auto output = LsmRun<T, V>::write(runPath(targetLevel, sequence), targetLevel, sequence, merged,
+                                          expectedEntries, lastLevel, level0Covered);
+
+        fileio::syncDirectory(this->directory);
+
+        updateVersion([&inputs, &output, targetLevel](LsmVersion<T, V> &updated) {
+
+            auto replaced = [&inputs](const std::shared_ptr<LsmRun<T, V>> &run) {
+                return std::find(inputs.begin(), inputs.end(), run) != inputs.end();
+            };
+
+            updated.level0.erase(std::remove_if(updated.level0.begin(), updated.level0.end(), replaced),
+                                 updated.level0.end());
+
+            for (auto &run : updated.levels) {
+                if (replaced(run)) run = nullptr;
+            }
+
+            if (updated.levels.size() < targetLevel) updated.levels.resize(targetLevel);
+
+            updated.levels[targetLevel - 1] = output;
+        });
+
+        for (auto &input : inputs) {
+            input->setObsolete();
+        }
+    }
+
+    /**
+     * Merge levels until none of them is over its size
+     */
+    void compact() {
+
+        while (true) {
+
+            auto current = currentVersion();
+
+            if (current->level0.size() >= LSM_LEVEL0_RUNS) {
+
+                auto inputs = current->level0;
+
+                if (!current->levels.empty() && current->levels[0] != nullptr) {
+                    inputs.push_back(current->levels[0]);
+                }
+
+                mergeRuns(inputs, 1);
+
+                continue;
+            }
+
+            bool merged = false;
+
+            for (size_t level = 0; level < current->levels.size(); level++) {
+
+                auto &run = current->levels[level];
+
+                if (run == nullptr || run->getEntryCount() <= levelCapacity(level + 1, this->memtableEntries)) {
+                    continue;
+                }
+
+                std::vector<std::shared_ptr<LsmRun<T, V>>> inputs{run};
+
+                if (level + 1 < current->levels.size() && current->levels[level + 1] != nullptr) {
+                    inputs.push_back(current->levels[level + 1]);
+                }
+
+                mergeRuns(inputs, level + 2);
+
+                merged = true;
+
+                break;
+            }
+
+            if (!merged) return;
+        }
+    }
+
+    /**
+     * Run a step of the background work without holding the work lock. Throwing from the background thread would end
+     * the process, so a failure is kept for the writers and flush to throw instead
+     *
+     * @return If the step succeeded
+     */
+    template<typename F>
+    bool runUnlocked(std::unique_lock<std::mutex> &work, F step) {
+
+        work.unlock();
+
+        std::exception_ptr error;
+
+        try {
+            step();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        work.lock();
+
+        if (error == nullptr) return true;
+
+        this->backgroundError = error;
+
+        this->failed.store(true, std::memory_order_release);
+
+        return false;
+    }
+
+    void backgroundWork() {
+
+        std::unique_lock<std::mutex> work(this->workLock);
+
+        while (true) {
+            this->workReady.wait(work, [this]() {
+                return this->stopping || (this->pendingMemtables > 0 && this->backgroundError == nullptr);
+            });
+
+            //After a failure the memtables stay pending, so reads keep finding their keys
+            if (this->pendingMemtables == 0 || this->backgroundError != nullptr) return;
+
+            this->compacting = true;
+
+            if (runUnlocked(work, [this]() { writeOldestMemtable(); })) {
+
+                this->pendingMemtables--;
+
+                //Writers that were waiting for room can go on while the levels are compacted
+                this->workDone.notify_all();
+
+                runUnlocked(work, [this]() { compact(); });
+            }
+
+            this->compacting = false;
+
+            this->workDone.notify_all();
+        }
+    }
+
+    /**
+     * Look the key up from the newest data to the oldest
+     *
+     * @return Empty if no data has the key, null if the newest entry of it is a removal
+     */
+    std::optional<std::shared_ptr<V>> lookup(const T &key) {
+
+        auto current = currentVersion();
+
+        if (auto found = current->memtable->get(key)) return found;
+
+        for (auto &immutable : current->immutables) {
+            if (auto found = immutable->get(key)) return found;
+        }
+
+        auto searchRun = [this, &key](const std::shared_ptr<LsmRun<T, V>> &run) -> std::optional<std::shared_ptr<V>> {
+            if (run == nullptr) return std::nullopt;
+
+            if (!run->mightContain(key)) {
+                this->filterSkips.fetch_add(1, std::memory_order_relaxed);
+
+                return std::nullopt;
+            }
+
+            this->blockReads.fetch_add(1, std::memory_order_relaxed);
+
+            return run->find(key);
+        };
+
+        for (auto &run : current->level0) {
+            if (auto found = searchRun(run)) return found;
+        }
+
+        for (auto &run : current->levels) {
+            if (auto found = searchRun(run)) return found;
+        }
+
+        return std::nullopt;
+    }
+
+    /**
+     * Merge all the data from the base on, skipping removed keys
+     *
+     * @param base Null to start at the smallest key
+     * @param max Null to go until the largest key
+     */
+    std::unique_ptr<std::vector<node_info<T, V>>> scan(const T *base, const T *max) {
+
+        auto current = currentVersion();
+
+        std::vector<std::unique_ptr<LsmSource<T, V>>> sources;
+
+        auto addMemtable = [&sources, base, max](const std::shared_ptr<Memtable> &memtable) {
+            if (base != nullptr && max != nullptr) {
+                sources.push_back(std::make_unique<LsmMemtableSource<T, V>>(memtable->rangeSearch(*base, *max)));
+            } else {
+                sources.push_back(std::make_unique<LsmMemtableSource<T, V>>(memtable->entries()));
+            }
+        };
+
+        addMemtable(current->memtable);
+
+        for (auto &immutable : current->immutables) {
+            addMemtable(immutable);
+        }
+
+        for (auto &run : current->level0) {
+            sources.push_back(std::make_unique<LsmRunSource<T, V>>(run, base));
+        }
+
+        for (auto &run : current->levels) {
+            if (run != nullptr) sources.push_back(std::make_unique<LsmRunSource<T, V>>(run, base));
+        }
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        for (LsmMergeIterator<T, V> iterator(std::move(sources)); iterator.valid(); iterator.next()) {
+
+            if (max != nullptr && *max < *iterator.key()) break;
+
+            if (iterator.value() != nullptr) {
+                results->push_back(std::make_tuple(iterator.key(), iterator.value()));
+            }
+        }
+
+        return results;
+    }
+
+public:
+    /**
+     * Open the store kept in the directory, creating it if needed
+     *
+     * @param memtableEntries Keys the memtable takes before being written out
+     */
+    explicit LsmTree(std::string directory, unsigned int memtableEntries = LSM_MEMTABLE_ENTRIES)
+            : directory(std::move(directory)), memtableEntries(memtableEntries),
+              memtable(std::make_shared<Memtable>()), nextSequence(0), filterSkips(0), blockReads(0),
+              pendingMemtables(0), compacting(false), stopping(false), failed(false) {
+
+        openDirectory();
+
+        this->worker = std::thread(&LsmTree<T, V>::backgroundWork, this);
+    }
+
+    /**
+     * Writes out the memtable and waits for the background thread to finish
+     */
+    ~LsmTree() {
+
+        try {
+            flush();
+        } catch (...) {
+            //The background thread failed, so the writes still in memory are lost as if the process had died
+        }
+
+        {
+            std::lock_guard<std::mutex> work(this->workLock);
+
+            this->stopping = true;
+        }
+
+        this->workReady.notify_one();
+
+        this->worker.join();
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+
+        //The error is only written before the flag is set, and never changes after that
+        if (this->failed.load(std::memory_order_acquire)) std::rethrow_exception(this->backgroundError);
+
+        {
+            std::shared_lock<std::shared_mutex> lock(this->memtableLock);
+
+            this->memtable->add(std::move(key), std::move(value));
+
+            if (this->memtable->size() < this->memtableEntries) return;
+        }
+
+        switchMemtable(false);
+    }
+
+    /**
+     * Remove the key. The removal is written like any other write, so this doesn't tell whether the key was there
+     */
+    void remove(const T &key) {
+        add(std::make_shared<T>(key), nullptr);
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) {
+
+        auto found = lookup(key);
+
+        if (found && *found != nullptr) return found;
+
+        return std::nullopt;
+    }
+
+    bool hasKey(const T &key) {
+        return get(key).has_value();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) {
+        return scan(&base, &max);
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() {
+        return scan(nullptr, nullptr);
+    }
+
+    /**
+     * Write out the memtable and wait until it and every compaction it leads to are done
+     */
+    void flush() {
+
+        switchMemtable(true);
+
+        std::unique_lock<std::mutex> work(this->workLock);
+
+        this->workDone.wait(work, [this]() {
+            return (this->pendingMemtables == 0 && !this->compacting) || this->backgroundError != nullptr;
+        });
+
+        if (this->backgroundError != nullptr) std::rethrow_exception(this->backgroundError);
+    }
+
+    LsmStats getStats() const {
+        return {this->filterSkips.load(), this->blockReads.load()};
+    }
+
+    /**
+     * @return How many runs each level has, starting at level 0
+     */
+    std::vector<unsigned int> getRunCounts() {
+
+        auto current = currentVersion();
+
+        std::vector<unsigned int> counts{(unsigned int) current->level0.size()};
+
+        for (auto &run : current->levels) {
+            counts.push_back(run != nullptr);
+        }
+
+        return counts;
+    }
+};
+
+#endif //TRABALHO1_LSMTREE_H
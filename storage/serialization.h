@@ -0,0 +1,73 @@
+#ifndef TRABALHO1_SERIALIZATION_H
+#define TRABALHO1_SERIALIZATION_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/**
+ * How keys and values are written to disk. Types that can be copied byte by byte are written as they are in memory,
+ * so files are only meant to be read back on the same kind of machine.
+ *
+ * Bytes are appended to a std::string, which is just used as a growable buffer
+ */
+template<typename T>
+struct Serializer {
+
+    static_assert(std::is_trivially_copyable<T>::value, "Types that can't be copied byte by byte need a Serializer");
+
+    static void write(std::string &out, const T &value) {
+        out.append((const char *) &value, sizeof(T));
+    }
+
+    /**
+     * Read a value and move the cursor past it
+     */
+    static T read(const char *&cursor) {
+
+        T value;
+
+        std::memcpy(&value, cursor, sizeof(T));
+
+        cursor += sizeof(T);
+
+        return value;
+    }
+
+    /**
+     * Whether the given bytes hold a whole value, so reading it doesn't go past them
+     */
+    static bool fits(const char *, size_t length) {
+        return length >= sizeof(T);
+    }
+};
+
+//Strings are written with their length first
+template<>
+struct Serializer<std::string> {
+
+    static void write(std::string &out, const std::string &value) {
+
+        Serializer<uint32_t>::write(out, (uint32_t) value.size());
+
+        out.append(value);
+    }
+
+    static std::string read(const char *&cursor) {
+
+        uint32_t length = Serializer<uint32_t>::read(cursor);
+
+        std::string value(cursor, length);
+
+        cursor += length;
+
+        return value;
+    }
+
+    static bool fits(const char *cursor, size_t length) {
+        return length >= sizeof(uint32_t) && Serializer<uint32_t>::read(cursor) <= length - sizeof(uint32_t);
+    }
+};
+
+#endif //TRABALHO1_SERIALIZATION_H
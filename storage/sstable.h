@@ -0,0 +1,942 @@
+#ifndef TRABALHO1_SSTABLE_H
+#define TRABALHO1_SSTABLE_H
+
+#include "../datastructures.h"
+#include "../filters/hashes/MurmurHash3.h"
+#include "../filters/hashes/SpookyV2.h"
+#include "../trees/radixkey.h"
+#include "checksum.h"
+#include "fileio.h"
+#include "serialization.h"
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+//Size of the data blocks, a page. A block only gets bigger when a single entry doesn't fit in it
+#define SSTABLE_BLOCK_SIZE 4096
+//"SSTable1"
+#define SSTABLE_MAGIC 0x53535461626C6531ull
+//Every this many keys of a block one is stored whole, lookups binary search those and then go through the rest
+#define SSTABLE_RESTART_INTERVAL 16
+//Most hash functions a block filter uses, however many bits per key it gets
+#define SSTABLE_MAX_HASH_FUNCTIONS 16
+
+/**
+ * Where a data block and its filter are, and what's in them. The index is an array of these, read in place from the
+ * mapped file
+ */
+struct SSTableBlockHandle {
+    uint64_t offset;
+
+    uint64_t filterOffset;
+
+    //Where the last key of the block is in the key area
+    uint64_t lastKeyOffset;
+
+    //Bytes of entries in the block, the rest of it is padding
+    uint32_t length;
+
+    //Zero when the table has no filters
+    uint32_t filterLength;
+
+    uint32_t entryCount;
+
+    //Of the entries and then of the filter
+    uint32_t checksum;
+
+    uint32_t lastKeyLength;
+
+    uint32_t reserved;
+};
+
+struct SSTableFooter {
+    uint64_t magic;
+
+    uint64_t entryCount;
+
+    uint64_t indexOffset;
+
+    uint64_t blockCount;
+
+    uint64_t keysOffset;
+
+    uint64_t keysLength;
+
+    uint32_t blockSize;
+
+    //Zero when the blocks have no filters
+    uint32_t filterHashFunctions;
+
+    //Of the index and then of the key area
+    uint32_t indexChecksum;
+
+    //Of the footer up to here
+    uint32_t footerChecksum;
+};
+
+/**
+ * Varints and the hashes of the block filters, shared by the writer and the reader
+ */
+namespace sstable {
+
+    inline void writeVarint(std::string &out, uint32_t value) {
+
+        while (value >= 0x80) {
+            out.push_back((char) (value | 0x80));
+
+            value >>= 7;
+        }
+
+        out.push_back((char) value);
+    }
+
+    /**
+     * Read a varint that has to end before the end of the buffer
+     *
+     * @return False if it doesn't, or if it's longer than a 32 bit varint can be
+     */
+    inline bool readVarint(const char *&cursor, const char *end, uint32_t &value) {
+
+        value = 0;
+
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (cursor >= end) return false;
+
+            auto byte = (uint8_t) *cursor++;
+
+            value |= (uint32_t) (byte & 0x7F) << shift;
+
+            if (byte < 0x80) return true;
+        }
+
+        return false;
+    }
+
+    inline size_t varintSize(uint32_t value) {
+
+        size_t size = 1;
+
+        while (value >= 0x80) {
+            value >>= 7;
+
+            size++;
+        }
+
+        return size;
+    }
+
+    /**
+     * The two hashes the positions of a key in a filter are derived from, as h1 + i * h2
+     */
+    inline std::pair<uint32_t, uint32_t> filterHashes(const char *key, size_t length) {
+
+        static MurmurHash murmurHash;
+
+        static SpookyHashImpl spookyHash;
+
+        return {murmurHash.hashObject(key, length, 0), spookyHash.hashObject(key, length, 0) | 1};
+    }
+
+    /**
+     * Compare two encoded keys byte by byte
+     */
+    inline int compareKeys(const char *first, size_t firstLength, const char *second, size_t secondLength) {
+
+        int result = std::memcmp(first, second, std::min(firstLength, secondLength));
+
+        if (result != 0) return result;
+
+        return firstLength < secondLength ? -1 : (firstLength > secondLength ? 1 : 0);
+    }
+}
+
+/**
+ * Writes an immutable sorted table in a single pass over entries given in ascending key order, like the entries() of
+ * an OrderedMap.
+ *
+ * Layout:
+ * - The data blocks, each SSTABLE_BLOCK_SIZE bytes padded with zeros. Keys are stored in their RadixKey encoding and
+ * each one only keeps the bytes that differ from the key before it in the block (Prefix compression): every entry is
+ * the amount of shared bytes, the amount of new bytes and the size of the value as varints, then the new bytes of the
+ * key and the value. Every SSTABLE_RESTART_INTERVAL'th key is stored whole (Starting with the first one, so blocks
+ * can be read on their own), and the block ends with their offsets and how many there are.
+ * - The Bloom filter of each block, if the table has them
+ * - The index, an SSTableBlockHandle per block, followed by the key area with the last key of every block
+ * - The footer
+ *
+ * The blocks are written out as they fill up, only the index and the filters are kept in memory until the end.
+ */
+template<typename T, typename V>
+class SSTableWriter {
+
+private:
+    std::string path, temporaryPath;
+
+    int file;
+
+    uint32_t blockSize, bitsPerKey, hashFunctions;
+
+    std::string block, filters, keys;
+
+    std::vector<SSTableBlockHandle> handles;
+
+    //Filter hashes of the keys of the current block
+    std::vector<std::pair<uint32_t, uint32_t>> blockHashes;
+
+    std::string previousKey, currentKey, valueBytes;
+
+    //Where the keys that are stored whole start in the current block
+    std::vector<uint32_t> restarts;
+
+    uint32_t blockEntries;
+
+    uint64_t written, entryCount;
+
+    bool finished;
+
+    void finishBlock() {
+
+        for (uint32_t restart : this->restarts) {
+            Serializer<uint32_t>::write(this->block, restart);
+        }
+
+        Serializer<uint32_t>::write(this->block, this->restarts.size());
+
+        SSTableBlockHandle handle{};
+
+        handle.offset = this->written;
+        handle.length = this->block.size();
+        handle.entryCount = this->blockEntries;
+        handle.checksum = crc32c(this->block.data(), this->block.size());
+        handle.lastKeyOffset = this->keys.size();
+        handle.lastKeyLength = this->previousKey.size();
+
+        this->keys.append(this->previousKey);
+
+        if (this->bitsPerKey > 0) {
+            //Offset from the start of the filters for now, they go after the last block
+            handle.filterOffset = this->filters.size();
+
+            uint32_t bits = std::max((uint32_t) 64, this->blockEntries * this->bitsPerKey);
+
+            handle.filterLength = (bits + 7) / 8;
+
+            bits = handle.filterLength * 8;
+
+            size_t start = this->filters.size();
+
+            this->filters.resize(start + handle.filterLength);
+
+            for (auto &[first, second] : this->blockHashes) {
+                for (uint32_t i = 0; i < this->hashFunctions; i++) {
+                    uint32_t position = (first + i * second) % bits;
+
+                    this->filters[start + position / 8] |= (char) (1 << (position % 8));
+                }
+            }
+
+            handle.checksum = crc32c(this->filters.data() + start, handle.filterLength, handle.checksum);
+        }
+
+        this->handles.push_back(handle);
+
+        //Pad the block to a multiple of the block size
+        size_t padded = (this->block.size() + this->blockSize - 1) / this->blockSize * this->blockSize;
+
+        this->block.resize(padded, '\0');
+
+        fileio::writeFully(this->file, this->block.data(), this->block.size(), this->temporaryPath);
+
+        this->written += this->block.size();
+
+        this->block.clear();
+        this->restarts.clear();
+        this->blockHashes.clear();
+        this->blockEntries = 0;
+    }
+
+public:
+    /**
+     * @param blockSize Bytes of each data block
+     * @param bitsPerKey Bits of the Bloom filter of each block per key in it, zero for no filters. 10 gives about 1%
+     * false positives
+     */
+    explicit SSTableWriter(std::string path, uint32_t blockSize = SSTABLE_BLOCK_SIZE, uint32_t bitsPerKey = 0)
+            : path(std::move(path)), blockSize(blockSize), bitsPerKey(bitsPerKey), blockEntries(0), written(0),
+              entryCount(0), finished(false) {
+
+        if (blockSize == 0) {
+            throw std::invalid_argument("The block size can't be 0");
+        }
+
+        //k = bits per key * ln 2 is the amount of hash functions with the lowest false positive rate
+        this->hashFunctions = bitsPerKey == 0 ? 0 : (uint32_t) std::min(
+                (double) SSTABLE_MAX_HASH_FUNCTIONS, std::max(1.0, std::round(bitsPerKey * std::log(2))));
+
+        this->temporaryPath = this->path + ".tmp";
+
+        this->file = ::open(this->temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (this->file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Creating " + this->temporaryPath);
+        }
+    }
+
+    SSTableWriter(const SSTableWriter &) = delete;
+
+    SSTableWriter &operator=(const SSTableWriter &) = delete;
+
+    /**
+     * A writer that wasn't finished leaves nothing behind
+     */
+    ~SSTableWriter() {
+        if (!this->finished) {
+            if (this->file >= 0) ::close(this->file);
+
+            ::unlink(this->temporaryPath.c_str());
+        }
+    }
+
+    /**
+     * Add an entry, the keys have to come in ascending order
+     */
+    void add(const T &key, const V &value) {
+
+        this->currentKey.clear();
+
+        RadixKey<T>::encode(key, this->currentKey);
+
+        if (this->entryCount > 0 && sstable::compareKeys(this->currentKey.data(), this->currentKey.size(),
+                                                         this->previousKey.data(), this->previousKey.size()) <= 0) {
+            throw std::invalid_argument("The keys of a table have to be added in ascending order");
+        }
+
+        this->valueBytes.clear();
+
+        Serializer<V>::write(this->valueBytes, value);
+
+        bool restart = this->blockEntries % SSTABLE_RESTART_INTERVAL == 0;
+
+        uint32_t shared = 0;
+
+        if (!restart) {
+            size_t limit = std::min(this->currentKey.size(), this->previousKey.size());
+
+            while (shared < limit && this->currentKey[shared] == this->previousKey[shared]) shared++;
+        }
+
+        uint32_t unshared = this->currentKey.size() - shared;
+
+        size_t entrySize = sstable::varintSize(shared) + sstable::varintSize(unshared) +
+                           sstable::varintSize(this->valueBytes.size()) + unshared + this->valueBytes.size();
+
+        //The restart offsets and their amount go at the end of the block
+        size_t trailer = (this->restarts.size() + restart + 1) * sizeof(uint32_t);
+
+        if (this->blockEntries > 0 && this->block.size() + entrySize + trailer > this->blockSize) {
+            finishBlock();
+
+            //The first key of a block is stored whole, so blocks can be read on their own
+            restart = true;
+            unshared += shared;
+            shared = 0;
+        }
+
+        if (restart) {
+            this->restarts.push_back(this->block.size());
+        }
+
+        sstable::writeVarint(this->block, shared);
+        sstable::writeVarint(this->block, unshared);
+        sstable::writeVarint(this->block, this->valueBytes.size());
+
+        this->block.append(this->currentKey, shared, unshared);
+        this->block.append(this->valueBytes);
+
+        if (this->bitsPerKey > 0) {
+            this->blockHashes.push_back(sstable::filterHashes(this->currentKey.data(), this->currentKey.size()));
+        }
+
+        this->blockEntries++;
+        this->entryCount++;
+
+        this->previousKey.swap(this->currentKey);
+    }
+
+    /**
+     * Write out the index and the footer, sync the file and give it its final name
+     */
+    void finish() {
+
+        if (this->blockEntries > 0) {
+            finishBlock();
+        }
+
+        uint64_t filtersStart = this->written;
+
+        for (auto &handle : this->handles) {
+            handle.filterOffset += filtersStart;
+        }
+
+        std::string tail = std::move(this->filters);
+
+        //The index is read in place, so it has to be aligned. The blocks before it can end anywhere
+        tail.resize((filtersStart + tail.size() + 7) / 8 * 8 - filtersStart, '\0');
+
+        SSTableFooter footer{};
+
+        footer.magic = SSTABLE_MAGIC;
+        footer.entryCount = this->entryCount;
+        footer.indexOffset = filtersStart + tail.size();
+        footer.blockCount = this->handles.size();
+        footer.keysOffset = footer.indexOffset + this->handles.size() * sizeof(SSTableBlockHandle);
+        footer.keysLength = this->keys.size();
+        footer.blockSize = this->blockSize;
+        footer.filterHashFunctions = this->hashFunctions;
+
+        const char *index = (const char *) this->handles.data();
+
+        footer.indexChecksum = crc32c(this->keys.data(), this->keys.size(),
+                                      crc32c(index, this->handles.size() * sizeof(SSTableBlockHandle)));
+
+        footer.footerChecksum = crc32c(&footer, offsetof(SSTableFooter, footerChecksum));
+
+        tail.append(index, this->handles.size() * sizeof(SSTableBlockHandle));
+        tail.append(this->keys);
+
+        //The footer is read in place as well
+        tail.resize((filtersStart + tail.size() + 7) / 8 * 8 - filtersStart, '\0');
+        tail.append((const char *) &footer, sizeof(SSTableFooter));
+
+        fileio::writeFully(this->file, tail.data(), tail.size(), this->temporaryPath);
+
+        if (::fsync(this->file) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Syncing " + this->temporaryPath);
+        }
+
+        ::close(this->file);
+
+        this->file = -1;
+
+        if (::rename(this->temporaryPath.c_str(), this->path.c_str()) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Renaming " + this->temporaryPath);
+        }
+
+        this->finished = true;
+    }
+
+    /**
+     * Write the entries of the map to a table, in a single pass over its entries()
+     */
+    static void write(const std::string &path, OrderedMap<T, V> *map, uint32_t blockSize = SSTABLE_BLOCK_SIZE,
+                      uint32_t bitsPerKey = 0) {
+
+        SSTableWriter<T, V> writer(path, blockSize, bitsPerKey);
+
+        auto entries = map->entries();
+
+        for (auto &entry : *entries) {
+            writer.add(*std::get<0>(entry), *std::get<1>(entry));
+        }
+
+        writer.finish();
+    }
+};
+
+/**
+ * A table written by SSTableWriter, mapped into memory. Opening it only checks the footer and the index, the blocks
+ * are paged in by the OS as lookups touch them, so a table of any size opens in constant time and nothing is
+ * deserialized up front.
+ *
+ * Lookups binary search the index and compare the keys where they are in the mapping, then decode the one block that
+ * could have the key (After asking its filter, if it has one).
+ */
+template<typename T, typename V>
+class SSTable {
+
+private:
+    std::string path;
+
+    const char *data;
+
+    size_t fileSize;
+
+    const SSTableFooter *footer;
+
+    const SSTableBlockHandle *handles;
+
+    const char *keys;
+
+    //Check the checksum of every block that is read, instead of only with verify
+    bool verifyChecksums;
+
+    /**
+     * Goes through the entries of a block, rebuilding each key from the one before it. Blocks are only checksummed
+     * with verifyChecksums, so every length read from one is checked against the end of the block
+     */
+    struct BlockCursor {
+        const SSTable<T, V> *table;
+
+        size_t block;
+
+        const char *start, *position, *end;
+
+        //Offsets of the keys that are stored whole, unaligned
+        const char *restarts;
+
+        uint32_t restartCount;
+
+        std::string key;
+
+        const char *value;
+
+        uint32_t valueLength;
+
+        [[noreturn]] void corrupted() const {
+            this->table->corrupted("block " + std::to_string(this->block));
+        }
+
+        /**
+         * Where the entry with a whole key starts
+         */
+        const char *restartEntry(uint32_t restart) const {
+
+            const char *cursor = this->restarts + restart * sizeof(uint32_t);
+
+            uint32_t offset = Serializer<uint32_t>::read(cursor);
+
+            if (offset >= (size_t) (this->end - this->start)) corrupted();
+
+            return this->start + offset;
+        }
+
+        bool next() {
+
+            if (this->position >= this->end) return false;
+
+            uint32_t shared, unshared;
+
+            if (!sstable::readVarint(this->position, this->end, shared) ||
+                !sstable::readVarint(this->position, this->end, unshared) ||
+                !sstable::readVarint(this->position, this->end, this->valueLength) || shared > this->key.size() ||
+                unshared > (size_t) (this->end - this->position) ||
+                this->valueLength > (size_t) (this->end - this->position) - unshared) {
+                corrupted();
+            }
+
+            this->key.resize(shared);
+            this->key.append(this->position, unshared);
+
+            this->value = this->position + unshared;
+
+            this->position = this->value + this->valueLength;
+
+            return true;
+        }
+
+        int compare(const std::string &other) const {
+            return sstable::compareKeys(this->key.data(), this->key.size(), other.data(), other.size());
+        }
+
+        /**
+         * Compare a key that is stored whole with another one, where it is in the block
+         */
+        int compareRestart(uint32_t restart, const std::string &other) const {
+
+            const char *cursor = restartEntry(restart);
+
+            //No shared bytes, and the value length isn't needed
+            uint32_t shared, length, valueLength;
+
+            if (!sstable::readVarint(cursor, this->end, shared) || !sstable::readVarint(cursor, this->end, length) ||
+                !sstable::readVarint(cursor, this->end, valueLength) || length > (size_t) (this->end - cursor)) {
+                corrupted();
+            }
+
+            return sstable::compareKeys(cursor, length, other.data(), other.size());
+        }
+
+        /**
+         * Move to just before the last key that is stored whole and is < than the key, so the next entries lead up
+         * to it
+         */
+        void skipTo(const std::string &other) {
+
+            //The first key of the block can't be skipped
+            uint32_t low = 0, high = this->restartCount - 1;
+
+            while (low < high) {
+                uint32_t middle = (low + high + 1) / 2;
+
+                if (compareRestart(middle, other) < 0) {
+                    low = middle;
+                } else {
+                    high = middle - 1;
+                }
+            }
+
+            this->position = restartEntry(low);
+
+            this->key.clear();
+        }
+    };
+
+    static std::string encode(const T &key) {
+
+        std::string bytes;
+
+        RadixKey<T>::encode(key, bytes);
+
+        return bytes;
+    }
+
+    [[noreturn]] void corrupted(const std::string &what) const {
+        throw std::runtime_error("Corrupted table " + this->path + ": " + what);
+    }
+
+    void checkBlock(size_t block) const {
+
+        const SSTableBlockHandle &handle = this->handles[block];
+
+        uint32_t checksum = crc32c(this->data + handle.offset, handle.length);
+
+        checksum = crc32c(this->data + handle.filterOffset, handle.filterLength, checksum);
+
+        if (checksum != handle.checksum) {
+            corrupted("block " + std::to_string(block));
+        }
+    }
+
+    /**
+     * The first block whose last key is >= to the key, the only one that can have it
+     */
+    size_t findBlock(const std::string &key) const {
+
+        size_t low = 0, high = this->footer->blockCount;
+
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+
+            const SSTableBlockHandle &handle = this->handles[middle];
+
+            if (sstable::compareKeys(this->keys + handle.lastKeyOffset, handle.lastKeyLength, key.data(),
+                                     key.size()) < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        return low;
+    }
+
+    bool filterRejects(size_t block, const std::string &key) const {
+
+        const SSTableBlockHandle &handle = this->handles[block];
+
+        if (this->footer->filterHashFunctions == 0) return false;
+
+        auto [first, second] = sstable::filterHashes(key.data(), key.size());
+
+        uint32_t bits = handle.filterLength * 8;
+
+        const char *filter = this->data + handle.filterOffset;
+
+        for (uint32_t i = 0; i < this->footer->filterHashFunctions; i++) {
+            uint32_t position = (first + i * second) % bits;
+
+            if ((filter[position / 8] & (1 << (position % 8))) == 0) return true;
+        }
+
+        return false;
+    }
+
+    BlockCursor openBlock(size_t block) const {
+
+        if (this->verifyChecksums) {
+            checkBlock(block);
+        }
+
+        const SSTableBlockHandle &handle = this->handles[block];
+
+        BlockCursor cursor;
+
+        cursor.table = this;
+        cursor.block = block;
+
+        cursor.start = this->data + handle.offset;
+        cursor.position = cursor.start;
+
+        const char *trailer = cursor.start + handle.length - sizeof(uint32_t);
+
+        cursor.restartCount = Serializer<uint32_t>::read(trailer);
+
+        //Every block starts with a whole key
+        if (cursor.restartCount == 0 || (cursor.restartCount + 1ull) * sizeof(uint32_t) > handle.length) {
+            corrupted("block " + std::to_string(block));
+        }
+
+        cursor.restarts = cursor.start + handle.length - (cursor.restartCount + 1) * sizeof(uint32_t);
+        cursor.end = cursor.restarts;
+
+        return cursor;
+    }
+
+    /**
+     * Find the entry with the key in its block
+     *
+     * @return Whether it's there, with the cursor on it
+     */
+    bool seek(const std::string &key, BlockCursor &cursor) const {
+
+        size_t block = findBlock(key);
+
+        if (block == this->footer->blockCount || filterRejects(block, key)) return false;
+
+        cursor = openBlock(block);
+
+        cursor.skipTo(key);
+
+        while (cursor.next()) {
+            int comparison = cursor.compare(key);
+
+            if (comparison >= 0) return comparison == 0;
+        }
+
+        return false;
+    }
+
+    std::shared_ptr<V> decodeValue(const BlockCursor &cursor) const {
+
+        if (!Serializer<V>::fits(cursor.value, cursor.valueLength)) cursor.corrupted();
+
+        const char *value = cursor.value;
+
+        return std::make_shared<V>(Serializer<V>::read(value));
+    }
+
+    node_info<T, V> decode(const BlockCursor &cursor) const {
+        return std::make_tuple(std::make_shared<T>(RadixKey<T>::decode(cursor.key.data(), cursor.key.size())),
+                               decodeValue(cursor));
+    }
+
+    /**
+     * Decode the entries from the first key >= to the base until the first key > than the max
+     *
+     * @param max Null to go until the end of the table
+     */
+    void scan(const std::string &base, const std::string *max, std::vector<node_info<T, V>> *results) const {
+
+        for (size_t block = findBlock(base); block < this->footer->blockCount; block++) {
+
+            BlockCursor cursor = openBlock(block);
+
+            cursor.skipTo(base);
+
+            while (cursor.next()) {
+                if (cursor.compare(base) < 0) continue;
+
+                if (max != nullptr && cursor.compare(*max) > 0) return;
+
+                results->push_back(decode(cursor));
+            }
+        }
+    }
+
+public:
+    /**
+     * Map the table and check its footer and index
+     *
+     * @param verifyChecksums Also check every block when it's read
+     */
+    explicit SSTable(std::string path, bool verifyChecksums = false) : path(std::move(path)),
+                                                                         verifyChecksums(verifyChecksums) {
+
+        int file = ::open(this->path.c_str(), O_RDONLY);
+
+        if (file < 0) {
+            throw std::system_error(errno, std::generic_category(), "Opening " + this->path);
+        }
+
+        struct stat status{};
+
+        if (::fstat(file, &status) != 0) {
+            ::close(file);
+
+            throw std::system_error(errno, std::generic_category(), "Reading " + this->path);
+        }
+
+        this->fileSize = status.st_size;
+
+        if (this->fileSize < sizeof(SSTableFooter)) {
+            ::close(file);
+
+            corrupted("too short");
+        }
+
+        void *mapping = ::mmap(nullptr, this->fileSize, PROT_READ, MAP_SHARED, file, 0);
+
+        //The mapping keeps the file open
+        ::close(file);
+
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "Mapping " + this->path);
+        }
+
+        this->data = (const char *) mapping;
+
+        try {
+            this->footer = (const SSTableFooter *) (this->data + this->fileSize - sizeof(SSTableFooter));
+
+            if (this->footer->magic != SSTABLE_MAGIC ||
+                this->footer->footerChecksum != crc32c(this->footer, offsetof(SSTableFooter, footerChecksum))) {
+                corrupted("bad footer");
+            }
+
+            uint64_t indexLength = this->footer->blockCount * sizeof(SSTableBlockHandle);
+
+            if (this->footer->indexOffset % 8 != 0 ||
+                this->footer->keysOffset != this->footer->indexOffset + indexLength ||
+                this->footer->keysOffset + this->footer->keysLength > this->fileSize - sizeof(SSTableFooter)) {
+                corrupted("bad index position");
+            }
+
+            this->handles = (const SSTableBlockHandle *) (this->data + this->footer->indexOffset);
+
+            this->keys = this->data + this->footer->keysOffset;
+
+            if (crc32c(this->keys, this->footer->keysLength,
+                       crc32c(this->handles, indexLength)) != this->footer->indexChecksum) {
+                corrupted("bad index");
+            }
+
+            //The blocks are parsed in place, so they have to be inside the data area
+            auto inside = [](uint64_t offset, uint64_t length, uint64_t limit) {
+                return offset <= limit && length <= limit - offset;
+            };
+
+            for (uint64_t block = 0; block < this->footer->blockCount; block++) {
+                const SSTableBlockHandle &handle = this->handles[block];
+
+                if (handle.length < sizeof(uint32_t) ||
+                    !inside(handle.offset, handle.length, this->footer->indexOffset) ||
+                    !inside(handle.filterOffset, handle.filterLength, this->footer->indexOffset) ||
+                    (this->footer->filterHashFunctions != 0 && handle.filterLength == 0) ||
+                    !inside(handle.lastKeyOffset, handle.lastKeyLength, this->footer->keysLength)) {
+                    corrupted("bad block " + std::to_string(block));
+                }
+            }
+        } catch (...) {
+            ::munmap(mapping, this->fileSize);
+
+            throw;
+        }
+
+        //Lookups jump around the file, reading ahead would mostly bring in pages that aren't needed
+        ::madvise(mapping, this->fileSize, MADV_RANDOM);
+    }
+
+    SSTable(const SSTable &) = delete;
+
+    SSTable &operator=(const SSTable &) = delete;
+
+    ~SSTable() {
+        ::munmap((void *) this->data, this->fileSize);
+    }
+
+    unsigned int size() const {
+        return this->footer->entryCount;
+    }
+
+    uint64_t getBlockCount() const {
+        return this->footer->blockCount;
+    }
+
+    bool hasKey(const T &key) const {
+
+        BlockCursor cursor;
+
+        return seek(encode(key), cursor);
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) const {
+
+        BlockCursor cursor;
+
+        if (!seek(encode(key), cursor)) return std::nullopt;
+
+        return decodeValue(cursor);
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) const {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        std::string encodedMax = encode(max);
+
+        scan(encode(base), &encodedMax, results.get());
+
+        return results;
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() const {
+
+        if (this->footer->blockCount == 0) return std::nullopt;
+
+        BlockCursor cursor = openBlock(0);
+
+        if (!cursor.next()) cursor.corrupted();
+
+        return decode(cursor);
+    }
+
+    std::optional<node_info<T, V>> peekLargest() const {
+
+        if (this->footer->blockCount == 0) return std::nullopt;
+
+        BlockCursor cursor = openBlock(this->footer->blockCount - 1), last = cursor;
+
+        if (!cursor.next()) cursor.corrupted();
+
+        do {
+            last = cursor;
+        } while (cursor.next());
+
+        return decode(last);
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() const {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        results->reserve(this->footer->entryCount);
+
+        scan(std::string(), nullptr, results.get());
+
+        return results;
+    }
+
+    /**
+     * Check the checksums of every block
+     */
+    bool verify() const {
+
+        try {
+            for (size_t block = 0; block < this->footer->blockCount; block++) {
+                checkBlock(block);
+            }
+        } catch (std::runtime_error &) {
+            return false;
+        }
+
+        return true;
+    }
+};
+
+#endif //TRABALHO1_SSTABLE_H
@@ -0,0 +1,214 @@
+#include "gtest/gtest.h"
+#include "../trees/adaptiveradixtree.h"
+#include <functional>
+#include <map>
+#include <random>
+
+template<typename T>
+std::string radixEncode(const T &key) {
+
+    std::string bytes;
+
+    RadixKey<T>::encode(key, bytes);
+
+    return bytes;
+}
+
+TEST(ARTTests, BinaryComparableKeys) {
+
+    std::vector<int> ints = {INT32_MIN, -70000, -256, -1, 0, 1, 255, 256, 70000, INT32_MAX};
+
+    for (size_t i = 1; i < ints.size(); i++) {
+        EXPECT_LT(radixEncode(ints[i - 1]), radixEncode(ints[i]));
+    }
+
+    EXPECT_LT(radixEncode((long) -1), radixEncode((long) 0));
+    EXPECT_LT(radixEncode((unsigned int) 1), radixEncode((unsigned int) 0x80000000));
+
+    std::vector<std::string> strings = {"", std::string(1, '\0'), std::string("\0\0", 2), std::string("\0a", 2),
+                                        "\x01", "a", std::string("a\0", 2), std::string("a\0b", 3), "a\x01", "ab",
+                                        "b", "\xff"};
+
+    for (size_t i = 1; i < strings.size(); i++) {
+        EXPECT_LT(strings[i - 1], strings[i]);
+        EXPECT_LT(radixEncode(strings[i - 1]), radixEncode(strings[i]));
+
+        //No key is a prefix of another one
+        EXPECT_NE(0, radixEncode(strings[i]).rfind(radixEncode(strings[i - 1]), 0));
+    }
+}
+
+/**
+ * Runs random operations on the tree and on a std::map, and checks they always agree
+ */
+template<typename T>
+void checkAgainstReference(const std::function<T(std::mt19937 &)> &randomKey, int operations) {
+
+    auto tree = std::make_unique<AdaptiveRadixTree<T, int>>();
+
+    std::map<T, int> reference;
+
+    std::mt19937 random(0xA27);
+
+    for (int i = 0; i < operations; i++) {
+
+        T key = randomKey(random);
+
+        int operation = (int) (random() % 10);
+
+        if (operation < 5) {
+            tree->add(std::make_shared<T>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        } else if (operation < 7) {
+            auto removed = tree->remove(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), removed.has_value());
+
+            if (removed) {
+                EXPECT_EQ(expected->second, **removed);
+
+                reference.erase(expected);
+            }
+        } else if (operation < 9) {
+            auto value = tree->get(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), value.has_value());
+
+            if (value) {
+                EXPECT_EQ(expected->second, **value);
+            }
+        } else {
+            T other = randomKey(random);
+
+            const T &base = std::min(key, other), &max = std::max(key, other);
+
+            auto range = tree->rangeSearch(base, max);
+
+            auto expected = reference.lower_bound(base);
+
+            for (auto &entry : *range) {
+                ASSERT_TRUE(expected != reference.end());
+                ASSERT_EQ(expected->first, *std::get<0>(entry));
+                ASSERT_EQ(expected->second, *std::get<1>(entry));
+
+                expected++;
+            }
+
+            EXPECT_TRUE(expected == reference.end() || max < expected->first);
+        }
+
+        ASSERT_EQ(reference.size(), tree->size());
+    }
+
+    auto entries = tree->entries();
+
+    ASSERT_EQ(reference.size(), entries->size());
+
+    auto expected = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(expected->first, *std::get<0>(entry));
+
+        expected++;
+    }
+
+    //Draining from both ends takes every kind of node back down to nothing
+    while (!reference.empty()) {
+        ASSERT_EQ(reference.begin()->first, *std::get<0>(*tree->popSmallest()));
+
+        reference.erase(reference.begin());
+
+        if (reference.empty()) break;
+
+        ASSERT_EQ(reference.rbegin()->first, *std::get<0>(*tree->popLargest()));
+
+        reference.erase(std::prev(reference.end()));
+    }
+
+    EXPECT_EQ(0, tree->size());
+    EXPECT_FALSE(tree->peekSmallest().has_value());
+    EXPECT_FALSE(tree->popLargest().has_value());
+}
+
+TEST(ARTTests, IntegerKeys) {
+
+    //Dense keys fill nodes up to 256 children, the negative ones share long prefixes of 0x7F bytes
+    checkAgainstReference<int>([](std::mt19937 &random) {
+        return (int) (random() % 3000) - 1500;
+    }, 100000);
+
+    //Sparse keys leave most nodes small
+    checkAgainstReference<long>([](std::mt19937 &random) {
+        return (long) (random() % 2 == 0 ? random() : -(long) random()) * 977;
+    }, 50000);
+}
+
+TEST(ARTTests, StringKeys) {
+
+    //Keys with prefixes longer than what fits in a node, a few zero bytes and different lengths
+    const std::vector<std::string> prefixes = {"", "user:", "user:profile:settings:", "user:profile:settings:theme",
+                                               std::string("bin\0ary", 7)};
+
+    checkAgainstReference<std::string>([&prefixes](std::mt19937 &random) {
+
+        std::string key = prefixes[random() % prefixes.size()];
+
+        int length = (int) (random() % 4);
+
+        for (int i = 0; i < length; i++) {
+            key.push_back("ab\0\xff"[random() % 4]);
+        }
+
+        return key;
+    }, 100000);
+}
+
+TEST(ARTTests, NodeGrowthAndPrefixSplits) {
+
+    auto tree = std::make_unique<AdaptiveRadixTree<std::string, int>>();
+
+    //A long shared prefix, then every possible byte, so the node below the prefix goes through every size
+    const std::string prefix = "a very long shared prefix/";
+
+    for (int i = 255; i >= 0; i--) {
+        tree->add(std::make_shared<std::string>(prefix + (char) i), std::make_shared<int>(i));
+    }
+
+    EXPECT_EQ(256, tree->size());
+
+    //Splits the compressed path past the bytes stored in the node
+    tree->add(std::make_shared<std::string>("a very long shared suffix"), std::make_shared<int>(-1));
+    tree->add(std::make_shared<std::string>("a very"), std::make_shared<int>(-2));
+
+    for (int i = 0; i < 256; i++) {
+        ASSERT_EQ(i, **tree->get(prefix + (char) i));
+    }
+
+    EXPECT_EQ(-1, **tree->get("a very long shared suffix"));
+    EXPECT_EQ(-2, **tree->get("a very"));
+    EXPECT_FALSE(tree->hasKey("a very long shared prefix"));
+    EXPECT_FALSE(tree->hasKey("a very long shared prefiy/"));
+
+    auto range = tree->rangeSearch(prefix + (char) 10, prefix + (char) 19);
+
+    ASSERT_EQ(10, range->size());
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(10 + i, *std::get<1>((*range)[i]));
+    }
+
+    //Shrinking back merges the paths again
+    for (int i = 0; i < 256; i++) {
+        ASSERT_TRUE(tree->remove(prefix + (char) i).has_value());
+    }
+
+    EXPECT_EQ(2, tree->size());
+    EXPECT_EQ("a very", *std::get<0>(*tree->peekSmallest()));
+    EXPECT_EQ("a very long shared suffix", *std::get<0>(*tree->peekLargest()));
+    EXPECT_EQ(-1, **tree->get("a very long shared suffix"));
+}
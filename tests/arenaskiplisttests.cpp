@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "../probabilisticlist/arenaskiplist.h"
+#include <map>
+#include <string>
+#include <thread>
+
+TEST(ArenaSkipListTests, MatchesReference) {
+
+    auto list = std::make_unique<ArenaSkipList<int, int>>();
+
+    //Keys that were removed keep their tombstone, with no value
+    std::map<int, std::optional<int>> reference;
+
+    srand(0xA7E4A);
+
+    for (int i = 0; i < 50000; i++) {
+
+        int key = rand() % 5000;
+
+        if (rand() % 4 == 0) {
+            list->remove(key);
+
+            reference[key] = std::nullopt;
+        } else {
+            list->add(key, i);
+
+            reference[key] = i;
+        }
+    }
+
+    unsigned int present = 0;
+
+    for (auto &[key, value] : reference) {
+        const int *found = nullptr;
+
+        MemtableLookup result = list->lookup(key, found);
+
+        if (value) {
+            ASSERT_EQ(result, MemtableLookup::FOUND);
+            ASSERT_EQ(*found, *value);
+
+            present++;
+        } else {
+            ASSERT_EQ(result, MemtableLookup::DELETED);
+        }
+    }
+
+    ASSERT_EQ(list->size(), present);
+
+    const int *found = nullptr;
+
+    ASSERT_EQ(list->lookup(-1, found), MemtableLookup::NOT_FOUND);
+
+    //The iterator goes through every key, including the tombstones
+    auto iterator = list->iterator();
+
+    for (auto &[key, value] : reference) {
+        ASSERT_TRUE(iterator.valid());
+        ASSERT_EQ(iterator.key(), key);
+        ASSERT_EQ(iterator.value() != nullptr, value.has_value());
+
+        iterator.next();
+    }
+
+    ASSERT_FALSE(iterator.valid());
+
+    iterator.seek(2500);
+
+    ASSERT_EQ(iterator.key(), reference.lower_bound(2500)->first);
+}
+
+TEST(ArenaSkipListTests, NonTrivialTypes) {
+
+    auto list = std::make_unique<ArenaSkipList<std::string, std::string>>();
+
+    for (int i = 0; i < 1000; i++) {
+        //Long enough to not fit in the small string buffer
+        list->add("key number " + std::to_string(i) + " with a long suffix", std::string(100, 'a' + i % 26));
+    }
+
+    for (int i = 0; i < 1000; i += 2) {
+        list->add("key number " + std::to_string(i) + " with a long suffix", "replaced");
+    }
+
+    for (int i = 0; i < 1000; i += 3) {
+        list->remove("key number " + std::to_string(i) + " with a long suffix");
+    }
+
+    ASSERT_EQ(list->size(), 1000u - 334);
+
+    const std::string *value = nullptr;
+
+    ASSERT_EQ(list->lookup("key number 2 with a long suffix", value), MemtableLookup::FOUND);
+    ASSERT_EQ(*value, "replaced");
+
+    ASSERT_EQ(list->lookup("key number 3 with a long suffix", value), MemtableLookup::DELETED);
+
+    ASSERT_GT(list->approximateMemoryUsage(), 1000u * 100);
+}
+
+TEST(ArenaSkipListTests, ReadersDuringWrites) {
+
+    auto list = std::make_unique<ArenaSkipList<int, int>>();
+
+    std::atomic_int written(0);
+
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&list, &written]() {
+            while (written.load() < 100000) {
+                int limit = written.load();
+
+                //Every key that was written before we started looking has to be there
+                for (int key = 0; key < limit; key += 97) {
+                    ASSERT_TRUE(list->hasKey(key));
+                }
+
+                int last = -1;
+
+                for (auto iterator = list->iterator(); iterator.valid(); iterator.next()) {
+                    ASSERT_GT(iterator.key(), last);
+
+                    last = iterator.key();
+                }
+            }
+        });
+    }
+
+    for (int key = 0; key < 100000; key++) {
+        list->add(key, key);
+
+        written.store(key + 1);
+    }
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    ASSERT_EQ(list->size(), 100000u);
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "../trees/avltree.h"
+#include <set>
 
 /**
  * Tests all the possible rotations,
@@ -127,4 +128,79 @@ TEST(AVLTest, TestRemove) {
     ASSERT_EQ(*(root->getRightChild()->getKeyVal()), 5);
     ASSERT_EQ(*(root->getLeftChild()->getKeyVal()), 2);
     ASSERT_EQ(*(root->getLeftChild()->getRightChild()->getKeyVal()), 3);
-}
\ No newline at end of file
+}
+int avlHeight(TreeNode<int, int> *node) {
+
+    if (node == nullptr) return 0;
+
+    int left = avlHeight(node->getLeftChild()), right = avlHeight(node->getRightChild());
+
+    if (left < 0 || right < 0 || std::abs(left - right) > 1) return -1;
+
+    return 1 + std::max(left, right);
+}
+
+TEST(AVLTest, TestAddWithHint) {
+
+    std::unique_ptr<AvlTree<int, int>> map = std::make_unique<AvlTree<int, int>>();
+
+    std::set<int> reference;
+
+    TreeNode<int, int> *hint = nullptr;
+
+    srand(0x3A1F);
+
+    //Timestamps with a little jitter, and now and then one from the past
+    for (int i = 0; i < 5000; i++) {
+
+        int key = i % 50 == 0 ? rand() % (i * 4 + 1) : i * 4 + rand() % 16;
+
+        hint = map->addWithHint(hint, std::make_shared<int>(key), std::make_shared<int>(i));
+
+        ASSERT_EQ(*hint->getKeyVal(), key);
+
+        reference.insert(key);
+    }
+
+    ASSERT_EQ(map->size(), reference.size());
+
+    ASSERT_GT(avlHeight(map->getRoot()), 0);
+
+    auto keys = map->keys();
+
+    ASSERT_TRUE(std::equal(keys->begin(), keys->end(), reference.begin(),
+                           [](const std::shared_ptr<int> &key, int expected) { return *key == expected; }));
+}
+
+TEST(AVLTest, TestAddBatch) {
+
+    std::unique_ptr<AvlTree<int, int>> map = std::make_unique<AvlTree<int, int>>();
+
+    std::set<int> reference;
+
+    srand(0x4D12);
+
+    for (int round = 0; round < 10; round++) {
+
+        std::vector<node_info<int, int>> batch;
+
+        for (int i = 0; i < 1000; i++) {
+            int key = rand() % 20000;
+
+            batch.emplace_back(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference.insert(key);
+        }
+
+        map->addBatch(std::move(batch));
+
+        ASSERT_GT(avlHeight(map->getRoot()), 0);
+    }
+
+    ASSERT_EQ(map->size(), reference.size());
+
+    auto keys = map->keys();
+
+    ASSERT_TRUE(std::equal(keys->begin(), keys->end(), reference.begin(),
+                           [](const std::shared_ptr<int> &key, int expected) { return *key == expected; }));
+}
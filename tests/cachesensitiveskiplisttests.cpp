@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+#include "../probabilisticlist/cachesensitiveskiplist.h"
+#include <map>
+#include <random>
+
+TEST(CSSLTests, LaneCountLess) {
+
+    std::vector<int> keys;
+
+    for (int i = 0; i < 37; i++) {
+        keys.push_back(i * 3 - 50);
+    }
+
+    std::vector<long> longKeys(keys.begin(), keys.end());
+
+    for (int key = -60; key < 70; key++) {
+        size_t expected = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+
+        //The SIMD version for int and the generic one for long have to agree, for every block size
+        EXPECT_EQ(expected, laneCountLess(keys.data(), keys.size(), key));
+        EXPECT_EQ(expected, laneCountLess(longKeys.data(), longKeys.size(), (long) key));
+        EXPECT_EQ(std::min(expected, (size_t) 5), laneCountLess(keys.data(), 5, key));
+    }
+}
+
+TEST(CSSLTests, MatchesReference) {
+
+    auto list = std::make_unique<CacheSensitiveSkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(42);
+
+    for (int i = 0; i < 200000; i++) {
+        int key = (int) (random() % 5000), operation = (int) (random() % 10);
+
+        if (operation < 4) {
+            list->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        } else if (operation < 6) {
+            auto removed = list->remove(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), removed.has_value());
+
+            if (removed) {
+                EXPECT_EQ(expected->second, **removed);
+
+                reference.erase(expected);
+            }
+        } else if (operation < 8) {
+            auto value = list->get(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), value.has_value());
+
+            if (value) {
+                EXPECT_EQ(expected->second, **value);
+            }
+        } else if (operation == 8) {
+            auto popped = random() % 2 == 0 ? list->popSmallest() : list->popLargest();
+
+            if (reference.empty()) {
+                ASSERT_FALSE(popped.has_value());
+
+                continue;
+            }
+
+            ASSERT_TRUE(popped.has_value());
+
+            int poppedKey = *std::get<0>(*popped);
+
+            ASSERT_TRUE(poppedKey == reference.begin()->first || poppedKey == reference.rbegin()->first);
+
+            reference.erase(poppedKey);
+        } else {
+            int max = key + (int) (random() % 100);
+
+            auto range = list->rangeSearch(key, max);
+
+            auto expected = reference.lower_bound(key);
+
+            for (auto &entry : *range) {
+                ASSERT_EQ(expected->first, *std::get<0>(entry));
+
+                expected++;
+            }
+
+            EXPECT_TRUE(expected == reference.end() || expected->first > max);
+        }
+
+        ASSERT_EQ(reference.size(), list->size());
+    }
+
+    EXPECT_GT(list->laneCount(), 0);
+}
+
+TEST(CSSLTests, AscendingLoadAndDrain) {
+
+    auto list = std::make_unique<CacheSensitiveSkipList<int, int>>();
+
+    const int keyCount = 100000;
+
+    for (int i = 0; i < keyCount; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    //The lanes are only built once the lookups need them
+    EXPECT_EQ(0, list->laneCount());
+
+    for (int i = 0; i < keyCount; i++) {
+        ASSERT_TRUE(list->hasKey(i));
+    }
+
+    EXPECT_GE(list->laneCount(), 3);
+
+    //Every node the lanes point to gets removed, so the lanes keep having to be patched
+    for (int i = 0; i < keyCount / 2; i++) {
+        EXPECT_EQ(i, *std::get<0>(*list->popSmallest()));
+        EXPECT_EQ(keyCount - 1 - i, *std::get<0>(*list->popLargest()));
+
+        if (i % 1000 == 0) {
+            EXPECT_FALSE(list->hasKey(i));
+            EXPECT_TRUE(list->hasKey(keyCount / 2));
+        }
+    }
+
+    EXPECT_EQ(0, list->size());
+    EXPECT_FALSE(list->peekSmallest().has_value());
+    EXPECT_FALSE(list->hasKey(keyCount / 2));
+}
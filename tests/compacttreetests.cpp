@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include "../trees/compacttree.h"
+#include <map>
+
+static_assert(sizeof(CompactNode<int, int>) <= 20, "Compact int nodes should fit in 20 bytes");
+
+/**
+ * Returns the black height of the sub tree, or -1 if any of the red black properties is broken
+ */
+int verifyRedBlack(CompactRedBlackTree<int, int> *tree, uint32_t index) {
+
+    if (index == COMPACT_NIL) return 1;
+
+    const CompactNode<int, int> &node = tree->getNode(index);
+
+    if (node.isRed() && (tree->getNode(node.getLeft()).isRed() || tree->getNode(node.getRight()).isRed())) {
+        return -1;
+    }
+
+    if (node.getLeft() != COMPACT_NIL && (tree->getNode(node.getLeft()).getParent() != index ||
+                                          tree->getNode(node.getLeft()).getKey() >= node.getKey())) {
+        return -1;
+    }
+
+    if (node.getRight() != COMPACT_NIL && (tree->getNode(node.getRight()).getParent() != index ||
+                                           tree->getNode(node.getRight()).getKey() <= node.getKey())) {
+        return -1;
+    }
+
+    int left = verifyRedBlack(tree, node.getLeft()), right = verifyRedBlack(tree, node.getRight());
+
+    if (left == -1 || left != right) return -1;
+
+    return left + (node.isRed() ? 0 : 1);
+}
+
+TEST(CompactTreeTests, MatchesReference) {
+
+    auto tree = std::make_unique<CompactRedBlackTree<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x1234);
+
+    for (int i = 0; i < 20000; i++) {
+
+        int key = rand() % 5000;
+
+        if (rand() % 3 == 0) {
+            auto removed = tree->remove(key);
+
+            ASSERT_EQ((bool) removed, reference.erase(key) == 1);
+        } else {
+            tree->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        }
+    }
+
+    ASSERT_EQ(tree->size(), reference.size());
+    ASSERT_GT(verifyRedBlack(tree.get(), tree->getRoot()), 0);
+
+    auto entries = tree->entries();
+
+    auto it = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(*std::get<0>(entry), it->first);
+        ASSERT_EQ(*std::get<1>(entry), it->second);
+
+        it++;
+    }
+
+    ASSERT_EQ(*std::get<0>(*tree->peekSmallest()), reference.begin()->first);
+    ASSERT_EQ(*std::get<0>(*tree->peekLargest()), reference.rbegin()->first);
+
+    auto range = tree->rangeSearch(1000, 2000);
+
+    ASSERT_EQ(range->size(), std::distance(reference.lower_bound(1000), reference.upper_bound(2000)));
+}
+
+TEST(CompactTreeTests, PopReusesSlots) {
+
+    auto tree = std::make_unique<CompactRedBlackTree<int, int>>();
+
+    auto value = std::make_shared<int>(42);
+
+    for (int i = 0; i < 1000; i++) {
+        tree->add(std::make_shared<int>(i), value);
+    }
+
+    for (int i = 0; i < 500; i++) {
+        ASSERT_EQ(*std::get<0>(*tree->popSmallest()), i);
+        ASSERT_EQ(*std::get<0>(*tree->popLargest()), 999 - i);
+
+        ASSERT_GT(verifyRedBlack(tree.get(), tree->getRoot()), 0);
+    }
+
+    ASSERT_EQ(tree->size(), 0);
+    ASSERT_FALSE(tree->popSmallest());
+
+    size_t poolSize = tree->getPoolSize();
+
+    ASSERT_EQ(poolSize, 1000u);
+
+    for (int i = 0; i < 1000; i++) {
+        tree->add(std::make_shared<int>(i), value);
+    }
+
+    ASSERT_EQ(tree->size(), 1000);
+
+    //Every node went into a slot the pops freed
+    ASSERT_EQ(tree->getPoolSize(), poolSize);
+    ASSERT_GT(verifyRedBlack(tree.get(), tree->getRoot()), 0);
+}
@@ -0,0 +1,208 @@
+#include "gtest/gtest.h"
+#include "../trees/concurrentavltree.h"
+#include <map>
+#include <thread>
+
+#define AVL_THREAD_COUNT 4
+#define AVL_KEYS_PER_THREAD 20000
+
+/**
+ * Returns the height of the sub tree, or -1 if the order, the parent pointers or the stored heights are broken
+ */
+int verifyTree(ConcurrentAVLNode<int, int> *node, const int *low, const int *high) {
+
+    if (node == nullptr) return 0;
+
+    int key = *node->getKeyVal();
+
+    if ((low != nullptr && key <= *low) || (high != nullptr && key >= *high)) return -1;
+
+    for (auto *child : {node->getLeftChild(), node->getRightChild()}) {
+        if (child != nullptr && child->getParent() != node) return -1;
+    }
+
+    int left = verifyTree(node->getLeftChild(), low, &key), right = verifyTree(node->getRightChild(), &key, high);
+
+    if (left == -1 || right == -1) return -1;
+
+    int height = 1 + std::max(left, right);
+
+    if (height != node->getHeight()) return -1;
+
+    return height;
+}
+
+TEST(ConcurrentAvlTests, MatchesReference) {
+
+    auto tree = std::make_unique<ConcurrentAvlTree<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x4321);
+
+    for (int i = 0; i < 50000; i++) {
+
+        int key = rand() % 5000, operation = rand() % 8;
+
+        if (operation < 3) {
+            auto removed = tree->remove(key);
+
+            ASSERT_EQ((bool) removed, reference.erase(key) == 1);
+        } else if (operation == 3 && !reference.empty()) {
+            auto popped = tree->popSmallest();
+
+            ASSERT_EQ(*std::get<0>(*popped), reference.begin()->first);
+            ASSERT_EQ(*std::get<1>(*popped), reference.begin()->second);
+
+            reference.erase(reference.begin());
+        } else {
+            tree->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        }
+    }
+
+    ASSERT_EQ(tree->size(), reference.size());
+
+    auto entries = tree->entries();
+
+    ASSERT_EQ(entries->size(), reference.size());
+
+    auto iterator = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(*std::get<0>(entry), iterator->first);
+        ASSERT_EQ(*std::get<1>(entry), iterator->second);
+
+        iterator++;
+    }
+
+    ASSERT_EQ(*std::get<0>(*tree->peekLargest()), reference.rbegin()->first);
+
+    auto range = tree->rangeSearch(1000, 2000);
+
+    ASSERT_EQ(range->size(), (size_t) std::distance(reference.lower_bound(1000), reference.upper_bound(2000)));
+
+    ASSERT_NE(verifyTree(tree->getRootNode(), nullptr, nullptr), -1);
+}
+
+TEST(ConcurrentAvlTests, StaysBalanced) {
+
+    auto tree = std::make_unique<ConcurrentAvlTree<int, int>>();
+
+    //Sorted inserts would make an unbalanced tree a list
+    for (int i = 0; i < 100000; i++) {
+        tree->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    int height = verifyTree(tree->getRootNode(), nullptr, nullptr);
+
+    ASSERT_NE(height, -1);
+
+    //An AVL tree is at most 1.44 log2(n) high
+    ASSERT_LE(height, 25);
+}
+
+TEST(ConcurrentAvlTests, ConcurrentInsertAndRemove) {
+
+    auto tree = std::make_unique<ConcurrentAvlTree<int, int>>();
+
+    std::vector<std::thread> threads;
+
+    std::atomic_bool running(true);
+
+    //Readers that keep searching while the tree is changed under them
+    std::thread reader([&tree, &running]() {
+        while (running.load()) {
+            for (int i = 0; i < AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD; i += 31) {
+                auto value = tree->get(i);
+
+                if (value) {
+                    ASSERT_EQ(**value, i);
+                }
+            }
+
+            auto range = tree->rangeSearch(0, AVL_KEYS_PER_THREAD);
+
+            for (size_t i = 1; i < range->size(); i++) {
+                ASSERT_LT(*std::get<0>((*range)[i - 1]), *std::get<0>((*range)[i]));
+            }
+        }
+    });
+
+    for (int t = 0; t < AVL_THREAD_COUNT; t++) {
+        threads.emplace_back([&tree, t]() {
+
+            //Interleave the keys of the threads so they fight over the same part of the tree
+            for (int i = t; i < AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD; i += AVL_THREAD_COUNT) {
+                tree->add(std::make_shared<int>(i), std::make_shared<int>(i));
+            }
+
+            for (int i = t; i < AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD; i += AVL_THREAD_COUNT) {
+                ASSERT_TRUE(tree->hasKey(i));
+            }
+
+            for (int i = t; i < AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD; i += 2 * AVL_THREAD_COUNT) {
+                ASSERT_TRUE(tree->remove(i));
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    running.store(false);
+
+    reader.join();
+
+    ASSERT_EQ(tree->size(), (unsigned int) (AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD / 2));
+
+    auto keys = tree->keys();
+
+    ASSERT_EQ(keys->size(), tree->size());
+
+    for (size_t i = 0; i < keys->size(); i++) {
+        ASSERT_EQ(*(*keys)[i] % (2 * AVL_THREAD_COUNT), (int) (i % AVL_THREAD_COUNT) + AVL_THREAD_COUNT);
+    }
+
+    ASSERT_NE(verifyTree(tree->getRootNode(), nullptr, nullptr), -1);
+}
+
+TEST(ConcurrentAvlTests, ConcurrentPop) {
+
+    auto tree = std::make_unique<ConcurrentAvlTree<int, int>>();
+
+    for (int i = 0; i < AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD; i++) {
+        tree->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    std::vector<std::thread> threads;
+
+    std::atomic_int popped(0);
+
+    for (int t = 0; t < AVL_THREAD_COUNT; t++) {
+        threads.emplace_back([&tree, &popped]() {
+            int last = -1;
+
+            while (true) {
+                auto result = tree->popSmallest();
+
+                if (!result) break;
+
+                ASSERT_GT(*std::get<0>(*result), last);
+
+                last = *std::get<0>(*result);
+
+                popped++;
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(popped.load(), AVL_THREAD_COUNT * AVL_KEYS_PER_THREAD);
+    ASSERT_EQ(tree->size(), 0u);
+}
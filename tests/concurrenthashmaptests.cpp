@@ -0,0 +1,198 @@
+#include "gtest/gtest.h"
+#include "../hashtables/concurrenthashmap.h"
+#include <random>
+#include <unordered_map>
+
+TEST(ConcurrentHashMapTests, MatchesReference) {
+
+    //A couple of shards, so they go through many resizes while other writes are moving their entries
+    auto map = std::make_unique<ConcurrentHashMap<int, int>>(2);
+
+    std::unordered_map<int, int> reference;
+
+    std::mt19937 random(0xC0C);
+
+    for (int i = 0; i < 300000; i++) {
+
+        //The range of the keys grows and shrinks, so the shards grow and get full of removed entries
+        int key = (int) (random() % (1000 + (i % 100000) / 4));
+
+        int operation = (int) (random() % 4);
+
+        if (operation == 0) {
+            map->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        } else if (operation == 1) {
+            auto removed = map->remove(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), removed.has_value());
+
+            if (removed) {
+                EXPECT_EQ(expected->second, **removed);
+
+                reference.erase(expected);
+            }
+        } else {
+            auto value = map->get(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), value.has_value());
+
+            if (value) {
+                EXPECT_EQ(expected->second, **value);
+            }
+        }
+
+        ASSERT_EQ(reference.size(), map->size());
+    }
+
+    auto entries = map->entries();
+
+    ASSERT_EQ(reference.size(), entries->size());
+
+    for (auto &entry : *entries) {
+        EXPECT_EQ(reference[*std::get<0>(entry)], *std::get<1>(entry));
+    }
+
+    //Keys that are there keep their value
+    ASSERT_FALSE(reference.empty());
+
+    int existing = reference.begin()->first;
+
+    EXPECT_FALSE(map->addIfAbsent(std::make_shared<int>(existing), std::make_shared<int>(-1)));
+    EXPECT_EQ(reference[existing], **map->get(existing));
+
+    EXPECT_TRUE(map->addIfAbsent(std::make_shared<int>(-1), std::make_shared<int>(-1)));
+    EXPECT_EQ(-1, **map->get(-1));
+}
+
+TEST(ConcurrentHashMapTests, SetOperations) {
+
+    auto set = std::make_unique<ConcurrentHashSet<std::string>>();
+
+    for (int i = 0; i < 10000; i++) {
+        set->add("key " + std::to_string(i));
+    }
+
+    //Adding a key twice keeps the first copy
+    auto first = set->find("key 1");
+
+    set->add("key 1");
+
+    EXPECT_EQ(first, set->find("key 1"));
+    EXPECT_EQ(10000, set->size());
+
+    for (int i = 0; i < 10000; i += 2) {
+        ASSERT_EQ("key " + std::to_string(i), *set->remove("key " + std::to_string(i)));
+    }
+
+    for (int i = 0; i < 10000; i++) {
+        ASSERT_EQ(i % 2 == 1, set->contains("key " + std::to_string(i)));
+    }
+
+    EXPECT_EQ(nullptr, set->remove("key 0"));
+    EXPECT_EQ(nullptr, set->find("key"));
+    EXPECT_EQ(5000, set->size());
+}
+
+TEST(ConcurrentHashMapTests, ConcurrentStress) {
+
+    //Meant to be run under ThreadSanitizer as well, the readers run while the shards are resized
+    const int keyCount = 20000, threadCount = 4, operations = 50000;
+
+    auto map = std::make_unique<ConcurrentHashMap<int, int>>(8);
+
+    std::atomic_bool running(true);
+
+    std::vector<std::thread> writers, readers;
+
+    for (int t = 0; t < threadCount; t++) {
+        writers.emplace_back([&map, t]() {
+
+            unsigned int seed = t * 7919 + 1;
+
+            for (int i = 0; i < operations; i++) {
+                seed = seed * 1103515245 + 12345;
+
+                int key = (seed >> 8) % keyCount;
+
+                if ((seed >> 4) % 4 == 0) {
+                    map->remove(key);
+                } else {
+                    //Every value says which key it belongs to, so readers can tell a torn read
+                    map->add(std::make_shared<int>(key), std::make_shared<int>(key * threadCount + t));
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&map, &running, t]() {
+            do {
+                for (int key = t; key < keyCount; key += 13) {
+                    auto value = map->get(key);
+
+                    if (value) {
+                        ASSERT_EQ(key, **value / threadCount);
+                    }
+                }
+            } while (running.load());
+        });
+    }
+
+    for (auto &writer : writers) {
+        writer.join();
+    }
+
+    running.store(false);
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    auto entries = map->entries();
+
+    EXPECT_EQ(map->size(), entries->size());
+
+    for (auto &entry : *entries) {
+        EXPECT_EQ(*std::get<0>(entry), *std::get<1>(entry) / threadCount);
+        EXPECT_TRUE(map->hasKey(*std::get<0>(entry)));
+    }
+}
+
+TEST(ConcurrentHashMapTests, DisjointWriters) {
+
+    const int threadCount = 4, keysPerThread = 30000;
+
+    auto map = std::make_unique<ConcurrentHashMap<int, int>>();
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&map, t]() {
+            for (int i = t; i < keysPerThread * threadCount; i += threadCount) {
+                map->add(std::make_shared<int>(i), std::make_shared<int>(i));
+            }
+
+            for (int i = t; i < keysPerThread * threadCount; i += threadCount * 2) {
+                ASSERT_EQ(i, **map->remove(i));
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(keysPerThread * threadCount / 2, map->size());
+
+    for (int i = 0; i < keysPerThread * threadCount; i++) {
+        bool removed = (i % threadCount) == (i % (threadCount * 2));
+
+        ASSERT_EQ(!removed, map->hasKey(i));
+    }
+}
@@ -0,0 +1,135 @@
+#include "gtest/gtest.h"
+#include "../trees/avltree.h"
+#include "../trees/redblacktree.h"
+#include "../trees/splaytree.h"
+#include "../trees/concurrentmapadaptor.h"
+#include <thread>
+
+#define THREAD_COUNT 4
+#define KEYS_PER_THREAD 5000
+
+void concurrentInsertAndRemove(OrderedMap<int, int> *map) {
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([map, t]() {
+
+            auto value = std::make_shared<int>(t);
+
+            for (int i = t * KEYS_PER_THREAD; i < (t + 1) * KEYS_PER_THREAD; i++) {
+                map->add(std::make_shared<int>(i), value);
+            }
+
+            for (int i = t * KEYS_PER_THREAD; i < (t + 1) * KEYS_PER_THREAD; i++) {
+                ASSERT_TRUE(map->hasKey(i));
+            }
+
+            //Remove half of our keys
+            for (int i = t * KEYS_PER_THREAD; i < (t + 1) * KEYS_PER_THREAD; i += 2) {
+                ASSERT_TRUE(map->remove(i));
+            }
+        });
+    }
+
+    //Readers that keep looking at the map while it changes
+    std::atomic_bool running(true);
+
+    std::thread reader([map, &running]() {
+        while (running.load()) {
+            for (int i = 0; i < THREAD_COUNT * KEYS_PER_THREAD; i += 97) {
+                auto value = map->get(i);
+
+                if (value) {
+                    ASSERT_EQ(**value, i / KEYS_PER_THREAD);
+                }
+            }
+        }
+    });
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    running.store(false);
+
+    reader.join();
+
+    ASSERT_EQ(map->size(), (unsigned int) (THREAD_COUNT * KEYS_PER_THREAD / 2));
+
+    auto entries = map->entries();
+
+    for (size_t i = 0; i < entries->size(); i++) {
+        ASSERT_EQ(*std::get<0>((*entries)[i]), (int) i * 2 + 1);
+    }
+}
+
+TEST(ConcurrentAdaptorTests, OptimisticReads) {
+
+    auto map = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<AvlTree<int, int>>());
+
+    concurrentInsertAndRemove(map.get());
+
+    auto redBlack = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<RedBlackTree<int, int>>());
+
+    concurrentInsertAndRemove(redBlack.get());
+}
+
+TEST(ConcurrentAdaptorTests, FlatCombining) {
+
+    auto map = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<AvlTree<int, int>>(),
+                                                                FLAT_COMBINING);
+
+    concurrentInsertAndRemove(map.get());
+}
+
+TEST(ConcurrentAdaptorTests, ExclusiveReads) {
+
+    //Reads on the splay tree change its structure
+    auto map = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<SplayTree<int, int>>(),
+                                                                FLAT_COMBINING, true);
+
+    concurrentInsertAndRemove(map.get());
+}
+
+TEST(ConcurrentAdaptorTests, ConcurrentPop) {
+
+    auto map = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<RedBlackTree<int, int>>(),
+                                                                FLAT_COMBINING);
+
+    auto value = std::make_shared<int>(42);
+
+    for (int i = 0; i < THREAD_COUNT * KEYS_PER_THREAD; i++) {
+        map->add(std::make_shared<int>(i), value);
+    }
+
+    std::vector<std::thread> threads;
+
+    std::atomic_int popped(0);
+
+    for (int t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&map, &popped]() {
+            int last = -1;
+
+            while (true) {
+                auto result = map->popSmallest();
+
+                if (!result) break;
+
+                //Every thread sees the keys it pops in order
+                ASSERT_GT(*std::get<0>(*result), last);
+
+                last = *std::get<0>(*result);
+
+                popped++;
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    ASSERT_EQ(popped.load(), THREAD_COUNT * KEYS_PER_THREAD);
+    ASSERT_EQ(map->size(), 0u);
+}
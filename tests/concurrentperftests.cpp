@@ -0,0 +1,398 @@
+#include "../datastructures.h"
+#include "../trees/avltree.h"
+#include "../trees/concurrentmapadaptor.h"
+#include "../trees/concurrentavltree.h"
+#include "../probabilisticlist/concurrentskiplist.h"
+#include "../probabilisticlist/spraylist.h"
+#include "../probabilisticlist/mvccskiplist.h"
+#include "../heaps/multiqueue.h"
+#include "../hashtables/concurrenthashmap.h"
+#include "../storage/durablemap.h"
+#include "temporarydirectory.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#define CONCURRENT_TEST_SIZE 100000
+#define OPERATIONS_PER_THREAD 200000
+#define MAX_THREADS 8
+//Writers of the group commit test, enough of them waiting on the disk to fill the largest batch
+#define DURABLE_WRITERS 64
+#define DURABLE_WRITES_PER_THREAD 200
+
+/**
+ * The way the trees had to be used from multiple threads before, every operation behind the same mutex
+ */
+template<typename T, typename V>
+class GlobalLockMap {
+
+private:
+    std::unique_ptr<OrderedMap<T, V>> map;
+
+    std::mutex lock;
+
+public:
+    explicit GlobalLockMap(std::unique_ptr<OrderedMap<T, V>> map) : map(std::move(map)) {}
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+        std::lock_guard<std::mutex> guard(lock);
+
+        map->add(std::move(key), std::move(value));
+    }
+
+    bool hasKey(const T &key) {
+        std::lock_guard<std::mutex> guard(lock);
+
+        return map->hasKey(key);
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) {
+        std::lock_guard<std::mutex> guard(lock);
+
+        return map->remove(key);
+    }
+};
+
+/**
+ * Every thread does 90% lookups, 5% inserts and 5% removes on random keys
+ */
+template<typename Map>
+void readMostlyTest(Map *map, int threadCount) {
+
+    auto value = std::make_shared<int>(1);
+
+    for (int i = 0; i < CONCURRENT_TEST_SIZE; i += 2) {
+        map->add(std::make_shared<int>(i), value);
+    }
+
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([map, t, &value]() {
+
+            unsigned int seed = t * 7919 + 1;
+
+            for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+
+                seed = seed * 1103515245 + 12345;
+
+                int key = (seed >> 8) % CONCURRENT_TEST_SIZE, operation = (seed >> 4) % 20;
+
+                if (operation == 0) {
+                    map->add(std::make_shared<int>(key), value);
+                } else if (operation == 1) {
+                    map->remove(key);
+                } else {
+                    map->hasKey(key);
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << threadCount << " threads took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+TEST(ConcurrentPerfTest, READ_MOSTLY_SCALING) {
+
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+
+        std::cout << "Testing the DS: AVL Tree behind a global lock" << std::endl;
+
+        auto globalLock = std::make_unique<GlobalLockMap<int, int>>(std::make_unique<AvlTree<int, int>>());
+
+        readMostlyTest(globalLock.get(), threads);
+
+        std::cout << "Testing the DS: AVL Tree with optimistic reads" << std::endl;
+
+        auto adaptor = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<AvlTree<int, int>>());
+
+        readMostlyTest(adaptor.get(), threads);
+
+        std::cout << "Testing the DS: AVL Tree with optimistic reads and flat combining" << std::endl;
+
+        adaptor = std::make_unique<ConcurrentMapAdaptor<int, int>>(std::make_unique<AvlTree<int, int>>(),
+                                                                   FLAT_COMBINING);
+
+        readMostlyTest(adaptor.get(), threads);
+
+        std::cout << "Testing the DS: Concurrent AVL Tree" << std::endl;
+
+        auto concurrentTree = std::make_unique<ConcurrentAvlTree<int, int>>();
+
+        readMostlyTest(concurrentTree.get(), threads);
+
+        std::cout << "Testing the DS: Concurrent Skip List" << std::endl;
+
+        auto skipList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+        readMostlyTest(skipList.get(), threads);
+
+        std::cout << "Testing the DS: MVCC Skip List" << std::endl;
+
+        auto mvccList = std::make_unique<MVCCSkipList<int, int>>();
+
+        readMostlyTest(mvccList.get(), threads);
+
+        std::cout << "Testing the DS: Concurrent Hash Map" << std::endl;
+
+        auto hashMap = std::make_unique<ConcurrentHashMap<int, int>>();
+
+        readMostlyTest(hashMap.get(), threads);
+    }
+}
+
+/**
+ * Every thread inserts the same amount of keys, interleaved with the keys of the other threads
+ */
+template<typename Map>
+void insertScalingTest(Map *map, int threadCount) {
+
+    auto value = std::make_shared<int>(1);
+
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([map, &value, t, threadCount]() {
+            for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                map->add(std::make_shared<int>(i * threadCount + t), value);
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << threadCount << " threads took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+TEST(ConcurrentPerfTest, INSERT_SCALING) {
+
+    for (int threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+
+        std::cout << "Testing the DS: Concurrent Skip List" << std::endl;
+
+        auto skipList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+        insertScalingTest(skipList.get(), threadCount);
+
+        std::cout << "Testing the DS: Concurrent Hash Map" << std::endl;
+
+        auto hashMap = std::make_unique<ConcurrentHashMap<int, int>>();
+
+        insertScalingTest(hashMap.get(), threadCount);
+    }
+}
+
+/**
+ * Point lookups only, every thread looks up random keys of a map that is half full
+ */
+template<typename Map>
+void lookupScalingTest(Map *map, int threadCount) {
+
+    auto value = std::make_shared<int>(1);
+
+    for (int i = 0; i < CONCURRENT_TEST_SIZE; i += 2) {
+        map->add(std::make_shared<int>(i), value);
+    }
+
+    std::vector<std::thread> threads;
+
+    std::atomic_int found(0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([map, t, &found]() {
+
+            unsigned int seed = t * 7919 + 1;
+
+            int localFound = 0;
+
+            for (int i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                seed = seed * 1103515245 + 12345;
+
+                localFound += map->hasKey((seed >> 8) % CONCURRENT_TEST_SIZE);
+            }
+
+            found.fetch_add(localFound);
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << threadCount << " threads took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete. (" << found.load() << " found)" << std::endl;
+}
+
+TEST(ConcurrentPerfTest, POINT_LOOKUP_SCALING) {
+
+    for (int threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+
+        std::cout << "Testing the DS: Concurrent Skip List" << std::endl;
+
+        auto skipList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+        lookupScalingTest(skipList.get(), threadCount);
+
+        std::cout << "Testing the DS: Concurrent Hash Map" << std::endl;
+
+        auto hashMap = std::make_unique<ConcurrentHashMap<int, int>>();
+
+        lookupScalingTest(hashMap.get(), threadCount);
+    }
+}
+
+/**
+ * Fill the list and have every thread pop from it until it is empty
+ */
+template<typename Map>
+void popTest(Map *map, int threadCount) {
+
+    auto value = std::make_shared<int>(1);
+
+    for (int i = 0; i < CONCURRENT_TEST_SIZE; i++) {
+        map->add(std::make_shared<int>(i), value);
+    }
+
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([map]() {
+            while (map->popSmallest()) {}
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << threadCount << " threads took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+TEST(ConcurrentPerfTest, POP_SCALING) {
+
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+
+        std::cout << "Testing the DS: Concurrent Skip List" << std::endl;
+
+        auto skipList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+        popTest(skipList.get(), threads);
+
+        std::cout << "Testing the DS: Spray List" << std::endl;
+
+        auto sprayList = std::make_unique<SprayList<int, int>>(threads);
+
+        popTest(sprayList.get(), threads);
+    }
+}
+
+TEST(ConcurrentPerfTest, PRIORITY_QUEUE_SCALING) {
+
+    for (int threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+
+        std::cout << "Testing the DS: Multi Queue" << std::endl;
+
+        auto queue = std::make_unique<MultiQueue<int, int>>(threadCount);
+
+        auto value = std::make_shared<int>(1);
+
+        for (int i = 0; i < CONCURRENT_TEST_SIZE; i++) {
+            queue->push(i, value);
+        }
+
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int t = 0; t < threadCount; t++) {
+            threads.emplace_back([&queue]() {
+                while (queue->popSmallest()) {}
+            });
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::cout << threadCount << " threads took "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+    }
+}
+
+/**
+ * Every writer waits for its own write to be synced, so the writes per second only go up with the amount of writers
+ * that can share a sync
+ */
+TEST(ConcurrentPerfTest, DURABLE_GROUP_COMMIT) {
+
+    for (unsigned int maxBatch = 1; maxBatch <= DURABLE_WRITERS; maxBatch *= 4) {
+
+        std::cout << "Testing the DS: Durable Skip List, batches of up to " << maxBatch << " writes" << std::endl;
+
+        TemporaryDirectory directory;
+
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath(), maxBatch);
+
+        auto value = std::make_shared<int>(1);
+
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int t = 0; t < DURABLE_WRITERS; t++) {
+            threads.emplace_back([&map, &value, t]() {
+                for (int i = 0; i < DURABLE_WRITES_PER_THREAD; i++) {
+                    map.add(std::make_shared<int>(i * DURABLE_WRITERS + t), value);
+                }
+            });
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+        DurabilityStats stats = map.getStats();
+
+        std::cout << DURABLE_WRITERS << " threads took " << milliseconds << " ms to complete. ("
+                  << stats.records * 1000 / std::max((long long) milliseconds, 1LL) << " writes/s, "
+                  << (double) stats.records / (double) stats.commits << " writes per fsync)" << std::endl;
+    }
+}
@@ -0,0 +1,310 @@
+#include "gtest/gtest.h"
+#include "../storage/durablemap.h"
+#include "../probabilisticlist/skiplist.h"
+#include "../trees/avltree.h"
+#include "temporarydirectory.h"
+#include <fstream>
+#include <map>
+#include <random>
+#include <thread>
+
+template<typename T, typename V>
+void expectDurableEntries(const std::map<T, V> &reference, OrderedMap<T, V> *map) {
+
+    auto entries = map->entries();
+
+    ASSERT_EQ(reference.size(), entries->size());
+
+    auto expected = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(expected->first, *std::get<0>(entry));
+        ASSERT_EQ(expected->second, *std::get<1>(entry));
+
+        expected++;
+    }
+}
+
+static unsigned int countSegments(const std::string &directory) {
+
+    unsigned int segments = 0;
+
+    DIR *dir = ::opendir(directory.c_str());
+
+    while (struct dirent *entry = ::readdir(dir)) {
+        segments += std::string(entry->d_name).rfind("wal-", 0) == 0;
+    }
+
+    ::closedir(dir);
+
+    return segments;
+}
+
+TEST(DurableMapTests, RecoversFromSnapshotAndLog) {
+
+    TemporaryDirectory directory;
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(0xD0);
+
+    {
+        //Snapshots every few thousand writes, so the map comes back from a snapshot and the log after it
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath(), 16, 3000);
+
+        for (int i = 0; i < 10000; i++) {
+
+            int key = (int) (random() % 2000) - 1000;
+
+            if (random() % 3 != 0) {
+                map.add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+                reference[key] = i;
+            } else {
+                auto removed = map.remove(key);
+
+                ASSERT_EQ(reference.count(key) != 0, removed.has_value());
+
+                reference.erase(key);
+            }
+        }
+
+        EXPECT_EQ(3u, map.getStats().snapshots);
+        EXPECT_EQ(10000u, map.getStats().records);
+
+        //The segments from before the last snapshot are gone
+        EXPECT_EQ(1u, countSegments(directory.getPath()));
+    }
+
+    //Any map can be recovered into, not just the kind the writes went to
+    DurableMapAdaptor<int, int> reopened(std::make_unique<AvlTree<int, int>>(), directory.getPath());
+
+    DurabilityStats stats = reopened.getStats();
+
+    EXPECT_GT(stats.snapshotEntries, 0u);
+    EXPECT_EQ(1000u, stats.replayedRecords);
+
+    expectDurableEntries(reference, &reopened);
+}
+
+TEST(DurableMapTests, StringEntries) {
+
+    TemporaryDirectory directory;
+
+    std::map<std::string, std::string> reference;
+
+    {
+        DurableMapAdaptor<std::string, std::string> map(std::make_unique<SkipList<std::string, std::string>>(),
+                                                        directory.getPath());
+
+        for (int i = 0; i < 500; i++) {
+            std::string key = "user:" + std::to_string(i);
+
+            map.add(std::make_shared<std::string>(key), std::make_shared<std::string>(std::string(i % 50, 'v')));
+
+            reference[key] = std::string(i % 50, 'v');
+        }
+
+        map.snapshot();
+
+        map.add(std::make_shared<std::string>("user:7"), std::make_shared<std::string>("changed"));
+        map.remove("user:8");
+
+        reference["user:7"] = "changed";
+        reference.erase("user:8");
+    }
+
+    DurableMapAdaptor<std::string, std::string> reopened(std::make_unique<SkipList<std::string, std::string>>(),
+                                                         directory.getPath());
+
+    EXPECT_EQ(500u, reopened.getStats().snapshotEntries);
+    EXPECT_EQ(2u, reopened.getStats().replayedRecords);
+
+    expectDurableEntries(reference, &reopened);
+}
+
+TEST(DurableMapTests, SortedLoadIsOneCommit) {
+
+    TemporaryDirectory directory;
+
+    std::map<int, int> reference;
+
+    {
+        DurableMapAdaptor<int, int> map(std::make_unique<AvlTree<int, int>>(), directory.getPath());
+
+        std::vector<node_info<int, int>> sorted;
+
+        for (int i = 0; i < 5000; i++) {
+            sorted.emplace_back(std::make_shared<int>(i * 3), std::make_shared<int>(i));
+
+            reference[i * 3] = i;
+        }
+
+        map.addSorted(std::move(sorted));
+
+        EXPECT_EQ(5000u, map.getStats().records);
+        EXPECT_EQ(1u, map.getStats().commits);
+
+        expectDurableEntries(reference, &map);
+    }
+
+    DurableMapAdaptor<int, int> reopened(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+    expectDurableEntries(reference, &reopened);
+}
+
+TEST(DurableMapTests, CutsOffTornRecord) {
+
+    TemporaryDirectory directory;
+
+    std::string segment = directory.getPath() + "/wal-0.log";
+
+    {
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+        for (int i = 0; i < 100; i++) {
+            map.add(std::make_shared<int>(i), std::make_shared<int>(i));
+        }
+    }
+
+    //A crash in the middle of the last write leaves part of a record behind
+    struct stat status{};
+
+    ::stat(segment.c_str(), &status);
+
+    ASSERT_EQ(0, ::truncate(segment.c_str(), status.st_size - 3));
+
+    std::map<int, int> reference;
+
+    for (int i = 0; i < 99; i++) {
+        reference[i] = i;
+    }
+
+    {
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+        EXPECT_EQ(99u, map.getStats().replayedRecords);
+
+        expectDurableEntries(reference, &map);
+
+        //New writes go after the last whole record
+        map.add(std::make_shared<int>(1000), std::make_shared<int>(1000));
+
+        reference[1000] = 1000;
+    }
+
+    DurableMapAdaptor<int, int> reopened(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+    expectDurableEntries(reference, &reopened);
+}
+
+TEST(DurableMapTests, RejectsCorruptedSnapshot) {
+
+    TemporaryDirectory directory;
+
+    {
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+        for (int i = 0; i < 100; i++) {
+            map.add(std::make_shared<int>(i), std::make_shared<int>(i));
+        }
+
+        map.snapshot();
+    }
+
+    {
+        std::fstream file(directory.getPath() + "/snapshot", std::ios::in | std::ios::out | std::ios::binary);
+
+        file.seekp(40);
+
+        file.put((char) 0x5A);
+    }
+
+    typedef DurableMapAdaptor<int, int> IntMap;
+
+    EXPECT_THROW(IntMap map(std::make_unique<SkipList<int, int>>(), directory.getPath()), std::runtime_error);
+}
+
+TEST(DurableMapTests, PopsAreLogged) {
+
+    TemporaryDirectory directory;
+
+    {
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+        for (int i = 0; i < 10; i++) {
+            map.add(std::make_shared<int>(i), std::make_shared<int>(i * 10));
+        }
+
+        EXPECT_EQ(0, *std::get<0>(*map.popSmallest()));
+        EXPECT_EQ(90, *std::get<1>(*map.popLargest()));
+    }
+
+    DurableMapAdaptor<int, int> reopened(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+    std::map<int, int> reference;
+
+    for (int i = 1; i < 9; i++) {
+        reference[i] = i * 10;
+    }
+
+    expectDurableEntries(reference, &reopened);
+
+    for (int i = 0; i < 8; i++) {
+        reopened.popSmallest();
+    }
+
+    EXPECT_FALSE(reopened.popSmallest().has_value());
+}
+
+TEST(DurableMapTests, ConcurrentWritersShareSyncs) {
+
+    TemporaryDirectory directory;
+
+    const int threadCount = 8, perThread = 300;
+
+    {
+        DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+        std::vector<std::thread> threads;
+
+        for (int t = 0; t < threadCount; t++) {
+            threads.emplace_back([&map, t]() {
+                for (int i = 0; i < perThread; i++) {
+                    map.add(std::make_shared<int>(t * perThread + i), std::make_shared<int>(t));
+                }
+            });
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        DurabilityStats stats = map.getStats();
+
+        EXPECT_EQ((uint64_t) threadCount * perThread, stats.records);
+        EXPECT_LT(stats.commits, stats.records);
+    }
+
+    DurableMapAdaptor<int, int> reopened(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+    std::map<int, int> reference;
+
+    for (int t = 0; t < threadCount; t++) {
+        for (int i = 0; i < perThread; i++) {
+            reference[t * perThread + i] = t;
+        }
+    }
+
+    expectDurableEntries(reference, &reopened);
+}
+
+TEST(DurableMapTests, DirectorySyncFailuresThrow) {
+
+    TemporaryDirectory directory;
+
+    EXPECT_NO_THROW(fileio::syncDirectory(directory.getPath()));
+
+    //The snapshot only drops the old segments once the sync went through, so it can't fail quietly
+    EXPECT_THROW(fileio::syncDirectory(directory.getPath() + "/missing"), std::system_error);
+}
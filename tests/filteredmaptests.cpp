@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+#include "../filters/countingbloomfilter.h"
+#include "../trees/filteredmapadaptor.h"
+#include "../probabilisticlist/skiplist.h"
+#include <map>
+#include <random>
+
+TEST(FilteredMapTests, CountingFilterRemove) {
+
+    auto filter = CountingBloomFilter<int>::forExpectedSize(10000, 0.01);
+
+    for (int i = 0; i < 10000; i++) {
+        filter->add(i);
+    }
+
+    for (int i = 0; i < 10000; i += 2) {
+        filter->remove(i);
+    }
+
+    EXPECT_EQ(5000u, filter->size());
+
+    int falsePositives = 0;
+
+    for (int i = 0; i < 10000; i++) {
+        if (i % 2 == 1) {
+            //Removing other keys never hides the ones that are left
+            ASSERT_TRUE(filter->test(i));
+        } else {
+            falsePositives += filter->test(i);
+        }
+    }
+
+    //The removed keys are gone again, apart from the usual false positives
+    EXPECT_LT(falsePositives, 5000 * 0.03);
+}
+
+TEST(FilteredMapTests, MatchesReference) {
+
+    auto map = std::make_unique<FilteredMapAdaptor<int, int>>(std::make_unique<SkipList<int, int>>());
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(0xF11);
+
+    for (int i = 0; i < 200000; i++) {
+
+        //The range of the keys grows and shrinks, so the filter is rebuilt both ways
+        int key = (int) (random() % (100 + (i % 100000) / 2));
+
+        int operation = (int) (random() % 5);
+
+        if (operation == 0) {
+            map->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        } else if (operation == 1) {
+            auto removed = map->remove(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), removed.has_value());
+
+            if (removed) reference.erase(expected);
+        } else if (operation == 2 && !reference.empty()) {
+            auto popped = random() % 2 == 0 ? map->popSmallest() : map->popLargest();
+
+            ASSERT_TRUE(popped.has_value());
+
+            ASSERT_EQ(1, reference.erase(*std::get<0>(*popped)));
+        } else {
+            auto value = map->get(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), value.has_value());
+
+            if (value) {
+                EXPECT_EQ(expected->second, **value);
+            }
+        }
+
+        ASSERT_EQ(reference.size(), map->size());
+    }
+
+    for (int key = 0; key < 50100; key++) {
+        ASSERT_EQ(reference.count(key) == 1, map->hasKey(key));
+    }
+}
+
+TEST(FilteredMapTests, StatsAndGrowth) {
+
+    auto map = std::make_unique<FilteredMapAdaptor<int, int>>(std::make_unique<SkipList<int, int>>());
+
+    unsigned int initialCapacity = map->getFilterCapacity();
+
+    auto value = std::make_shared<int>(0);
+
+    for (int i = 0; i < 100000; i++) {
+        map->add(std::make_shared<int>(i), value);
+    }
+
+    //The filter grew with the map
+    EXPECT_GE(map->getFilterCapacity(), map->size());
+    EXPECT_GT(map->getFilterCapacity(), initialCapacity);
+    EXPECT_GT(map->getStats().rebuilds, 0u);
+
+    map->resetStats();
+
+    for (int i = 0; i < 200000; i++) {
+        map->hasKey(i);
+    }
+
+    FilterStats stats = map->getStats();
+
+    EXPECT_EQ(100000, stats.hits);
+    EXPECT_EQ(100000, stats.filtered + stats.falsePositives);
+
+    //The filter is sized for 1%, with some slack
+    EXPECT_LT(stats.falsePositiveRate(), 0.02);
+
+    //Shrinking the map shrinks the filter back
+    for (int i = 0; i < 99000; i++) {
+        map->popSmallest();
+    }
+
+    EXPECT_LT(map->getFilterCapacity(), 100000u);
+
+    for (int i = 99000; i < 100000; i++) {
+        ASSERT_TRUE(map->hasKey(i));
+    }
+}
@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include "../trees/avltree.h"
+#include "../trees/frozenmap.h"
+#include "../probabilisticlist/skiplist.h"
+
+TEST(FrozenMapTests, LookupAllSizes) {
+
+    //Every size from an empty map to a few complete trees and the ones in between
+    for (int size = 0; size <= 130; size++) {
+
+        auto map = std::make_unique<AvlTree<int, int>>();
+
+        for (int i = 0; i < size; i++) {
+            //Only even keys, so we can look for the odd ones that are in between
+            map->add(std::make_shared<int>(i * 2), std::make_shared<int>(i));
+        }
+
+        auto frozen = freeze<int, int>(map.get());
+
+        ASSERT_EQ(frozen->size(), size);
+
+        for (int i = -1; i <= size * 2; i++) {
+
+            if (i >= 0 && i % 2 == 0 && i < size * 2) {
+                ASSERT_TRUE(frozen->hasKey(i));
+                ASSERT_EQ(**frozen->get(i), i / 2);
+            } else {
+                ASSERT_FALSE(frozen->hasKey(i));
+                ASSERT_FALSE(frozen->get(i));
+            }
+        }
+    }
+}
+
+TEST(FrozenMapTests, RangeAndPeek) {
+
+    auto list = std::make_unique<SkipList<int, int>>();
+
+    auto value = std::make_shared<int>(42);
+
+    ASSERT_FALSE((freeze<int, int>(list.get())->peekSmallest()));
+
+    for (int i = 0; i < 1000; i++) {
+        list->add(std::make_shared<int>(i * 3), value);
+    }
+
+    auto frozen = freeze<int, int>(list.get());
+
+    ASSERT_EQ(*std::get<0>(*frozen->peekSmallest()), 0);
+    ASSERT_EQ(*std::get<0>(*frozen->peekLargest()), 2997);
+
+    auto range = frozen->rangeSearch(10, 100);
+
+    ASSERT_EQ(range->size(), 30);
+    ASSERT_EQ(*std::get<0>(range->front()), 12);
+    ASSERT_EQ(*std::get<0>(range->back()), 99);
+
+    ASSERT_TRUE(frozen->rangeSearch(3000, 4000)->empty());
+    ASSERT_EQ(frozen->rangeSearch(-100, 5000)->size(), 1000);
+}
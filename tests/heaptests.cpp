@@ -0,0 +1,187 @@
+#include "gtest/gtest.h"
+#include "../heaps/daryheap.h"
+#include "../heaps/pairingheap.h"
+#include "../heaps/multiqueue.h"
+#include <algorithm>
+#include <random>
+#include <set>
+
+#define HEAP_TEST_SIZE 10000
+#define HEAP_THREAD_COUNT 4
+
+/**
+ * Push random keys (With repeats) and check that they come out sorted
+ */
+void sortTest(PriorityQueue<int, int> *queue) {
+
+    std::mt19937 random(HEAP_TEST_SIZE);
+
+    std::vector<int> keys;
+
+    for (int i = 0; i < HEAP_TEST_SIZE; i++) {
+        keys.push_back(random() % (HEAP_TEST_SIZE / 2));
+
+        queue->push(keys.back(), std::make_shared<int>(keys.back() * 2));
+    }
+
+    EXPECT_EQ(HEAP_TEST_SIZE, queue->size());
+
+    std::sort(keys.begin(), keys.end());
+
+    for (int key : keys) {
+        EXPECT_EQ(key, queue->peekSmallest()->first);
+
+        auto entry = queue->popSmallest();
+
+        ASSERT_TRUE(entry.has_value());
+
+        EXPECT_EQ(key, entry->first);
+        EXPECT_EQ(key * 2, *entry->second);
+    }
+
+    EXPECT_EQ(0, queue->size());
+    EXPECT_FALSE(queue->popSmallest().has_value());
+    EXPECT_FALSE(queue->peekSmallest().has_value());
+}
+
+TEST(HeapTests, DaryHeapSorts) {
+
+    auto heap = std::make_unique<DaryHeap<int, int>>();
+
+    sortTest(heap.get());
+
+    auto binaryHeap = std::make_unique<DaryHeap<int, int, 2>>();
+
+    sortTest(binaryHeap.get());
+
+    auto wideHeap = std::make_unique<DaryHeap<int, int, 8>>(HEAP_TEST_SIZE);
+
+    sortTest(wideHeap.get());
+}
+
+TEST(HeapTests, PairingHeapSorts) {
+
+    auto heap = std::make_unique<PairingHeap<int, int>>();
+
+    sortTest(heap.get());
+}
+
+TEST(HeapTests, PairingHeapDecreaseKey) {
+
+    auto heap = std::make_unique<PairingHeap<int, int>>();
+
+    std::vector<PairingNode<int, int> *> handles;
+
+    for (int i = 0; i < HEAP_TEST_SIZE; i++) {
+        handles.push_back(heap->insert(HEAP_TEST_SIZE + i, std::make_shared<int>(i)));
+    }
+
+    //Pop a few first so the heap isn't just a root with a long list of children
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(i, *heap->popSmallest()->second);
+    }
+
+    //Reverse the order of the odd entries, all of them become smaller than the even ones
+    for (int i = 11; i < HEAP_TEST_SIZE; i += 2) {
+        EXPECT_TRUE(heap->decreaseKey(handles[i], -i));
+    }
+
+    EXPECT_FALSE(heap->decreaseKey(handles[10], HEAP_TEST_SIZE * 3));
+
+    int previous = INT32_MIN;
+
+    for (int i = 10; i < HEAP_TEST_SIZE; i++) {
+        auto entry = heap->popSmallest();
+
+        ASSERT_TRUE(entry.has_value());
+
+        EXPECT_LE(previous, entry->first);
+
+        //The odd values come first, from the largest to the smallest
+        if (i < 10 + (HEAP_TEST_SIZE - 10) / 2) {
+            EXPECT_EQ(1, *entry->second % 2);
+        }
+
+        previous = entry->first;
+    }
+
+    EXPECT_EQ(0, heap->size());
+}
+
+TEST(HeapTests, MultiQueuePopsEveryKey) {
+
+    auto queue = std::make_unique<MultiQueue<int, int>>(HEAP_THREAD_COUNT);
+
+    for (int i = 0; i < HEAP_TEST_SIZE; i++) {
+        queue->push(i, std::make_shared<int>(i));
+    }
+
+    EXPECT_EQ(0, queue->peekSmallest()->first);
+
+    std::set<int> popped;
+
+    long totalRank = 0;
+
+    for (int i = 0; i < HEAP_TEST_SIZE; i++) {
+        auto entry = queue->popSmallest();
+
+        ASSERT_TRUE(entry.has_value());
+
+        //How many keys smaller than the popped one weren't popped yet
+        totalRank += entry->first - std::distance(popped.begin(), popped.lower_bound(entry->first));
+
+        EXPECT_TRUE(popped.insert(entry->first).second);
+    }
+
+    EXPECT_FALSE(queue->popSmallest().has_value());
+
+    //The expected rank is linear in the amount of heaps, an exact queue would be 0
+    EXPECT_LT(totalRank / HEAP_TEST_SIZE, HEAP_THREAD_COUNT * MULTI_QUEUE_FACTOR * 4);
+}
+
+TEST(HeapTests, MultiQueueConcurrent) {
+
+    auto queue = std::make_unique<MultiQueue<int, int>>(HEAP_THREAD_COUNT);
+
+    std::vector<std::vector<int>> popped(HEAP_THREAD_COUNT);
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < HEAP_THREAD_COUNT; t++) {
+        threads.emplace_back([&queue, &popped, t]() {
+            for (int i = 0; i < HEAP_TEST_SIZE; i++) {
+                queue->push(i * HEAP_THREAD_COUNT + t, std::make_shared<int>(i));
+
+                if (i % 2 == 1) {
+                    auto entry = queue->popSmallest();
+
+                    if (entry) popped[t].push_back(entry->first);
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::set<int> allPopped;
+
+    size_t total = 0;
+
+    for (auto &keys : popped) {
+        total += keys.size();
+
+        allPopped.insert(keys.begin(), keys.end());
+    }
+
+    //No key was popped twice, and none got lost
+    EXPECT_EQ(total, allPopped.size());
+    EXPECT_EQ(HEAP_TEST_SIZE * HEAP_THREAD_COUNT, total + queue->size());
+
+    while (auto entry = queue->popSmallest()) {
+        EXPECT_TRUE(allPopped.insert(entry->first).second);
+    }
+
+    EXPECT_EQ(HEAP_TEST_SIZE * HEAP_THREAD_COUNT, allPopped.size());
+}
@@ -0,0 +1,188 @@
+#include "gtest/gtest.h"
+#include "../storage/lsmtree.h"
+#include "temporarydirectory.h"
+#include <map>
+#include <random>
+
+void expectSameEntries(const std::map<int, int> &reference, const std::vector<node_info<int, int>> &entries) {
+
+    ASSERT_EQ(reference.size(), entries.size());
+
+    auto expected = reference.begin();
+
+    for (auto &entry : entries) {
+        ASSERT_EQ(expected->first, *std::get<0>(entry));
+        ASSERT_EQ(expected->second, *std::get<1>(entry));
+
+        expected++;
+    }
+}
+
+TEST(LsmTreeTests, MatchesReference) {
+
+    TemporaryDirectory directory;
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(0x15A);
+
+    {
+        //A small memtable, so the keys go through many flushes and compactions
+        LsmTree<int, int> tree(directory.getPath(), 512);
+
+        for (int i = 0; i < 60000; i++) {
+
+            int key = (int) (random() % 20000);
+
+            int operation = (int) (random() % 4);
+
+            if (operation <= 1) {
+                tree.add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+                reference[key] = i;
+            } else if (operation == 2) {
+                tree.remove(key);
+
+                reference.erase(key);
+            } else {
+                auto value = tree.get(key);
+
+                auto expected = reference.find(key);
+
+                ASSERT_EQ(expected != reference.end(), value.has_value());
+
+                if (value) {
+                    ASSERT_EQ(expected->second, **value);
+                }
+            }
+        }
+
+        tree.flush();
+
+        auto runs = tree.getRunCounts();
+
+        //Compactions kept level 0 short and pushed the keys into deeper levels
+        EXPECT_LT(runs[0], LSM_LEVEL0_RUNS);
+        EXPECT_GE(runs.size(), 3u);
+
+        expectSameEntries(reference, *tree.entries());
+
+        for (int base = 0; base < 20000; base += 1777) {
+            std::map<int, int> expected(reference.lower_bound(base), reference.upper_bound(base + 500));
+
+            expectSameEntries(expected, *tree.rangeSearch(base, base + 500));
+        }
+    }
+
+    //Everything was written out when the tree was destroyed, and comes back when the directory is opened again
+    LsmTree<int, int> reopened(directory.getPath(), 512);
+
+    expectSameEntries(reference, *reopened.entries());
+
+    for (int key = 0; key < 20000; key++) {
+        ASSERT_EQ(reference.count(key) == 1, reopened.hasKey(key));
+    }
+}
+
+TEST(LsmTreeTests, FiltersSkipRuns) {
+
+    TemporaryDirectory directory;
+
+    LsmTree<std::string, std::string> tree(directory.getPath(), 1000);
+
+    for (int i = 0; i < 10000; i += 2) {
+        tree.add(std::make_shared<std::string>("key" + std::to_string(i)),
+                 std::make_shared<std::string>("value" + std::to_string(i)));
+    }
+
+    tree.flush();
+
+    for (int i = 0; i < 10000; i++) {
+        auto value = tree.get("key" + std::to_string(i));
+
+        ASSERT_EQ(i % 2 == 0, value.has_value());
+
+        if (value) {
+            ASSERT_EQ("value" + std::to_string(i), **value);
+        }
+    }
+
+    LsmStats stats = tree.getStats();
+
+    //Every present key reads at least one block, the missing ones should hardly ever need to
+    EXPECT_GE(stats.blockReads, 5000u);
+    EXPECT_LT(stats.blockReads, 5000u + 5000u / 10);
+    EXPECT_GT(stats.filterSkips, 0u);
+}
+
+TEST(LsmTreeTests, ConcurrentWriters) {
+
+    TemporaryDirectory directory;
+
+    const int threadCount = 4, keysPerThread = 20000;
+
+    LsmTree<int, int> tree(directory.getPath(), 2048);
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&tree, t]() {
+            for (int i = t; i < keysPerThread * threadCount; i += threadCount) {
+                tree.add(std::make_shared<int>(i), std::make_shared<int>(i * 2));
+            }
+
+            for (int i = t; i < keysPerThread * threadCount; i += threadCount * 2) {
+                tree.remove(i);
+            }
+        });
+    }
+
+    //Reads run while memtables are swapped and runs are compacted
+    for (int i = 0; i < keysPerThread * threadCount; i += 97) {
+        auto value = tree.get(i);
+
+        if (value) {
+            ASSERT_EQ(i * 2, **value);
+        }
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    tree.flush();
+
+    auto entries = tree.entries();
+
+    EXPECT_EQ(keysPerThread * threadCount / 2, (int) entries->size());
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(*std::get<0>(entry) * 2, *std::get<1>(entry));
+        ASSERT_NE(*std::get<0>(entry) % threadCount, *std::get<0>(entry) % (threadCount * 2));
+    }
+}
+
+TEST(LsmTreeTests, WriteFailuresReachWriters) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/store";
+
+    LsmTree<int, int> tree(path, 100);
+
+    //The runs can't be created once the directory is gone
+    ASSERT_EQ(0, ::rmdir(path.c_str()));
+
+    //The last add fills the memtable, the background thread fails to write it out after that
+    for (int i = 0; i < 100; i++) {
+        tree.add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    EXPECT_THROW(tree.flush(), std::system_error);
+    EXPECT_THROW(tree.add(std::make_shared<int>(1000), std::make_shared<int>(0)), std::system_error);
+
+    //The memtable that couldn't be written is still read from
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(i, **tree.get(i));
+    }
+}
@@ -4,6 +4,7 @@
 #include "../trees/redblacktree.h"
 #include "../trees/splaytree.h"
 #include "../trees/treaps.h"
+#include "../trees/compacttree.h"
 #include "../probabilisticlist/skiplist.h"
 #include "gtest/gtest.h"
 #include <chrono>
@@ -191,6 +192,10 @@ TEST(TreeTest, InsertAndContains) {
     std::cout << "testing skip list" << std::endl;
 
     insertAndContains(map.get());
+
+    map = std::make_unique<CompactRedBlackTree<int, int>>();
+
+    insertAndContains(map.get());
 }
 
 TEST(TreeTest, InsertAndRemove) {
@@ -216,6 +221,10 @@ TEST(TreeTest, InsertAndRemove) {
     map = std::make_unique<SkipList<int, int>>();
 
     insertAndRemove(map.get());
+
+    map = std::make_unique<CompactRedBlackTree<int, int>>();
+
+    insertAndRemove(map.get());
 }
 
 TEST(TreeTest, InsertAndRemoveBackwards) {
@@ -272,6 +281,10 @@ TEST(TreeTest, InsertAndPopInOrder) {
     map = std::make_unique<SkipList<int, int>>();
 
     insertAndPop(map.get());
+
+    map = std::make_unique<CompactRedBlackTree<int, int>>();
+
+    insertAndPop(map.get());
 }
 
 TEST(TreeTest, InsertAndPopBackwards) {
@@ -301,6 +314,10 @@ TEST(TreeTest, InsertAndPopBackwards) {
     map = std::make_unique<SkipList<int, int>>();
 
     insertAndPopBackwards(map.get());
+
+    map = std::make_unique<CompactRedBlackTree<int, int>>();
+
+    insertAndPopBackwards(map.get());
 }
 
 class DestructionTest {
@@ -331,6 +348,69 @@ TEST(test, random) {
 }
 
 
+void checkTraversals(BinarySearchTree<int, int> *tree, int size) {
+
+    for (TraversalMode mode : {EXPLICIT_STACK, PARENT_THREADED}) {
+
+        tree->setTraversalMode(mode);
+
+        auto entries = tree->entries();
+
+        ASSERT_EQ(entries->size(), (size_t) size);
+
+        for (int i = 0; i < size; i++) {
+            ASSERT_EQ(*std::get<0>((*entries)[i]), i);
+        }
+
+        auto range = tree->rangeSearch(size / 4, size / 2);
+
+        ASSERT_EQ(range->size(), (size_t) (size / 2 - size / 4 + 1));
+
+        for (size_t i = 0; i < range->size(); i++) {
+            ASSERT_EQ(*std::get<0>((*range)[i]), size / 4 + (int) i);
+        }
+
+        ASSERT_TRUE(tree->rangeSearch(size, size * 2)->empty());
+    }
+}
+
+TEST(TraversalTest, DegenerateSplayTree) {
+
+    //Sequential inserts leave the splay tree as a path, which used to blow the stack in the recursive traversals
+    const int size = 1000000;
+
+    auto tree = std::make_unique<SplayTree<int, int>>();
+
+    std::shared_ptr<int> value = std::make_shared<int>(42);
+
+    for (int i = 0; i < size; i++) {
+        tree->add(std::make_shared<int>(i), value);
+    }
+
+    checkTraversals(tree.get(), size);
+}
+
+TEST(TraversalTest, InOrderAndRange) {
+
+    auto avlTree = std::make_unique<AvlTree<int, int>>();
+
+    insertBackwards(avlTree.get());
+
+    checkTraversals(avlTree.get(), TEST_SIZE);
+
+    auto redBlackTree = std::make_unique<RedBlackTree<int, int>>();
+
+    insertBackwards(redBlackTree.get());
+
+    checkTraversals(redBlackTree.get(), TEST_SIZE);
+
+    auto treap = std::make_unique<Treap<int, int>>();
+
+    insertBackwards(treap.get());
+
+    checkTraversals(treap.get(), TEST_SIZE);
+}
+
 int main(int argc, char **argv) {
 
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,240 @@
+#include "gtest/gtest.h"
+#include "../probabilisticlist/mvccskiplist.h"
+#include <thread>
+
+#define MVCC_THREAD_COUNT 4
+#define MVCC_KEY_COUNT 2000
+
+TEST(MVCCSkipListTests, MapOperations) {
+
+    auto list = std::make_unique<MVCCSkipList<int, int>>();
+
+    for (int i = MVCC_KEY_COUNT - 1; i >= 0; i--) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i * 2));
+    }
+
+    EXPECT_EQ(MVCC_KEY_COUNT, list->size());
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i += 2) {
+        auto removed = list->remove(i);
+
+        ASSERT_TRUE(removed.has_value());
+        EXPECT_EQ(i * 2, **removed);
+    }
+
+    EXPECT_FALSE(list->remove(0).has_value());
+    EXPECT_EQ(MVCC_KEY_COUNT / 2, list->size());
+
+    list->add(std::make_shared<int>(1), std::make_shared<int>(-1));
+
+    EXPECT_EQ(-1, **list->get(1));
+    EXPECT_FALSE(list->hasKey(2));
+    EXPECT_EQ(MVCC_KEY_COUNT / 2, list->size());
+
+    auto range = list->rangeSearch(10, 20);
+
+    ASSERT_EQ(5, range->size());
+
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(11 + i * 2, *std::get<0>((*range)[i]));
+    }
+
+    auto keys = list->keys();
+
+    ASSERT_EQ(MVCC_KEY_COUNT / 2, keys->size());
+    EXPECT_TRUE(std::is_sorted(keys->begin(), keys->end(),
+                               [](const std::shared_ptr<int> &first, const std::shared_ptr<int> &second) {
+                                   return *first < *second;
+                               }));
+
+    EXPECT_EQ(1, *std::get<0>(*list->peekSmallest()));
+    EXPECT_EQ(MVCC_KEY_COUNT - 1, *std::get<0>(*list->peekLargest()));
+
+    list->remove(MVCC_KEY_COUNT - 1);
+
+    EXPECT_EQ(MVCC_KEY_COUNT - 3, *std::get<0>(*list->popLargest()));
+    EXPECT_EQ(1, *std::get<0>(*list->popSmallest()));
+    EXPECT_EQ(3, *std::get<0>(*list->peekSmallest()));
+    EXPECT_EQ(MVCC_KEY_COUNT / 2 - 3, list->size());
+}
+
+TEST(MVCCSkipListTests, SnapshotIsolation) {
+
+    auto list = std::make_unique<MVCCSkipList<int, int>>();
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    auto snapshot = list->snapshot();
+
+    //Change every key after the snapshot was taken
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        if (i % 3 == 0) {
+            list->remove(i);
+        } else {
+            list->add(std::make_shared<int>(i), std::make_shared<int>(-i));
+        }
+
+        list->add(std::make_shared<int>(MVCC_KEY_COUNT + i), std::make_shared<int>(i));
+    }
+
+    list->collectGarbage();
+
+    auto entries = snapshot->entries();
+
+    ASSERT_EQ(MVCC_KEY_COUNT, entries->size());
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        EXPECT_EQ(i, *std::get<0>((*entries)[i]));
+        EXPECT_EQ(i, *std::get<1>((*entries)[i]));
+    }
+
+    EXPECT_EQ(3, **snapshot->get(3));
+    EXPECT_FALSE(snapshot->hasKey(MVCC_KEY_COUNT));
+    EXPECT_EQ(11, snapshot->rangeSearch(10, 20)->size());
+
+    EXPECT_FALSE(list->hasKey(3));
+    EXPECT_EQ(-4, **list->get(4));
+    EXPECT_EQ(MVCC_KEY_COUNT * 2 - (MVCC_KEY_COUNT + 2) / 3, list->size());
+}
+
+TEST(MVCCSkipListTests, CollectsOldVersions) {
+
+    auto list = std::make_unique<MVCCSkipList<int, int>>();
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    auto snapshot = list->snapshot();
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+            list->add(std::make_shared<int>(i), std::make_shared<int>(round));
+        }
+    }
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i += 2) {
+        list->remove(i);
+    }
+
+    list->collectGarbage();
+
+    //The snapshot still needs the first version of every key, the map needs the last one
+    EXPECT_GE(list->versionCount(), MVCC_KEY_COUNT * 2);
+
+    snapshot.reset();
+
+    list->collectGarbage();
+
+    //Only the keys that are still in the map are left, with a single version each
+    EXPECT_EQ(MVCC_KEY_COUNT / 2, list->versionCount());
+    EXPECT_EQ(MVCC_KEY_COUNT / 2, list->size());
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        EXPECT_EQ(i % 2 == 1, list->hasKey(i));
+    }
+}
+
+TEST(MVCCSkipListTests, ConsistentScansDuringWrites) {
+
+    auto list = std::make_unique<MVCCSkipList<int, int>>();
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(0));
+    }
+
+    std::atomic_bool running(true);
+
+    //A single writer sets every key to the round number, in key order. Any consistent view has the keys of the current
+    //Round first, followed by the keys still in the previous round
+    std::thread writer([&list, &running]() {
+        for (int round = 1; round <= 20; round++) {
+            for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+                list->add(std::make_shared<int>(i), std::make_shared<int>(round));
+            }
+        }
+
+        running.store(false);
+    });
+
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < MVCC_THREAD_COUNT - 1; t++) {
+        readers.emplace_back([&list, &running]() {
+            do {
+                auto snapshot = list->snapshot();
+
+                auto entries = snapshot->entries();
+
+                ASSERT_EQ(MVCC_KEY_COUNT, entries->size());
+
+                int first = *std::get<1>(entries->front());
+
+                for (auto &entry : *entries) {
+                    int round = *std::get<1>(entry);
+
+                    ASSERT_TRUE(round == first || round == first - 1);
+
+                    first = round;
+                }
+
+                //Reading again gives exactly the same view
+                auto again = snapshot->rangeSearch(0, MVCC_KEY_COUNT);
+
+                ASSERT_EQ(entries->size(), again->size());
+
+                for (size_t i = 0; i < entries->size(); i++) {
+                    ASSERT_EQ(*std::get<1>((*entries)[i]), *std::get<1>((*again)[i]));
+                }
+            } while (running.load());
+        });
+    }
+
+    writer.join();
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    for (int i = 0; i < MVCC_KEY_COUNT; i++) {
+        EXPECT_EQ(20, **list->get(i));
+    }
+}
+
+TEST(MVCCSkipListTests, ConcurrentAddAndRemove) {
+
+    auto list = std::make_unique<MVCCSkipList<int, int>>();
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < MVCC_THREAD_COUNT; t++) {
+        threads.emplace_back([&list, t]() {
+            for (int repeat = 0; repeat < 3; repeat++) {
+                for (int i = t; i < MVCC_KEY_COUNT * 4; i += MVCC_THREAD_COUNT) {
+                    list->add(std::make_shared<int>(i), std::make_shared<int>(repeat));
+                }
+
+                for (int i = t; i < MVCC_KEY_COUNT * 4; i += MVCC_THREAD_COUNT * 2) {
+                    ASSERT_TRUE(list->remove(i).has_value());
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    list->collectGarbage();
+
+    EXPECT_EQ(MVCC_KEY_COUNT * 4 - MVCC_KEY_COUNT * 2, list->size());
+    EXPECT_EQ(list->size(), list->versionCount());
+
+    for (int i = 0; i < MVCC_KEY_COUNT * 4; i++) {
+        bool removed = (i % MVCC_THREAD_COUNT) == (i % (MVCC_THREAD_COUNT * 2));
+
+        EXPECT_EQ(!removed, list->hasKey(i));
+    }
+}
@@ -3,8 +3,24 @@
 #include "../trees/redblacktree.h"
 #include "../trees/splaytree.h"
 #include "../trees/treaps.h"
+#include "../trees/compacttree.h"
+#include "../trees/frozenmap.h"
+#include "../trees/adaptiveradixtree.h"
+#include "../trees/filteredmapadaptor.h"
+#include "../trees/persistenttree.h"
 #include "../probabilisticlist/skiplist.h"
+#include "../probabilisticlist/concurrentskiplist.h"
+#include "../probabilisticlist/arenaskiplist.h"
+#include "../probabilisticlist/cachesensitiveskiplist.h"
+#include "../hashtables/swisstable.h"
+#include "../heaps/daryheap.h"
+#include "../heaps/pairingheap.h"
+#include "../storage/durablemap.h"
+#include "../storage/sstable.h"
+#include "temporarydirectory.h"
+#include <algorithm>
 #include <chrono>
+#include <random>
 
 #include "gtest/gtest.h"
 
@@ -12,6 +28,11 @@
 #define TEST_MULTIPLY 10
 #define TEST_AMOUNTS 5
 #define RANDOM_SEED 0xFA4812
+//Writes logged together when filling the durable map for the recovery test
+#define DURABLE_MAP_RECOVERY_CHUNK 8192
+//Versions published by the versioning test, and how many of the latest ones readers are still holding on to
+#define PUBLISHED_VERSIONS 100
+#define LIVE_VERSIONS 4
 
 void insertTest(OrderedMap<int, int> *map, int start, int end) {
 
@@ -199,6 +220,77 @@ void randomizedLookupHeavyTest(int testSize, OrderedMap<int, int> *map) {
               << " ms to complete." << std::endl;
 }
 
+void hotKeyLookupTest(int testSize, OrderedMap<int, int> *map) {
+
+    srand(RANDOM_SEED);
+
+    auto value = std::make_shared<int>(1);
+
+    insertTest(map, 0, testSize);
+
+    //A small set of keys gets most of the lookups
+    std::vector<int> hotKeys;
+
+    for (int i = 0; i < 16; i++) {
+        hotKeys.push_back(rand() % testSize);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < testSize * 5; i++) {
+
+        if (i % 10 == 0) {
+            map->hasKey(rand() % testSize);
+        } else {
+            map->hasKey(hotKeys[i % hotKeys.size()]);
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+/**
+ * Push every key and then pop them all, using the map as a priority queue
+ */
+void orderedMapQueueTest(OrderedMap<int, int> *map, const std::vector<int> &keys) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+
+    for (int key : keys) {
+        map->add(std::make_shared<int>(key), value);
+    }
+
+    while (map->popSmallest()) {}
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+void priorityQueueTest(PriorityQueue<int, int> *queue, const std::vector<int> &keys) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+
+    for (int key : keys) {
+        queue->push(key, value);
+    }
+
+    while (queue->popSmallest()) {}
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
 TEST(PerfTest, SEQUENTIAL_ASC_INSERT_HEAVY) {
 
     int currentTestSize = BASE_TEST_SIZE;
@@ -464,6 +556,907 @@ TEST(PerfTest, RANDOM_LOOKUP_HEAVY) {
 
         randomizedLookupHeavyTest(currentTestSize, ptrs.get());
 
+        ptrs = std::make_unique<CompactRedBlackTree<int, int>>();
+
+        std::cout << "Testing the DS: Compact Red Black" << std::endl;
+
+        randomizedLookupHeavyTest(currentTestSize, ptrs.get());
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+TEST(PerfTest, HOT_KEY_LOOKUP) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::unique_ptr<OrderedMap<int, int>> ptrs = std::make_unique<AvlTree<int, int>>();
+
+        std::cout << "Testing the DS: AVL Tree" << std::endl;
+
+        hotKeyLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<SplayTree<int, int>>(BOTTOM_UP);
+
+        std::cout << "Testing the DS: Splay Tree (Bottom up)" << std::endl;
+
+        hotKeyLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<SplayTree<int, int>>(TOP_DOWN);
+
+        std::cout << "Testing the DS: Splay Tree (Top down)" << std::endl;
+
+        hotKeyLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<SplayTree<int, int>>(SEMI_SPLAY);
+
+        std::cout << "Testing the DS: Splay Tree (Semi splay)" << std::endl;
+
+        hotKeyLookupTest(currentTestSize, ptrs.get());
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+TEST(PerfTest, FROZEN_LOOKUP_HEAVY) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::unique_ptr<AvlTree<int, int>> tree = std::make_unique<AvlTree<int, int>>();
+
+        insertTest(tree.get(), 0, currentTestSize);
+
+        //Half of the keys are in the map, in random order so the search paths don't repeat
+        std::mt19937 random(RANDOM_SEED);
+
+        std::uniform_int_distribution<int> distribution(0, currentTestSize * 2 - 1);
+
+        std::vector<int> keys(currentTestSize * 2);
+
+        for (auto &key : keys) {
+            key = distribution(random);
+        }
+
+        std::cout << "Testing the DS: AVL Tree" << std::endl;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        unsigned int treeFound = 0;
+
+        for (int key : keys) {
+            treeFound += tree->hasKey(key);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
+        auto frozen = freeze<int, int>(tree.get());
+
+        std::cout << "Testing the DS: Frozen AVL Tree" << std::endl;
+
+        start = std::chrono::high_resolution_clock::now();
+
+        //Counting the hits keeps the compiler from dropping the lookups
+        unsigned int frozenFound = 0;
+
+        for (int key : keys) {
+            frozenFound += frozen->hasKey(key);
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
+        std::cout << "Found " << frozenFound << " of " << keys.size() << " keys" << std::endl;
+
+        EXPECT_EQ(treeFound, frozenFound);
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+TEST(PerfTest, MEMTABLE_FILL_AND_FREE) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::vector<int> keys(currentTestSize);
+
+        for (int key = 0; key < currentTestSize; key++) {
+            keys[key] = key;
+        }
+
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(RANDOM_SEED));
+
+        std::cout << "Testing the DS: Concurrent Skip List" << std::endl;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        {
+            auto list = std::make_unique<ConcurrentSkipList<int, int>>();
+
+            auto value = std::make_shared<int>(1);
+
+            for (int key : keys) {
+                list->add(std::make_shared<int>(key), value);
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
+        std::cout << "Testing the DS: Arena Skip List" << std::endl;
+
+        start = std::chrono::high_resolution_clock::now();
+
+        {
+            auto list = std::make_unique<ArenaSkipList<int, int>>();
+
+            for (int key : keys) {
+                list->add(key, 1);
+            }
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+TEST(PerfTest, PRIORITY_QUEUE_PUSH_POP) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::vector<int> keys(currentTestSize);
+
+        for (int key = 0; key < currentTestSize; key++) {
+            keys[key] = key;
+        }
+
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(RANDOM_SEED));
+
+        std::unique_ptr<OrderedMap<int, int>> map = std::make_unique<AvlTree<int, int>>();
+
+        std::cout << "Testing the DS: AVL Tree" << std::endl;
+
+        orderedMapQueueTest(map.get(), keys);
+
+        map = std::make_unique<RedBlackTree<int, int>>();
+
+        std::cout << "Testing the DS: Red Black" << std::endl;
+
+        orderedMapQueueTest(map.get(), keys);
+
+        map = std::make_unique<SkipList<int, int>>();
+
+        std::cout << "Testing the DS: Skip List" << std::endl;
+
+        orderedMapQueueTest(map.get(), keys);
+
+        map.reset();
+
+        std::unique_ptr<PriorityQueue<int, int>> queue = std::make_unique<DaryHeap<int, int>>();
+
+        std::cout << "Testing the DS: 4-ary Heap" << std::endl;
+
+        priorityQueueTest(queue.get(), keys);
+
+        queue = std::make_unique<DaryHeap<int, int, 2>>();
+
+        std::cout << "Testing the DS: Binary Heap" << std::endl;
+
+        priorityQueueTest(queue.get(), keys);
+
+        queue = std::make_unique<PairingHeap<int, int>>();
+
+        std::cout << "Testing the DS: Pairing Heap" << std::endl;
+
+        priorityQueueTest(queue.get(), keys);
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+TEST(PerfTest, NEARLY_SORTED_INSERT) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        //Timestamps with a little jitter, going into the gaps between the ones that are already there
+        std::vector<int> keys(currentTestSize);
+
+        std::mt19937 random(RANDOM_SEED);
+
+        for (int key = 0; key < currentTestSize; key++) {
+            keys[key] = key * 8 + 1 + random() % 6;
+        }
+
+        std::shared_ptr<int> value = std::make_shared<int>(1);
+
+        std::cout << "Testing the DS: AVL Tree" << std::endl;
+
+        auto tree = std::make_unique<AvlTree<int, int>>();
+
+        insertTest(tree.get(), 0, currentTestSize * 8);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int key : keys) {
+            tree->add(std::make_shared<int>(key), value);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
+        std::cout << "Testing the DS: AVL Tree with hints" << std::endl;
+
+        tree = std::make_unique<AvlTree<int, int>>();
+
+        insertTest(tree.get(), 0, currentTestSize * 8);
+
+        start = std::chrono::high_resolution_clock::now();
+
+        TreeNode<int, int> *hint = nullptr;
+
+        for (int key : keys) {
+            hint = tree->addWithHint(hint, std::make_shared<int>(key), value);
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
+        tree.reset();
+
+        std::cout << "Testing the DS: Skip List with finger search" << std::endl;
+
+        auto list = std::make_unique<SkipList<int, int>>();
+
+        insertTest(list.get(), 0, currentTestSize * 8);
+
+        start = std::chrono::high_resolution_clock::now();
+
+        for (int key : keys) {
+            list->add(std::make_shared<int>(key), value);
+        }
+
+        end = std::chrono::high_resolution_clock::now();
+
+        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms to complete." << std::endl;
+
         currentTestSize *= TEST_MULTIPLY;
     }
-}
\ No newline at end of file
+}
+
+template<typename Map>
+void batchInsertTest(Map *map, const std::vector<std::vector<int>> &batches, bool useBatch) {
+
+    std::shared_ptr<int> value = std::make_shared<int>(1);
+
+    long long elapsed = 0;
+
+    for (const auto &keys : batches) {
+        //Both ways get the same entries, so only the inserts themselves are timed
+        std::vector<node_info<int, int>> batch;
+
+        batch.reserve(keys.size());
+
+        for (int key : keys) {
+            batch.emplace_back(std::make_shared<int>(key), value);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        if (useBatch) {
+            map->addBatch(std::move(batch));
+        } else {
+            for (auto &entry : batch) {
+                map->add(std::move(std::get<0>(entry)), std::move(std::get<1>(entry)));
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        elapsed += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+
+    std::cout << "Took " << elapsed / 1000 << " ms to complete." << std::endl;
+}
+
+TEST(PerfTest, SORTED_BATCH_INSERT) {
+
+    //The size of the write batches
+    const int batchSize = 10000;
+
+    int currentTestSize = BASE_TEST_SIZE * TEST_MULTIPLY * TEST_MULTIPLY;
+
+    for (int i = 2; i < TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::mt19937 random(RANDOM_SEED);
+
+        std::vector<std::vector<int>> batches(std::max(1, currentTestSize / batchSize));
+
+        for (auto &batch : batches) {
+            batch.resize(std::min(batchSize, currentTestSize));
+
+            for (int &key : batch) {
+                key = (int) (random() % ((unsigned int) currentTestSize * 4));
+            }
+
+            std::sort(batch.begin(), batch.end());
+        }
+
+        std::cout << "Testing the DS: Skip List" << std::endl;
+        batchInsertTest(std::make_unique<SkipList<int, int>>().get(), batches, false);
+
+        std::cout << "Testing the DS: Skip List with batches" << std::endl;
+        batchInsertTest(std::make_unique<SkipList<int, int>>().get(), batches, true);
+
+        std::cout << "Testing the DS: Red Black Tree" << std::endl;
+        batchInsertTest(std::make_unique<RedBlackTree<int, int>>().get(), batches, false);
+
+        std::cout << "Testing the DS: Red Black Tree with batches" << std::endl;
+        batchInsertTest(std::make_unique<RedBlackTree<int, int>>().get(), batches, true);
+
+        std::cout << "Testing the DS: AVL Tree" << std::endl;
+        batchInsertTest(std::make_unique<AvlTree<int, int>>().get(), batches, false);
+
+        std::cout << "Testing the DS: AVL Tree with batches" << std::endl;
+        batchInsertTest(std::make_unique<AvlTree<int, int>>().get(), batches, true);
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * Look up random keys, half of them present, in a map that was filled in random order
+ */
+void randomLookupTest(int testSize, OrderedMap<int, int> *map) {
+
+    std::mt19937 random(RANDOM_SEED);
+
+    auto value = std::make_shared<int>(1);
+
+    for (int i = 0; i < testSize; i++) {
+        map->add(std::make_shared<int>((int) (random() % ((unsigned int) testSize * 2))), value);
+    }
+
+    std::vector<int> lookups(std::max(testSize, 1000000));
+
+    for (int &key : lookups) {
+        key = (int) (random() % ((unsigned int) testSize * 2));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int key : lookups) {
+        map->hasKey(key);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+TEST(PerfTest, CACHE_SENSITIVE_LOOKUP) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::unique_ptr<OrderedMap<int, int>> ptrs = std::make_unique<SkipList<int, int>>();
+
+        std::cout << "Testing the DS: Skip List" << std::endl;
+
+        randomLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<CacheSensitiveSkipList<int, int>>();
+
+        std::cout << "Testing the DS: Cache Sensitive Skip List" << std::endl;
+
+        randomLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<RedBlackTree<int, int>>();
+
+        std::cout << "Testing the DS: Red Black" << std::endl;
+
+        randomLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<AdaptiveRadixTree<int, int>>();
+
+        std::cout << "Testing the DS: Adaptive Radix Tree" << std::endl;
+
+        randomLookupTest(currentTestSize, ptrs.get());
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * Look up random keys in a map where most lookups are for keys that aren't there, like the reads that miss a cache
+ */
+void missingKeyLookupTest(int testSize, OrderedMap<int, int> *map) {
+
+    std::mt19937 random(RANDOM_SEED);
+
+    auto value = std::make_shared<int>(1);
+
+    for (int i = 0; i < testSize; i++) {
+        map->add(std::make_shared<int>((int) (random() % ((unsigned int) testSize * 10))), value);
+    }
+
+    std::vector<int> lookups(std::max(testSize, 1000000));
+
+    for (int &key : lookups) {
+        key = (int) (random() % ((unsigned int) testSize * 10));
+    }
+
+    int found = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int key : lookups) {
+        found += map->hasKey(key);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete. (" << found << " found)" << std::endl;
+}
+
+TEST(PerfTest, MISSING_KEY_LOOKUP) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::unique_ptr<OrderedMap<int, int>> ptrs = std::make_unique<SkipList<int, int>>();
+
+        std::cout << "Testing the DS: Skip List" << std::endl;
+
+        missingKeyLookupTest(currentTestSize, ptrs.get());
+
+        auto filtered = std::make_unique<FilteredMapAdaptor<int, int>>(std::make_unique<SkipList<int, int>>());
+
+        std::cout << "Testing the DS: Filtered Skip List" << std::endl;
+
+        missingKeyLookupTest(currentTestSize, filtered.get());
+
+        FilterStats stats = filtered->getStats();
+
+        std::cout << "Hits: " << stats.hits << ", filtered: " << stats.filtered << ", false positives: "
+                  << stats.falsePositives << " (" << stats.falsePositiveRate() * 100 << "%)" << std::endl;
+
+        ptrs = std::make_unique<RedBlackTree<int, int>>();
+
+        std::cout << "Testing the DS: Red Black" << std::endl;
+
+        missingKeyLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<FilteredMapAdaptor<int, int>>(std::make_unique<RedBlackTree<int, int>>());
+
+        std::cout << "Testing the DS: Filtered Red Black" << std::endl;
+
+        missingKeyLookupTest(currentTestSize, ptrs.get());
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * Look up random string keys that share long prefixes, like the keys of a real index
+ */
+void stringLookupTest(int testSize, OrderedMap<std::string, int> *map) {
+
+    std::mt19937 random(RANDOM_SEED);
+
+    auto value = std::make_shared<int>(1);
+
+    auto randomKey = [&random, testSize]() {
+        return "tenant:" + std::to_string(random() % 16) + ":user:" +
+               std::to_string(random() % ((unsigned int) testSize * 2));
+    };
+
+    for (int i = 0; i < testSize; i++) {
+        map->add(std::make_shared<std::string>(randomKey()), value);
+    }
+
+    std::vector<std::string> lookups(std::max(testSize, 1000000));
+
+    for (std::string &key : lookups) {
+        key = randomKey();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (const std::string &key : lookups) {
+        map->hasKey(key);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete." << std::endl;
+}
+
+TEST(PerfTest, STRING_KEY_LOOKUP) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i < TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::unique_ptr<OrderedMap<std::string, int>> ptrs = std::make_unique<RedBlackTree<std::string, int>>();
+
+        std::cout << "Testing the DS: Red Black" << std::endl;
+
+        stringLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<SkipList<std::string, int>>();
+
+        std::cout << "Testing the DS: Skip List" << std::endl;
+
+        stringLookupTest(currentTestSize, ptrs.get());
+
+        ptrs = std::make_unique<AdaptiveRadixTree<std::string, int>>();
+
+        std::cout << "Testing the DS: Adaptive Radix Tree" << std::endl;
+
+        stringLookupTest(currentTestSize, ptrs.get());
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * Fill with random keys and then test random keys for membership, half of them present
+ * @param add Adds a key
+ * @param contains Tests a key
+ */
+template<typename Add, typename Contains>
+void membershipTest(int testSize, Add add, Contains contains) {
+
+    std::mt19937 random(RANDOM_SEED);
+
+    for (int i = 0; i < testSize; i++) {
+        add((int) (random() % ((unsigned int) testSize * 2)));
+    }
+
+    std::vector<int> lookups(std::max(testSize, 1000000));
+
+    for (int &key : lookups) {
+        key = (int) (random() % ((unsigned int) testSize * 2));
+    }
+
+    int found = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int key : lookups) {
+        found += contains(key);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+              << " ms to complete. (" << found << " found)" << std::endl;
+}
+
+TEST(PerfTest, HASH_SET_MEMBERSHIP) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    auto value = std::make_shared<int>(1);
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        {
+            auto tree = std::make_unique<RedBlackTree<int, int>>();
+
+            std::cout << "Testing the DS: Red Black" << std::endl;
+
+            membershipTest(currentTestSize, [&tree, &value](int key) {
+                tree->add(std::make_shared<int>(key), value);
+            }, [&tree](int key) { return tree->hasKey(key); });
+        }
+
+        {
+            auto map = std::make_unique<SwissMap<int, int>>();
+
+            std::cout << "Testing the DS: Swiss Map" << std::endl;
+
+            membershipTest(currentTestSize, [&map, &value](int key) {
+                map->add(std::make_shared<int>(key), value);
+            }, [&map](int key) { return map->hasKey(key); });
+        }
+
+        {
+            auto set = std::make_unique<SwissSet<int, MurmurHash>>();
+
+            std::cout << "Testing the DS: Swiss Set (Murmur)" << std::endl;
+
+            membershipTest(currentTestSize, [&set](int key) { set->add(key); },
+                           [&set](int key) { return set->contains(key); });
+        }
+
+        {
+            auto set = std::make_unique<SwissSet<int, SpookyHashImpl>>();
+
+            std::cout << "Testing the DS: Swiss Set (Spooky)" << std::endl;
+
+            membershipTest(currentTestSize, [&set](int key) { set->add(key); },
+                           [&set](int key) { return set->contains(key); });
+        }
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * Time getting a map that was saved to disk ready for lookups and then doing them: rebuilding a tree from the saved
+ * entries, against mapping the table and searching it where it is
+ */
+TEST(PerfTest, SSTABLE_COLD_START) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::mt19937 random(RANDOM_SEED);
+
+        auto entries = std::make_unique<std::vector<node_info<int, int>>>();
+
+        for (int key = 0; key < currentTestSize; key++) {
+            entries->push_back(std::make_tuple(std::make_shared<int>(key * 2), std::make_shared<int>(key)));
+        }
+
+        {
+            SSTableWriter<int, int> writer(path);
+
+            for (auto &entry : *entries) {
+                writer.add(*std::get<0>(entry), *std::get<1>(entry));
+            }
+
+            writer.finish();
+        }
+
+        std::vector<int> lookups(100000);
+
+        for (int &key : lookups) {
+            key = (int) (random() % ((unsigned int) currentTestSize * 2));
+        }
+
+        {
+            std::cout << "Testing the DS: AVL Tree rebuilt from the entries" << std::endl;
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            auto tree = std::make_unique<AvlTree<int, int>>();
+
+            for (auto &entry : *entries) {
+                tree->add(std::make_shared<int>(*std::get<0>(entry)), std::make_shared<int>(*std::get<1>(entry)));
+            }
+
+            int found = 0;
+
+            for (int key : lookups) {
+                found += tree->hasKey(key);
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                      << " ms to complete. (" << found << " found)" << std::endl;
+        }
+
+        {
+            std::cout << "Testing the DS: Mapped SSTable" << std::endl;
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            SSTable<int, int> table(path);
+
+            int found = 0;
+
+            for (int key : lookups) {
+                found += table.hasKey(key);
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                      << " ms to complete. (" << found << " found)" << std::endl;
+        }
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * Opening a durable map after a restart, once with every write still in the log and once with a snapshot of them
+ */
+TEST(PerfTest, DURABLE_MAP_RECOVERY) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    for (int i = 0; i <= TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        TemporaryDirectory directory;
+
+        std::mt19937 random(RANDOM_SEED);
+
+        std::vector<int> order(currentTestSize);
+
+        for (int key = 0; key < currentTestSize; key++) {
+            order[key] = key;
+        }
+
+        std::shuffle(order.begin(), order.end(), random);
+
+        {
+            //No snapshots until the log has all of them
+            DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath(),
+                                            DURABLE_MAP_MAX_BATCH, UINT64_MAX);
+
+            //Logged a chunk at a time, so the log doesn't have the keys in order
+            for (size_t chunk = 0; chunk < order.size(); chunk += DURABLE_MAP_RECOVERY_CHUNK) {
+
+                auto last = order.begin() + std::min(order.size(), chunk + DURABLE_MAP_RECOVERY_CHUNK);
+
+                std::sort(order.begin() + chunk, last);
+
+                std::vector<node_info<int, int>> sorted;
+
+                for (auto key = order.begin() + chunk; key != last; key++) {
+                    sorted.emplace_back(std::make_shared<int>(*key), std::make_shared<int>(*key));
+                }
+
+                map.addSorted(std::move(sorted));
+            }
+        }
+
+        auto recover = [&directory](const std::string &name, std::unique_ptr<OrderedMap<int, int>> empty) {
+
+            std::cout << "Testing the DS: " << name << std::endl;
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            DurableMapAdaptor<int, int> map(std::move(empty), directory.getPath());
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                      << " ms to complete. (" << map.size() << " entries)" << std::endl;
+        };
+
+        recover("Skip List replayed from the log", std::make_unique<SkipList<int, int>>());
+        recover("AVL Tree replayed from the log", std::make_unique<AvlTree<int, int>>());
+
+        {
+            DurableMapAdaptor<int, int> map(std::make_unique<SkipList<int, int>>(), directory.getPath());
+
+            map.snapshot();
+        }
+
+        recover("Skip List bulk loaded from the snapshot", std::make_unique<SkipList<int, int>>());
+        recover("AVL Tree bulk loaded from the snapshot", std::make_unique<AvlTree<int, int>>());
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
+
+/**
+ * A writer that changes one key and then publishes a version of the map for readers, which hold on to the latest few
+ */
+TEST(PerfTest, PUBLISH_VERSIONS) {
+
+    int currentTestSize = BASE_TEST_SIZE;
+
+    //The copies take O(n) each, so this stops one size short of the other tests
+    for (int i = 0; i < TEST_AMOUNTS; i++) {
+        std::cout << "Test size: " << currentTestSize << std::endl;
+
+        std::mt19937 random(RANDOM_SEED);
+
+        std::vector<node_info<int, int>> sorted;
+
+        for (int key = 0; key < currentTestSize; key++) {
+            sorted.emplace_back(std::make_shared<int>(key), std::make_shared<int>(key));
+        }
+
+        std::vector<int> updates(PUBLISHED_VERSIONS);
+
+        for (int &key : updates) {
+            key = (int) (random() % (unsigned int) currentTestSize);
+        }
+
+        {
+            std::cout << "Testing the DS: AVL Tree copied for every version" << std::endl;
+
+            auto tree = std::make_unique<AvlTree<int, int>>();
+
+            tree->addSorted(sorted);
+
+            std::vector<std::unique_ptr<AvlTree<int, int>>> versions(LIVE_VERSIONS);
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int version = 0; version < PUBLISHED_VERSIONS; version++) {
+                tree->add(std::make_shared<int>(updates[version]), std::make_shared<int>(version));
+
+                auto copy = std::make_unique<AvlTree<int, int>>();
+
+                copy->addSorted(std::move(*tree->entries()));
+
+                versions[version % LIVE_VERSIONS] = std::move(copy);
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                      << " ms to complete." << std::endl;
+        }
+
+        {
+            std::cout << "Testing the DS: Persistent Tree" << std::endl;
+
+            PersistentMap<int, int> map;
+
+            map.addSorted(sorted);
+
+            std::vector<PersistentTree<int, int>> versions(LIVE_VERSIONS);
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int version = 0; version < PUBLISHED_VERSIONS; version++) {
+                map.add(std::make_shared<int>(updates[version]), std::make_shared<int>(version));
+
+                versions[version % LIVE_VERSIONS] = map.getVersion();
+            }
+
+            auto end = std::chrono::high_resolution_clock::now();
+
+            std::cout << "Took " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+                      << " us to complete." << std::endl;
+        }
+
+        currentTestSize *= TEST_MULTIPLY;
+    }
+}
@@ -0,0 +1,298 @@
+#include "gtest/gtest.h"
+#include "../trees/persistenttree.h"
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <unordered_set>
+
+typedef PersistentTree<int, int> IntTree;
+
+/**
+ * Check the order, the sizes and the balance of every node
+ *
+ * @return The size of the sub tree
+ */
+static unsigned int checkTree(const IntTree::NodePtr &node, const int *lowest, const int *highest) {
+
+    if (node == nullptr) return 0;
+
+    int key = *node->getKeyVal();
+
+    if (lowest != nullptr) {
+        EXPECT_LT(*lowest, key);
+    }
+
+    if (highest != nullptr) {
+        EXPECT_LT(key, *highest);
+    }
+
+    unsigned int left = checkTree(node->getLeftChild(), lowest, &key),
+            right = checkTree(node->getRightChild(), &key, highest);
+
+    EXPECT_EQ(left + right + 1, node->getSize());
+
+    EXPECT_LE(right + 1, PERSISTENT_TREE_DELTA * (left + 1));
+    EXPECT_LE(left + 1, PERSISTENT_TREE_DELTA * (right + 1));
+
+    return left + right + 1;
+}
+
+static void expectVersionEntries(const std::map<int, int> &reference, const IntTree &version) {
+
+    auto entries = version.entries();
+
+    ASSERT_EQ(reference.size(), entries->size());
+
+    auto expected = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(expected->first, *std::get<0>(entry));
+        ASSERT_EQ(expected->second, *std::get<1>(entry));
+
+        expected++;
+    }
+}
+
+static void collectNodes(const IntTree::NodePtr &node, std::unordered_set<const void *> &nodes) {
+
+    if (node == nullptr) return;
+
+    nodes.insert(node.get());
+
+    collectNodes(node->getLeftChild(), nodes);
+    collectNodes(node->getRightChild(), nodes);
+}
+
+TEST(PersistentTreeTests, MatchesMap) {
+
+    IntTree tree;
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(0x9E);
+
+    for (int i = 0; i < 40000; i++) {
+
+        int key = (int) (random() % 5000);
+
+        if (random() % 3 != 0) {
+            tree = tree.add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        } else {
+            std::optional<node_info<int, int>> removed;
+
+            tree = tree.remove(key, &removed);
+
+            ASSERT_EQ(reference.count(key) != 0, removed.has_value());
+
+            reference.erase(key);
+        }
+    }
+
+    EXPECT_EQ(reference.size(), checkTree(tree.getRoot(), nullptr, nullptr));
+
+    expectVersionEntries(reference, tree);
+
+    for (int key = 0; key < 5000; key++) {
+        auto value = tree.get(key);
+
+        auto expected = reference.find(key);
+
+        ASSERT_EQ(expected != reference.end(), value.has_value());
+
+        if (value) {
+            ASSERT_EQ(expected->second, **value);
+        }
+    }
+
+    auto range = tree.rangeSearch(1000, 1500);
+
+    EXPECT_EQ((size_t) std::distance(reference.lower_bound(1000), reference.upper_bound(1500)), range->size());
+
+    EXPECT_EQ(reference.begin()->first, *std::get<0>(*tree.peekSmallest()));
+    EXPECT_EQ(reference.rbegin()->first, *std::get<0>(*tree.peekLargest()));
+}
+
+TEST(PersistentTreeTests, OldVersionsDoNotChange) {
+
+    std::vector<IntTree> versions;
+    std::vector<std::map<int, int>> references;
+
+    IntTree tree;
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(0x3F);
+
+    for (int i = 0; i < 20000; i++) {
+
+        int key = (int) (random() % 3000);
+
+        if (random() % 4 != 0) {
+            tree = tree.add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        } else {
+            tree = tree.remove(key);
+
+            reference.erase(key);
+        }
+
+        if (i % 1000 == 0) {
+            versions.push_back(tree);
+            references.push_back(reference);
+        }
+    }
+
+    for (size_t version = 0; version < versions.size(); version++) {
+        expectVersionEntries(references[version], versions[version]);
+    }
+}
+
+TEST(PersistentTreeTests, UpdatesShareUntouchedNodes) {
+
+    std::vector<node_info<int, int>> sorted;
+
+    for (int i = 0; i < 100000; i++) {
+        sorted.emplace_back(std::make_shared<int>(i * 2), std::make_shared<int>(i));
+    }
+
+    IntTree base = IntTree::fromSorted(sorted);
+
+    EXPECT_EQ(100000u, checkTree(base.getRoot(), nullptr, nullptr));
+
+    std::unordered_set<const void *> baseNodes;
+
+    collectNodes(base.getRoot(), baseNodes);
+
+    auto countNew = [&baseNodes](const IntTree &version) {
+
+        std::unordered_set<const void *> nodes;
+
+        collectNodes(version.getRoot(), nodes);
+
+        unsigned int created = 0;
+
+        for (const void *node : nodes) {
+            created += baseNodes.count(node) == 0;
+        }
+
+        return created;
+    };
+
+    //Only the path to the key is copied, about log2(100000) = 17 nodes, plus the ones a rotation creates
+    EXPECT_LE(countNew(base.add(std::make_shared<int>(777), std::make_shared<int>(0))), 40u);
+    EXPECT_LE(countNew(base.add(std::make_shared<int>(1000), std::make_shared<int>(0))), 40u);
+    EXPECT_LE(countNew(base.remove(50000)), 40u);
+    EXPECT_LE(countNew(base.removeSmallest()), 40u);
+
+    //Removing a key that isn't there doesn't copy anything
+    EXPECT_EQ(base.getRoot(), base.remove(777).getRoot());
+}
+
+TEST(PersistentTreeTests, NodesAreReclaimed) {
+
+    auto value = std::make_shared<int>(42);
+
+    std::weak_ptr<int> watched = value;
+
+    IntTree tree;
+
+    for (int i = 0; i < 100; i++) {
+        tree = tree.add(std::make_shared<int>(i), i == 50 ? value : std::make_shared<int>(i));
+    }
+
+    value.reset();
+
+    IntTree older = tree;
+
+    tree = tree.remove(50);
+
+    //The older version still has it
+    EXPECT_FALSE(watched.expired());
+    EXPECT_EQ(42, **older.get(50));
+
+    older = IntTree();
+
+    EXPECT_TRUE(watched.expired());
+    EXPECT_EQ(99u, tree.size());
+}
+
+TEST(PersistentTreeTests, MapInterface) {
+
+    auto map = std::make_unique<PersistentMap<int, int>>();
+
+    for (int i = 0; i < 100; i++) {
+        map->add(std::make_shared<int>(i), std::make_shared<int>(i * 10));
+    }
+
+    PersistentTree<int, int> before = map->getVersion();
+
+    EXPECT_EQ(0, *std::get<0>(*map->popSmallest()));
+    EXPECT_EQ(99, *std::get<0>(*map->popLargest()));
+    EXPECT_EQ(500, **map->remove(50));
+    EXPECT_FALSE(map->remove(50).has_value());
+
+    EXPECT_EQ(97u, map->size());
+    EXPECT_EQ(97u, map->keys()->size());
+    EXPECT_FALSE(map->hasKey(50));
+
+    //The version taken before still has everything
+    EXPECT_EQ(100u, before.size());
+    EXPECT_TRUE(before.hasKey(50));
+
+    std::vector<node_info<int, int>> sorted;
+
+    for (int i = 0; i < 1000; i++) {
+        sorted.emplace_back(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    auto loaded = std::make_unique<PersistentMap<int, int>>();
+
+    loaded->addSorted(sorted);
+
+    EXPECT_EQ(1000u, checkTree(loaded->getVersion().getRoot(), nullptr, nullptr));
+}
+
+TEST(PersistentTreeTests, ReadersSeeWholeVersions) {
+
+    PersistentMap<int, int> map;
+
+    std::atomic_bool done(false);
+
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&map, &done]() {
+            while (!done.load()) {
+                //Keys are added in order, so every version holds the keys 0 to size - 1
+                PersistentTree<int, int> version = map.getVersion();
+
+                unsigned int expected = 0;
+
+                version.forEachInRange(nullptr, nullptr, [&expected](const std::shared_ptr<int> &key,
+                                                                     const std::shared_ptr<int> &) {
+                    ASSERT_EQ((int) expected, *key);
+
+                    expected++;
+                });
+
+                ASSERT_EQ(version.size(), expected);
+            }
+        });
+    }
+
+    for (int i = 0; i < 5000; i++) {
+        map.add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    done.store(true);
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(5000u, map.size());
+}
@@ -1,5 +1,7 @@
 
 #include "../trees/redblacktree.h"
+#include <map>
+#include <set>
 #include "gtest/gtest.h"
 
 TEST(RBTests, TestRecolour) {
@@ -127,4 +129,92 @@ TEST(RBTests, TestRemoveDoubleBlack) {
     ASSERT_EQ(*root->getKeyVal(), 40);
     ASSERT_EQ(*(root->getRightChild()->getKeyVal()), 50);
     ASSERT_EQ(*(root->getLeftChild()->getKeyVal()), 30);
-}
\ No newline at end of file
+}
+TEST(RBTests, TestAddWithHint) {
+
+    std::unique_ptr<RedBlackTree<int, int>> map = std::make_unique<RedBlackTree<int, int>>();
+
+    std::set<int> reference;
+
+    TreeNode<int, int> *hint = nullptr;
+
+    srand(0x7C02);
+
+    for (int i = 0; i < 5000; i++) {
+
+        int key = i % 50 == 0 ? rand() % (i * 4 + 1) : i * 4 + rand() % 16;
+
+        hint = map->addWithHint(hint, std::make_shared<int>(key), std::make_shared<int>(i));
+
+        ASSERT_EQ(*hint->getKeyVal(), key);
+
+        reference.insert(key);
+    }
+
+    ASSERT_EQ(map->size(), reference.size());
+
+    auto keys = map->keys();
+
+    ASSERT_TRUE(std::equal(keys->begin(), keys->end(), reference.begin(),
+                           [](const std::shared_ptr<int> &key, int expected) { return *key == expected; }));
+}
+
+/**
+ * Returns the black height of the sub tree, or -1 if a red node has a red child or the black heights differ
+ */
+int blackHeight(RBNode<int, int> *node) {
+
+    if (node == nullptr) return 1;
+
+    auto *left = (RBNode<int, int> *) node->getLeftChild(), *right = (RBNode<int, int> *) node->getRightChild();
+
+    if (node->getColor() == RED && ((left != nullptr && left->getColor() == RED) ||
+                                    (right != nullptr && right->getColor() == RED))) {
+        return -1;
+    }
+
+    int leftHeight = blackHeight(left), rightHeight = blackHeight(right);
+
+    if (leftHeight == -1 || leftHeight != rightHeight) return -1;
+
+    return leftHeight + (node->getColor() == BLACK ? 1 : 0);
+}
+
+TEST(RBTests, TestAddBatch) {
+
+    std::unique_ptr<RedBlackTree<int, int>> map = std::make_unique<RedBlackTree<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x61E0);
+
+    for (int round = 0; round < 10; round++) {
+
+        std::vector<node_info<int, int>> batch;
+
+        for (int i = 0; i < 1000; i++) {
+            int key = rand() % 20000;
+
+            batch.emplace_back(std::make_shared<int>(key), std::make_shared<int>(round * 1000 + i));
+
+            reference[key] = round * 1000 + i;
+        }
+
+        map->addBatch(std::move(batch));
+
+        ASSERT_NE(blackHeight((RBNode<int, int> *) map->getRoot()), -1);
+    }
+
+    ASSERT_EQ(map->size(), reference.size());
+
+    auto entries = map->entries();
+
+    auto expected = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(*std::get<0>(entry), expected->first);
+        ASSERT_EQ(*std::get<1>(entry), expected->second);
+
+        expected++;
+    }
+}
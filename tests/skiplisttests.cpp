@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "../probabilisticlist/skiplist.h"
 #include "../probabilisticlist/concurrentskiplist.h"
+#include <map>
+#include <thread>
 
 TEST(SkipListTests, TestInsert) {
 
@@ -48,4 +50,427 @@ TEST(SkipListTests, TestInsertRemove) {
     ASSERT_FALSE(skipList2->hasKey(1));
 
     ASSERT_EQ(skipList2->size(), 0);
-}
\ No newline at end of file
+}
+
+TEST(SkipListTests, InlineTowers) {
+
+    auto skipList = std::make_unique<SkipList<int, int>>();
+
+    auto concurrentList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x5eed);
+
+    for (int i = 0; i < 50000; i++) {
+
+        int key = rand() % 10000;
+
+        if (rand() % 3 == 0) {
+            auto removed = skipList->remove(key), concurrentRemoved = concurrentList->remove(key);
+
+            bool expected = reference.erase(key) == 1;
+
+            ASSERT_EQ((bool) removed, expected);
+            ASSERT_EQ((bool) concurrentRemoved, expected);
+        } else {
+            auto value = std::make_shared<int>(i);
+
+            skipList->add(std::make_shared<int>(key), value);
+            concurrentList->add(std::make_shared<int>(key), value);
+
+            reference[key] = i;
+        }
+    }
+
+    ASSERT_EQ(skipList->size(), reference.size());
+    ASSERT_EQ(concurrentList->size(), reference.size());
+
+    auto entries = skipList->entries();
+
+    auto iterator = reference.begin();
+
+    for (auto &entry : *entries) {
+        ASSERT_EQ(*std::get<0>(entry), iterator->first);
+        ASSERT_EQ(*std::get<1>(entry), iterator->second);
+
+        ASSERT_EQ(**concurrentList->get(iterator->first), iterator->second);
+
+        iterator++;
+    }
+}
+
+TEST(SkipListTests, LevelDistribution) {
+
+    const int samples = 1 << 20;
+
+    unsigned int counts[SKIP_LIST_HEIGHT_LIMIT] = {};
+
+    for (int i = 0; i < samples; i++) {
+        int level = generateSkipListLevel();
+
+        ASSERT_GE(level, 0);
+        ASSERT_LT(level, SKIP_LIST_HEIGHT_LIMIT);
+
+        counts[level]++;
+    }
+
+    //Each level should get half of the nodes of the one below it, only the levels with enough samples are checked
+    for (int level = 0; level < 8; level++) {
+        double expected = (double) samples / (2 << level);
+
+        EXPECT_NEAR(counts[level], expected, expected * 0.1) << "Level " << level;
+    }
+}
+
+TEST(SkipListTests, RankQueries) {
+
+    auto skipList = std::make_unique<SkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x12A4C);
+
+    for (int i = 0; i < 30000; i++) {
+
+        int key = rand() % 8000;
+
+        if (rand() % 3 == 0) {
+            skipList->remove(key);
+
+            reference.erase(key);
+        } else {
+            skipList->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        }
+
+        //Check the spans now and then while the list is changing
+        if (i % 1000 == 0) {
+            int position = 0;
+
+            for (auto &[key, value] : reference) {
+                ASSERT_EQ(*skipList->rank(key), position);
+
+                position++;
+            }
+        }
+    }
+
+    ASSERT_EQ(skipList->size(), reference.size());
+
+    unsigned int position = 0;
+
+    for (auto &[key, value] : reference) {
+        ASSERT_EQ(*skipList->rank(key), position);
+
+        auto entry = skipList->at(position);
+
+        ASSERT_EQ(*std::get<0>(*entry), key);
+        ASSERT_EQ(*std::get<1>(*entry), value);
+
+        position++;
+    }
+
+    ASSERT_FALSE(skipList->at(reference.size()));
+    ASSERT_FALSE(skipList->rank(-1));
+
+    auto range = skipList->rangeByRank(100, 199);
+
+    ASSERT_EQ(range->size(), 100);
+
+    auto iterator = std::next(reference.begin(), 100);
+
+    for (auto &entry : *range) {
+        ASSERT_EQ(*std::get<0>(entry), iterator->first);
+
+        iterator++;
+    }
+
+    //The end of the range is clamped to the end of the list
+    ASSERT_EQ(skipList->rangeByRank(reference.size() - 5, reference.size() + 100)->size(), 5);
+}
+
+/**
+ * Checks the order and the spans of the whole list against the reference
+ */
+void checkAgainstReference(SkipList<int, int> *skipList, std::map<int, int> &reference) {
+
+    ASSERT_EQ(skipList->size(), reference.size());
+
+    unsigned int position = 0;
+
+    auto iterator = skipList->begin();
+
+    for (auto &[key, value] : reference) {
+        ASSERT_TRUE(iterator.valid());
+
+        ASSERT_EQ(*iterator.key(), key);
+        ASSERT_EQ(*iterator.value(), value);
+
+        ASSERT_EQ(*skipList->rank(key), position);
+
+        iterator.next();
+
+        position++;
+    }
+
+    ASSERT_FALSE(iterator.valid());
+}
+
+TEST(SkipListTests, FingerSearch) {
+
+    auto skipList = std::make_unique<SkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x5F21);
+
+    //Timestamps with a little jitter, and every now and then a late or an early one
+    for (int i = 0; i < 20000; i++) {
+
+        int key = i * 4 + rand() % 16;
+
+        if (i % 100 == 0) key = rand() % (i * 4 + 1);
+
+        if (i % 7 == 0) {
+            skipList->remove(key - 8);
+
+            reference.erase(key - 8);
+        }
+
+        skipList->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+        reference[key] = i;
+
+        if (i % 5000 == 0) {
+            checkAgainstReference(skipList.get(), reference);
+        }
+    }
+
+    checkAgainstReference(skipList.get(), reference);
+
+    while (skipList->popSmallest()) {}
+
+    ASSERT_EQ(skipList->size(), 0);
+    ASSERT_FALSE(skipList->peekLargest());
+}
+
+TEST(SkipListTests, AddWithHint) {
+
+    auto skipList = std::make_unique<SkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    for (int i = 0; i < 1000; i++) {
+        skipList->add(std::make_shared<int>(i * 100), std::make_shared<int>(i));
+
+        reference[i * 100] = i;
+    }
+
+    auto hint = skipList->lowerBound(50000);
+
+    ASSERT_EQ(*hint.key(), 50000);
+
+    for (int i = 1; i < 2000; i++) {
+        hint = skipList->addWithHint(hint, std::make_shared<int>(50000 + i), std::make_shared<int>(-i));
+
+        ASSERT_EQ(*hint.key(), 50000 + i);
+
+        reference[50000 + i] = -i;
+    }
+
+    //Hints that are after the key, or that went stale because the list changed, still work
+    auto stale = skipList->lowerBound(90000);
+
+    skipList->remove(100);
+
+    reference.erase(100);
+
+    hint = skipList->addWithHint(stale, std::make_shared<int>(150), std::make_shared<int>(1));
+
+    reference[150] = 1;
+
+    hint = skipList->addWithHint(hint, std::make_shared<int>(42), std::make_shared<int>(2));
+
+    reference[42] = 2;
+
+    //Replacing the value of an existing key
+    hint = skipList->addWithHint(skipList->begin(), std::make_shared<int>(50010), std::make_shared<int>(3));
+
+    ASSERT_EQ(*hint.value(), 3);
+
+    reference[50010] = 3;
+
+    checkAgainstReference(skipList.get(), reference);
+}
+
+TEST(SkipListTests, AddBatch) {
+
+    auto skipList = std::make_unique<SkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    srand(0x2C9D);
+
+    for (int i = 0; i < 5000; i++) {
+        int key = rand() % 40000;
+
+        skipList->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+        reference[key] = i;
+    }
+
+    for (int round = 0; round < 10; round++) {
+
+        //Unsorted, with repeated keys and keys that are already in the list
+        std::vector<node_info<int, int>> batch;
+
+        for (int i = 0; i < 1000; i++) {
+            int key = rand() % 50000;
+
+            batch.emplace_back(std::make_shared<int>(key), std::make_shared<int>(round * 1000 + i));
+
+            reference[key] = round * 1000 + i;
+        }
+
+        skipList->addBatch(std::move(batch));
+
+        checkAgainstReference(skipList.get(), reference);
+    }
+
+    //The finger left by the batch is still usable
+    skipList->add(std::make_shared<int>(50001), std::make_shared<int>(1));
+    skipList->remove(reference.begin()->first);
+
+    reference[50001] = 1;
+    reference.erase(reference.begin());
+
+    checkAgainstReference(skipList.get(), reference);
+}
+
+TEST(SkipListTests, ConcurrentQueries) {
+
+    auto skipList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+    EXPECT_FALSE(skipList->get(1).has_value());
+    EXPECT_FALSE(skipList->hasKey(1));
+
+    skipList->add(std::make_shared<int>(1), std::make_shared<int>(1));
+
+    skipList->remove(1);
+
+    //Removing the only node must not leave the root as the last node
+    EXPECT_FALSE(skipList->peekLargest().has_value());
+
+    for (int i = 0; i < 100; i++) {
+        skipList->add(std::make_shared<int>(i * 2), std::make_shared<int>(i));
+    }
+
+    skipList->add(std::make_shared<int>(10), std::make_shared<int>(-1));
+
+    EXPECT_EQ(-1, **skipList->get(10));
+
+    auto range = skipList->rangeSearch(9, 21);
+
+    ASSERT_EQ(6, range->size());
+
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(10 + i * 2, *std::get<0>((*range)[i]));
+    }
+
+    EXPECT_EQ(100, skipList->entries()->size());
+    EXPECT_EQ(100, skipList->keys()->size());
+    EXPECT_EQ(198, *std::get<0>(*skipList->peekLargest()));
+
+    auto smallest = skipList->popSmallest(), largest = skipList->popLargest();
+
+    EXPECT_EQ(0, *std::get<0>(*smallest));
+    EXPECT_EQ(0, *std::get<1>(*smallest));
+    EXPECT_EQ(198, *std::get<0>(*largest));
+    EXPECT_EQ(99, *std::get<1>(*largest));
+    EXPECT_EQ(98u, skipList->size());
+}
+
+TEST(SkipListTests, ConcurrentStress) {
+
+    //Meant to be run under ThreadSanitizer as well, every read here happens while other threads change the list
+    const int keyCount = 512, threadCount = 4, operations = 20000;
+
+    auto skipList = std::make_unique<ConcurrentSkipList<int, int>>();
+
+    std::atomic_bool running(true);
+
+    std::vector<std::thread> writers, readers;
+
+    for (int t = 0; t < threadCount; t++) {
+        writers.emplace_back([&skipList, t]() {
+
+            unsigned int seed = t * 7919 + 1;
+
+            for (int i = 0; i < operations; i++) {
+                seed = seed * 1103515245 + 12345;
+
+                int key = (seed >> 8) % keyCount;
+
+                if ((seed >> 4) % 3 == 0) {
+                    skipList->remove(key);
+                } else {
+                    //Every value says which key it belongs to, so readers can tell a torn read
+                    skipList->add(std::make_shared<int>(key), std::make_shared<int>(key * threadCount + t));
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < 2; t++) {
+        readers.emplace_back([&skipList, &running]() {
+            do {
+                for (int key = 0; key < keyCount; key += 7) {
+                    auto value = skipList->get(key);
+
+                    if (value) {
+                        ASSERT_EQ(key, **value / threadCount);
+                    }
+                }
+
+                auto range = skipList->rangeSearch(keyCount / 4, keyCount / 2);
+
+                for (size_t i = 0; i < range->size(); i++) {
+                    int key = *std::get<0>((*range)[i]);
+
+                    ASSERT_TRUE(key >= keyCount / 4 && key <= keyCount / 2);
+                    ASSERT_EQ(key, *std::get<1>((*range)[i]) / threadCount);
+
+                    if (i > 0) {
+                        ASSERT_LT(*std::get<0>((*range)[i - 1]), key);
+                    }
+                }
+
+                auto smallest = skipList->peekSmallest();
+
+                if (smallest) {
+                    ASSERT_EQ(*std::get<0>(*smallest), *std::get<1>(*smallest) / threadCount);
+                }
+            } while (running.load());
+        });
+    }
+
+    for (auto &writer : writers) {
+        writer.join();
+    }
+
+    running.store(false);
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    auto entries = skipList->entries();
+
+    EXPECT_EQ(skipList->size(), entries->size());
+
+    for (auto &entry : *entries) {
+        EXPECT_TRUE(skipList->hasKey(*std::get<0>(entry)));
+    }
+}
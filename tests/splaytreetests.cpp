@@ -0,0 +1,210 @@
+#include "gtest/gtest.h"
+#include "../trees/splaytree.h"
+
+#define SPLAY_TEST_SIZE 10000
+
+bool verifyParentsAndOrder(TreeNode<int, int> *root) {
+
+    if (root == nullptr) return true;
+
+    auto *left = root->getLeftChild(), *right = root->getRightChild();
+
+    if (left != nullptr) {
+        if (left->getParent() != root || *left->getKeyVal() >= *root->getKeyVal()) return false;
+
+        if (!verifyParentsAndOrder(left)) return false;
+    }
+
+    if (right != nullptr) {
+        if (right->getParent() != root || *right->getKeyVal() <= *root->getKeyVal()) return false;
+
+        if (!verifyParentsAndOrder(right)) return false;
+    }
+
+    return true;
+}
+
+int getDepth(TreeNode<int, int> *root, int key) {
+
+    int depth = 0;
+
+    while (root != nullptr && *root->getKeyVal() != key) {
+        root = key < *root->getKeyVal() ? root->getLeftChild() : root->getRightChild();
+
+        depth++;
+    }
+
+    return depth;
+}
+
+TEST(SplayTests, TopDownSplayToRoot) {
+
+    auto map = std::make_unique<SplayTree<int, int>>(TOP_DOWN);
+
+    auto value = std::make_shared<int>(42);
+
+    for (int i = 0; i < 100; i++) {
+        map->add(std::make_shared<int>((i * 37) % 100), value);
+
+        ASSERT_EQ(*map->getRoot()->getKeyVal(), (i * 37) % 100);
+    }
+
+    ASSERT_TRUE(map->hasKey(50));
+    ASSERT_EQ(*map->getRoot()->getKeyVal(), 50);
+
+    ASSERT_TRUE(map->get(3));
+    ASSERT_EQ(*map->getRoot()->getKeyVal(), 3);
+
+    ASSERT_FALSE(map->hasKey(1000));
+    ASSERT_EQ(*map->getRoot()->getKeyVal(), 99);
+
+    ASSERT_TRUE(verifyParentsAndOrder(map->getRoot()));
+}
+
+TEST(SplayTests, SemiSplayHalvesDepth) {
+
+    //Don't restructure anything while inserting, so sequential inserts leave a path
+    auto map = std::make_unique<SplayTree<int, int>>(SEMI_SPLAY, 1000);
+
+    auto value = std::make_shared<int>(42);
+
+    for (int i = 0; i < 100; i++) {
+        map->add(std::make_shared<int>(i), value);
+    }
+
+    ASSERT_EQ(getDepth(map->getRoot(), 99), 99);
+
+    map->setSemiSplayDepth(10);
+
+    map->hasKey(99);
+
+    int depthLimited = getDepth(map->getRoot(), 99);
+
+    ASSERT_LT(depthLimited, 99);
+
+    //The top levels were not touched
+    ASSERT_EQ(*map->getRoot()->getKeyVal(), 0);
+    ASSERT_TRUE(verifyParentsAndOrder(map->getRoot()));
+
+    map->setSemiSplayDepth(0);
+
+    map->hasKey(99);
+
+    int depthAfter = getDepth(map->getRoot(), 99);
+
+    ASSERT_LT(depthAfter, depthLimited);
+    ASSERT_GT(depthAfter, 0);
+
+    ASSERT_TRUE(verifyParentsAndOrder(map->getRoot()));
+}
+
+/**
+ * The nodes in the top levels of the tree, level by level, with nulls where a level has no node
+ */
+std::vector<TreeNode<int, int> *> getTopLevels(TreeNode<int, int> *root, unsigned int levels) {
+
+    std::vector<TreeNode<int, int> *> nodes{root};
+
+    for (size_t start = 0, level = 1; level < levels; level++) {
+
+        size_t end = nodes.size();
+
+        for (size_t i = start; i < end; i++) {
+            nodes.push_back(nodes[i] == nullptr ? nullptr : nodes[i]->getLeftChild());
+            nodes.push_back(nodes[i] == nullptr ? nullptr : nodes[i]->getRightChild());
+        }
+
+        start = end;
+    }
+
+    return nodes;
+}
+
+TEST(SplayTests, SemiSplayKeepsTopLevels) {
+
+    const unsigned int keptLevels = 4;
+
+    //A random tree, nothing is restructured while inserting
+    auto map = std::make_unique<SplayTree<int, int>>(SEMI_SPLAY, 1000);
+
+    auto value = std::make_shared<int>(42);
+
+    for (int i = 0; i < 1000; i++) {
+        map->add(std::make_shared<int>((i * 7919) % 1000), value);
+    }
+
+    map->setSemiSplayDepth(keptLevels);
+
+    //Deep keys at both parities of depth, so the last step of the splay lands on either side of the limit
+    int deepest[2] = {-1, -1};
+
+    for (int key = 0; key < 1000; key++) {
+        int depth = getDepth(map->getRoot(), key);
+
+        if (deepest[depth % 2] < 0 || depth > getDepth(map->getRoot(), deepest[depth % 2])) {
+            deepest[depth % 2] = key;
+        }
+    }
+
+    for (int key : deepest) {
+        ASSERT_GE(key, 0);
+
+        int depthBefore = getDepth(map->getRoot(), key);
+
+        auto topBefore = getTopLevels(map->getRoot(), keptLevels);
+
+        ASSERT_TRUE(map->hasKey(key));
+
+        EXPECT_LT(getDepth(map->getRoot(), key), depthBefore);
+        EXPECT_GE(getDepth(map->getRoot(), key), (int) keptLevels);
+
+        EXPECT_EQ(topBefore, getTopLevels(map->getRoot(), keptLevels));
+
+        ASSERT_TRUE(verifyParentsAndOrder(map->getRoot()));
+    }
+}
+
+TEST(SplayTests, AllModesInsertRemovePop) {
+
+    auto value = std::make_shared<int>(42);
+
+    for (SplayMode mode : {BOTTOM_UP, TOP_DOWN, SEMI_SPLAY}) {
+
+        auto map = std::make_unique<SplayTree<int, int>>(mode);
+
+        for (int i = 0; i < SPLAY_TEST_SIZE; i++) {
+            map->add(std::make_shared<int>((i * 7919) % SPLAY_TEST_SIZE), std::make_shared<int>(i));
+        }
+
+        ASSERT_EQ(map->size(), SPLAY_TEST_SIZE);
+
+        ASSERT_TRUE(verifyParentsAndOrder(map->getRoot()));
+
+        for (int i = 0; i < SPLAY_TEST_SIZE; i += 2) {
+            ASSERT_TRUE(map->remove(i));
+
+            ASSERT_FALSE(map->hasKey(i));
+        }
+
+        ASSERT_FALSE(map->remove(0));
+
+        ASSERT_TRUE(verifyParentsAndOrder(map->getRoot()));
+
+        for (int i = 1; i < SPLAY_TEST_SIZE / 2; i += 2) {
+            auto smallest = map->popSmallest();
+
+            ASSERT_TRUE(smallest);
+            ASSERT_EQ(*std::get<0>(*smallest), i);
+        }
+
+        for (int i = SPLAY_TEST_SIZE - 1; i >= SPLAY_TEST_SIZE / 2; i -= 2) {
+            auto largest = map->popLargest();
+
+            ASSERT_TRUE(largest);
+            ASSERT_EQ(*std::get<0>(*largest), i);
+        }
+
+        ASSERT_EQ(map->size(), 0);
+        ASSERT_FALSE(map->peekSmallest());
+    }
+}
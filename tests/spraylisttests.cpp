@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+#include "../probabilisticlist/spraylist.h"
+#include <set>
+#include <thread>
+
+#define SPRAY_THREAD_COUNT 4
+#define SPRAY_KEY_COUNT 20000
+
+TEST(SprayListTests, PopsEveryKeyOnce) {
+
+    auto list = std::make_unique<SprayList<int, int>>(SPRAY_THREAD_COUNT);
+
+    for (int i = 0; i < SPRAY_KEY_COUNT; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i * 2));
+    }
+
+    std::set<int> popped;
+
+    while (true) {
+        auto result = list->popSmallest();
+
+        if (!result) break;
+
+        int key = *std::get<0>(*result);
+
+        EXPECT_EQ(key * 2, *std::get<1>(*result));
+
+        EXPECT_TRUE(popped.insert(key).second);
+    }
+
+    EXPECT_EQ(SPRAY_KEY_COUNT, popped.size());
+    EXPECT_EQ(0, list->size());
+}
+
+TEST(SprayListTests, PopsAreNearTheSmallest) {
+
+    auto list = std::make_unique<SprayList<int, int>>(SPRAY_THREAD_COUNT);
+
+    for (int i = 0; i < SPRAY_KEY_COUNT; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    long totalRank = 0;
+
+    std::set<int> remaining;
+
+    for (int i = 0; i < SPRAY_KEY_COUNT; i++) {
+        remaining.insert(i);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        auto result = list->popSmallest();
+
+        ASSERT_TRUE(result.has_value());
+
+        int key = *std::get<0>(*result);
+
+        //How many keys smaller than the popped one are still in the list
+        totalRank += std::distance(remaining.begin(), remaining.find(key));
+
+        remaining.erase(key);
+    }
+
+    //The spray only covers the first few hundred keys, an exact queue would have a rank of 0
+    EXPECT_LT(totalRank / 1000, 500);
+}
+
+TEST(SprayListTests, SingleThreadIsExact) {
+
+    auto list = std::make_unique<SprayList<int, int>>(1);
+
+    for (int i = 0; i < 1000; i++) {
+        list->add(std::make_shared<int>(999 - i), std::make_shared<int>(i));
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(i, *std::get<0>(*list->popSmallest()));
+    }
+
+    EXPECT_FALSE(list->popSmallest().has_value());
+}
+
+TEST(SprayListTests, ConcurrentPops) {
+
+    auto list = std::make_unique<SprayList<int, int>>(SPRAY_THREAD_COUNT);
+
+    for (int i = 0; i < SPRAY_KEY_COUNT; i++) {
+        list->add(std::make_shared<int>(i), std::make_shared<int>(i));
+    }
+
+    std::vector<std::vector<int>> popped(SPRAY_THREAD_COUNT);
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < SPRAY_THREAD_COUNT; t++) {
+        threads.emplace_back([&list, &popped, t]() {
+            while (true) {
+                auto result = list->popSmallest();
+
+                if (!result) break;
+
+                popped[t].push_back(*std::get<0>(*result));
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::set<int> allPopped;
+
+    size_t total = 0;
+
+    for (auto &keys : popped) {
+        total += keys.size();
+
+        allPopped.insert(keys.begin(), keys.end());
+    }
+
+    //Every key was popped by exactly one thread
+    EXPECT_EQ(SPRAY_KEY_COUNT, total);
+    EXPECT_EQ(SPRAY_KEY_COUNT, allPopped.size());
+}
+
+TEST(SprayListTests, ConcurrentAddAndPop) {
+
+    auto list = std::make_unique<SprayList<int, int>>(SPRAY_THREAD_COUNT);
+
+    std::atomic_int poppedCount(0);
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < SPRAY_THREAD_COUNT; t++) {
+        threads.emplace_back([&list, &poppedCount, t]() {
+            for (int i = 0; i < SPRAY_KEY_COUNT / SPRAY_THREAD_COUNT; i++) {
+                list->add(std::make_shared<int>(i * SPRAY_THREAD_COUNT + t), std::make_shared<int>(i));
+
+                if (i % 2 == 1 && list->popSmallest()) {
+                    poppedCount++;
+                }
+            }
+        });
+    }
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(SPRAY_KEY_COUNT, poppedCount.load() + list->size());
+}
@@ -0,0 +1,256 @@
+#include "gtest/gtest.h"
+#include "../storage/sstable.h"
+#include "../probabilisticlist/skiplist.h"
+#include "temporarydirectory.h"
+#include <fstream>
+#include <map>
+#include <random>
+
+template<typename T>
+void expectTableEntries(const std::map<T, T> &reference, const std::vector<node_info<T, T>> &entries) {
+
+    ASSERT_EQ(reference.size(), entries.size());
+
+    auto expected = reference.begin();
+
+    for (auto &entry : entries) {
+        ASSERT_EQ(expected->first, *std::get<0>(entry));
+        ASSERT_EQ(expected->second, *std::get<1>(entry));
+
+        expected++;
+    }
+}
+
+TEST(SSTableTests, MatchesMap) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    auto map = std::make_unique<SkipList<int, int>>();
+
+    std::map<int, int> reference;
+
+    std::mt19937 random(0x55);
+
+    //Negative keys too, their encoding has to keep them before the positive ones
+    for (int i = 0; i < 50000; i++) {
+        int key = (int) (random() % 400000) - 200000;
+
+        map->add(std::make_shared<int>(key), std::make_shared<int>(i));
+
+        reference[key] = i;
+    }
+
+    SSTableWriter<int, int>::write(path, map.get(), SSTABLE_BLOCK_SIZE, 10);
+
+    SSTable<int, int> table(path, true);
+
+    EXPECT_EQ(reference.size(), table.size());
+    EXPECT_TRUE(table.verify());
+
+    expectTableEntries(reference, *table.entries());
+
+    for (int key = -200000; key < 200000; key += 7) {
+        auto value = table.get(key);
+
+        auto expected = reference.find(key);
+
+        ASSERT_EQ(expected != reference.end(), value.has_value());
+
+        if (value) {
+            ASSERT_EQ(expected->second, **value);
+        }
+    }
+
+    for (int base = -200000; base < 200000; base += 33333) {
+        std::map<int, int> expected(reference.lower_bound(base), reference.upper_bound(base + 5000));
+
+        expectTableEntries(expected, *table.rangeSearch(base, base + 5000));
+    }
+
+    EXPECT_EQ(reference.begin()->first, *std::get<0>(*table.peekSmallest()));
+    EXPECT_EQ(reference.rbegin()->first, *std::get<0>(*table.peekLargest()));
+}
+
+TEST(SSTableTests, StringKeysArePrefixCompressed) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    std::map<std::string, std::string> reference;
+
+    size_t rawBytes = 0;
+
+    for (int i = 0; i < 20000; i++) {
+        std::string key = "tenant:00042:user:" + std::to_string(1000000 + i);
+
+        reference[key] = std::to_string(i);
+
+        rawBytes += key.size() + reference[key].size();
+    }
+
+    //Zero bytes and keys that are prefixes of other keys have to survive the encoding
+    reference[std::string("tenant\0zero", 11)] = "zero";
+    reference["tenant"] = "prefix";
+
+    //Small blocks, so the keys spread over many of them
+    SSTableWriter<std::string, std::string> writer(path, 512, 10);
+
+    for (auto &[key, value] : reference) {
+        writer.add(key, value);
+    }
+
+    writer.finish();
+
+    SSTable<std::string, std::string> table(path);
+
+    expectTableEntries(reference, *table.entries());
+
+    EXPECT_EQ("zero", **table.get(std::string("tenant\0zero", 11)));
+    EXPECT_EQ("prefix", **table.get("tenant"));
+    EXPECT_FALSE(table.hasKey("tenan"));
+    EXPECT_FALSE(table.hasKey(std::string("tenant\0", 7)));
+
+    //The shared prefixes are only stored once per block
+    struct stat status{};
+
+    ::stat(path.c_str(), &status);
+
+    EXPECT_LT((size_t) status.st_size, rawBytes);
+}
+
+TEST(SSTableTests, RejectsUnsortedKeys) {
+
+    TemporaryDirectory directory;
+
+    SSTableWriter<int, int> writer(directory.getPath() + "/table");
+
+    writer.add(2, 2);
+
+    EXPECT_THROW(writer.add(2, 2), std::invalid_argument);
+    EXPECT_THROW(writer.add(1, 1), std::invalid_argument);
+}
+
+TEST(SSTableTests, EmptyTable) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    SSTableWriter<int, int>(path).finish();
+
+    SSTable<int, int> table(path);
+
+    EXPECT_EQ(0u, table.size());
+    EXPECT_FALSE(table.hasKey(0));
+    EXPECT_FALSE(table.peekSmallest().has_value());
+    EXPECT_TRUE(table.entries()->empty());
+}
+
+TEST(SSTableTests, DetectsCorruption) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    SSTableWriter<int, int> writer(path);
+
+    for (int i = 0; i < 10000; i++) {
+        writer.add(i, i);
+    }
+
+    writer.finish();
+
+    //Flip a byte in the middle of the first block
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+
+        file.seekp(100);
+
+        file.put((char) 0x5A);
+    }
+
+    {
+        SSTable<int, int> table(path, true);
+
+        EXPECT_FALSE(table.verify());
+        EXPECT_THROW(table.get(1), std::runtime_error);
+    }
+
+    //A table that was cut short is refused when it's opened
+    ASSERT_EQ(0, ::truncate(path.c_str(), 5000));
+
+    typedef SSTable<int, int> IntTable;
+
+    EXPECT_THROW(IntTable table(path), std::runtime_error);
+}
+
+TEST(SSTableTests, OddBlockSize) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    std::map<int, int> reference;
+
+    {
+        //The blocks end at offsets that aren't aligned, the index after them still has to be
+        SSTableWriter<int, int> writer(path, 100, 10);
+
+        for (int i = 0; i < 1000; i++) {
+            writer.add(i * 3, i);
+
+            reference[i * 3] = i;
+        }
+
+        writer.finish();
+    }
+
+    SSTable<int, int> table(path, true);
+
+    EXPECT_TRUE(table.verify());
+    EXPECT_EQ(1000u, table.size());
+    EXPECT_EQ(300, **table.get(900));
+    EXPECT_FALSE(table.hasKey(901));
+
+    expectTableEntries(reference, *table.entries());
+
+    typedef SSTableWriter<int, int> IntWriter;
+
+    EXPECT_THROW(IntWriter(directory.getPath() + "/empty", 0), std::invalid_argument);
+}
+
+TEST(SSTableTests, CorruptBlocksAreNotReadPast) {
+
+    TemporaryDirectory directory;
+
+    std::string path = directory.getPath() + "/table";
+
+    SSTableWriter<int, int> writer(path);
+
+    for (int i = 0; i < 10000; i++) {
+        writer.add(i, i);
+    }
+
+    writer.finish();
+
+    //Varints that never end, right at the start of the first block
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+
+        file.seekp(0);
+
+        for (int i = 0; i < 64; i++) {
+            file.put((char) 0xFF);
+        }
+    }
+
+    //Without verifyChecksums the block isn't checksummed, but it's still not parsed past its end
+    SSTable<int, int> table(path);
+
+    EXPECT_THROW(table.entries(), std::runtime_error);
+    EXPECT_THROW(table.peekSmallest(), std::runtime_error);
+    EXPECT_EQ(9999, **table.get(9999));
+}
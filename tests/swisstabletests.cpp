@@ -0,0 +1,145 @@
+#include "gtest/gtest.h"
+#include "../hashtables/swisstable.h"
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+template<typename H>
+void checkSetAgainstReference() {
+
+    auto set = std::make_unique<SwissSet<int, H>>();
+
+    std::unordered_set<int> reference;
+
+    std::mt19937 random(0x5155);
+
+    for (int i = 0; i < 200000; i++) {
+
+        //The range of the keys grows, so the table has to grow with it
+        int key = (int) (random() % (1000 + i / 4));
+
+        int operation = (int) (random() % 3);
+
+        if (operation == 0) {
+            set->add(key);
+
+            reference.insert(key);
+        } else if (operation == 1) {
+            auto removed = set->remove(key);
+
+            ASSERT_EQ(reference.erase(key) == 1, removed != nullptr);
+
+            if (removed != nullptr) {
+                EXPECT_EQ(key, *removed);
+            }
+        } else {
+            ASSERT_EQ(reference.count(key) == 1, set->contains(key));
+        }
+
+        ASSERT_EQ(reference.size(), set->size());
+    }
+
+    for (int key : reference) {
+        ASSERT_EQ(key, *set->find(key));
+    }
+
+    EXPECT_EQ(nullptr, set->find(-1));
+}
+
+TEST(SwissTableTests, SetOperations) {
+    checkSetAgainstReference<MurmurHash>();
+    checkSetAgainstReference<SpookyHashImpl>();
+}
+
+TEST(SwissTableTests, TombstonesDontGrowTheTable) {
+
+    auto set = std::make_unique<SwissSet<long>>();
+
+    //The same amount of keys, but always new ones, leaves a trail of removed slots
+    for (long i = 0; i < 1000000; i++) {
+        set->add(i);
+
+        if (i >= 1000) {
+            ASSERT_NE(nullptr, set->remove(i - 1000));
+        }
+    }
+
+    EXPECT_EQ(1000, set->size());
+    EXPECT_LE(set->capacity(), 4096);
+
+    for (long i = 1000000 - 1000; i < 1000000; i++) {
+        ASSERT_TRUE(set->contains(i));
+    }
+}
+
+TEST(SwissTableTests, StringKeys) {
+
+    auto set = std::make_unique<SwissSet<std::string>>(5000);
+
+    size_t capacity = set->capacity();
+
+    for (int i = 0; i < 5000; i++) {
+        set->add("key number " + std::to_string(i));
+    }
+
+    //The expected size was enough, no rehash was needed
+    EXPECT_EQ(capacity, set->capacity());
+    EXPECT_EQ(5000, set->size());
+
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_TRUE(set->contains("key number " + std::to_string(i)));
+    }
+
+    EXPECT_FALSE(set->contains("key number 5000"));
+    EXPECT_FALSE(set->contains(""));
+}
+
+TEST(SwissTableTests, MapOperations) {
+
+    auto map = std::make_unique<SwissMap<std::string, int>>();
+
+    std::unordered_map<std::string, int> reference;
+
+    std::mt19937 random(0x3A9);
+
+    for (int i = 0; i < 100000; i++) {
+
+        std::string key = std::to_string(random() % 5000);
+
+        if (random() % 3 == 0) {
+            auto removed = map->remove(key);
+
+            auto expected = reference.find(key);
+
+            ASSERT_EQ(expected != reference.end(), removed.has_value());
+
+            if (removed) {
+                EXPECT_EQ(expected->second, **removed);
+
+                reference.erase(expected);
+            }
+        } else {
+            map->add(std::make_shared<std::string>(key), std::make_shared<int>(i));
+
+            reference[key] = i;
+        }
+    }
+
+    ASSERT_EQ(reference.size(), map->size());
+
+    for (auto &[key, value] : reference) {
+        ASSERT_TRUE(map->hasKey(key));
+        ASSERT_EQ(value, **map->get(key));
+    }
+
+    auto entries = map->entries();
+
+    ASSERT_EQ(reference.size(), entries->size());
+
+    for (auto &entry : *entries) {
+        EXPECT_EQ(reference[*std::get<0>(entry)], *std::get<1>(entry));
+    }
+
+    EXPECT_EQ(reference.size(), map->keys()->size());
+    EXPECT_EQ(reference.size(), map->values()->size());
+}
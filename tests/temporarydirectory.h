@@ -0,0 +1,43 @@
+#ifndef TRABALHO1_TEMPORARYDIRECTORY_H
+#define TRABALHO1_TEMPORARYDIRECTORY_H
+
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+
+/**
+ * A new empty directory under /tmp, removed with everything in it when the test ends
+ */
+class TemporaryDirectory {
+
+private:
+    std::string path;
+
+public:
+    TemporaryDirectory() {
+
+        char name[] = "/tmp/trabalho1XXXXXX";
+
+        this->path = ::mkdtemp(name);
+    }
+
+    ~TemporaryDirectory() {
+
+        DIR *dir = ::opendir(this->path.c_str());
+
+        while (struct dirent *entry = ::readdir(dir)) {
+            ::unlink((this->path + "/" + entry->d_name).c_str());
+        }
+
+        ::closedir(dir);
+
+        ::rmdir(this->path.c_str());
+    }
+
+    const std::string &getPath() const {
+        return this->path;
+    }
+};
+
+#endif //TRABALHO1_TEMPORARYDIRECTORY_H
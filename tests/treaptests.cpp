@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "../trees/treaps.h"
+#include <set>
 
 bool verifyHeapProperty(TreapNode<int, int> *root) {
 
@@ -75,3 +76,33 @@ TEST(TreapTests, VerifyHeapProperty) {
 
 
 }
+
+TEST(TreapTests, AddWithHint) {
+
+    std::unique_ptr<Treap<int, int>> map = std::make_unique<Treap<int, int>>();
+
+    std::set<int> reference;
+
+    TreeNode<int, int> *hint = nullptr;
+
+    srand(0x1B77);
+
+    for (int i = 0; i < 5000; i++) {
+
+        int key = i % 50 == 0 ? rand() % (i * 4 + 1) : i * 4 + rand() % 16;
+
+        hint = map->addWithHint(hint, std::make_shared<int>(key), std::make_shared<int>(i));
+
+        ASSERT_EQ(*hint->getKeyVal(), key);
+
+        reference.insert(key);
+    }
+
+    ASSERT_EQ(map->size(), reference.size());
+
+    ASSERT_TRUE(verifyHeapProperty((TreapNode<int, int> *) map->getRoot()));
+
+    for (int key : reference) {
+        ASSERT_TRUE(map->hasKey(key));
+    }
+}
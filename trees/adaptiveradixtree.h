@@ -0,0 +1,1083 @@
+#ifndef TRABALHO1_ADAPTIVERADIXTREE_H
+#define TRABALHO1_ADAPTIVERADIXTREE_H
+
+#include "../datastructures.h"
+#include "radixkey.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//How many bytes of a compressed path are kept in the inner node. Longer paths are checked against one of the leaves
+#define ART_MAX_PREFIX 8
+
+enum ArtNodeType : uint8_t {
+    ART_LEAF, ART_NODE4, ART_NODE16, ART_NODE48, ART_NODE256
+};
+
+/*
+ * The nodes are plain structs, the tree works on their arrays directly and tells them apart by their type
+ */
+
+struct ArtNode {
+
+    ArtNodeType type;
+
+    explicit ArtNode(ArtNodeType type) : type(type) {}
+};
+
+struct ArtInnerNode : public ArtNode {
+
+    uint16_t childCount;
+
+    //The length of the whole compressed path, only the first ART_MAX_PREFIX bytes of it are in prefix
+    uint32_t prefixLength;
+
+    uint8_t prefix[ART_MAX_PREFIX];
+
+    explicit ArtInnerNode(ArtNodeType type) : ArtNode(type), childCount(0), prefixLength(0), prefix() {}
+};
+
+/**
+ * Up to 4 children, with their key bytes sorted
+ */
+struct ArtNode4 : public ArtInnerNode {
+
+    uint8_t keys[4];
+
+    ArtNode *children[4];
+
+    ArtNode4() : ArtInnerNode(ART_NODE4), keys(), children() {}
+};
+
+/**
+ * Up to 16 children, with their key bytes sorted. The 16 key bytes are compared at once with SIMD
+ */
+struct ArtNode16 : public ArtInnerNode {
+
+    uint8_t keys[16];
+
+    ArtNode *children[16];
+
+    ArtNode16() : ArtInnerNode(ART_NODE16), keys(), children() {}
+};
+
+/**
+ * Up to 48 children, indexed by key byte. Each byte has the position of its child plus one, zero if there is none
+ */
+struct ArtNode48 : public ArtInnerNode {
+
+    uint8_t childIndex[256];
+
+    ArtNode *children[48];
+
+    ArtNode48() : ArtInnerNode(ART_NODE48), childIndex(), children() {}
+};
+
+struct ArtNode256 : public ArtInnerNode {
+
+    ArtNode *children[256];
+
+    ArtNode256() : ArtInnerNode(ART_NODE256), children() {}
+};
+
+template<typename T, typename V>
+struct ArtLeaf : public ArtNode {
+
+    std::string keyBytes;
+
+    std::shared_ptr<T> key;
+
+    std::shared_ptr<V> value;
+
+    ArtLeaf(std::string keyBytes, std::shared_ptr<T> key, std::shared_ptr<V> value) : ArtNode(ART_LEAF),
+                                                                                       keyBytes(std::move(keyBytes)),
+                                                                                       key(std::move(key)),
+                                                                                       value(std::move(value)) {}
+};
+
+/**
+ * Adaptive radix tree (Leis et al. "The Adaptive Radix Tree: ARTful Indexing for Main-Memory Databases").
+ *
+ * The keys are turned into their binary comparable encoding (See RadixKey) and the tree branches on one byte of it per
+ * level, so a lookup costs O(key length) no matter how many keys there are, and never compares two whole keys until
+ * it reaches the leaf. Inner nodes grow and shrink between 4, 16, 48 and 256 children to keep the memory use low, and
+ * chains of nodes with a single child are collapsed into a prefix stored in the node below them (Path compression).
+ * Only ART_MAX_PREFIX bytes of each prefix are stored: lookups skip the rest and check the whole key in the leaf,
+ * changes read the missing bytes from a leaf of the node.
+ *
+ * The order of the encoded keys is the order of the keys, so the map stays ordered.
+ */
+template<typename T, typename V>
+class AdaptiveRadixTree : public OrderedMap<T, V> {
+
+private:
+    typedef ArtLeaf<T, V> Leaf;
+
+    ArtNode *root;
+
+    unsigned int treeSize;
+
+    static std::string encode(const T &key) {
+
+        std::string bytes;
+
+        RadixKey<T>::encode(key, bytes);
+
+        return bytes;
+    }
+
+    static uint8_t byteAt(const std::string &bytes, uint32_t depth) {
+        return (uint8_t) bytes[depth];
+    }
+
+    static ArtNode **findChild(ArtInnerNode *node, uint8_t byte) {
+
+        switch (node->type) {
+            case ART_NODE4: {
+                auto *node4 = static_cast<ArtNode4 *>(node);
+
+                for (int i = 0; i < node4->childCount; i++) {
+                    if (node4->keys[i] == byte) return &node4->children[i];
+                }
+
+                return nullptr;
+            }
+            case ART_NODE16: {
+                auto *node16 = static_cast<ArtNode16 *>(node);
+#if defined(__SSE2__)
+                __m128i matches = _mm_cmpeq_epi8(_mm_set1_epi8((char) byte),
+                                                 _mm_loadu_si128((const __m128i *) node16->keys));
+
+                //Only the bits of the keys that are in use
+                int mask = _mm_movemask_epi8(matches) & ((1 << node16->childCount) - 1);
+
+                return mask == 0 ? nullptr : &node16->children[__builtin_ctz(mask)];
+#else
+                for (int i = 0; i < node16->childCount; i++) {
+                    if (node16->keys[i] == byte) return &node16->children[i];
+                }
+
+                return nullptr;
+#endif
+            }
+            case ART_NODE48: {
+                auto *node48 = static_cast<ArtNode48 *>(node);
+
+                int index = node48->childIndex[byte];
+
+                return index == 0 ? nullptr : &node48->children[index - 1];
+            }
+            default: {
+                auto *node256 = static_cast<ArtNode256 *>(node);
+
+                return node256->children[byte] == nullptr ? nullptr : &node256->children[byte];
+            }
+        }
+    }
+
+    /**
+     * The child with the smallest key byte that is >= from
+     * @param byte Gets the key byte of the child
+     * @return Null if there is no such child
+     */
+    static ArtNode *childFrom(ArtInnerNode *node, int from, int &byte) {
+
+        switch (node->type) {
+            case ART_NODE4:
+            case ART_NODE16: {
+                //Both keep their key bytes sorted in the same place
+                const uint8_t *keys = node->type == ART_NODE4 ? static_cast<ArtNode4 *>(node)->keys
+                                                              : static_cast<ArtNode16 *>(node)->keys;
+
+                ArtNode **children = node->type == ART_NODE4 ? static_cast<ArtNode4 *>(node)->children
+                                                             : static_cast<ArtNode16 *>(node)->children;
+
+                for (int i = 0; i < node->childCount; i++) {
+                    if (keys[i] >= from) {
+                        byte = keys[i];
+
+                        return children[i];
+                    }
+                }
+
+                return nullptr;
+            }
+            case ART_NODE48: {
+                auto *node48 = static_cast<ArtNode48 *>(node);
+
+                for (int i = from; i < 256; i++) {
+                    if (node48->childIndex[i] != 0) {
+                        byte = i;
+
+                        return node48->children[node48->childIndex[i] - 1];
+                    }
+                }
+
+                return nullptr;
+            }
+            default: {
+                auto *node256 = static_cast<ArtNode256 *>(node);
+
+                for (int i = from; i < 256; i++) {
+                    if (node256->children[i] != nullptr) {
+                        byte = i;
+
+                        return node256->children[i];
+                    }
+                }
+
+                return nullptr;
+            }
+        }
+    }
+
+    static ArtNode *lastChild(ArtInnerNode *node) {
+
+        switch (node->type) {
+            case ART_NODE4:
+                return static_cast<ArtNode4 *>(node)->children[node->childCount - 1];
+            case ART_NODE16:
+                return static_cast<ArtNode16 *>(node)->children[node->childCount - 1];
+            case ART_NODE48: {
+                auto *node48 = static_cast<ArtNode48 *>(node);
+
+                for (int i = 255; i >= 0; i--) {
+                    if (node48->childIndex[i] != 0) return node48->children[node48->childIndex[i] - 1];
+                }
+
+                return nullptr;
+            }
+            default: {
+                auto *node256 = static_cast<ArtNode256 *>(node);
+
+                for (int i = 255; i >= 0; i--) {
+                    if (node256->children[i] != nullptr) return node256->children[i];
+                }
+
+                return nullptr;
+            }
+        }
+    }
+
+    static Leaf *minimum(ArtNode *node) {
+
+        int byte;
+
+        while (node != nullptr && node->type != ART_LEAF) {
+            node = childFrom(static_cast<ArtInnerNode *>(node), 0, byte);
+        }
+
+        return static_cast<Leaf *>(node);
+    }
+
+    static Leaf *maximum(ArtNode *node) {
+
+        while (node != nullptr && node->type != ART_LEAF) {
+            node = lastChild(static_cast<ArtInnerNode *>(node));
+        }
+
+        return static_cast<Leaf *>(node);
+    }
+
+    static void copyHeader(ArtInnerNode *destination, const ArtInnerNode *source) {
+
+        destination->childCount = source->childCount;
+        destination->prefixLength = source->prefixLength;
+
+        memcpy(destination->prefix, source->prefix, ART_MAX_PREFIX);
+    }
+
+    /**
+     * How many bytes of the stored part of the prefix match the key, the rest of the prefix isn't checked
+     */
+    static uint32_t checkPrefix(const ArtInnerNode *node, const std::string &key, uint32_t depth) {
+
+        uint32_t length = std::min(node->prefixLength, (uint32_t) ART_MAX_PREFIX);
+
+        if (depth + length > key.size()) {
+            length = key.size() > depth ? key.size() - depth : 0;
+        }
+
+        uint32_t i = 0;
+
+        while (i < length && node->prefix[i] == byteAt(key, depth + i)) {
+            i++;
+        }
+
+        return i;
+    }
+
+    /**
+     * How many bytes of the whole prefix match the key, reading the bytes that aren't stored from a leaf
+     */
+    static uint32_t prefixMismatch(ArtInnerNode *node, const std::string &key, uint32_t depth) {
+
+        uint32_t matched = checkPrefix(node, key, depth);
+
+        if (matched < ART_MAX_PREFIX || node->prefixLength <= ART_MAX_PREFIX) {
+            return matched;
+        }
+
+        //Every leaf below the node has the whole prefix
+        const std::string &leafKey = minimum(node)->keyBytes;
+
+        uint32_t length = std::min(node->prefixLength, (uint32_t) std::min(leafKey.size(), key.size()) - depth);
+
+        while (matched < length && leafKey[depth + matched] == key[depth + matched]) {
+            matched++;
+        }
+
+        return matched;
+    }
+
+    static void addChild4(ArtNode4 *node, uint8_t byte, ArtNode *child) {
+
+        int position = 0;
+
+        while (position < node->childCount && node->keys[position] < byte) {
+            position++;
+        }
+
+        memmove(node->keys + position + 1, node->keys + position, node->childCount - position);
+        memmove(node->children + position + 1, node->children + position,
+                (node->childCount - position) * sizeof(ArtNode *));
+
+        node->keys[position] = byte;
+        node->children[position] = child;
+
+        node->childCount++;
+    }
+
+    static void addChild16(ArtNode16 *node, uint8_t byte, ArtNode *child) {
+
+        int position = 0;
+
+        while (position < node->childCount && node->keys[position] < byte) {
+            position++;
+        }
+
+        memmove(node->keys + position + 1, node->keys + position, node->childCount - position);
+        memmove(node->children + position + 1, node->children + position,
+                (node->childCount - position) * sizeof(ArtNode *));
+
+        node->keys[position] = byte;
+        node->children[position] = child;
+
+        node->childCount++;
+    }
+
+    static void addChild48(ArtNode48 *node, uint8_t byte, ArtNode *child) {
+
+        int slot = 0;
+
+        while (node->children[slot] != nullptr) {
+            slot++;
+        }
+
+        node->children[slot] = child;
+        node->childIndex[byte] = (uint8_t) (slot + 1);
+
+        node->childCount++;
+    }
+
+    static void addChild256(ArtNode256 *node, uint8_t byte, ArtNode *child) {
+
+        node->children[byte] = child;
+
+        node->childCount++;
+    }
+
+    /**
+     * Add a child for a byte the node doesn't have yet, replacing the node with a bigger one when it's full
+     * @param reference Where the node is referenced from
+     */
+    static void addChild(ArtNode **reference, ArtInnerNode *node, uint8_t byte, ArtNode *child) {
+
+        switch (node->type) {
+            case ART_NODE4: {
+                auto *node4 = static_cast<ArtNode4 *>(node);
+
+                if (node4->childCount < 4) {
+                    addChild4(node4, byte, child);
+
+                    return;
+                }
+
+                auto *bigger = new ArtNode16();
+
+                copyHeader(bigger, node4);
+
+                memcpy(bigger->keys, node4->keys, 4);
+                memcpy(bigger->children, node4->children, 4 * sizeof(ArtNode *));
+
+                *reference = bigger;
+
+                delete node4;
+
+                addChild16(bigger, byte, child);
+
+                return;
+            }
+            case ART_NODE16: {
+                auto *node16 = static_cast<ArtNode16 *>(node);
+
+                if (node16->childCount < 16) {
+                    addChild16(node16, byte, child);
+
+                    return;
+                }
+
+                auto *bigger = new ArtNode48();
+
+                copyHeader(bigger, node16);
+
+                for (int i = 0; i < 16; i++) {
+                    bigger->children[i] = node16->children[i];
+                    bigger->childIndex[node16->keys[i]] = (uint8_t) (i + 1);
+                }
+
+                *reference = bigger;
+
+                delete node16;
+
+                addChild48(bigger, byte, child);
+
+                return;
+            }
+            case ART_NODE48: {
+                auto *node48 = static_cast<ArtNode48 *>(node);
+
+                if (node48->childCount < 48) {
+                    addChild48(node48, byte, child);
+
+                    return;
+                }
+
+                auto *bigger = new ArtNode256();
+
+                copyHeader(bigger, node48);
+
+                for (int i = 0; i < 256; i++) {
+                    if (node48->childIndex[i] != 0) {
+                        bigger->children[i] = node48->children[node48->childIndex[i] - 1];
+                    }
+                }
+
+                *reference = bigger;
+
+                delete node48;
+
+                addChild256(bigger, byte, child);
+
+                return;
+            }
+            default:
+                addChild256(static_cast<ArtNode256 *>(node), byte, child);
+        }
+    }
+
+    /**
+     * Remove the child in the slot, replacing the node with a smaller one when it gets sparse enough. A node 4 left
+     * with a single child is merged into it
+     */
+    static void removeChild(ArtNode **reference, ArtInnerNode *node, uint8_t byte, ArtNode **slot) {
+
+        switch (node->type) {
+            case ART_NODE4: {
+                auto *node4 = static_cast<ArtNode4 *>(node);
+
+                int position = (int) (slot - node4->children);
+
+                memmove(node4->keys + position, node4->keys + position + 1, node4->childCount - position - 1);
+                memmove(node4->children + position, node4->children + position + 1,
+                        (node4->childCount - position - 1) * sizeof(ArtNode *));
+
+                node4->childCount--;
+
+                if (node4->childCount == 1) {
+                    ArtNode *child = node4->children[0];
+
+                    if (child->type != ART_LEAF) {
+                        //The child's path becomes this node's prefix, its key byte and its own prefix
+                        auto *innerChild = static_cast<ArtInnerNode *>(child);
+
+                        uint8_t merged[ART_MAX_PREFIX];
+
+                        uint32_t length = std::min(node4->prefixLength, (uint32_t) ART_MAX_PREFIX);
+
+                        memcpy(merged, node4->prefix, length);
+
+                        if (length < ART_MAX_PREFIX) {
+                            merged[length++] = node4->keys[0];
+                        }
+
+                        if (length < ART_MAX_PREFIX) {
+                            uint32_t childLength = std::min(innerChild->prefixLength,
+                                                            (uint32_t) ART_MAX_PREFIX - length);
+
+                            memcpy(merged + length, innerChild->prefix, childLength);
+
+                            length += childLength;
+                        }
+
+                        memcpy(innerChild->prefix, merged, length);
+
+                        innerChild->prefixLength += node4->prefixLength + 1;
+                    }
+
+                    *reference = child;
+
+                    delete node4;
+                }
+
+                return;
+            }
+            case ART_NODE16: {
+                auto *node16 = static_cast<ArtNode16 *>(node);
+
+                int position = (int) (slot - node16->children);
+
+                memmove(node16->keys + position, node16->keys + position + 1, node16->childCount - position - 1);
+                memmove(node16->children + position, node16->children + position + 1,
+                        (node16->childCount - position - 1) * sizeof(ArtNode *));
+
+                node16->childCount--;
+
+                if (node16->childCount == 3) {
+                    auto *smaller = new ArtNode4();
+
+                    copyHeader(smaller, node16);
+
+                    memcpy(smaller->keys, node16->keys, 3);
+                    memcpy(smaller->children, node16->children, 3 * sizeof(ArtNode *));
+
+                    *reference = smaller;
+
+                    delete node16;
+                }
+
+                return;
+            }
+            case ART_NODE48: {
+                auto *node48 = static_cast<ArtNode48 *>(node);
+
+                node48->children[node48->childIndex[byte] - 1] = nullptr;
+                node48->childIndex[byte] = 0;
+
+                node48->childCount--;
+
+                if (node48->childCount == 12) {
+                    auto *smaller = new ArtNode16();
+
+                    copyHeader(smaller, node48);
+
+                    int position = 0;
+
+                    for (int i = 0; i < 256; i++) {
+                        if (node48->childIndex[i] != 0) {
+                            smaller->keys[position] = (uint8_t) i;
+                            smaller->children[position] = node48->children[node48->childIndex[i] - 1];
+
+                            position++;
+                        }
+                    }
+
+                    *reference = smaller;
+
+                    delete node48;
+                }
+
+                return;
+            }
+            default: {
+                auto *node256 = static_cast<ArtNode256 *>(node);
+
+                node256->children[byte] = nullptr;
+
+                node256->childCount--;
+
+                if (node256->childCount == 37) {
+                    auto *smaller = new ArtNode48();
+
+                    copyHeader(smaller, node256);
+
+                    int slotCount = 0;
+
+                    for (int i = 0; i < 256; i++) {
+                        if (node256->children[i] != nullptr) {
+                            smaller->children[slotCount] = node256->children[i];
+                            smaller->childIndex[i] = (uint8_t) (slotCount + 1);
+
+                            slotCount++;
+                        }
+                    }
+
+                    *reference = smaller;
+
+                    delete node256;
+                }
+            }
+        }
+    }
+
+    /**
+     * @return Whether the leaf was added, when the key is already there only its value is replaced and the leaf is
+     * deleted
+     */
+    static bool insert(ArtNode **reference, Leaf *leaf, uint32_t depth) {
+
+        ArtNode *node = *reference;
+
+        if (node == nullptr) {
+            *reference = leaf;
+
+            return true;
+        }
+
+        const std::string &key = leaf->keyBytes;
+
+        if (node->type == ART_LEAF) {
+            auto *existing = static_cast<Leaf *>(node);
+
+            if (existing->keyBytes == key) {
+                existing->value = std::move(leaf->value);
+
+                delete leaf;
+
+                return false;
+            }
+
+            //Both leaves go below a new node, which gets the bytes they share as its prefix
+            auto *split = new ArtNode4();
+
+            uint32_t common = 0, length = std::min(existing->keyBytes.size(), key.size()) - depth;
+
+            while (common < length && existing->keyBytes[depth + common] == key[depth + common]) {
+                common++;
+            }
+
+            split->prefixLength = common;
+
+            memcpy(split->prefix, key.data() + depth, std::min(common, (uint32_t) ART_MAX_PREFIX));
+
+            addChild4(split, byteAt(existing->keyBytes, depth + common), existing);
+            addChild4(split, byteAt(key, depth + common), leaf);
+
+            *reference = split;
+
+            return true;
+        }
+
+        auto *inner = static_cast<ArtInnerNode *>(node);
+
+        if (inner->prefixLength > 0) {
+            uint32_t mismatch = prefixMismatch(inner, key, depth);
+
+            if (mismatch < inner->prefixLength) {
+                //The key leaves the compressed path halfway, split it there
+                auto *split = new ArtNode4();
+
+                split->prefixLength = mismatch;
+
+                memcpy(split->prefix, inner->prefix, std::min(mismatch, (uint32_t) ART_MAX_PREFIX));
+
+                if (inner->prefixLength <= ART_MAX_PREFIX) {
+                    addChild4(split, inner->prefix[mismatch], inner);
+
+                    inner->prefixLength -= mismatch + 1;
+
+                    memmove(inner->prefix, inner->prefix + mismatch + 1, inner->prefixLength);
+                } else {
+                    //The rest of the prefix is only in the leaves
+                    const std::string &leafKey = minimum(inner)->keyBytes;
+
+                    addChild4(split, byteAt(leafKey, depth + mismatch), inner);
+
+                    inner->prefixLength -= mismatch + 1;
+
+                    memcpy(inner->prefix, leafKey.data() + depth + mismatch + 1,
+                           std::min(inner->prefixLength, (uint32_t) ART_MAX_PREFIX));
+                }
+
+                addChild4(split, byteAt(key, depth + mismatch), leaf);
+
+                *reference = split;
+
+                return true;
+            }
+
+            depth += inner->prefixLength;
+        }
+
+        ArtNode **child = findChild(inner, byteAt(key, depth));
+
+        if (child != nullptr) {
+            return insert(child, leaf, depth + 1);
+        }
+
+        addChild(reference, inner, byteAt(key, depth), leaf);
+
+        return true;
+    }
+
+    /**
+     * @return The removed leaf, null if the key isn't in the tree
+     */
+    static Leaf *erase(ArtNode **reference, const std::string &key, uint32_t depth) {
+
+        ArtNode *node = *reference;
+
+        if (node == nullptr) return nullptr;
+
+        if (node->type == ART_LEAF) {
+            //Only when the leaf is the root, every other leaf is removed by its parent
+            if (static_cast<Leaf *>(node)->keyBytes != key) return nullptr;
+
+            *reference = nullptr;
+
+            return static_cast<Leaf *>(node);
+        }
+
+        auto *inner = static_cast<ArtInnerNode *>(node);
+
+        if (checkPrefix(inner, key, depth) != std::min(inner->prefixLength, (uint32_t) ART_MAX_PREFIX)) {
+            return nullptr;
+        }
+
+        depth += inner->prefixLength;
+
+        if (depth >= key.size()) return nullptr;
+
+        ArtNode **child = findChild(inner, byteAt(key, depth));
+
+        if (child == nullptr) return nullptr;
+
+        if ((*child)->type == ART_LEAF) {
+            auto *leaf = static_cast<Leaf *>(*child);
+
+            if (leaf->keyBytes != key) return nullptr;
+
+            removeChild(reference, inner, byteAt(key, depth), child);
+
+            return leaf;
+        }
+
+        return erase(child, key, depth + 1);
+    }
+
+    Leaf *search(const std::string &key) const {
+
+        ArtNode *node = this->root;
+
+        uint32_t depth = 0;
+
+        while (node != nullptr) {
+
+            if (node->type == ART_LEAF) {
+                auto *leaf = static_cast<Leaf *>(node);
+
+                return leaf->keyBytes == key ? leaf : nullptr;
+            }
+
+            auto *inner = static_cast<ArtInnerNode *>(node);
+
+            //The bytes of the prefix that aren't stored are checked in the leaf
+            if (checkPrefix(inner, key, depth) != std::min(inner->prefixLength, (uint32_t) ART_MAX_PREFIX)) {
+                return nullptr;
+            }
+
+            depth += inner->prefixLength;
+
+            if (depth >= key.size()) return nullptr;
+
+            ArtNode **child = findChild(inner, byteAt(key, depth));
+
+            node = child == nullptr ? nullptr : *child;
+
+            depth++;
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * In order traversal of the leaves between low and high
+     * @param checkLow Whether the path so far is the same as low's, otherwise every key below is already bigger
+     * @param checkHigh Whether the path so far is the same as high's, otherwise every key below is already smaller
+     */
+    static void rangeHelper(ArtNode *node, uint32_t depth, const std::string &low, const std::string &high,
+                            bool checkLow, bool checkHigh, std::vector<node_info<T, V>> *results) {
+
+        if (node->type == ART_LEAF) {
+            auto *leaf = static_cast<Leaf *>(node);
+
+            if ((!checkLow || leaf->keyBytes >= low) && (!checkHigh || leaf->keyBytes <= high)) {
+                results->push_back(std::make_tuple(leaf->key, leaf->value));
+            }
+
+            return;
+        }
+
+        auto *inner = static_cast<ArtInnerNode *>(node);
+
+        if (checkLow || checkHigh) {
+            const std::string *leafKey = inner->prefixLength > ART_MAX_PREFIX ? &minimum(inner)->keyBytes : nullptr;
+
+            for (uint32_t i = 0; i < inner->prefixLength && (checkLow || checkHigh); i++) {
+
+                uint8_t byte = i < ART_MAX_PREFIX ? inner->prefix[i] : byteAt(*leafKey, depth + i);
+
+                if (checkLow) {
+                    if (depth + i >= low.size() || byte > byteAt(low, depth + i)) {
+                        checkLow = false;
+                    } else if (byte < byteAt(low, depth + i)) {
+                        return;
+                    }
+                }
+
+                if (checkHigh) {
+                    if (depth + i >= high.size() || byte > byteAt(high, depth + i)) {
+                        return;
+                    } else if (byte < byteAt(high, depth + i)) {
+                        checkHigh = false;
+                    }
+                }
+            }
+        }
+
+        depth += inner->prefixLength;
+
+        int from = 0, to = 255;
+
+        if (checkLow) {
+            if (depth < low.size()) {
+                from = byteAt(low, depth);
+            } else {
+                checkLow = false;
+            }
+        }
+
+        if (checkHigh) {
+            if (depth >= high.size()) return;
+
+            to = byteAt(high, depth);
+        }
+
+        int byte = 0;
+
+        for (ArtNode *child = childFrom(inner, from, byte);
+             child != nullptr && byte <= to; child = byte == 255 ? nullptr : childFrom(inner, byte + 1, byte)) {
+            rangeHelper(child, depth + 1, low, high, checkLow && byte == from, checkHigh && byte == to, results);
+        }
+    }
+
+    static void freeNode(ArtNode *node) {
+
+        if (node == nullptr) return;
+
+        switch (node->type) {
+            case ART_LEAF:
+                delete static_cast<Leaf *>(node);
+
+                return;
+            case ART_NODE4: {
+                auto *node4 = static_cast<ArtNode4 *>(node);
+
+                for (int i = 0; i < node4->childCount; i++) {
+                    freeNode(node4->children[i]);
+                }
+
+                delete node4;
+
+                return;
+            }
+            case ART_NODE16: {
+                auto *node16 = static_cast<ArtNode16 *>(node);
+
+                for (int i = 0; i < node16->childCount; i++) {
+                    freeNode(node16->children[i]);
+                }
+
+                delete node16;
+
+                return;
+            }
+            case ART_NODE48: {
+                auto *node48 = static_cast<ArtNode48 *>(node);
+
+                for (ArtNode *child : node48->children) {
+                    freeNode(child);
+                }
+
+                delete node48;
+
+                return;
+            }
+            default: {
+                auto *node256 = static_cast<ArtNode256 *>(node);
+
+                for (ArtNode *child : node256->children) {
+                    freeNode(child);
+                }
+
+                delete node256;
+            }
+        }
+    }
+
+    std::optional<node_info<T, V>> popLeaf(Leaf *leaf) {
+
+        if (leaf == nullptr) return std::nullopt;
+
+        erase(&this->root, leaf->keyBytes, 0);
+
+        this->treeSize--;
+
+        node_info<T, V> result = std::make_tuple(std::move(leaf->key), std::move(leaf->value));
+
+        delete leaf;
+
+        return result;
+    }
+
+public:
+    AdaptiveRadixTree() : root(nullptr), treeSize(0) {}
+
+    AdaptiveRadixTree(const AdaptiveRadixTree &) = delete;
+
+    AdaptiveRadixTree &operator=(const AdaptiveRadixTree &) = delete;
+
+    ~AdaptiveRadixTree() override {
+        freeNode(this->root);
+    }
+
+    unsigned int size() override {
+        return this->treeSize;
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        std::string keyBytes = encode(*key);
+
+        auto *leaf = new Leaf(std::move(keyBytes), std::move(key), std::move(value));
+
+        if (insert(&this->root, leaf, 0)) {
+            this->treeSize++;
+        }
+    }
+
+    bool hasKey(const T &key) override {
+        return search(encode(key)) != nullptr;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        Leaf *leaf = search(encode(key));
+
+        if (leaf == nullptr) return std::nullopt;
+
+        return leaf->value;
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        Leaf *leaf = erase(&this->root, encode(key), 0);
+
+        if (leaf == nullptr) return std::nullopt;
+
+        this->treeSize--;
+
+        std::shared_ptr<V> value = std::move(leaf->value);
+
+        delete leaf;
+
+        return value;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        results->reserve(this->treeSize);
+
+        auto cache = entries();
+
+        for (auto &entry : *cache) {
+            results->push_back(std::move(std::get<0>(entry)));
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto results = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        results->reserve(this->treeSize);
+
+        auto cache = entries();
+
+        for (auto &entry : *cache) {
+            results->push_back(std::move(std::get<1>(entry)));
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        results->reserve(this->treeSize);
+
+        if (this->root != nullptr) {
+            rangeHelper(this->root, 0, std::string(), std::string(), false, false, results.get());
+        }
+
+        return results;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+
+        auto results = std::make_unique<std::vector<node_info<T, V>>>();
+
+        if (this->root != nullptr) {
+            rangeHelper(this->root, 0, encode(base), encode(max), true, true, results.get());
+        }
+
+        return results;
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+
+        Leaf *leaf = minimum(this->root);
+
+        if (leaf == nullptr) return std::nullopt;
+
+        return std::make_tuple(leaf->key, leaf->value);
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+
+        Leaf *leaf = maximum(this->root);
+
+        if (leaf == nullptr) return std::nullopt;
+
+        return std::make_tuple(leaf->key, leaf->value);
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+        return popLeaf(minimum(this->root));
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+        return popLeaf(maximum(this->root));
+    }
+};
+
+#endif //TRABALHO1_ADAPTIVERADIXTREE_H
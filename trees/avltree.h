@@ -206,6 +206,17 @@ public:
         updateBalance((AVLNode<T, V> *) newNode);
     }
 
+    TreeNode<T, V> *addWithHint(TreeNode<T, V> *hint, std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        TreeNode<T, V> *start = this->findHintStart(hint, *key);
+
+        TreeNode<T, V> *newNode = this->addNode(std::move(key), std::move(value), start);
+
+        updateBalance((AVLNode<T, V> *) newNode);
+
+        return newNode;
+    }
+
     std::optional<std::shared_ptr<V>> remove(const T &key) override {
         auto removedNodeInfo = this->removeNode(key);
 
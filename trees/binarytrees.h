@@ -2,6 +2,7 @@
 #define TRABALHO1_BINARYTREES_H
 
 #include "../datastructures.h"
+#include <algorithm>
 #include <tuple>
 #include <memory>
 #include <vector>
@@ -100,6 +101,17 @@ public:
     }
 };
 
+/**
+ * How the tree is traversed when collecting entries and range searching.
+ *
+ * EXPLICIT_STACK keeps the path in a heap allocated stack, PARENT_THREADED uses constant space by following the
+ * parent pointers to find each node's successor
+ */
+enum TraversalMode {
+    EXPLICIT_STACK,
+    PARENT_THREADED
+};
+
 template<typename T, typename V>
 class BinarySearchTree : public OrderedMap<T, V> {
 
@@ -110,8 +122,10 @@ protected:
 
     unsigned int treeSize;
 
+    TraversalMode traversalMode;
+
     BinarySearchTree() : treeSize(0), rootNode(nullptr),
-                         leftMostNode(nullptr), rightMostNode(nullptr) {}
+                         leftMostNode(nullptr), rightMostNode(nullptr), traversalMode(EXPLICIT_STACK) {}
 
     ~BinarySearchTree() override {
 
@@ -166,26 +180,110 @@ protected:
         this->rightMostNode = rightMost;
     }
 
-    void inOrderHelper(TreeNode<T, V> *current, std::vector<node_info<T, V>> *destination) {
+    /**
+     * In order traversal using an explicit stack, so degenerate trees (Like a splay tree after sequential inserts,
+     * which is a path) do not go over the stack recursion limit
+     */
+    void inOrderHelper(TreeNode<T, V> *root, std::vector<node_info<T, V>> *destination) {
+
+        if (this->traversalMode == PARENT_THREADED) {
+            threadedInOrderHelper(root, destination);
+
+            return;
+        }
+
+        std::stack<TreeNode<T, V> *> stack;
+
+        TreeNode<T, V> *current = root;
+
+        while (current != nullptr || !stack.empty()) {
+
+            //Go as far left as we can, leaving the nodes we pass by to be visited on the way back
+            while (current != nullptr) {
+                stack.push(current);
+
+                current = current->getLeftChild();
+            }
+
+            current = stack.top();
+
+            stack.pop();
+
+            destination->emplace_back(std::make_tuple(current->getKey(), current->getValue()));
+
+            current = current->getRightChild();
+        }
+    }
+
+    /**
+     * Constant space in order traversal.
+     *
+     * We can't thread the tree Morris style because the children are owned by unique_ptrs (A thread back to an
+     * ancestor would mean two owners), but since every node keeps a pointer to its parent, the successor of any node
+     * can be found without any extra space.
+     */
+    void threadedInOrderHelper(TreeNode<T, V> *root, std::vector<node_info<T, V>> *destination) {
+
+        if (root == nullptr) return;
+
+        TreeNode<T, V> *current = getLeftMostNodeInTree(root), *last = getRightMostNodeInTree(root);
+
+        while (current != nullptr) {
+
+            destination->emplace_back(std::make_tuple(current->getKey(), current->getValue()));
+
+            if (current == last) break;
+
+            current = getSuccessor(current);
+        }
+    }
+
+    void preOrderHelper(TreeNode<T, V> *root, std::vector<node_info<T, V>> *destination) {
+
+        if (root == nullptr) return;
+
+        std::stack<TreeNode<T, V> *> stack;
+
+        stack.push(root);
 
-        if (current == nullptr) return;
+        while (!stack.empty()) {
 
-        inOrderHelper(current->getLeftChild(), destination);
+            TreeNode<T, V> *current = stack.top();
 
-        destination->emplace_back(std::make_tuple(current->getKey(), current->getValue()));
+            stack.pop();
 
-        inOrderHelper(current->getRightChild(), destination);
+            destination->push_back(std::make_tuple(current->getKey(), current->getValue()));
 
+            //Push the right child first, so that the left sub tree gets visited before it
+            if (current->getRightChild() != nullptr)
+                stack.push(current->getRightChild());
+
+            if (current->getLeftChild() != nullptr)
+                stack.push(current->getLeftChild());
+        }
     }
 
-    void preOrderHelper(TreeNode<T, V> *current, std::vector<node_info<T, V>> *destination) {
-        if (current == nullptr) return;
+    /**
+     * Get the next node in order, using only the parent pointers
+     * @param node
+     * @return The successor, or nullptr if node is the largest node in the tree
+     */
+    TreeNode<T, V> *getSuccessor(TreeNode<T, V> *node) {
+
+        if (node->getRightChild() != nullptr) {
+            return getLeftMostNodeInTree(node->getRightChild());
+        }
+
+        TreeNode<T, V> *parent = node->getParent();
 
-        destination->push_back(std::make_tuple(current->getKey(), current->getValue()));
+        //Go up until we come from a left child, that parent is the next node in order
+        while (parent != nullptr && parent->getRightChild() == node) {
+            node = parent;
 
-        preOrderHelper(current->getLeftChild(), destination);
+            parent = parent->getParent();
+        }
 
-        preOrderHelper(current->getRightChild(), destination);
+        return parent;
     }
 
     TreeNode<T, V> *getRightMostNodeInTree(TreeNode<T, V> *root) {
@@ -213,7 +311,42 @@ protected:
     virtual std::unique_ptr<TreeNode<T, V>> initializeNode(std::shared_ptr<T> key, std::shared_ptr<V> value,
                                                            TreeNode<T, V> *parent) = 0;
 
-    TreeNode<T, V> *addNode(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+    /**
+     * Find where a search for the key can start from, given a node that is close to it. Climbs from the hint until
+     * the key falls inside the range of the current sub tree, so for keys a distance d away this is about O(log d)
+     *
+     * @param hint A node that is still in the tree, or null to start from the root
+     */
+    TreeNode<T, V> *findHintStart(TreeNode<T, V> *hint, const T &key) {
+
+        if (hint == nullptr) return this->getRoot();
+
+        bool goingRight = *hint->getKeyVal() < key;
+
+        TreeNode<T, V> *current = hint;
+
+        while (current->getParent() != nullptr) {
+
+            TreeNode<T, V> *parent = current->getParent();
+
+            bool isLeftChild = parent->getLeftChild() == current;
+
+            //The parent bounds the sub tree on the side we're going, and the key is within that bound
+            if (goingRight && isLeftChild && key < *parent->getKeyVal()) break;
+
+            if (!goingRight && !isLeftChild && *parent->getKeyVal() < key) break;
+
+            current = parent;
+        }
+
+        return current;
+    }
+
+    /**
+     * @param start Where to start looking for the place of the key, the root if null. The key must belong in its
+     * sub tree
+     */
+    TreeNode<T, V> *addNode(std::shared_ptr<T> key, std::shared_ptr<V> value, TreeNode<T, V> *start = nullptr) {
 
         if (this->getRoot() == nullptr) {
 
@@ -229,7 +362,7 @@ protected:
             return this->getRoot();
         }
 
-        TreeNode<T, V> *currentRoot = this->getRoot(),
+        TreeNode<T, V> *currentRoot = start != nullptr ? start : this->getRoot(),
                 *parent = nullptr;
 
         while (currentRoot != nullptr) {
@@ -424,22 +557,75 @@ protected:
         return std::nullopt;
     }
 
+    /**
+     * Pruned in order traversal, only visits the O(log n + k) nodes that can be in the range
+     */
     void searchInTree(TreeNode<T, V> *root, const T &base, const T &max, std::vector<node_info<T, V>> *result) {
 
-        if (root == nullptr) return;
+        if (this->traversalMode == PARENT_THREADED) {
+            threadedSearchInTree(root, base, max, result);
+
+            return;
+        }
+
+        std::stack<TreeNode<T, V> *> stack;
+
+        TreeNode<T, V> *current = root;
+
+        while (current != nullptr || !stack.empty()) {
+
+            while (current != nullptr) {
+
+                if (*current->getKeyVal() < base) {
+                    //This node and it's entire left sub tree are smaller than the base, skip them
+                    current = current->getRightChild();
+                } else {
+                    stack.push(current);
+
+                    current = current->getLeftChild();
+                }
+            }
+
+            //Every node left in the path was smaller than the base
+            if (stack.empty()) break;
+
+            current = stack.top();
 
-        if (*root->getKeyVal() >= base && *root->getKeyVal() <= max) {
+            stack.pop();
 
-            //Search first in the left sub tree, so that the smaller values come out first in the vector
-            searchInTree(root->getLeftChild(), base, max, result);
+            //The nodes come out in order, so after the first one that is larger than max there is nothing left to find
+            if (*current->getKeyVal() > max) break;
 
-            result->push_back(std::make_tuple(root->getKey(), root->getValue()));
+            result->push_back(std::make_tuple(current->getKey(), current->getValue()));
 
-            //After inserting our value (larger than the left sub tree and smaller than the right subtree) search the right sub tree,so
-            //that in the end, the elements get added in order
-            searchInTree(root->getRightChild(), base, max, result);
+            current = current->getRightChild();
+        }
+    }
+
+    void threadedSearchInTree(TreeNode<T, V> *root, const T &base, const T &max,
+                              std::vector<node_info<T, V>> *result) {
+
+        TreeNode<T, V> *current = root, *lowerBound = nullptr;
+
+        //Find the smallest node that is >= base
+        while (current != nullptr) {
+            if (*current->getKeyVal() < base) {
+                current = current->getRightChild();
+            } else {
+                lowerBound = current;
+
+                current = current->getLeftChild();
+            }
         }
 
+        current = lowerBound;
+
+        while (current != nullptr && *current->getKeyVal() <= max) {
+
+            result->push_back(std::make_tuple(current->getKey(), current->getValue()));
+
+            current = getSuccessor(current);
+        }
     }
 
     void handleRemoveLargestNode() {
@@ -587,6 +773,54 @@ protected:
         return left;
     }
 
+    /**
+     * Descend the tree once for a whole sorted batch, splitting it at every node on the way down, and leave for each
+     * key the node where its search ended (Its parent to be, or the node with the same key)
+     */
+    std::vector<TreeNode<T, V> *> findBatchPositions(const std::vector<node_info<T, V>> &batch) {
+
+        std::vector<TreeNode<T, V> *> positions(batch.size(), nullptr);
+
+        if (this->getRoot() == nullptr) return positions;
+
+        //The node we're at, the last node before it and the part of the batch that belongs in its sub tree
+        std::stack<std::tuple<TreeNode<T, V> *, TreeNode<T, V> *, size_t, size_t>> toVisit;
+
+        toVisit.push(std::make_tuple(this->getRoot(), nullptr, 0, batch.size()));
+
+        auto keyLess = [](const node_info<T, V> &entry, const T &key) { return *std::get<0>(entry) < key; };
+        auto keyGreater = [](const T &key, const node_info<T, V> &entry) { return key < *std::get<0>(entry); };
+
+        while (!toVisit.empty()) {
+
+            auto [node, parent, first, last] = toVisit.top();
+
+            toVisit.pop();
+
+            if (node == nullptr) {
+                std::fill(positions.begin() + first, positions.begin() + last, parent);
+
+                continue;
+            }
+
+            const T &nodeKey = *node->getKeyVal();
+
+            size_t equalStart = std::lower_bound(batch.begin() + first, batch.begin() + last, nodeKey, keyLess) -
+                                batch.begin();
+
+            size_t equalEnd = std::upper_bound(batch.begin() + equalStart, batch.begin() + last, nodeKey, keyGreater) -
+                              batch.begin();
+
+            std::fill(positions.begin() + equalStart, positions.begin() + equalEnd, node);
+
+            if (first < equalStart) toVisit.push(std::make_tuple(node->getLeftChild(), node, first, equalStart));
+
+            if (equalEnd < last) toVisit.push(std::make_tuple(node->getRightChild(), node, equalEnd, last));
+        }
+
+        return positions;
+    }
+
     TreeNode<T, V> *getNodeBy(const T &key) {
 
         if (this->getRoot() != nullptr) {
@@ -713,9 +947,13 @@ public:
 
     std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
 
-        auto vector = std::make_unique<std::vector<std::shared_ptr<T>>>(this->size());
+        auto vector = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        vector->reserve(this->size());
+
+        std::vector<node_info<T, V>> nodeCache;
 
-        std::vector<node_info<T, V>> nodeCache(this->size());
+        nodeCache.reserve(this->size());
 
         inOrderHelper(this->getRoot(), &nodeCache);
 
@@ -728,9 +966,13 @@ public:
 
     std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
 
-        auto vector = std::make_unique<std::vector<std::shared_ptr<V>>>(this->size());
+        auto vector = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        vector->reserve(this->size());
+
+        std::vector<node_info<T, V>> nodeCache;
 
-        std::vector<node_info<T, V>> nodeCache(this->size());
+        nodeCache.reserve(this->size());
 
         inOrderHelper(this->getRoot(), &nodeCache);
 
@@ -745,14 +987,95 @@ public:
 
         auto vector = std::make_unique<std::vector<node_info<T, V>>>();
 
+        vector->reserve(this->size());
+
         inOrderHelper(this->getRoot(), vector.get());
 
         return vector;
     }
 
+    void forEachEntry(const entry_visitor<T, V> &visitor) override {
+
+        std::stack<TreeNode<T, V> *> stack;
+
+        TreeNode<T, V> *current = this->getRoot();
+
+        while (current != nullptr || !stack.empty()) {
+
+            while (current != nullptr) {
+                stack.push(current);
+
+                current = current->getLeftChild();
+            }
+
+            current = stack.top();
+
+            stack.pop();
+
+            visitor(current->getKey(), current->getValue());
+
+            current = current->getRightChild();
+        }
+    }
+
+    /**
+     * Add the key, starting the search from a node close to it instead of from the root. Nearly sorted keys only
+     * climb a few levels from the previous one. Trees that don't override this insert without rebalancing
+     *
+     * @param hint A node still in the tree (Like the one returned by the last addWithHint), or null
+     * @return The node of the key, to be used as the next hint. It must not be used after a removal
+     */
+    virtual TreeNode<T, V> *addWithHint(TreeNode<T, V> *hint, std::shared_ptr<T> key, std::shared_ptr<V> value) {
+
+        TreeNode<T, V> *start = this->findHintStart(hint, *key);
+
+        return this->addNode(std::move(key), std::move(value), start);
+    }
+
+    /**
+     * Add a batch of entries, sorting it first if needed. Instead of a search from the root for every key, the tree
+     * is descended once with the whole batch and each key is then inserted from where that descent left it.
+     * When a key shows up more than once in the batch, the last value wins
+     */
+    void addBatch(std::vector<node_info<T, V>> batch) {
+
+        auto keyOrder = [](const node_info<T, V> &first, const node_info<T, V> &second) {
+            return *std::get<0>(first) < *std::get<0>(second);
+        };
+
+        if (!std::is_sorted(batch.begin(), batch.end(), keyOrder)) {
+            std::stable_sort(batch.begin(), batch.end(), keyOrder);
+        }
+
+        std::vector<TreeNode<T, V> *> positions = findBatchPositions(batch);
+
+        TreeNode<T, V> *previous = nullptr;
+
+        for (size_t i = 0; i < batch.size(); i++) {
+
+            //Keys that ended in the same place are next to each other, so the previous one is the closest hint.
+            //The rebalancing of the previous inserts might have moved the node, but it's still a valid hint
+            TreeNode<T, V> *hint = (i > 0 && positions[i] == positions[i - 1]) ? previous : positions[i];
+
+            previous = this->addWithHint(hint, std::move(std::get<0>(batch[i])), std::move(std::get<1>(batch[i])));
+        }
+    }
+
+    void addSorted(std::vector<node_info<T, V>> sorted) override {
+        addBatch(std::move(sorted));
+    }
+
     TreeNode<T, V> *getRoot() {
         return this->rootNode.get();
     }
+
+    TraversalMode getTraversalMode() const {
+        return this->traversalMode;
+    }
+
+    void setTraversalMode(TraversalMode traversalMode) {
+        this->traversalMode = traversalMode;
+    }
 };
 
 #endif //TRABALHO1_BINARYTREES_H
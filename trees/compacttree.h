@@ -0,0 +1,721 @@
+#ifndef TRABALHO1_COMPACTTREE_H
+#define TRABALHO1_COMPACTTREE_H
+
+#include "../datastructures.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+//Index 0 of the pool is the sentinel, every leaf points to it (Like the NIL leaves of the red black tree)
+#define COMPACT_NIL 0
+//The top bit of the parent index is used to store the colour of the node
+#define COMPACT_RED_BIT 0x80000000u
+#define COMPACT_INDEX_MASK 0x7FFFFFFFu
+
+/**
+ * Node of the compact tree. Instead of pointers, the links are 32 bit indexes into the node pool of the tree
+ * and the key and value are stored inline, so a node for int keys and values takes 20 bytes
+ * (Instead of the 64+ of the TreeNode)
+ */
+template<typename T, typename V>
+class CompactNode {
+
+private:
+    T key;
+    V value;
+
+    uint32_t left, right;
+
+    //The index of the parent, with the colour packed into the top bit
+    uint32_t parentAndColor;
+
+public:
+    CompactNode(T key, V value, uint32_t parent) : key(std::move(key)),
+                                                   value(std::move(value)),
+                                                   left(COMPACT_NIL),
+                                                   right(COMPACT_NIL),
+                                                   parentAndColor(parent & COMPACT_INDEX_MASK) {}
+
+    const T &getKey() const {
+        return key;
+    }
+
+    const V &getValue() const {
+        return value;
+    }
+
+    void setValue(V value) {
+        this->value = std::move(value);
+    }
+
+    uint32_t getLeft() const {
+        return left;
+    }
+
+    uint32_t getRight() const {
+        return right;
+    }
+
+    uint32_t getParent() const {
+        return parentAndColor & COMPACT_INDEX_MASK;
+    }
+
+    void setLeft(uint32_t left) {
+        this->left = left;
+    }
+
+    void setRight(uint32_t right) {
+        this->right = right;
+    }
+
+    void setParent(uint32_t parent) {
+        this->parentAndColor = (this->parentAndColor & COMPACT_RED_BIT) | (parent & COMPACT_INDEX_MASK);
+    }
+
+    bool isRed() const {
+        return (parentAndColor & COMPACT_RED_BIT) != 0;
+    }
+
+    void setRed(bool red) {
+        if (red) {
+            this->parentAndColor |= COMPACT_RED_BIT;
+        } else {
+            this->parentAndColor &= COMPACT_INDEX_MASK;
+        }
+    }
+};
+
+/**
+ * Red black tree where all of the nodes live in a contiguous pool.
+ *
+ * Since the nodes store the keys and values by value, the values returned by get and the traversals are copies
+ * wrapped in new shared_ptrs.
+ */
+template<typename T, typename V>
+class CompactRedBlackTree : public OrderedMap<T, V> {
+
+private:
+    std::vector<CompactNode<T, V>> nodes;
+
+    uint32_t root, smallest, largest;
+
+    //Removed nodes are kept in a list (linked by the left index) so their slots can be reused
+    uint32_t freeList;
+
+    unsigned int treeSize;
+
+    CompactNode<T, V> &node(uint32_t index) {
+        return nodes[index];
+    }
+
+    bool isRed(uint32_t index) {
+        return nodes[index].isRed();
+    }
+
+    uint32_t allocateNode(T key, V value, uint32_t parent) {
+
+        if (freeList != COMPACT_NIL) {
+            uint32_t index = freeList;
+
+            freeList = node(index).getLeft();
+
+            nodes[index] = CompactNode<T, V>(std::move(key), std::move(value), parent);
+
+            return index;
+        }
+
+        if (nodes.size() > COMPACT_INDEX_MASK) {
+            throw std::length_error("Compact tree node pool is full");
+        }
+
+        nodes.emplace_back(std::move(key), std::move(value), parent);
+
+        return (uint32_t) (nodes.size() - 1);
+    }
+
+    void freeNode(uint32_t index) {
+
+        //Release whatever the key and value might be holding on to
+        nodes[index] = CompactNode<T, V>(T(), V(), COMPACT_NIL);
+
+        node(index).setLeft(freeList);
+
+        freeList = index;
+    }
+
+    uint32_t findNode(const T &key) {
+
+        uint32_t current = root;
+
+        while (current != COMPACT_NIL) {
+
+            const T &currentKey = node(current).getKey();
+
+            if (currentKey == key) {
+                return current;
+            } else if (key < currentKey) {
+                current = node(current).getLeft();
+            } else {
+                current = node(current).getRight();
+            }
+        }
+
+        return COMPACT_NIL;
+    }
+
+    uint32_t minimum(uint32_t index) {
+
+        while (node(index).getLeft() != COMPACT_NIL) {
+            index = node(index).getLeft();
+        }
+
+        return index;
+    }
+
+    uint32_t maximum(uint32_t index) {
+
+        while (node(index).getRight() != COMPACT_NIL) {
+            index = node(index).getRight();
+        }
+
+        return index;
+    }
+
+    uint32_t successor(uint32_t index) {
+
+        if (node(index).getRight() != COMPACT_NIL) {
+            return minimum(node(index).getRight());
+        }
+
+        uint32_t parent = node(index).getParent();
+
+        while (parent != COMPACT_NIL && node(parent).getRight() == index) {
+            index = parent;
+
+            parent = node(parent).getParent();
+        }
+
+        return parent;
+    }
+
+    uint32_t predecessor(uint32_t index) {
+
+        if (node(index).getLeft() != COMPACT_NIL) {
+            return maximum(node(index).getLeft());
+        }
+
+        uint32_t parent = node(index).getParent();
+
+        while (parent != COMPACT_NIL && node(parent).getLeft() == index) {
+            index = parent;
+
+            parent = node(parent).getParent();
+        }
+
+        return parent;
+    }
+
+    void rotateLeft(uint32_t x) {
+
+        uint32_t y = node(x).getRight();
+
+        node(x).setRight(node(y).getLeft());
+
+        if (node(y).getLeft() != COMPACT_NIL) {
+            node(node(y).getLeft()).setParent(x);
+        }
+
+        uint32_t parent = node(x).getParent();
+
+        node(y).setParent(parent);
+
+        if (parent == COMPACT_NIL) {
+            root = y;
+        } else if (node(parent).getLeft() == x) {
+            node(parent).setLeft(y);
+        } else {
+            node(parent).setRight(y);
+        }
+
+        node(y).setLeft(x);
+        node(x).setParent(y);
+    }
+
+    void rotateRight(uint32_t x) {
+
+        uint32_t y = node(x).getLeft();
+
+        node(x).setLeft(node(y).getRight());
+
+        if (node(y).getRight() != COMPACT_NIL) {
+            node(node(y).getRight()).setParent(x);
+        }
+
+        uint32_t parent = node(x).getParent();
+
+        node(y).setParent(parent);
+
+        if (parent == COMPACT_NIL) {
+            root = y;
+        } else if (node(parent).getRight() == x) {
+            node(parent).setRight(y);
+        } else {
+            node(parent).setLeft(y);
+        }
+
+        node(y).setRight(x);
+        node(x).setParent(y);
+    }
+
+    void insertFixup(uint32_t z) {
+
+        while (isRed(node(z).getParent())) {
+
+            uint32_t parent = node(z).getParent(), grandParent = node(parent).getParent();
+
+            if (node(grandParent).getLeft() == parent) {
+
+                uint32_t uncle = node(grandParent).getRight();
+
+                if (isRed(uncle)) {
+                    node(parent).setRed(false);
+                    node(uncle).setRed(false);
+                    node(grandParent).setRed(true);
+
+                    z = grandParent;
+                } else {
+                    if (node(parent).getRight() == z) {
+                        //Left Right case, turn it into the left left case
+                        z = parent;
+
+                        rotateLeft(z);
+
+                        parent = node(z).getParent();
+                    }
+
+                    node(parent).setRed(false);
+                    node(grandParent).setRed(true);
+
+                    rotateRight(grandParent);
+                }
+            } else {
+
+                uint32_t uncle = node(grandParent).getLeft();
+
+                if (isRed(uncle)) {
+                    node(parent).setRed(false);
+                    node(uncle).setRed(false);
+                    node(grandParent).setRed(true);
+
+                    z = grandParent;
+                } else {
+                    if (node(parent).getLeft() == z) {
+                        //Right Left case, turn it into the right right case
+                        z = parent;
+
+                        rotateRight(z);
+
+                        parent = node(z).getParent();
+                    }
+
+                    node(parent).setRed(false);
+                    node(grandParent).setRed(true);
+
+                    rotateLeft(grandParent);
+                }
+            }
+        }
+
+        //The root is always BLACK
+        node(root).setRed(false);
+    }
+
+    /**
+     * Replace the sub tree rooted at u with the one rooted at v
+     * (The parent of the sentinel gets set as well, the delete fix up relies on it)
+     */
+    void transplant(uint32_t u, uint32_t v) {
+
+        uint32_t parent = node(u).getParent();
+
+        if (parent == COMPACT_NIL) {
+            root = v;
+        } else if (node(parent).getLeft() == u) {
+            node(parent).setLeft(v);
+        } else {
+            node(parent).setRight(v);
+        }
+
+        node(v).setParent(parent);
+    }
+
+    void deleteFixup(uint32_t x) {
+
+        while (x != root && !isRed(x)) {
+
+            uint32_t parent = node(x).getParent();
+
+            if (node(parent).getLeft() == x) {
+
+                uint32_t sibling = node(parent).getRight();
+
+                if (isRed(sibling)) {
+                    node(sibling).setRed(false);
+                    node(parent).setRed(true);
+
+                    rotateLeft(parent);
+
+                    sibling = node(parent).getRight();
+                }
+
+                if (!isRed(node(sibling).getLeft()) && !isRed(node(sibling).getRight())) {
+                    node(sibling).setRed(true);
+
+                    x = parent;
+                } else {
+                    if (!isRed(node(sibling).getRight())) {
+                        node(node(sibling).getLeft()).setRed(false);
+                        node(sibling).setRed(true);
+
+                        rotateRight(sibling);
+
+                        sibling = node(parent).getRight();
+                    }
+
+                    node(sibling).setRed(isRed(parent));
+                    node(parent).setRed(false);
+                    node(node(sibling).getRight()).setRed(false);
+
+                    rotateLeft(parent);
+
+                    x = root;
+                }
+            } else {
+
+                uint32_t sibling = node(parent).getLeft();
+
+                if (isRed(sibling)) {
+                    node(sibling).setRed(false);
+                    node(parent).setRed(true);
+
+                    rotateRight(parent);
+
+                    sibling = node(parent).getLeft();
+                }
+
+                if (!isRed(node(sibling).getLeft()) && !isRed(node(sibling).getRight())) {
+                    node(sibling).setRed(true);
+
+                    x = parent;
+                } else {
+                    if (!isRed(node(sibling).getLeft())) {
+                        node(node(sibling).getRight()).setRed(false);
+                        node(sibling).setRed(true);
+
+                        rotateLeft(sibling);
+
+                        sibling = node(parent).getLeft();
+                    }
+
+                    node(sibling).setRed(isRed(parent));
+                    node(parent).setRed(false);
+                    node(node(sibling).getLeft()).setRed(false);
+
+                    rotateRight(parent);
+
+                    x = root;
+                }
+            }
+        }
+
+        node(x).setRed(false);
+    }
+
+    V removeIndex(uint32_t z) {
+
+        V value = node(z).getValue();
+
+        if (z == smallest) {
+            smallest = successor(z);
+        }
+
+        if (z == largest) {
+            largest = predecessor(z);
+        }
+
+        uint32_t y = z, x;
+
+        bool removedRed = isRed(y);
+
+        if (node(z).getLeft() == COMPACT_NIL) {
+            x = node(z).getRight();
+
+            transplant(z, x);
+        } else if (node(z).getRight() == COMPACT_NIL) {
+            x = node(z).getLeft();
+
+            transplant(z, x);
+        } else {
+            //Replace the node with the smallest node of its right sub tree
+            y = minimum(node(z).getRight());
+
+            removedRed = isRed(y);
+
+            x = node(y).getRight();
+
+            if (node(y).getParent() == z) {
+                node(x).setParent(y);
+            } else {
+                transplant(y, x);
+
+                node(y).setRight(node(z).getRight());
+                node(node(y).getRight()).setParent(y);
+            }
+
+            transplant(z, y);
+
+            node(y).setLeft(node(z).getLeft());
+            node(node(y).getLeft()).setParent(y);
+            node(y).setRed(isRed(z));
+        }
+
+        if (!removedRed) {
+            deleteFixup(x);
+        }
+
+        freeNode(z);
+
+        treeSize--;
+
+        return value;
+    }
+
+    node_info<T, V> nodeInfo(uint32_t index) {
+        return std::make_tuple(std::make_shared<T>(node(index).getKey()), std::make_shared<V>(node(index).getValue()));
+    }
+
+    void traverseTree(std::vector<node_info<T, V>> *destination) {
+
+        if (root == COMPACT_NIL) return;
+
+        //Follow the parent indexes, so we don't need any extra space
+        for (uint32_t current = smallest; current != COMPACT_NIL; current = successor(current)) {
+            destination->push_back(nodeInfo(current));
+        }
+    }
+
+public:
+    CompactRedBlackTree(unsigned int initialCapacity = 0) : root(COMPACT_NIL), smallest(COMPACT_NIL),
+                                                            largest(COMPACT_NIL), freeList(COMPACT_NIL),
+                                                            treeSize(0) {
+        nodes.reserve(initialCapacity + 1);
+
+        //The sentinel, which is always BLACK
+        nodes.emplace_back(T(), V(), COMPACT_NIL);
+    }
+
+    ~CompactRedBlackTree() override {}
+
+    /**
+     * Make sure the pool has space for the given amount of nodes, so adding them does not move the pool around
+     */
+    void reserve(unsigned int capacity) {
+        nodes.reserve(capacity + 1);
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        uint32_t parent = COMPACT_NIL, current = root;
+
+        while (current != COMPACT_NIL) {
+
+            parent = current;
+
+            const T &currentKey = node(current).getKey();
+
+            if (currentKey == *key) {
+                node(current).setValue(*value);
+
+                return;
+            } else if (*key < currentKey) {
+                current = node(current).getLeft();
+            } else {
+                current = node(current).getRight();
+            }
+        }
+
+        uint32_t z = allocateNode(*key, *value, parent);
+
+        //A Node always starts as a RED node
+        node(z).setRed(true);
+
+        if (parent == COMPACT_NIL) {
+            root = z;
+        } else if (*key < node(parent).getKey()) {
+            node(parent).setLeft(z);
+        } else {
+            node(parent).setRight(z);
+        }
+
+        if (smallest == COMPACT_NIL || *key < node(smallest).getKey()) {
+            smallest = z;
+        }
+
+        if (largest == COMPACT_NIL || node(largest).getKey() < *key) {
+            largest = z;
+        }
+
+        treeSize++;
+
+        insertFixup(z);
+    }
+
+    bool hasKey(const T &key) override {
+        return findNode(key) != COMPACT_NIL;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        uint32_t index = findNode(key);
+
+        if (index != COMPACT_NIL) {
+            return std::make_shared<V>(node(index).getValue());
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        uint32_t index = findNode(key);
+
+        if (index == COMPACT_NIL) {
+            return std::nullopt;
+        }
+
+        return std::make_shared<V>(removeIndex(index));
+    }
+
+    unsigned int size() override {
+        return this->treeSize;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto result = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        result->reserve(this->size());
+
+        for (uint32_t current = smallest; current != COMPACT_NIL; current = successor(current)) {
+            result->push_back(std::make_shared<T>(node(current).getKey()));
+        }
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto result = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        result->reserve(this->size());
+
+        for (uint32_t current = smallest; current != COMPACT_NIL; current = successor(current)) {
+            result->push_back(std::make_shared<V>(node(current).getValue()));
+        }
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        result->reserve(this->size());
+
+        traverseTree(result.get());
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        uint32_t current = root, lowerBound = COMPACT_NIL;
+
+        //Find the smallest node that is >= base
+        while (current != COMPACT_NIL) {
+            if (node(current).getKey() < base) {
+                current = node(current).getRight();
+            } else {
+                lowerBound = current;
+
+                current = node(current).getLeft();
+            }
+        }
+
+        for (current = lowerBound; current != COMPACT_NIL && !(max < node(current).getKey());
+             current = successor(current)) {
+            result->push_back(nodeInfo(current));
+        }
+
+        return result;
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+
+        if (smallest == COMPACT_NIL) {
+            return std::nullopt;
+        }
+
+        return nodeInfo(smallest);
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+
+        if (largest == COMPACT_NIL) {
+            return std::nullopt;
+        }
+
+        return nodeInfo(largest);
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        if (smallest == COMPACT_NIL) {
+            return std::nullopt;
+        }
+
+        auto key = std::make_shared<T>(node(smallest).getKey());
+
+        return std::make_tuple(key, std::make_shared<V>(removeIndex(smallest)));
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        if (largest == COMPACT_NIL) {
+            return std::nullopt;
+        }
+
+        auto key = std::make_shared<T>(node(largest).getKey());
+
+        return std::make_tuple(key, std::make_shared<V>(removeIndex(largest)));
+    }
+
+    uint32_t getRoot() const {
+        return root;
+    }
+
+    const CompactNode<T, V> &getNode(uint32_t index) const {
+        return nodes[index];
+    }
+
+    /**
+     * The amount of slots in the pool, counting the free ones but not the sentinel
+     */
+    size_t getPoolSize() const {
+        return nodes.size() - 1;
+    }
+};
+
+#endif //TRABALHO1_COMPACTTREE_H
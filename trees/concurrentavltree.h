@@ -0,0 +1,830 @@
+#ifndef TRABALHO1_CONCURRENTAVLTREE_H
+#define TRABALHO1_CONCURRENTAVLTREE_H
+
+#include "../datastructures.h"
+#include "../epochreclamation.h"
+#include <atomic>
+#include <stack>
+#include <thread>
+#include <vector>
+
+template<typename T, typename V>
+class ConcurrentAVLNode {
+
+private:
+    //Never changes after the node is created
+    std::shared_ptr<T> key;
+
+    //Null when the node is only a routing node (Its key was removed but it still had two children).
+    //The pointed value is never changed, a new one is swapped in instead, so readers can copy it without locks
+    std::atomic<std::shared_ptr<V> *> value;
+
+    std::atomic<ConcurrentAVLNode<T, V> *> leftNode, rightNode, parent;
+
+    std::atomic_int height;
+
+    std::atomic_bool unlinked;
+
+    //Odd while a writer holds the node, incremented every time the node is changed
+    std::atomic_uint64_t version;
+
+public:
+    ConcurrentAVLNode(std::shared_ptr<T> key, std::shared_ptr<V> *value, ConcurrentAVLNode<T, V> *parent) :
+            key(std::move(key)), value(value), leftNode(nullptr), rightNode(nullptr), parent(parent), height(1),
+            unlinked(false), version(0) {}
+
+    ~ConcurrentAVLNode() {
+        delete this->value.load();
+    }
+
+    const T *getKeyVal() const {
+        return key.get();
+    }
+
+    std::shared_ptr<T> getKey() const {
+        return key;
+    }
+
+    std::shared_ptr<V> *getValue() const {
+        return value.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Must be called with the node locked
+     * @return The previous value, that has to be retired by the caller
+     */
+    std::shared_ptr<V> *exchangeValue(std::shared_ptr<V> *newValue) {
+        return value.exchange(newValue, std::memory_order_acq_rel);
+    }
+
+    ConcurrentAVLNode<T, V> *getLeftChild() const {
+        return leftNode.load(std::memory_order_acquire);
+    }
+
+    ConcurrentAVLNode<T, V> *getRightChild() const {
+        return rightNode.load(std::memory_order_acquire);
+    }
+
+    void setLeftChild(ConcurrentAVLNode<T, V> *node) {
+        this->leftNode.store(node, std::memory_order_release);
+    }
+
+    void setRightChild(ConcurrentAVLNode<T, V> *node) {
+        this->rightNode.store(node, std::memory_order_release);
+    }
+
+    ConcurrentAVLNode<T, V> *getParent() const {
+        return parent.load(std::memory_order_acquire);
+    }
+
+    void setParent(ConcurrentAVLNode<T, V> *parent) {
+        this->parent.store(parent, std::memory_order_release);
+    }
+
+    int getHeight() const {
+        return height.load(std::memory_order_relaxed);
+    }
+
+    void setHeight(int height) {
+        this->height.store(height, std::memory_order_relaxed);
+    }
+
+    bool isUnlinked() const {
+        return unlinked.load(std::memory_order_acquire);
+    }
+
+    void setUnlinked() {
+        this->unlinked.store(true, std::memory_order_release);
+    }
+
+    /**
+     * Wait until no writer holds the node and get its version
+     */
+    uint64_t stableVersion() const {
+
+        uint64_t current = version.load(std::memory_order_acquire);
+
+        while ((current & 1) != 0) {
+            std::this_thread::yield();
+
+            current = version.load(std::memory_order_acquire);
+        }
+
+        return current;
+    }
+
+    /**
+     * Every read of the node's fields is an acquire load, so none of them can be moved after this check
+     * @return Whether the node is still the same as it was when we got the version
+     */
+    bool validate(uint64_t readVersion) const {
+        return version.load(std::memory_order_acquire) == readVersion;
+    }
+
+    /**
+     * Lock the node only if it didn't change since we got the version
+     */
+    bool tryLock(uint64_t readVersion) {
+        return version.compare_exchange_strong(readVersion, readVersion + 1, std::memory_order_acquire);
+    }
+
+    void lock() {
+        while (!tryLock(stableVersion())) {}
+    }
+
+    void unlock() {
+        version.fetch_add(1, std::memory_order_release);
+    }
+};
+
+/**
+ * AVL tree that can be used by many threads at the same time, with relaxed balance in the style of Bronson et al.
+ *
+ * Every node has a version lock. Readers take no locks at all: they read the version of each node on the path,
+ * follow the child pointer and check that the version didn't change (Optimistic lock coupling), restarting from the
+ * root if a writer got in the way. Writers do the same optimistic descent and then only lock the nodes they
+ * change, upgrading from the versions they read.
+ *
+ * Removing a key from a node with two children only turns it into a routing node, which is unlinked later once it
+ * has a single child. Unlinked nodes are freed through epoch based reclamation, since readers might still be on
+ * them. The rebalancing runs bottom up after each change, locking parent before child, and a tree that is being
+ * changed by many threads may be briefly out of balance.
+ */
+template<typename T, typename V>
+class ConcurrentAvlTree : public OrderedMap<T, V> {
+
+private:
+    //Declared first so it's destroyed last, after the tree itself
+    EpochReclaimer reclaimer;
+
+    //Sentinel with no key, the actual root is its right child
+    ConcurrentAVLNode<T, V> rootHolder;
+
+    std::atomic_uint32_t treeSize;
+
+    static int heightOf(ConcurrentAVLNode<T, V> *node) {
+        if (node == nullptr) return 0;
+
+        return node->getHeight();
+    }
+
+    static void updateHeight(ConcurrentAVLNode<T, V> *node) {
+        node->setHeight(1 + std::max(heightOf(node->getLeftChild()), heightOf(node->getRightChild())));
+    }
+
+    /**
+     * Must be called with the parent locked
+     */
+    static void replaceChild(ConcurrentAVLNode<T, V> *parent, ConcurrentAVLNode<T, V> *oldChild,
+                             ConcurrentAVLNode<T, V> *newChild) {
+
+        if (parent->getLeftChild() == oldChild) {
+            parent->setLeftChild(newChild);
+        } else {
+            parent->setRightChild(newChild);
+        }
+
+        if (newChild != nullptr) {
+            newChild->setParent(parent);
+        }
+    }
+
+    /**
+     * Find the node with the given key.
+     *
+     * Ends with node set to the node that has the key, or to null with parent being the node the key would be
+     * inserted under. Both versions are validated against each other, so parent still had node as a child.
+     *
+     * @return false if a writer changed the path and the search has to be restarted
+     */
+    bool optimisticFind(const T &key, ConcurrentAVLNode<T, V> *&parent, uint64_t &parentVersion,
+                        ConcurrentAVLNode<T, V> *&node, uint64_t &nodeVersion) {
+
+        parent = &rootHolder;
+        parentVersion = parent->stableVersion();
+
+        node = parent->getRightChild();
+
+        if (!parent->validate(parentVersion)) return false;
+
+        while (node != nullptr) {
+
+            nodeVersion = node->stableVersion();
+
+            //The parent might have changed between reading the child and reading its version
+            if (!parent->validate(parentVersion)) return false;
+
+            const T &nodeKey = *node->getKeyVal();
+
+            if (key == nodeKey) return true;
+
+            ConcurrentAVLNode<T, V> *next = key < nodeKey ? node->getLeftChild() : node->getRightChild();
+
+            if (!node->validate(nodeVersion)) return false;
+
+            parent = node;
+            parentVersion = nodeVersion;
+
+            node = next;
+        }
+
+        return true;
+    }
+
+    /**
+     * Find the smallest (Or largest) node that has a value, skipping routing nodes with an in order traversal
+     *
+     * @return false if a writer changed the path and the search has to be restarted
+     */
+    bool optimisticExtreme(bool smallest, ConcurrentAVLNode<T, V> *&found, uint64_t &foundVersion) {
+
+        std::vector<std::pair<ConcurrentAVLNode<T, V> *, uint64_t>> path;
+
+        ConcurrentAVLNode<T, V> *linkNode = &rootHolder;
+
+        uint64_t linkVersion = linkNode->stableVersion();
+
+        path.emplace_back(linkNode, linkVersion);
+
+        ConcurrentAVLNode<T, V> *current = linkNode->getRightChild();
+
+        if (!linkNode->validate(linkVersion)) return false;
+
+        while (true) {
+
+            //Go as far as possible towards the extreme
+            while (current != nullptr) {
+                uint64_t currentVersion = current->stableVersion();
+
+                if (!linkNode->validate(linkVersion)) return false;
+
+                path.emplace_back(current, currentVersion);
+
+                ConcurrentAVLNode<T, V> *next = smallest ? current->getLeftChild() : current->getRightChild();
+
+                if (!current->validate(currentVersion)) return false;
+
+                linkNode = current;
+                linkVersion = currentVersion;
+
+                current = next;
+            }
+
+            auto [node, version] = path.back();
+
+            path.pop_back();
+
+            if (node == &rootHolder) {
+                //The tree is empty
+                found = nullptr;
+
+                return node->validate(version);
+            }
+
+            if (node->getValue() != nullptr) {
+                found = node;
+                foundVersion = version;
+
+                return true;
+            }
+
+            //A routing node, continue with the subtree on the other side of it
+            current = smallest ? node->getRightChild() : node->getLeftChild();
+
+            if (!node->validate(version)) return false;
+
+            linkNode = node;
+            linkVersion = version;
+        }
+    }
+
+    /**
+     * Lock the parent of the node, making sure it's still its parent after the lock
+     * @return The locked parent, or null if the node was unlinked from the tree
+     */
+    ConcurrentAVLNode<T, V> *lockParent(ConcurrentAVLNode<T, V> *node) {
+
+        while (true) {
+            ConcurrentAVLNode<T, V> *parent = node->getParent();
+
+            parent->lock();
+
+            //A node's parent can only be changed with the old parent locked
+            if (parent->getLeftChild() == node || parent->getRightChild() == node) {
+                return parent;
+            }
+
+            parent->unlock();
+
+            if (node->isUnlinked()) {
+                return nullptr;
+            }
+        }
+    }
+
+    /**
+     * Remove a node with at most one child from the tree, must be called with both nodes locked
+     */
+    void unlink(ConcurrentAVLNode<T, V> *parent, ConcurrentAVLNode<T, V> *node) {
+
+        ConcurrentAVLNode<T, V> *child = node->getLeftChild() != nullptr ? node->getLeftChild()
+                                                                         : node->getRightChild();
+
+        replaceChild(parent, node, child);
+
+        node->setUnlinked();
+    }
+
+    /**
+     * Rotate a left heavy node, with the parent and the node locked
+     */
+    void rotateRight(ConcurrentAVLNode<T, V> *parent, ConcurrentAVLNode<T, V> *node) {
+
+        ConcurrentAVLNode<T, V> *left = node->getLeftChild();
+
+        left->lock();
+
+        ConcurrentAVLNode<T, V> *leftLeft = left->getLeftChild(), *leftRight = left->getRightChild();
+
+        if (heightOf(leftLeft) >= heightOf(leftRight)) {
+
+            node->setLeftChild(leftRight);
+
+            if (leftRight != nullptr) leftRight->setParent(node);
+
+            left->setRightChild(node);
+            node->setParent(left);
+
+            replaceChild(parent, node, left);
+
+            updateHeight(node);
+            updateHeight(left);
+        } else {
+            //Left right case, the grand child becomes the root of the subtree
+            leftRight->lock();
+
+            ConcurrentAVLNode<T, V> *middleLeft = leftRight->getLeftChild(), *middleRight = leftRight->getRightChild();
+
+            left->setRightChild(middleLeft);
+
+            if (middleLeft != nullptr) middleLeft->setParent(left);
+
+            node->setLeftChild(middleRight);
+
+            if (middleRight != nullptr) middleRight->setParent(node);
+
+            leftRight->setLeftChild(left);
+            left->setParent(leftRight);
+
+            leftRight->setRightChild(node);
+            node->setParent(leftRight);
+
+            replaceChild(parent, node, leftRight);
+
+            updateHeight(left);
+            updateHeight(node);
+            updateHeight(leftRight);
+
+            leftRight->unlock();
+        }
+
+        left->unlock();
+    }
+
+    /**
+     * Rotate a right heavy node, with the parent and the node locked
+     */
+    void rotateLeft(ConcurrentAVLNode<T, V> *parent, ConcurrentAVLNode<T, V> *node) {
+
+        ConcurrentAVLNode<T, V> *right = node->getRightChild();
+
+        right->lock();
+
+        ConcurrentAVLNode<T, V> *rightLeft = right->getLeftChild(), *rightRight = right->getRightChild();
+
+        if (heightOf(rightRight) >= heightOf(rightLeft)) {
+
+            node->setRightChild(rightLeft);
+
+            if (rightLeft != nullptr) rightLeft->setParent(node);
+
+            right->setLeftChild(node);
+            node->setParent(right);
+
+            replaceChild(parent, node, right);
+
+            updateHeight(node);
+            updateHeight(right);
+        } else {
+            //Right left case, the grand child becomes the root of the subtree
+            rightLeft->lock();
+
+            ConcurrentAVLNode<T, V> *middleLeft = rightLeft->getLeftChild(), *middleRight = rightLeft->getRightChild();
+
+            right->setLeftChild(middleRight);
+
+            if (middleRight != nullptr) middleRight->setParent(right);
+
+            node->setRightChild(middleLeft);
+
+            if (middleLeft != nullptr) middleLeft->setParent(node);
+
+            rightLeft->setRightChild(right);
+            right->setParent(rightLeft);
+
+            rightLeft->setLeftChild(node);
+            node->setParent(rightLeft);
+
+            replaceChild(parent, node, rightLeft);
+
+            updateHeight(right);
+            updateHeight(node);
+            updateHeight(rightLeft);
+
+            rightLeft->unlock();
+        }
+
+        right->unlock();
+    }
+
+    /**
+     * Walk up from the node fixing the heights, rotating unbalanced nodes and unlinking routing nodes
+     * that no longer need to be in the tree
+     */
+    void rebalance(ConcurrentAVLNode<T, V> *node) {
+
+        while (node != &rootHolder) {
+
+            ConcurrentAVLNode<T, V> *parent = lockParent(node);
+
+            if (parent == nullptr) return;
+
+            node->lock();
+
+            ConcurrentAVLNode<T, V> *left = node->getLeftChild(), *right = node->getRightChild();
+
+            if (node->getValue() == nullptr && (left == nullptr || right == nullptr)) {
+
+                unlink(parent, node);
+
+                node->unlock();
+                parent->unlock();
+
+                reclaimer.retire(node);
+
+                node = parent;
+
+                continue;
+            }
+
+            int balance = heightOf(left) - heightOf(right);
+
+            if (balance > 1) {
+                rotateRight(parent, node);
+            } else if (balance < -1) {
+                rotateLeft(parent, node);
+            } else {
+                int newHeight = 1 + std::max(heightOf(left), heightOf(right));
+
+                if (newHeight == node->getHeight()) {
+                    //Nothing changed above this node
+                    node->unlock();
+                    parent->unlock();
+
+                    return;
+                }
+
+                node->setHeight(newHeight);
+            }
+
+            node->unlock();
+            parent->unlock();
+
+            node = parent;
+        }
+    }
+
+    /**
+     * In order traversal that takes no locks, for the operations that return many entries.
+     *
+     * Each node is only visited if its key is still inside the bounds of the path that led to it, so a node that
+     * was rotated away while we were traversing is skipped instead of being returned twice or out of order.
+     */
+    void collectEntries(ConcurrentAVLNode<T, V> *node, const T *low, const T *high, const T *base, const T *max,
+                        std::vector<node_info<T, V>> *result) {
+
+        if (node == nullptr) return;
+
+        const T &key = *node->getKeyVal();
+
+        if ((low != nullptr && !(*low < key)) || (high != nullptr && !(key < *high))) return;
+
+        if (base == nullptr || *base < key) {
+            collectEntries(node->getLeftChild(), low, &key, base, max, result);
+        }
+
+        std::shared_ptr<V> *value = node->getValue();
+
+        if (value != nullptr && (base == nullptr || !(key < *base)) && (max == nullptr || !(*max < key))) {
+            result->push_back(std::make_tuple(node->getKey(), *value));
+        }
+
+        if (max == nullptr || key < *max) {
+            collectEntries(node->getRightChild(), &key, high, base, max, result);
+        }
+    }
+
+    std::optional<node_info<T, V>> peekExtreme(bool smallest) {
+
+        auto guard = reclaimer.enter();
+
+        while (true) {
+            ConcurrentAVLNode<T, V> *node;
+
+            uint64_t version;
+
+            if (!optimisticExtreme(smallest, node, version)) continue;
+
+            if (node == nullptr) return std::nullopt;
+
+            std::shared_ptr<V> *value = node->getValue();
+
+            if (value == nullptr) continue;
+
+            auto entry = std::make_tuple(node->getKey(), *value);
+
+            if (node->validate(version)) return entry;
+        }
+    }
+
+    std::optional<node_info<T, V>> popExtreme(bool smallest) {
+
+        while (true) {
+            auto extreme = peekExtreme(smallest);
+
+            if (!extreme) return std::nullopt;
+
+            //Another thread might remove it first, in which case we try the next one
+            auto value = remove(*std::get<0>(*extreme));
+
+            if (value) {
+                return std::make_tuple(std::get<0>(*extreme), *value);
+            }
+        }
+    }
+
+public:
+    ConcurrentAvlTree() : reclaimer(), rootHolder(nullptr, nullptr, nullptr), treeSize(0) {}
+
+    ~ConcurrentAvlTree() override {
+
+        std::stack<ConcurrentAVLNode<T, V> *> toDelete;
+
+        if (rootHolder.getRightChild() != nullptr) {
+            toDelete.push(rootHolder.getRightChild());
+        }
+
+        while (!toDelete.empty()) {
+            auto *node = toDelete.top();
+
+            toDelete.pop();
+
+            if (node->getLeftChild() != nullptr) toDelete.push(node->getLeftChild());
+            if (node->getRightChild() != nullptr) toDelete.push(node->getRightChild());
+
+            delete node;
+        }
+    }
+
+    ConcurrentAVLNode<T, V> *getRootNode() const {
+        return rootHolder.getRightChild();
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        auto guard = reclaimer.enter();
+
+        auto *newValue = new std::shared_ptr<V>(std::move(value));
+
+        while (true) {
+            ConcurrentAVLNode<T, V> *parent, *node;
+
+            uint64_t parentVersion, nodeVersion;
+
+            if (!optimisticFind(*key, parent, parentVersion, node, nodeVersion)) continue;
+
+            if (node != nullptr) {
+                //The key is already in the tree, possibly in a routing node
+                if (!node->tryLock(nodeVersion)) continue;
+
+                std::shared_ptr<V> *oldValue = node->exchangeValue(newValue);
+
+                node->unlock();
+
+                if (oldValue == nullptr) {
+                    treeSize++;
+                } else {
+                    reclaimer.retire(oldValue);
+                }
+
+                return;
+            }
+
+            //The version didn't change, so the child we're inserting in is still empty
+            if (!parent->tryLock(parentVersion)) continue;
+
+            auto *created = new ConcurrentAVLNode<T, V>(key, newValue, parent);
+
+            if (parent != &rootHolder && *key < *parent->getKeyVal()) {
+                parent->setLeftChild(created);
+            } else {
+                parent->setRightChild(created);
+            }
+
+            parent->unlock();
+
+            treeSize++;
+
+            rebalance(parent);
+
+            return;
+        }
+    }
+
+    bool hasKey(const T &key) override {
+        return get(key).has_value();
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        auto guard = reclaimer.enter();
+
+        while (true) {
+            ConcurrentAVLNode<T, V> *parent, *node;
+
+            uint64_t parentVersion, nodeVersion;
+
+            if (!optimisticFind(key, parent, parentVersion, node, nodeVersion)) continue;
+
+            if (node == nullptr) return std::nullopt;
+
+            std::shared_ptr<V> *value = node->getValue();
+
+            std::shared_ptr<V> result;
+
+            if (value != nullptr) {
+                result = *value;
+            }
+
+            if (!node->validate(nodeVersion)) continue;
+
+            if (value == nullptr) return std::nullopt;
+
+            return result;
+        }
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        auto guard = reclaimer.enter();
+
+        while (true) {
+            ConcurrentAVLNode<T, V> *parent, *node;
+
+            uint64_t parentVersion, nodeVersion;
+
+            if (!optimisticFind(key, parent, parentVersion, node, nodeVersion)) continue;
+
+            if (node == nullptr) return std::nullopt;
+
+            if (node->getValue() == nullptr) {
+                //Routing node
+                if (node->validate(nodeVersion)) return std::nullopt;
+
+                continue;
+            }
+
+            if (node->getLeftChild() != nullptr && node->getRightChild() != nullptr) {
+
+                //Two children, we only remove the value and keep the node for routing
+                if (!node->tryLock(nodeVersion)) continue;
+
+                std::shared_ptr<V> *oldValue = node->exchangeValue(nullptr);
+
+                node->unlock();
+
+                treeSize--;
+
+                std::shared_ptr<V> result = *oldValue;
+
+                reclaimer.retire(oldValue);
+
+                return result;
+            }
+
+            //Lock from the top down, like the rebalancing does
+            if (!parent->tryLock(parentVersion)) continue;
+
+            if (!node->tryLock(nodeVersion)) {
+                parent->unlock();
+
+                continue;
+            }
+
+            unlink(parent, node);
+
+            std::shared_ptr<V> result = *node->getValue();
+
+            node->unlock();
+            parent->unlock();
+
+            treeSize--;
+
+            reclaimer.retire(node);
+
+            rebalance(parent);
+
+            return result;
+        }
+    }
+
+    unsigned int size() override {
+        return treeSize.load();
+    }
+
+    /**
+     * The operations that return many entries are weakly consistent, they see every entry that was in the tree
+     * for their whole duration, but might or might not see the ones that are changed while they run
+     */
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+
+        auto guard = reclaimer.enter();
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        result->reserve(size());
+
+        collectEntries(rootHolder.getRightChild(), nullptr, nullptr, nullptr, nullptr, result.get());
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto entries = this->entries();
+
+        auto result = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        result->reserve(entries->size());
+
+        for (auto &entry : *entries) {
+            result->push_back(std::get<0>(entry));
+        }
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto entries = this->entries();
+
+        auto result = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        result->reserve(entries->size());
+
+        for (auto &entry : *entries) {
+            result->push_back(std::get<1>(entry));
+        }
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+
+        auto guard = reclaimer.enter();
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        collectEntries(rootHolder.getRightChild(), nullptr, nullptr, &base, &max, result.get());
+
+        return result;
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+        return peekExtreme(true);
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+        return peekExtreme(false);
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+        return popExtreme(true);
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+        return popExtreme(false);
+    }
+};
+
+#endif //TRABALHO1_CONCURRENTAVLTREE_H
@@ -0,0 +1,351 @@
+#ifndef TRABALHO1_CONCURRENTMAPADAPTOR_H
+#define TRABALHO1_CONCURRENTMAPADAPTOR_H
+
+#include "../datastructures.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Amount of reader indicators, each one in its own cache line, threads get spread among them
+#define CONCURRENT_READER_SLOTS 64
+#define CACHE_LINE_SIZE 64
+
+enum AdaptorMode {
+    //Each writer takes the write lock and applies its own operation
+    EXCLUSIVE_WRITES,
+    //Writers queue their operations and whoever gets the write lock applies the whole batch
+    FLAT_COMBINING
+};
+
+struct alignas(CACHE_LINE_SIZE) ReaderSlot {
+    std::atomic_int readers{0};
+};
+
+/**
+ * Announces a reader in its slot for as long as it lives, so the slot is left even if the read throws
+ */
+class ReaderSlotGuard {
+
+private:
+    std::atomic_int &readers;
+
+public:
+    explicit ReaderSlotGuard(std::atomic_int &readers) : readers(readers) {
+        this->readers.fetch_add(1);
+    }
+
+    ReaderSlotGuard(const ReaderSlotGuard &) = delete;
+
+    ReaderSlotGuard &operator=(const ReaderSlotGuard &) = delete;
+
+    ~ReaderSlotGuard() {
+        this->readers.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+/**
+ * A write that is waiting to be applied by the combiner thread
+ */
+template<typename T, typename V>
+class CombinedWrite {
+
+public:
+    enum WriteType {
+        ADD,
+        REMOVE,
+        POP_SMALLEST,
+        POP_LARGEST
+    };
+
+    WriteType type;
+
+    std::shared_ptr<T> key;
+    std::shared_ptr<V> value;
+
+    const T *removedKey;
+
+    std::optional<std::shared_ptr<V>> removedValue;
+    std::optional<node_info<T, V>> poppedNode;
+
+    std::atomic_bool done;
+
+    explicit CombinedWrite(WriteType type) : type(type), removedKey(nullptr), done(false) {}
+};
+
+/**
+ * Makes any OrderedMap safe to use from multiple threads.
+ *
+ * Readers don't write to the version or to a lock. They read the version of the map (Odd while a writer is active),
+ * announce themselves in the reader slot their thread id hashes to and check that the version didn't change in the
+ * meantime, retrying if it did. Threads only share a slot when their ids hash to the same one, so most readers
+ * don't bounce a cache line between each other. Writers take the write lock, make the version odd and wait for the
+ * readers that got in before them to leave. A plain seqlock would let the readers run at the same time as the
+ * writer, but the trees free their nodes when removing them, so a reader could follow a pointer into freed memory.
+ *
+ * Maps whose reads change their structure (Like the splay tree) have to be created with exclusiveReads.
+ */
+template<typename T, typename V>
+class ConcurrentMapAdaptor : public OrderedMap<T, V> {
+
+private:
+    std::unique_ptr<OrderedMap<T, V>> map;
+
+    AdaptorMode mode;
+
+    bool exclusiveReads;
+
+    std::atomic_uint64_t version;
+
+    ReaderSlot readerSlots[CONCURRENT_READER_SLOTS];
+
+    std::mutex writeLock;
+
+    std::mutex pendingLock;
+
+    std::vector<CombinedWrite<T, V> *> pendingWrites;
+
+    static unsigned int getReaderSlot() {
+        static thread_local unsigned int slot =
+                std::hash<std::thread::id>()(std::this_thread::get_id()) % CONCURRENT_READER_SLOTS;
+
+        return slot;
+    }
+
+    template<typename Result, typename Operation>
+    Result read(Operation operation) {
+
+        if (this->exclusiveReads) {
+            return write<Result>(operation);
+        }
+
+        std::atomic_int &readers = readerSlots[getReaderSlot()].readers;
+
+        while (true) {
+            uint64_t startVersion = version.load(std::memory_order_acquire);
+
+            if ((startVersion & 1) != 0) {
+                //A writer is active
+                std::this_thread::yield();
+
+                continue;
+            }
+
+            ReaderSlotGuard guard(readers);
+
+            if (version.load() != startVersion) {
+                //A writer got in between, so it might not have seen us
+                continue;
+            }
+
+            return operation(this->map.get());
+        }
+    }
+
+    /**
+     * Must be called with the write lock held
+     */
+    void startWrite() {
+        version.fetch_add(1);
+
+        //Wait for the readers that came in before the version changed. Like the version load of the readers, this load
+        //has to be sequentially consistent, or the writer could miss a reader that also missed the new version
+        for (auto &slot : readerSlots) {
+            while (slot.readers.load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void endWrite() {
+        version.fetch_add(1, std::memory_order_release);
+    }
+
+    template<typename Result, typename Operation>
+    Result write(Operation operation) {
+
+        std::lock_guard<std::mutex> lock(writeLock);
+
+        startWrite();
+
+        Result result = operation(this->map.get());
+
+        endWrite();
+
+        return result;
+    }
+
+    void applyWrite(CombinedWrite<T, V> *pending) {
+
+        switch (pending->type) {
+            case CombinedWrite<T, V>::ADD:
+                this->map->add(std::move(pending->key), std::move(pending->value));
+                break;
+            case CombinedWrite<T, V>::REMOVE:
+                pending->removedValue = this->map->remove(*pending->removedKey);
+                break;
+            case CombinedWrite<T, V>::POP_SMALLEST:
+                pending->poppedNode = this->map->popSmallest();
+                break;
+            case CombinedWrite<T, V>::POP_LARGEST:
+                pending->poppedNode = this->map->popLargest();
+                break;
+        }
+    }
+
+    /**
+     * Apply every pending write, must be called with the write lock held
+     */
+    void combine() {
+
+        std::vector<CombinedWrite<T, V> *> batch;
+
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(pendingLock);
+
+                batch.swap(pendingWrites);
+            }
+
+            if (batch.empty()) break;
+
+            //The whole batch only has to wait for the readers once
+            startWrite();
+
+            for (auto *pending : batch) {
+                applyWrite(pending);
+            }
+
+            endWrite();
+
+            for (auto *pending : batch) {
+                pending->done.store(true, std::memory_order_release);
+            }
+
+            batch.clear();
+        }
+    }
+
+    void submit(CombinedWrite<T, V> *pending) {
+
+        if (this->mode == EXCLUSIVE_WRITES) {
+            std::lock_guard<std::mutex> lock(writeLock);
+
+            startWrite();
+
+            applyWrite(pending);
+
+            endWrite();
+
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pendingLock);
+
+            pendingWrites.push_back(pending);
+        }
+
+        while (!pending->done.load(std::memory_order_acquire)) {
+
+            //If nobody is combining, become the combiner.
+            //Otherwise our write will be applied by the current combiner
+            if (writeLock.try_lock()) {
+                combine();
+
+                writeLock.unlock();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+public:
+    explicit ConcurrentMapAdaptor(std::unique_ptr<OrderedMap<T, V>> map, AdaptorMode mode = EXCLUSIVE_WRITES,
+                                  bool exclusiveReads = false) : map(std::move(map)), mode(mode),
+                                                                 exclusiveReads(exclusiveReads), version(0) {}
+
+    ~ConcurrentMapAdaptor() override {}
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        CombinedWrite<T, V> pending(CombinedWrite<T, V>::ADD);
+
+        pending.key = std::move(key);
+        pending.value = std::move(value);
+
+        submit(&pending);
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        CombinedWrite<T, V> pending(CombinedWrite<T, V>::REMOVE);
+
+        pending.removedKey = &key;
+
+        submit(&pending);
+
+        return pending.removedValue;
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        CombinedWrite<T, V> pending(CombinedWrite<T, V>::POP_SMALLEST);
+
+        submit(&pending);
+
+        return pending.poppedNode;
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        CombinedWrite<T, V> pending(CombinedWrite<T, V>::POP_LARGEST);
+
+        submit(&pending);
+
+        return pending.poppedNode;
+    }
+
+    bool hasKey(const T &key) override {
+        return read<bool>([&key](OrderedMap<T, V> *map) { return map->hasKey(key); });
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+        return read<std::optional<std::shared_ptr<V>>>([&key](OrderedMap<T, V> *map) { return map->get(key); });
+    }
+
+    unsigned int size() override {
+        return read<unsigned int>([](OrderedMap<T, V> *map) { return map->size(); });
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+        return read<std::unique_ptr<std::vector<std::shared_ptr<T>>>>(
+                [](OrderedMap<T, V> *map) { return map->keys(); });
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+        return read<std::unique_ptr<std::vector<std::shared_ptr<V>>>>(
+                [](OrderedMap<T, V> *map) { return map->values(); });
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+        return read<std::unique_ptr<std::vector<node_info<T, V>>>>(
+                [](OrderedMap<T, V> *map) { return map->entries(); });
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+        return read<std::unique_ptr<std::vector<node_info<T, V>>>>(
+                [&base, &max](OrderedMap<T, V> *map) { return map->rangeSearch(base, max); });
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+        return read<std::optional<node_info<T, V>>>([](OrderedMap<T, V> *map) { return map->peekSmallest(); });
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+        return read<std::optional<node_info<T, V>>>([](OrderedMap<T, V> *map) { return map->peekLargest(); });
+    }
+};
+
+#endif //TRABALHO1_CONCURRENTMAPADAPTOR_H
@@ -0,0 +1,270 @@
+#ifndef TRABALHO1_FILTEREDMAPADAPTOR_H
+#define TRABALHO1_FILTEREDMAPADAPTOR_H
+
+#include "../datastructures.h"
+#include "../filters/countingbloomfilter.h"
+#include <cstdint>
+
+//The filter is first sized for this many keys
+#define FILTERED_MAP_INITIAL_KEYS 1024
+//False positive rate the filter is sized for
+#define FILTERED_MAP_FALSE_POSITIVE_RATE 0.01
+//The filter is rebuilt once the false positives measured are this many times the rate it was sized for
+#define FILTERED_MAP_REBUILD_FACTOR 4
+//Lookups of missing keys that have to be seen before the measured rate is trusted
+#define FILTERED_MAP_MIN_SAMPLES 1024
+
+/**
+ * How the lookups through the filter went
+ */
+struct FilterStats {
+    //Lookups of keys that are in the map
+    uint64_t hits;
+
+    //Lookups of missing keys that the filter answered on its own
+    uint64_t filtered;
+
+    //Lookups of missing keys that the filter let through to the map
+    uint64_t falsePositives;
+
+    uint64_t rebuilds;
+
+    double falsePositiveRate() const {
+        return filtered + falsePositives == 0 ? 0 : (double) falsePositives / (double) (filtered + falsePositives);
+    }
+};
+
+/**
+ * Puts a counting Bloom filter in front of any OrderedMap, so lookups of keys that aren't in the map are answered
+ * without going through the map at all. The filter knows every key of the map (Removed keys are removed from it too),
+ * so it never hides a key that is there.
+ *
+ * The filter is sized for twice the keys of the map whenever it's rebuilt, from the keys of the map. It's rebuilt when
+ * the map outgrows it, when the map shrinks to a fraction of it, and when the false positives it lets through get well
+ * above the rate it was sized for (Counters that saturated can't be decremented, so a filter with a lot of churn
+ * slowly fills up).
+ */
+template<typename T, typename V>
+class FilteredMapAdaptor : public OrderedMap<T, V> {
+
+private:
+    std::unique_ptr<OrderedMap<T, V>> map;
+
+    std::unique_ptr<CountingBloomFilter<T>> filter;
+
+    //How many keys the filter was sized for
+    unsigned int filterCapacity;
+
+    FilterStats stats;
+
+    //Missing keys looked up, and the ones the filter let through, since the filter was last built
+    uint64_t sampledMisses, sampledFalsePositives;
+
+    void rebuildFilter() {
+
+        this->filterCapacity = std::max(this->map->size() * 2, (unsigned int) FILTERED_MAP_INITIAL_KEYS);
+
+        this->filter = CountingBloomFilter<T>::forExpectedSize(this->filterCapacity, FILTERED_MAP_FALSE_POSITIVE_RATE);
+
+        auto keys = this->map->keys();
+
+        for (auto &key : *keys) {
+            this->filter->add(*key);
+        }
+
+        this->sampledMisses = 0;
+        this->sampledFalsePositives = 0;
+
+        this->stats.rebuilds++;
+    }
+
+    void checkSize() {
+
+        unsigned int size = this->map->size();
+
+        if (size > this->filterCapacity ||
+            (this->filterCapacity > FILTERED_MAP_INITIAL_KEYS && size < this->filterCapacity / 8)) {
+            rebuildFilter();
+        }
+    }
+
+    /**
+     * Count a lookup of a missing key, and rebuild the filter if it lets too many of them through
+     */
+    void countMiss(bool falsePositive) {
+
+        this->sampledMisses++;
+
+        if (!falsePositive) {
+            this->stats.filtered++;
+
+            return;
+        }
+
+        this->stats.falsePositives++;
+
+        this->sampledFalsePositives++;
+
+        //Enough samples that the rebuild pays for itself
+        if (this->sampledMisses >= std::max((uint64_t) FILTERED_MAP_MIN_SAMPLES, (uint64_t) this->map->size()) &&
+            this->sampledFalsePositives >
+            this->sampledMisses * FILTERED_MAP_FALSE_POSITIVE_RATE * FILTERED_MAP_REBUILD_FACTOR) {
+            rebuildFilter();
+        }
+    }
+
+    /**
+     * Take a key that left the map out of the filter
+     */
+    void forget(const T &key) {
+
+        this->filter->remove(key);
+
+        checkSize();
+    }
+
+public:
+    explicit FilteredMapAdaptor(std::unique_ptr<OrderedMap<T, V>> map) : map(std::move(map)), filterCapacity(0),
+                                                                         stats(), sampledMisses(0),
+                                                                         sampledFalsePositives(0) {
+        rebuildFilter();
+
+        this->stats.rebuilds = 0;
+    }
+
+    ~FilteredMapAdaptor() override {}
+
+    FilterStats getStats() const {
+        return this->stats;
+    }
+
+    void resetStats() {
+        this->stats = FilterStats();
+    }
+
+    unsigned int getFilterCapacity() const {
+        return this->filterCapacity;
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        unsigned int previousSize = this->map->size();
+
+        std::shared_ptr<T> addedKey = key;
+
+        this->map->add(std::move(key), std::move(value));
+
+        //Replacing the value of a key doesn't add it to the filter again
+        if (this->map->size() > previousSize) {
+            this->filter->add(*addedKey);
+
+            checkSize();
+        }
+    }
+
+    bool hasKey(const T &key) override {
+
+        if (!this->filter->test(key)) {
+            countMiss(false);
+
+            return false;
+        }
+
+        bool found = this->map->hasKey(key);
+
+        if (found) {
+            this->stats.hits++;
+        } else {
+            countMiss(true);
+        }
+
+        return found;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+
+        if (!this->filter->test(key)) {
+            countMiss(false);
+
+            return std::nullopt;
+        }
+
+        auto value = this->map->get(key);
+
+        if (value) {
+            this->stats.hits++;
+        } else {
+            countMiss(true);
+        }
+
+        return value;
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        //Removing a key that isn't there doesn't need the map either
+        if (!this->filter->test(key)) {
+            return std::nullopt;
+        }
+
+        auto value = this->map->remove(key);
+
+        if (value) {
+            forget(key);
+        }
+
+        return value;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+        return this->map->keys();
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+        return this->map->values();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+        return this->map->entries();
+    }
+
+    unsigned int size() override {
+        return this->map->size();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+        return this->map->rangeSearch(base, max);
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+        return this->map->peekSmallest();
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+        return this->map->peekLargest();
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        auto popped = this->map->popSmallest();
+
+        if (popped) {
+            forget(*std::get<0>(*popped));
+        }
+
+        return popped;
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        auto popped = this->map->popLargest();
+
+        if (popped) {
+            forget(*std::get<0>(*popped));
+        }
+
+        return popped;
+    }
+};
+
+#endif //TRABALHO1_FILTEREDMAPADAPTOR_H
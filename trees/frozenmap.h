@@ -0,0 +1,172 @@
+#ifndef TRABALHO1_FROZENMAP_H
+#define TRABALHO1_FROZENMAP_H
+
+#include "../datastructures.h"
+#include <cstdint>
+#include <vector>
+
+//Size of the cache line we want to prefetch into
+#define FROZEN_CACHE_LINE 64
+
+/**
+ * Immutable snapshot of an ordered map, meant for maps that are queried for a long time without any changes.
+ *
+ * The keys are stored in Eytzinger layout (The order of a breadth first traversal of a complete binary tree, where
+ * the children of position k are in 2k and 2k + 1), so the top levels of the search all share a few cache lines
+ * and the search needs no pointers and no branches. The entries themselves are kept in order, so range searches
+ * are a linear scan.
+ */
+template<typename T, typename V>
+class FrozenOrderedMap {
+
+private:
+    //Position 0 is unused, so the root is in position 1
+    std::vector<T> eytzingerKeys;
+
+    //The position in the sorted entries of each key in the Eytzinger layout
+    std::vector<uint32_t> sortedPositions;
+
+    std::vector<node_info<T, V>> sortedEntries;
+
+    /**
+     * How many keys fit in a cache line. Prefetching k * this gets us the descendants of k four levels down
+     * (For 4 byte keys) in a single cache line
+     */
+    static constexpr size_t keysPerCacheLine() {
+        return sizeof(T) >= FROZEN_CACHE_LINE ? 1 : FROZEN_CACHE_LINE / sizeof(T);
+    }
+
+    /**
+     * Fill the layout by doing an in order traversal of the implicit tree, the sorted entries come out in order
+     * @return The next sorted entry to place
+     */
+    size_t buildLayout(size_t sortedPosition, size_t k) {
+
+        if (k < eytzingerKeys.size()) {
+            sortedPosition = buildLayout(sortedPosition, 2 * k);
+
+            eytzingerKeys[k] = *std::get<0>(sortedEntries[sortedPosition]);
+            sortedPositions[k] = (uint32_t) sortedPosition;
+
+            sortedPosition = buildLayout(sortedPosition + 1, 2 * k + 1);
+        }
+
+        return sortedPosition;
+    }
+
+    /**
+     * Branchless search for the first key that is >= than the given key
+     * @return The position in the sorted entries, or size() if every key is smaller
+     */
+    size_t lowerBound(const T &key) const {
+
+        const size_t n = eytzingerKeys.size();
+
+        const T *keys = eytzingerKeys.data();
+
+        size_t k = 1;
+
+        while (k < n) {
+#if defined(__GNUC__)
+            __builtin_prefetch(keys + k * keysPerCacheLine());
+#endif
+            //Go right when the key is smaller than the one we're looking for, left otherwise
+            k = 2 * k + (keys[k] < key);
+        }
+
+        //Every right turn we took at the end of the path has to be undone, the last left turn is the lower bound
+#if defined(__GNUC__)
+        k >>= __builtin_ffsll((long long) ~k);
+#else
+        while ((k & 1) != 0) {
+            k >>= 1;
+        }
+
+        k >>= 1;
+#endif
+
+        if (k == 0) {
+            return sortedEntries.size();
+        }
+
+        return sortedPositions[k];
+    }
+
+public:
+    /**
+     * @param entries The entries of the map, sorted by key
+     */
+    explicit FrozenOrderedMap(std::vector<node_info<T, V>> entries) : eytzingerKeys(entries.size() + 1),
+                                                                      sortedPositions(entries.size() + 1),
+                                                                      sortedEntries(std::move(entries)) {
+        buildLayout(0, 1);
+    }
+
+    explicit FrozenOrderedMap(OrderedMap<T, V> *map) : FrozenOrderedMap(std::move(*map->entries())) {}
+
+    unsigned int size() const {
+        return sortedEntries.size();
+    }
+
+    bool hasKey(const T &key) const {
+
+        size_t position = lowerBound(key);
+
+        return position < sortedEntries.size() && *std::get<0>(sortedEntries[position]) == key;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) const {
+
+        size_t position = lowerBound(key);
+
+        if (position < sortedEntries.size() && *std::get<0>(sortedEntries[position]) == key) {
+            return std::get<1>(sortedEntries[position]);
+        }
+
+        return std::nullopt;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) const {
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        for (size_t position = lowerBound(base);
+             position < sortedEntries.size() && !(max < *std::get<0>(sortedEntries[position])); position++) {
+            result->push_back(sortedEntries[position]);
+        }
+
+        return result;
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() const {
+
+        if (sortedEntries.empty()) {
+            return std::nullopt;
+        }
+
+        return sortedEntries.front();
+    }
+
+    std::optional<node_info<T, V>> peekLargest() const {
+
+        if (sortedEntries.empty()) {
+            return std::nullopt;
+        }
+
+        return sortedEntries.back();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() const {
+        return std::make_unique<std::vector<node_info<T, V>>>(sortedEntries);
+    }
+};
+
+/**
+ * Take a read only snapshot of the map, the keys and values are shared with the map
+ */
+template<typename T, typename V>
+std::unique_ptr<FrozenOrderedMap<T, V>> freeze(OrderedMap<T, V> *map) {
+    return std::make_unique<FrozenOrderedMap<T, V>>(map);
+}
+
+#endif //TRABALHO1_FROZENMAP_H
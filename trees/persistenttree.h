@@ -0,0 +1,610 @@
+#ifndef TRABALHO1_PERSISTENTTREE_H
+#define TRABALHO1_PERSISTENTTREE_H
+
+#include "../datastructures.h"
+#include <mutex>
+#include <stack>
+#include <tuple>
+#include <vector>
+
+//A sub tree can weigh at most this many times its sibling (The weight of a sub tree is its size + 1)
+#define PERSISTENT_TREE_DELTA 3
+//When rebalancing, a single rotation is enough if the outer grandchild weighs at least 1 / this of the inner one
+#define PERSISTENT_TREE_RATIO 2
+
+/**
+ * A node that never changes once it's created. It's shared by every version of the tree that has it and is freed
+ * when the last of them lets go of it
+ */
+template<typename T, typename V>
+class PersistentNode {
+
+public:
+    typedef std::shared_ptr<const PersistentNode<T, V>> Ptr;
+
+private:
+    std::shared_ptr<T> key;
+    std::shared_ptr<V> value;
+
+    Ptr leftNode, rightNode;
+
+    //Nodes in the sub tree rooted here, this one included
+    unsigned int treeSize;
+
+public:
+    PersistentNode(std::shared_ptr<T> key, std::shared_ptr<V> value, Ptr left, Ptr right) :
+            key(std::move(key)), value(std::move(value)), leftNode(std::move(left)), rightNode(std::move(right)),
+            treeSize(sizeOf(leftNode) + sizeOf(rightNode) + 1) {}
+
+    static unsigned int sizeOf(const Ptr &node) {
+        return node == nullptr ? 0 : node->treeSize;
+    }
+
+    const std::shared_ptr<T> &getKey() const {
+        return key;
+    }
+
+    const std::shared_ptr<V> &getValue() const {
+        return value;
+    }
+
+    const T *getKeyVal() const {
+        return key.get();
+    }
+
+    const Ptr &getLeftChild() const {
+        return leftNode;
+    }
+
+    const Ptr &getRightChild() const {
+        return rightNode;
+    }
+
+    unsigned int getSize() const {
+        return treeSize;
+    }
+};
+
+/**
+ * A version of a weight balanced tree. Versions are never modified: add and remove copy the O(log n) nodes on the path
+ * to the key and return a new version that shares every other node with this one, so keeping a version around
+ * costs O(log n) nodes per change made after it instead of a copy of the whole map.
+ *
+ * Versions are cheap to copy (It's a single reference counted pointer) and can be read from any amount of threads
+ * at the same time, nodes are reclaimed by their reference counts once no version has them.
+ *
+ * The tree is balanced by the sizes of the sub trees (Adams' weight balanced trees, with the parameters proven
+ * correct by Hirai and Yamamoto), which the nodes keep anyway, so there's no color or height to copy along.
+ */
+template<typename T, typename V>
+class PersistentMap;
+
+template<typename T, typename V>
+class PersistentTree {
+
+    //The map keeps only the root of its current version
+    friend class PersistentMap<T, V>;
+
+public:
+    typedef PersistentNode<T, V> Node;
+
+    typedef typename Node::Ptr NodePtr;
+
+private:
+    NodePtr root;
+
+    explicit PersistentTree(NodePtr root) : root(std::move(root)) {}
+
+    static NodePtr createNode(const std::shared_ptr<T> &key, const std::shared_ptr<V> &value, NodePtr left,
+                              NodePtr right) {
+        return std::make_shared<const Node>(key, value, std::move(left), std::move(right));
+    }
+
+    /**
+     * Whether a sub tree is light enough next to its sibling
+     */
+    static bool isBalanced(const NodePtr &node, const NodePtr &sibling) {
+        return (Node::sizeOf(sibling) + 1) <= PERSISTENT_TREE_DELTA * (Node::sizeOf(node) + 1);
+    }
+
+    static bool isSingle(const NodePtr &inner, const NodePtr &outer) {
+        return (Node::sizeOf(inner) + 1) < PERSISTENT_TREE_RATIO * (Node::sizeOf(outer) + 1);
+    }
+
+    /**
+     * Create a node whose sub trees were balanced before one of them gained or lost a node, rotating it back into
+     * balance if it needs to. Only new nodes are rotated, the ones the sub trees share with other versions are not
+     */
+    static NodePtr balance(const std::shared_ptr<T> &key, const std::shared_ptr<V> &value, NodePtr left,
+                           NodePtr right) {
+
+        if (!isBalanced(left, right)) {
+            //The right side is too heavy
+            const NodePtr &inner = right->getLeftChild(), &outer = right->getRightChild();
+
+            if (isSingle(inner, outer)) {
+                return createNode(right->getKey(), right->getValue(), createNode(key, value, std::move(left), inner),
+                                  outer);
+            }
+
+            return createNode(inner->getKey(), inner->getValue(),
+                              createNode(key, value, std::move(left), inner->getLeftChild()),
+                              createNode(right->getKey(), right->getValue(), inner->getRightChild(), outer));
+        }
+
+        if (!isBalanced(right, left)) {
+            const NodePtr &inner = left->getRightChild(), &outer = left->getLeftChild();
+
+            if (isSingle(inner, outer)) {
+                return createNode(left->getKey(), left->getValue(), outer,
+                                  createNode(key, value, inner, std::move(right)));
+            }
+
+            return createNode(inner->getKey(), inner->getValue(),
+                              createNode(left->getKey(), left->getValue(), outer, inner->getLeftChild()),
+                              createNode(key, value, inner->getRightChild(), std::move(right)));
+        }
+
+        return createNode(key, value, std::move(left), std::move(right));
+    }
+
+    static NodePtr insert(const NodePtr &node, const std::shared_ptr<T> &key, const std::shared_ptr<V> &value) {
+
+        if (node == nullptr) return createNode(key, value, nullptr, nullptr);
+
+        if (*key < *node->getKeyVal()) {
+            return balance(node->getKey(), node->getValue(), insert(node->getLeftChild(), key, value),
+                           node->getRightChild());
+        }
+
+        if (*node->getKeyVal() < *key) {
+            return balance(node->getKey(), node->getValue(), node->getLeftChild(),
+                           insert(node->getRightChild(), key, value));
+        }
+
+        return createNode(node->getKey(), value, node->getLeftChild(), node->getRightChild());
+    }
+
+    /**
+     * Take the smallest node out of a sub tree
+     *
+     * @param removed Where the node that was taken out is left
+     */
+    static NodePtr takeSmallest(const NodePtr &node, NodePtr &removed) {
+
+        if (node->getLeftChild() == nullptr) {
+            removed = node;
+
+            return node->getRightChild();
+        }
+
+        return balance(node->getKey(), node->getValue(), takeSmallest(node->getLeftChild(), removed),
+                       node->getRightChild());
+    }
+
+    static NodePtr takeLargest(const NodePtr &node, NodePtr &removed) {
+
+        if (node->getRightChild() == nullptr) {
+            removed = node;
+
+            return node->getLeftChild();
+        }
+
+        return balance(node->getKey(), node->getValue(), node->getLeftChild(),
+                       takeLargest(node->getRightChild(), removed));
+    }
+
+    /**
+     * Join the two sub trees of a removed node, putting the node next to it from the heavier side in its place
+     */
+    static NodePtr glue(const NodePtr &left, const NodePtr &right) {
+
+        if (left == nullptr) return right;
+
+        if (right == nullptr) return left;
+
+        NodePtr replacement;
+
+        if (left->getSize() > right->getSize()) {
+            NodePtr remaining = takeLargest(left, replacement);
+
+            return balance(replacement->getKey(), replacement->getValue(), std::move(remaining), right);
+        }
+
+        NodePtr remaining = takeSmallest(right, replacement);
+
+        return balance(replacement->getKey(), replacement->getValue(), left, std::move(remaining));
+    }
+
+    /**
+     * @return The same node if the key isn't in the sub tree, so nothing gets copied
+     */
+    static NodePtr erase(const NodePtr &node, const T &key, NodePtr &removed) {
+
+        if (node == nullptr) return nullptr;
+
+        if (key < *node->getKeyVal()) {
+            NodePtr left = erase(node->getLeftChild(), key, removed);
+
+            if (removed == nullptr) return node;
+
+            return balance(node->getKey(), node->getValue(), std::move(left), node->getRightChild());
+        }
+
+        if (*node->getKeyVal() < key) {
+            NodePtr right = erase(node->getRightChild(), key, removed);
+
+            if (removed == nullptr) return node;
+
+            return balance(node->getKey(), node->getValue(), node->getLeftChild(), std::move(right));
+        }
+
+        removed = node;
+
+        return glue(node->getLeftChild(), node->getRightChild());
+    }
+
+    /**
+     * Perfectly balanced tree of the entries between first and last (Exclusive)
+     */
+    static NodePtr build(const std::vector<node_info<T, V>> &sorted, size_t first, size_t last) {
+
+        if (first == last) return nullptr;
+
+        size_t middle = first + (last - first) / 2;
+
+        return createNode(std::get<0>(sorted[middle]), std::get<1>(sorted[middle]), build(sorted, first, middle),
+                          build(sorted, middle + 1, last));
+    }
+
+    const Node *find(const T &key) const {
+
+        const Node *current = this->root.get();
+
+        while (current != nullptr) {
+            if (key < *current->getKeyVal()) {
+                current = current->getLeftChild().get();
+            } else if (*current->getKeyVal() < key) {
+                current = current->getRightChild().get();
+            } else {
+                return current;
+            }
+        }
+
+        return nullptr;
+    }
+
+public:
+    PersistentTree() = default;
+
+    /**
+     * @param sorted Entries sorted by key, without repeated keys. The tree is built in O(n)
+     */
+    static PersistentTree<T, V> fromSorted(const std::vector<node_info<T, V>> &sorted) {
+        return PersistentTree<T, V>(build(sorted, 0, sorted.size()));
+    }
+
+    /**
+     * @return A version with the key added or its value replaced
+     */
+    PersistentTree<T, V> add(std::shared_ptr<T> key, std::shared_ptr<V> value) const {
+        return PersistentTree<T, V>(insert(this->root, key, value));
+    }
+
+    /**
+     * @param removed Where the entry that was removed is left, if the key was there
+     * @return A version without the key. It shares the root of this one if the key wasn't there
+     */
+    PersistentTree<T, V> remove(const T &key, std::optional<node_info<T, V>> *removed = nullptr) const {
+
+        NodePtr removedNode;
+
+        NodePtr updated = erase(this->root, key, removedNode);
+
+        if (removed != nullptr && removedNode != nullptr) {
+            *removed = std::make_tuple(removedNode->getKey(), removedNode->getValue());
+        }
+
+        return PersistentTree<T, V>(std::move(updated));
+    }
+
+    PersistentTree<T, V> removeSmallest(std::optional<node_info<T, V>> *removed = nullptr) const {
+
+        if (this->root == nullptr) return *this;
+
+        NodePtr removedNode;
+
+        NodePtr updated = takeSmallest(this->root, removedNode);
+
+        if (removed != nullptr) *removed = std::make_tuple(removedNode->getKey(), removedNode->getValue());
+
+        return PersistentTree<T, V>(std::move(updated));
+    }
+
+    PersistentTree<T, V> removeLargest(std::optional<node_info<T, V>> *removed = nullptr) const {
+
+        if (this->root == nullptr) return *this;
+
+        NodePtr removedNode;
+
+        NodePtr updated = takeLargest(this->root, removedNode);
+
+        if (removed != nullptr) *removed = std::make_tuple(removedNode->getKey(), removedNode->getValue());
+
+        return PersistentTree<T, V>(std::move(updated));
+    }
+
+    unsigned int size() const {
+        return Node::sizeOf(this->root);
+    }
+
+    bool hasKey(const T &key) const {
+        return find(key) != nullptr;
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) const {
+
+        const Node *node = find(key);
+
+        if (node == nullptr) return std::nullopt;
+
+        return node->getValue();
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() const {
+
+        const Node *current = this->root.get();
+
+        if (current == nullptr) return std::nullopt;
+
+        while (current->getLeftChild() != nullptr) {
+            current = current->getLeftChild().get();
+        }
+
+        return std::make_tuple(current->getKey(), current->getValue());
+    }
+
+    std::optional<node_info<T, V>> peekLargest() const {
+
+        const Node *current = this->root.get();
+
+        if (current == nullptr) return std::nullopt;
+
+        while (current->getRightChild() != nullptr) {
+            current = current->getRightChild().get();
+        }
+
+        return std::make_tuple(current->getKey(), current->getValue());
+    }
+
+    /**
+     * In order traversal of the entries with keys between base and max (Inclusive), skipping the sub trees that are
+     * out of the range
+     */
+    template<typename F>
+    void forEachInRange(const T *base, const T *max, F visitor) const {
+
+        std::stack<const Node *> stack;
+
+        const Node *current = this->root.get();
+
+        while (current != nullptr || !stack.empty()) {
+
+            while (current != nullptr) {
+                if (base != nullptr && *current->getKeyVal() < *base) {
+                    current = current->getRightChild().get();
+                } else {
+                    stack.push(current);
+
+                    current = current->getLeftChild().get();
+                }
+            }
+
+            if (stack.empty()) break;
+
+            current = stack.top();
+
+            stack.pop();
+
+            if (max != nullptr && *max < *current->getKeyVal()) break;
+
+            visitor(current->getKey(), current->getValue());
+
+            current = current->getRightChild().get();
+        }
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) const {
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        forEachInRange(&base, &max, [&result](const std::shared_ptr<T> &key, const std::shared_ptr<V> &value) {
+            result->emplace_back(key, value);
+        });
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() const {
+
+        auto result = std::make_unique<std::vector<node_info<T, V>>>();
+
+        result->reserve(size());
+
+        forEachInRange(nullptr, nullptr, [&result](const std::shared_ptr<T> &key, const std::shared_ptr<V> &value) {
+            result->emplace_back(key, value);
+        });
+
+        return result;
+    }
+
+    const NodePtr &getRoot() const {
+        return this->root;
+    }
+};
+
+/**
+ * An OrderedMap over persistent tree versions. Writers build the next version and publish it, readers take the
+ * current version and read it without any lock, so a reader (Or a version kept with getVersion) sees the map as it
+ * was when it took the version no matter what writers do after that.
+ *
+ * Publishing a version only stores its root with std::atomic_store, and taking one loads it with std::atomic_load,
+ * so readers don't wait on each other or on the writers.
+ */
+template<typename T, typename V>
+class PersistentMap : public OrderedMap<T, V> {
+
+private:
+    //The root of the current version, only accessed with the atomic shared_ptr functions
+    typename PersistentTree<T, V>::NodePtr currentRoot;
+
+    //Writers build their version from the current one one at a time
+    std::mutex writeLock;
+
+    template<typename F>
+    void update(F change) {
+
+        std::lock_guard<std::mutex> write(this->writeLock);
+
+        PersistentTree<T, V> updated = change(getVersion());
+
+        std::atomic_store(&this->currentRoot, std::move(updated.root));
+    }
+
+public:
+    PersistentMap() = default;
+
+    ~PersistentMap() override = default;
+
+    /**
+     * The map as it is now. It doesn't change when the map does
+     */
+    PersistentTree<T, V> getVersion() {
+        return PersistentTree<T, V>(std::atomic_load(&this->currentRoot));
+    }
+
+    void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+        update([&key, &value](const PersistentTree<T, V> &version) {
+            return version.add(std::move(key), std::move(value));
+        });
+    }
+
+    std::optional<std::shared_ptr<V>> remove(const T &key) override {
+
+        std::optional<node_info<T, V>> removed;
+
+        update([&key, &removed](const PersistentTree<T, V> &version) {
+            return version.remove(key, &removed);
+        });
+
+        if (!removed) return std::nullopt;
+
+        return std::get<1>(*removed);
+    }
+
+    std::optional<node_info<T, V>> popSmallest() override {
+
+        std::optional<node_info<T, V>> removed;
+
+        update([&removed](const PersistentTree<T, V> &version) {
+            return version.removeSmallest(&removed);
+        });
+
+        return removed;
+    }
+
+    std::optional<node_info<T, V>> popLargest() override {
+
+        std::optional<node_info<T, V>> removed;
+
+        update([&removed](const PersistentTree<T, V> &version) {
+            return version.removeLargest(&removed);
+        });
+
+        return removed;
+    }
+
+    /**
+     * Replace an empty map with a balanced tree of the entries in O(n), otherwise add them one by one
+     */
+    void addSorted(std::vector<node_info<T, V>> sorted) override {
+
+        std::lock_guard<std::mutex> write(this->writeLock);
+
+        PersistentTree<T, V> version = getVersion();
+
+        if (version.size() == 0) {
+            version = PersistentTree<T, V>::fromSorted(sorted);
+        } else {
+            for (auto &entry : sorted) {
+                version = version.add(std::move(std::get<0>(entry)), std::move(std::get<1>(entry)));
+            }
+        }
+
+        std::atomic_store(&this->currentRoot, std::move(version.root));
+    }
+
+    bool hasKey(const T &key) override {
+        return getVersion().hasKey(key);
+    }
+
+    std::optional<std::shared_ptr<V>> get(const T &key) override {
+        return getVersion().get(key);
+    }
+
+    unsigned int size() override {
+        return getVersion().size();
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<T>>> keys() override {
+
+        auto result = std::make_unique<std::vector<std::shared_ptr<T>>>();
+
+        auto all = entries();
+
+        result->reserve(all->size());
+
+        for (auto &entry : *all) {
+            result->push_back(std::move(std::get<0>(entry)));
+        }
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<std::shared_ptr<V>>> values() override {
+
+        auto result = std::make_unique<std::vector<std::shared_ptr<V>>>();
+
+        auto all = entries();
+
+        result->reserve(all->size());
+
+        for (auto &entry : *all) {
+            result->push_back(std::move(std::get<1>(entry)));
+        }
+
+        return result;
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> entries() override {
+        return getVersion().entries();
+    }
+
+    std::unique_ptr<std::vector<node_info<T, V>>> rangeSearch(const T &base, const T &max) override {
+        return getVersion().rangeSearch(base, max);
+    }
+
+    std::optional<node_info<T, V>> peekSmallest() override {
+        return getVersion().peekSmallest();
+    }
+
+    std::optional<node_info<T, V>> peekLargest() override {
+        return getVersion().peekLargest();
+    }
+
+    void forEachEntry(const entry_visitor<T, V> &visitor) override {
+        getVersion().forEachInRange(nullptr, nullptr, visitor);
+    }
+};
+
+#endif //TRABALHO1_PERSISTENTTREE_H
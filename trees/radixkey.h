@@ -0,0 +1,92 @@
+#ifndef TRABALHO1_RADIXKEY_H
+#define TRABALHO1_RADIXKEY_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/**
+ * Binary comparable encoding of keys: comparing two encoded keys byte by byte (As unsigned bytes) gives the same order
+ * as comparing the keys. No encoded key is a prefix of another one, so every key gets its own leaf in a radix tree.
+ *
+ * Used by the radix tree and by the on disk tables, which search and compress their keys without decoding them
+ */
+template<typename T, typename Enable = void>
+struct RadixKey;
+
+/**
+ * Integers are stored big endian, with the sign bit flipped so the negative numbers come before the positive ones
+ */
+template<typename T>
+struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+
+    typedef typename std::make_unsigned<T>::type Bits;
+
+    static void encode(const T &key, std::string &bytes) {
+
+        Bits bits = (Bits) key;
+
+        if (std::is_signed<T>::value) {
+            bits ^= (Bits) ((Bits) 1 << (sizeof(T) * 8 - 1));
+        }
+
+        for (int shift = (int) (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+            bytes.push_back((char) (uint8_t) (bits >> shift));
+        }
+    }
+
+    static T decode(const char *bytes, size_t) {
+
+        Bits bits = 0;
+
+        for (size_t i = 0; i < sizeof(T); i++) {
+            bits = (Bits) ((bits << 8) | (uint8_t) bytes[i]);
+        }
+
+        if (std::is_signed<T>::value) {
+            bits ^= (Bits) ((Bits) 1 << (sizeof(T) * 8 - 1));
+        }
+
+        return (T) bits;
+    }
+};
+
+/**
+ * Strings already compare byte by byte. Zero bytes are escaped as 0x00 0xFF and every key ends with 0x00 0x00, so a
+ * string still comes before the longer strings that start with it but is never a prefix of their encoding
+ */
+template<>
+struct RadixKey<std::string> {
+
+    static void encode(const std::string &key, std::string &bytes) {
+
+        bytes.reserve(bytes.size() + key.size() + 2);
+
+        for (char byte : key) {
+            bytes.push_back(byte);
+
+            if (byte == 0) bytes.push_back((char) 0xFF);
+        }
+
+        bytes.push_back(0);
+        bytes.push_back(0);
+    }
+
+    static std::string decode(const char *bytes, size_t length) {
+
+        std::string key;
+
+        key.reserve(length - 2);
+
+        //The last two bytes are the terminator
+        for (size_t i = 0; i + 2 < length; i++) {
+            key.push_back(bytes[i]);
+
+            if (bytes[i] == 0) i++;
+        }
+
+        return key;
+    }
+};
+
+#endif //TRABALHO1_RADIXKEY_H
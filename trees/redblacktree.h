@@ -326,9 +326,29 @@ protected:
 public:
     void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
 
+        unsigned int previousSize = this->size();
+
         auto newNode = this->addNode(key, value);
 
-        updateBalance((RBNode<T, V> *) newNode);
+        //Only a new node can break the colors, an existing key just had its value replaced
+        if (this->size() != previousSize) {
+            updateBalance((RBNode<T, V> *) newNode);
+        }
+    }
+
+    TreeNode<T, V> *addWithHint(TreeNode<T, V> *hint, std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        TreeNode<T, V> *start = this->findHintStart(hint, *key);
+
+        unsigned int previousSize = this->size();
+
+        auto newNode = this->addNode(std::move(key), std::move(value), start);
+
+        if (this->size() != previousSize) {
+            updateBalance((RBNode<T, V> *) newNode);
+        }
+
+        return newNode;
     }
 
     std::optional<std::shared_ptr<V>> remove(const T &key) override {
@@ -4,6 +4,23 @@
 #include "binarytrees.h"
 #include <stack>
 
+//The depth above which a semi splay stops restructuring the tree (0 lets it restructure up to the root)
+#define DEFAULT_SEMI_SPLAY_DEPTH 0
+
+/**
+ * BOTTOM_UP finds the node and then rotates it all the way up to the root.
+ *
+ * TOP_DOWN restructures the tree while descending, so each access is a single pass from the root.
+ *
+ * SEMI_SPLAY only moves the node's parent up on the zig zig cases (Roughly halving the depth of the path instead of
+ * moving the node to the root) and leaves the top levels of the tree alone.
+ */
+enum SplayMode {
+    BOTTOM_UP,
+    TOP_DOWN,
+    SEMI_SPLAY
+};
+
 template<typename T, typename V>
 class SplayNode : public TreeNode<T, V> {
 
@@ -22,6 +39,9 @@ template<typename T, typename V>
 class SplayTree : public BinarySearchTree<T, V> {
 
 protected:
+    SplayMode splayMode;
+
+    unsigned int semiSplayDepth;
 
     void rotateRightP(TreeNode<T, V> *root) {
 
@@ -87,7 +107,7 @@ protected:
         rotateRightP(root->getParent());
     }
 
-    void splay(TreeNode<T, V> *x) {
+    void bottomUpSplay(TreeNode<T, V> *x) {
 
         if (x == nullptr) return;
 
@@ -132,6 +152,269 @@ protected:
         }
     }
 
+    /**
+     * Semi splay, the nodes closer than semiSplayDepth to the root are never restructured
+     */
+    void semiSplay(TreeNode<T, V> *x) {
+
+        unsigned int depth = 0;
+
+        for (auto *current = x; current->getParent() != nullptr; current = current->getParent()) {
+            depth++;
+        }
+
+        //Every step restructures the nodes down from the grand parent, which is 2 levels above the node
+        while (depth >= this->semiSplayDepth + 2) {
+
+            auto parent = x->getParent();
+
+            auto grandParent = parent->getParent();
+
+            if (grandParent->getLeftChild() == parent && parent->getLeftChild() == x) {
+                //Only rotate the parent, and continue from it, as it is now where the grand parent was
+                rotateRightP(grandParent);
+
+                x = parent;
+            } else if (grandParent->getRightChild() == parent && parent->getRightChild() == x) {
+                rotateLeftP(grandParent);
+
+                x = parent;
+            } else if (grandParent->getLeftChild() == parent) {
+                zagZig(x);
+            } else {
+                zigZag(x);
+            }
+
+            depth -= 2;
+        }
+    }
+
+    /**
+     * Top down splay of the sub tree with the given root.
+     *
+     * While we descend, the nodes that are smaller than the key are hung in the left tree and the ones that are
+     * larger in the right tree. When we reach the node (Or the last node in the search path, if the key is not
+     * present) it gets assembled as the root, with the left and right trees as its children.
+     *
+     * @param root The root of the sub tree, the parent of the returned root is not updated
+     * @param key
+     * @return The new root of the sub tree
+     */
+    std::unique_ptr<TreeNode<T, V>> topDownSplay(std::unique_ptr<TreeNode<T, V>> root, const T &key) {
+
+        if (root.get() == nullptr) return root;
+
+        std::unique_ptr<TreeNode<T, V>> leftTree, rightTree;
+
+        //The largest node in the left tree and the smallest node in the right tree, where the next nodes get linked
+        TreeNode<T, V> *leftMax = nullptr, *rightMin = nullptr;
+
+        std::unique_ptr<TreeNode<T, V>> current = std::move(root);
+
+        while (true) {
+
+            const T &currentKey = *current->getKeyVal();
+
+            if (currentKey == key) {
+                break;
+            } else if (key < currentKey) {
+
+                if (current->getLeftChild() == nullptr) break;
+
+                if (key < *current->getLeftChild()->getKeyVal()) {
+                    //Zig zig, rotate before linking
+                    current = this->rotateRight(std::move(current));
+
+                    if (current->getLeftChild() == nullptr) break;
+                }
+
+                //Link the current node into the right tree and continue down its left child
+                std::unique_ptr<TreeNode<T, V>> next = current->getLeftNodeOwnership();
+
+                TreeNode<T, V> *currentP = current.get();
+
+                if (rightMin == nullptr) {
+                    rightTree = std::move(current);
+                } else {
+                    rightMin->setLeftChild(std::move(current));
+                }
+
+                rightMin = currentP;
+
+                current = std::move(next);
+            } else {
+
+                if (current->getRightChild() == nullptr) break;
+
+                if (*current->getRightChild()->getKeyVal() < key) {
+                    //Zag zag
+                    current = this->rotateLeft(std::move(current));
+
+                    if (current->getRightChild() == nullptr) break;
+                }
+
+                std::unique_ptr<TreeNode<T, V>> next = current->getRightNodeOwnership();
+
+                TreeNode<T, V> *currentP = current.get();
+
+                if (leftMax == nullptr) {
+                    leftTree = std::move(current);
+                } else {
+                    leftMax->setRightChild(std::move(current));
+                }
+
+                leftMax = currentP;
+
+                current = std::move(next);
+            }
+        }
+
+        //Assemble the tree, the children of the new root get hung in the left and right trees
+        if (leftMax != nullptr) {
+            leftMax->setRightChild(current->getLeftNodeOwnership());
+
+            current->setLeftChild(std::move(leftTree));
+        }
+
+        if (rightMin != nullptr) {
+            rightMin->setLeftChild(current->getRightNodeOwnership());
+
+            current->setRightChild(std::move(rightTree));
+        }
+
+        return current;
+    }
+
+    void splayByKey(const T &key) {
+        this->setRootNode(topDownSplay(this->getRootNodeOwnership(), key));
+    }
+
+    /**
+     * Splay the node after it has been accessed, depending on the mode of the tree
+     * (The node might not end up in the root)
+     */
+    void splay(TreeNode<T, V> *x) {
+
+        if (x == nullptr) return;
+
+        switch (this->splayMode) {
+            case TOP_DOWN:
+                splayByKey(*x->getKeyVal());
+                break;
+            case SEMI_SPLAY:
+                semiSplay(x);
+                break;
+            default:
+                bottomUpSplay(x);
+                break;
+        }
+    }
+
+    /**
+     * Splay the node all the way to the root, no matter the mode of the tree
+     */
+    void splayToRoot(TreeNode<T, V> *x) {
+
+        if (x == nullptr) return;
+
+        if (this->splayMode == TOP_DOWN) {
+            splayByKey(*x->getKeyVal());
+        } else {
+            bottomUpSplay(x);
+        }
+    }
+
+    /**
+     * Remove the current root from the tree, joining its left and right sub trees
+     * @return The removed root
+     */
+    std::unique_ptr<TreeNode<T, V>> removeRoot() {
+
+        std::unique_ptr<TreeNode<T, V>> rootOwner = this->getRootNodeOwnership(),
+                leftNodeOwner = rootOwner->getLeftNodeOwnership(),
+                rightNodeOwner = rootOwner->getRightNodeOwnership();
+
+        if (leftNodeOwner.get() == nullptr) {
+
+            this->setRootNode(std::move(rightNodeOwner));
+
+        } else if (this->splayMode == TOP_DOWN) {
+
+            //Every key in the left sub tree is smaller than the removed key, so splaying for it brings the largest
+            //Node of the left sub tree to its root, which has no right child
+            leftNodeOwner = topDownSplay(std::move(leftNodeOwner), *rootOwner->getKeyVal());
+
+            leftNodeOwner->setRightChild(std::move(rightNodeOwner));
+
+            this->setRootNode(std::move(leftNodeOwner));
+
+        } else {
+
+            auto *leftNodeP = leftNodeOwner.get();
+
+            //Set the left sub tree as the new root-
+            this->setRootNode(std::move(leftNodeOwner));
+
+            auto largestNodeInRoot1 = this->getRightMostNodeInTree(leftNodeP);
+
+            //Splay the largest node
+            bottomUpSplay(largestNodeInRoot1);
+
+            //The right subtree is now the right child of the
+            largestNodeInRoot1->setRightChild(std::move(rightNodeOwner));
+        }
+
+        this->treeSize--;
+
+        return rootOwner;
+    }
+
+    void addTopDown(std::shared_ptr<T> key, std::shared_ptr<V> value) {
+
+        if (this->getRoot() == nullptr) {
+            this->addNode(std::move(key), std::move(value));
+
+            return;
+        }
+
+        splayByKey(*key);
+
+        TreeNode<T, V> *root = this->getRoot();
+
+        if (*root->getKeyVal() == *key) {
+            root->setValue(std::move(value));
+
+            return;
+        }
+
+        const T &keyRef = *key;
+
+        std::unique_ptr<TreeNode<T, V>> newNode = this->initializeNode(std::move(key), std::move(value), nullptr);
+
+        TreeNode<T, V> *newNodeP = newNode.get();
+
+        //The old root is either the predecessor or the successor of the new key, so split the tree around it
+        if (keyRef < *root->getKeyVal()) {
+            newNode->setLeftChild(root->getLeftNodeOwnership());
+            newNode->setRightChild(this->getRootNodeOwnership());
+        } else {
+            newNode->setRightChild(root->getRightNodeOwnership());
+            newNode->setLeftChild(this->getRootNodeOwnership());
+        }
+
+        this->setRootNode(std::move(newNode));
+
+        if (keyRef < *this->leftMostNode->getKeyVal()) {
+            this->setLeftMostNode(newNodeP);
+        }
+
+        if (keyRef > *this->rightMostNode->getKeyVal()) {
+            this->setRightMostNode(newNodeP);
+        }
+
+        this->treeSize++;
+    }
+
     std::tuple<TreeNode<T, V> *, TreeNode<T, V> *> getNodeAndPreviousByKey(const T &key) {
 
         if (this->getRoot() != nullptr) {
@@ -171,13 +454,28 @@ protected:
 
 public:
 
-    SplayTree() : BinarySearchTree<T, V>() {}
+    SplayTree(SplayMode splayMode = BOTTOM_UP, unsigned int semiSplayDepth = DEFAULT_SEMI_SPLAY_DEPTH)
+            : BinarySearchTree<T, V>(), splayMode(splayMode), semiSplayDepth(semiSplayDepth) {}
 
     ~SplayTree() override {
     }
 
+    SplayMode getSplayMode() const {
+        return this->splayMode;
+    }
+
+    void setSemiSplayDepth(unsigned int semiSplayDepth) {
+        this->semiSplayDepth = semiSplayDepth;
+    }
+
     void add(std::shared_ptr<T> key, std::shared_ptr<V> value) override {
 
+        if (this->splayMode == TOP_DOWN) {
+            addTopDown(std::move(key), std::move(value));
+
+            return;
+        }
+
         auto *addedNode = this->addNode(std::move(key), std::move(value));
 
         splay(addedNode);
@@ -190,6 +488,12 @@ public:
             return false;
         }
 
+        if (this->splayMode == TOP_DOWN) {
+            splayByKey(key);
+
+            return *this->getRoot()->getKeyVal() == key;
+        }
+
         auto node = this->getNodeAndPreviousByKey(key);
 
         TreeNode<T, V> *root, *previous;
@@ -213,6 +517,16 @@ public:
             return std::nullopt;
         }
 
+        if (this->splayMode == TOP_DOWN) {
+            splayByKey(key);
+
+            if (*this->getRoot()->getKeyVal() == key) {
+                return this->getRoot()->getValue();
+            }
+
+            return std::nullopt;
+        }
+
         auto node = this->getNodeAndPreviousByKey(key);
 
         TreeNode<T, V> *root, *previous;
@@ -237,49 +551,37 @@ public:
             return std::nullopt;
         }
 
-        auto node = this->getNodeAndPreviousByKey(key);
+        if (this->splayMode == TOP_DOWN) {
+            splayByKey(key);
+        } else {
+            auto node = this->getNodeAndPreviousByKey(key);
 
-        TreeNode<T, V> *foundNode, *previous;
+            TreeNode<T, V> *foundNode, *previous;
 
-        std::tie(foundNode, previous) = node;
+            std::tie(foundNode, previous) = node;
 
-        if (foundNode != nullptr) {
-            splay(foundNode);
-        } else {
-            splay(previous);
+            if (foundNode != nullptr) {
+                splayToRoot(foundNode);
+            } else {
+                splay(previous);
+            }
         }
 
         TreeNode<T, V> *root = this->getRoot();
 
         if ((*root->getKeyVal()) == key) {
 
-            std::unique_ptr<TreeNode<T, V>> rootOwner = this->getRootNodeOwnership(),
-                    leftNodeOwner = rootOwner.get()->getLeftNodeOwnership(),
-                    rightNodeOwner = rootOwner.get()->getRightNodeOwnership();
-
-            if (leftNodeOwner.get() == nullptr) {
-
-                this->setRootNode(std::move(rightNodeOwner));
-
-            } else {
-
-                auto *leftNodeP = leftNodeOwner.get();
-
-                //Set the left sub tree as the new root-
-                this->setRootNode(std::move(leftNodeOwner));
-
-                auto largestNodeInRoot1 = this->getRightMostNodeInTree(leftNodeP);
-
-                //Splay the largest node
-                splay(largestNodeInRoot1);
+            if (root == this->leftMostNode) {
+                this->handleRemoveSmallestNode();
+            }
 
-                //The right subtree is now the right child of the
-                largestNodeInRoot1->setRightChild(std::move(rightNodeOwner));
+            if (root == this->rightMostNode) {
+                this->handleRemoveLargestNode();
             }
 
-            this->treeSize--;
+            std::unique_ptr<TreeNode<T, V>> rootOwner = removeRoot();
 
-            return rootOwner.get()->getKey();
+            return rootOwner->getValue();
 
         } else {
             return std::nullopt;
@@ -294,33 +596,14 @@ public:
 
             this->handleRemoveLargestNode();
 
-            splay(rightNode);
-
-            std::unique_ptr<TreeNode<T, V>> rootOwner = this->getRootNodeOwnership(),
-                    leftNodeOwner = rootOwner->getLeftNodeOwnership(),
-                    rightNodeOwner = rootOwner->getRightNodeOwnership();
-
-            if (leftNodeOwner.get() == nullptr) {
-
-                this->setRootNode(std::move(rightNodeOwner));
-
-            } else {
-
-                auto *leftNodeP = leftNodeOwner.get();
-
-                //Set the left sub tree as the new root-
-                this->setRootNode(std::move(leftNodeOwner));
-
-                auto largestNodeInRoot1 = this->getRightMostNodeInTree(leftNodeP);
-
-                //Splay the largest node
-                splay(largestNodeInRoot1);
-
-                //The right subtree is now the right child of the
-                largestNodeInRoot1->setRightChild(std::move(rightNodeOwner));
+            if (this->leftMostNode == rightNode) {
+                //This was the only node in the tree
+                this->leftMostNode = nullptr;
             }
 
-            this->treeSize--;
+            splayToRoot(rightNode);
+
+            std::unique_ptr<TreeNode<T, V>> rootOwner = removeRoot();
 
             return std::make_tuple(rootOwner->getKey(), rootOwner->getValue());
         }
@@ -335,32 +618,14 @@ public:
 
             this->handleRemoveSmallestNode();
 
-            splay(leftNode);
-
-            std::unique_ptr<TreeNode<T, V>> rootOwner = this->getRootNodeOwnership(),
-                    leftNodeOwner = rootOwner->getLeftNodeOwnership(),
-                    rightNodeOwner = rootOwner->getRightNodeOwnership();
-
-            if (leftNodeOwner.get() == nullptr) {
-
-                this->setRootNode(std::move(rightNodeOwner));
-
-            } else {
-
-                auto *leftNodeP = leftNodeOwner.get();
-                //Set the left sub tree as the new root-
-                this->setRootNode(std::move(leftNodeOwner));
-
-                auto largestNodeInRoot1 = this->getRightMostNodeInTree(leftNodeP);
-
-                //Splay the largest node
-                splay(largestNodeInRoot1);
-
-                //The right subtree is now the right child of the
-                largestNodeInRoot1->setRightChild(std::move(rightNodeOwner));
+            if (this->rightMostNode == leftNode) {
+                //This was the only node in the tree
+                this->rightMostNode = nullptr;
             }
 
-            this->treeSize--;
+            splayToRoot(leftNode);
+
+            std::unique_ptr<TreeNode<T, V>> rootOwner = removeRoot();
 
             return std::make_tuple(rootOwner->getKey(), rootOwner->getValue());
         }
@@ -368,7 +633,6 @@ public:
         return std::nullopt;
     }
 
-
 };
 
 #endif //TRABALHO1_SPLAYTREE_H
@@ -238,6 +238,17 @@ public:
 
     }
 
+    TreeNode<T, V> *addWithHint(TreeNode<T, V> *hint, std::shared_ptr<T> key, std::shared_ptr<V> value) override {
+
+        TreeNode<T, V> *start = this->findHintStart(hint, *key);
+
+        auto addedNode = this->addNode(std::move(key), std::move(value), start);
+
+        heapify((TreapNode<T, V> *) addedNode);
+
+        return addedNode;
+    }
+
     std::optional<std::shared_ptr<V>> remove(const T &key) override {
 
         auto *rootNode = (TreapNode<T, V> *) this->getRoot();